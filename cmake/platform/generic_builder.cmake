@@ -8,6 +8,8 @@ endif()
 set(AK_ENCRYPTOR_SRC_DIR       "${PROJECT_SOURCE_DIR}/src")
 set(AK_GRAPHICS_SRC_DIR        "${AK_ENCRYPTOR_SRC_DIR}/gui")
 set(AK_PROCESSOR_SRC_DIR       "${AK_ENCRYPTOR_SRC_DIR}/processor")
+set(AK_CLI_SRC_DIR             "${AK_ENCRYPTOR_SRC_DIR}/cli")
+set(AK_BENCH_SRC_DIR           "${AK_ENCRYPTOR_SRC_DIR}/bench")
 set(AK_LOGGER_SRC_DIR          "${AK_ENCRYPTOR_SRC_DIR}/log")
 
 # [INCLUDE DIRECTORIES]
@@ -15,6 +17,7 @@ set(AK_ENCRYPTOR_INCLUDE_DIRS
     ${AK_ENCRYPTOR_SRC_DIR}
     ${AK_GRAPHICS_SRC_DIR}
     ${AK_PROCESSOR_SRC_DIR}
+    ${AK_CLI_SRC_DIR}
 )
 
 # [SOURCE FILES]
@@ -33,6 +36,16 @@ file(GLOB AK_PROCESSOR_SRC CONFIGURE_DEPENDS
     "${AK_PROCESSOR_SRC_DIR}/*.cpp"
 )
 
+file(GLOB AK_CLI_SRC CONFIGURE_DEPENDS
+    "${AK_CLI_SRC_DIR}/*.hpp"
+    "${AK_CLI_SRC_DIR}/*.cpp"
+)
+
+file(GLOB AK_BENCH_SRC CONFIGURE_DEPENDS
+    "${AK_BENCH_SRC_DIR}/*.hpp"
+    "${AK_BENCH_SRC_DIR}/*.cpp"
+)
+
 file(GLOB AK_LOGGER_SRC CONFIGURE_DEPENDS
     "${AK_LOGGER_SRC_DIR}/*.hpp"
     "${AK_LOGGER_SRC_DIR}/*.cpp"
@@ -55,6 +68,8 @@ message(${AK_GRAPHICS_SRC})
 source_group("Encryptor Base"  FILES ${AK_ENCRYPTOR_SRC})
 source_group("User Interface"  FILES ${AK_GRAPHICS_SRC})
 source_group("Processing"      FILES ${AK_PROCESSOR_SRC})
+source_group("Command Line"    FILES ${AK_CLI_SRC})
+source_group("Benchmarks"      FILES ${AK_BENCH_SRC})
 source_group("Log Handler"     FILES ${AK_LOGGER_SRC})
 
 if(CMAKE_RELEASE AND CMAKE_UPX_COMPRESS)
@@ -1,5 +1,6 @@
 set(AK_GRAPHICS_LIB  "lib-ak-gui")
 set(AK_PROCESSOR_LIB "lib-ak-prc")
+set(AK_CLI_LIB       "lib-ak-cli")
 
 add_library(${AK_GRAPHICS_LIB} STATIC ${AK_GRAPHICS_SRC})
 
@@ -11,16 +12,47 @@ add_library(${AK_PROCESSOR_LIB} STATIC ${AK_PROCESSOR_SRC})
 target_include_directories(${AK_PROCESSOR_LIB} PRIVATE ${AK_ENCRYPTOR_INCLUDE_DIRS}/)
 target_link_directories(${AK_PROCESSOR_LIB} PRIVATE ${AK_ENCRYPTOR_INCLUDE_DIRS}/)
 
+add_library(${AK_CLI_LIB} STATIC ${AK_CLI_SRC})
+
+target_include_directories(${AK_CLI_LIB} PRIVATE ${AK_ENCRYPTOR_INCLUDE_DIRS}/)
+target_link_directories(${AK_CLI_LIB} PRIVATE ${AK_ENCRYPTOR_INCLUDE_DIRS}/)
+
 find_library(AKRYPT_LIBRARY NAMES akrypt)
 
 set(AK_ENCRYPTOR_LIBS
     ${AK_GRAPHICS_LIB}
+    ${AK_CLI_LIB}
     ${AK_PROCESSOR_LIB}
 )
 
 set(SYSTEM_ENCRYPTOR_LIBS
     ncurses
     pthread
+    z
     libakrypt-base.so
     libakrypt.so
 )
+
+if(AK_ENABLE_IO_URING)
+    find_library(URING_LIBRARY NAMES uring)
+    find_path(URING_INCLUDE_DIR NAMES liburing.h)
+
+    if(URING_LIBRARY AND URING_INCLUDE_DIR)
+        message(STATUS "io_uring:          ${URING_LIBRARY}")
+        target_compile_definitions(${AK_PROCESSOR_LIB} PRIVATE AK_HAVE_IO_URING)
+        target_include_directories(${AK_PROCESSOR_LIB} PRIVATE ${URING_INCLUDE_DIR})
+        list(APPEND SYSTEM_ENCRYPTOR_LIBS ${URING_LIBRARY})
+    else()
+        message(STATUS "io_uring:          liburing not found, using thread pipeline")
+    endif()
+endif()
+
+if(AK_ENABLE_SIMD_KUZNECHIK)
+    message(STATUS "Kuznechik kernel:  runtime-dispatched (generic/SSE4.1/AVX-512)")
+    target_compile_definitions(${AK_PROCESSOR_LIB} PRIVATE AK_HAVE_SIMD_KUZNECHIK)
+endif()
+
+if(AK_ENABLE_MULTI_BUFFER_MAGMA)
+    message(STATUS "Magma kernel:      runtime-dispatched multi-buffer (generic/AVX2/AVX-512)")
+    target_compile_definitions(${AK_PROCESSOR_LIB} PRIVATE AK_HAVE_MULTI_BUFFER_MAGMA)
+endif()
@@ -45,6 +45,15 @@ target_include_directories(${PROJECT_NAME} PUBLIC ${AK_ENCRYPTOR_INCLUDE_DIRS})
 target_link_directories(${PROJECT_NAME} PUBLIC ${AK_ENCRYPTOR_INCLUDE_DIRS})
 target_link_libraries(${PROJECT_NAME} ${AK_ENCRYPTOR_LIBS} ${SYSTEM_ENCRYPTOR_LIBS} )
 
+# Add benchmark executable
+set(AK_BENCH_NAME "ak-bench")
+
+add_executable(${AK_BENCH_NAME} ${AK_BENCH_SRC})
+
+target_include_directories(${AK_BENCH_NAME} PUBLIC ${AK_ENCRYPTOR_INCLUDE_DIRS})
+target_link_directories(${AK_BENCH_NAME} PUBLIC ${AK_ENCRYPTOR_INCLUDE_DIRS})
+target_link_libraries(${AK_BENCH_NAME} ${AK_PROCESSOR_LIB} ${SYSTEM_ENCRYPTOR_LIBS} )
+
 # Install desktop file and icons
 install(FILES ${APPLICATION_PATH} DESTINATION /usr/share/applications)
 install(DIRECTORY ${ICON_FOLDER} DESTINATION /usr/share/icons/hicolor)
@@ -0,0 +1,617 @@
+/**
+ * @file       <ak_bench.cpp>
+ * @brief      Замер производительности криптографической части ak-file-encryptor.
+ *
+ *             Измеряет скорость шифрования буферов, выработки ключа и обработки
+ *             файлов для magma и kuznechik при разных размерах данных и количестве
+ *             потоков. Результат выводится в JSON или CSV, чтобы его можно было
+ *             сравнивать между релизами.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "akr_container.hpp"
+#include "crypto_provider.hpp"
+#include "crypto_session.hpp"
+#include "ctr_engine.hpp"
+#include "file_stream.hpp"
+#include "kuznechik_kernel.hpp"
+#include "magma_kernel.hpp"
+#include "pipeline.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <libakrypt.h>
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Результат одного замера.
+ */
+struct BenchResult
+{
+    std::string benchmark;
+    std::string algorithm;
+    std::string variant;
+    size_t      size       = 0;
+    unsigned    threads    = 1;
+    size_t      iterations = 0;
+    double      mb_per_s   = 0.0;
+    double      p50_us     = 0.0;
+    double      p90_us     = 0.0;
+    double      p99_us     = 0.0;
+};
+
+/**
+ * @brief Параметры запуска.
+ */
+struct BenchOptions
+{
+    std::string              format = "json";
+    std::string              output;
+    std::vector<std::string> algorithms = {"magma", "kuznechik"};
+    bool                     quick = false;
+};
+
+/**
+ * @brief Выполняет операцию iterations раз и считает скорость и перцентили задержки.
+ *
+ * @param bytes Количество байт, обрабатываемых одним вызовом (0 - скорость не считается).
+ * @param iterations Количество повторов.
+ * @param operation Замеряемая операция.
+ * @param result Структура, в которую записываются результаты.
+ */
+static void measure(size_t bytes, size_t iterations, const std::function<void()>& operation, BenchResult& result)
+{
+    std::vector<double> latencies;
+    latencies.reserve(iterations);
+
+    operation(); ///< Прогрев: страничный кэш, аллокатор, таблицы libakrypt
+
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        operation();
+        const auto end = std::chrono::steady_clock::now();
+        latencies.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    }
+
+    double total_us = 0.0;
+    for (double latency : latencies)
+    {
+        total_us += latency;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    auto percentile = [&](double p)
+    {
+        const size_t index = std::min(latencies.size() - 1, static_cast<size_t>(p * static_cast<double>(latencies.size())));
+        return latencies[index];
+    };
+
+    result.iterations = iterations;
+    result.p50_us     = percentile(0.50);
+    result.p90_us     = percentile(0.90);
+    result.p99_us     = percentile(0.99);
+    result.mb_per_s   = (bytes && total_us > 0.0)
+                        ? static_cast<double>(bytes) * static_cast<double>(iterations) / total_us
+                        : 0.0;
+}
+
+/**
+ * @brief Подбирает количество повторов так, чтобы замер длился разумное время.
+ *
+ * @param size Размер данных одного повтора.
+ * @param quick Сокращенный режим.
+ * @return size_t Количество повторов.
+ */
+static size_t iterations_for(size_t size, bool quick)
+{
+    const size_t budget = quick ? (64u << 20) : (512u << 20);
+    return std::clamp<size_t>(budget / std::max<size_t>(size, 1), 5, quick ? 200 : 2000);
+}
+
+/**
+ * @brief Создает файл заданного размера со случайным содержимым.
+ *
+ * @param path Путь к файлу.
+ * @param size Размер файла.
+ */
+static void create_input_file(const fs::path& path, size_t size)
+{
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    std::vector<char> block(1 << 20);
+
+    for (size_t i = 0; i < block.size(); ++i)
+    {
+        block[i] = static_cast<char>((i * 2654435761u) >> 13);
+    }
+
+    for (size_t written = 0; written < size; written += block.size())
+    {
+        ofs.write(block.data(), static_cast<std::streamsize>(std::min(block.size(), size - written)));
+    }
+}
+
+/**
+ * @brief Замеряет режим CTR KuznechikKernel для каждого доступного варианта.
+ *
+ * Эта функция по очереди выбирает каждый вариант (переносимый, SSE4.1,
+ * AVX-512), а после замеров возвращает вариант, выбранный автоматически.
+ *
+ * @param sizes Размеры буферов.
+ * @param options Параметры запуска.
+ * @param results Вектор, в который добавляются результаты.
+ */
+static void bench_kuznechik_kernel(const std::vector<size_t>& sizes, const BenchOptions& options, std::vector<BenchResult>& results)
+{
+    const std::string selected = KuznechikKernel::isa();
+
+    ak_uint8 secret[KUZNECHIK_KEY_SIZE];
+    ak_uint8 iv[KUZNECHIK_IV_SIZE] = {0};
+    for (size_t i = 0; i < sizeof(secret); ++i)
+    {
+        secret[i] = static_cast<ak_uint8>(i * 7 + 1);
+    }
+
+    const KuznechikKernel kernel(secret);
+
+    for (const auto& isa : KuznechikKernel::supported_isas())
+    {
+        KuznechikKernel::select_isa(isa);
+
+        for (size_t size : sizes)
+        {
+            std::vector<ak_uint8> buffer(size, 0x5a);
+            ak_uint8 counter[KUZNECHIK_BLOCK_SIZE];
+
+            BenchResult result;
+            result.benchmark = "encrypt_buffer";
+            result.algorithm = "kuznechik";
+            result.variant   = "ctr_" + isa;
+            result.size      = size;
+
+            measure(size, iterations_for(size, options.quick), [&]()
+            {
+                KuznechikKernel::ctr_counter(iv, counter);
+                kernel.ctr(buffer.data(), buffer.data(), size, counter);
+            }, result);
+
+            results.push_back(result);
+        }
+    }
+
+    KuznechikKernel::select_isa(selected);
+}
+
+/**
+ * @brief Замеряет MagmaKernel для каждого доступного варианта.
+ *
+ * Для OFB буфер делится на MagmaKernel::lanes() независимых потоков,
+ * как группа фрагментов контейнера, для CTR шифруется одним потоком.
+ *
+ * @param sizes Размеры буферов.
+ * @param options Параметры запуска.
+ * @param results Вектор, в который добавляются результаты.
+ */
+static void bench_magma_kernel(const std::vector<size_t>& sizes, const BenchOptions& options, std::vector<BenchResult>& results)
+{
+    const std::string selected = MagmaKernel::isa();
+
+    ak_uint8 secret[MAGMA_KEY_SIZE];
+    ak_uint8 iv[MAGMA_BLOCK_SIZE] = {0};
+    for (size_t i = 0; i < sizeof(secret); ++i)
+    {
+        secret[i] = static_cast<ak_uint8>(i * 7 + 1);
+    }
+
+    const MagmaKernel kernel(secret);
+
+    for (const auto& isa : MagmaKernel::supported_isas())
+    {
+        MagmaKernel::select_isa(isa);
+
+        for (size_t size : sizes)
+        {
+            std::vector<ak_uint8> buffer(size, 0x5a);
+            ak_uint8 counter[MAGMA_BLOCK_SIZE];
+
+            const size_t count  = MagmaKernel::lanes();
+            const size_t stride = (size + count - 1) / count;
+            std::vector<MagmaStream> streams;
+            for (size_t offset = 0; offset < size; offset += stride)
+            {
+                MagmaStream stream;
+                stream.in   = buffer.data() + offset;
+                stream.out  = buffer.data() + offset;
+                stream.size = std::min(stride, size - offset);
+                stream.iv   = iv;
+                streams.push_back(stream);
+            }
+
+            BenchResult ofb;
+            ofb.benchmark = "encrypt_buffer";
+            ofb.algorithm = "magma";
+            ofb.variant   = "ofb_streams_" + isa;
+            ofb.size      = size;
+
+            measure(size, iterations_for(size, options.quick), [&]()
+            {
+                kernel.ofb(streams.data(), streams.size());
+            }, ofb);
+
+            results.push_back(ofb);
+
+            BenchResult ctr;
+            ctr.benchmark = "encrypt_buffer";
+            ctr.algorithm = "magma";
+            ctr.variant   = "ctr_" + isa;
+            ctr.size      = size;
+
+            measure(size, iterations_for(size, options.quick), [&]()
+            {
+                MagmaKernel::ctr_counter(iv, counter);
+                kernel.ctr(buffer.data(), buffer.data(), size, counter);
+            }, ctr);
+
+            results.push_back(ctr);
+        }
+    }
+
+    MagmaKernel::select_isa(selected);
+}
+
+/**
+ * @brief Замеряет шифрование буферов в памяти.
+ *
+ * @param options Параметры запуска.
+ * @param results Вектор, в который добавляются результаты.
+ */
+static void bench_buffers(const BenchOptions& options, std::vector<BenchResult>& results)
+{
+    const std::vector<size_t> sizes = options.quick
+        ? std::vector<size_t>{4096, 1 << 20}
+        : std::vector<size_t>{512, 4096, 65536, 1 << 20, 16 << 20};
+
+    for (const auto& algorithm : options.algorithms)
+    {
+        struct bckey key;
+        if (CryptoProvider::generate_key_from_password("ak-bench", "", &key, algorithm) != EXIT_SUCCESS)
+        {
+            continue;
+        }
+
+        for (size_t size : sizes)
+        {
+            std::vector<ak_uint8> buffer(size, 0x5a);
+
+            BenchResult result;
+            result.benchmark = "encrypt_buffer";
+            result.algorithm = algorithm;
+            result.variant   = "ofb";
+            result.size      = size;
+
+            measure(size, iterations_for(size, options.quick), [&]()
+            {
+                CryptoProvider::encrypt(buffer.data(), size, &key);
+            }, result);
+
+            results.push_back(result);
+        }
+
+        ak_bckey_destroy(&key);
+    }
+
+    if (std::find(options.algorithms.begin(), options.algorithms.end(), "kuznechik") != options.algorithms.end())
+    {
+        bench_kuznechik_kernel(sizes, options, results);
+    }
+
+    if (std::find(options.algorithms.begin(), options.algorithms.end(), "magma") != options.algorithms.end())
+    {
+        bench_magma_kernel(sizes, options, results);
+    }
+}
+
+/**
+ * @brief Замеряет выработку ключа из пароля: полную (PBKDF2) и из кэша CryptoSession.
+ *
+ * @param options Параметры запуска.
+ * @param results Вектор, в который добавляются результаты.
+ */
+static void bench_key_derivation(const BenchOptions& options, std::vector<BenchResult>& results)
+{
+    for (const auto& algorithm : options.algorithms)
+    {
+        BenchResult result;
+        result.benchmark = "key_derivation";
+        result.algorithm = algorithm;
+        result.variant   = "pbkdf2";
+
+        measure(0, options.quick ? 5 : 20, [&]()
+        {
+            struct bckey key;
+            if (CryptoProvider::generate_key_from_password("ak-bench", "ak-bench-salt", &key, algorithm) == EXIT_SUCCESS)
+            {
+                ak_bckey_destroy(&key);
+            }
+        }, result);
+
+        results.push_back(result);
+
+        BenchResult cached;
+        cached.benchmark = "key_derivation";
+        cached.algorithm = algorithm;
+        cached.variant   = "session_cache";
+
+        measure(0, options.quick ? 100 : 1000, [&]()
+        {
+            CryptoSession::instance().acquire_key("ak-bench", "ak-bench-salt", algorithm);
+        }, cached);
+
+        results.push_back(cached);
+    }
+}
+
+/**
+ * @brief Замеряет сохранение и обработку файлов всеми доступными способами.
+ *
+ * @param options Параметры запуска.
+ * @param directory Временный каталог для файлов.
+ * @param results Вектор, в который добавляются результаты.
+ */
+static void bench_files(const BenchOptions& options, const fs::path& directory, std::vector<BenchResult>& results)
+{
+    const std::vector<size_t> sizes = options.quick
+        ? std::vector<size_t>{16 << 20}
+        : std::vector<size_t>{16 << 20, 256 << 20, 1024u << 20};
+
+    const unsigned int max_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned int> thread_counts;
+    for (unsigned int threads = 1; threads < max_threads; threads *= 2)
+    {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    const fs::path input  = directory / "input.bin";
+    const fs::path output = directory / "output.bin";
+
+    for (size_t size : sizes)
+    {
+        create_input_file(input, size);
+        const size_t iterations = options.quick ? 3 : std::clamp<size_t>((2048u << 20) / size, 3, 20);
+
+        for (const auto& algorithm : options.algorithms)
+        {
+            struct bckey key;
+            if (CryptoProvider::generate_key_from_password("ak-bench", "", &key, algorithm) != EXIT_SUCCESS)
+            {
+                continue;
+            }
+
+            auto add = [&](const std::string& benchmark, const std::string& variant, unsigned int threads, const std::function<void()>& operation)
+            {
+                BenchResult result;
+                result.benchmark = benchmark;
+                result.algorithm = algorithm;
+                result.variant   = variant;
+                result.size      = size;
+                result.threads   = threads;
+                measure(size, iterations, operation, result);
+                results.push_back(result);
+            };
+
+            std::vector<ak_uint8> data(size, 0x5a);
+            add("file_save", "pwrite", 1, [&]() { CryptoProvider::ak_save_to_file(data.data(), size, output.string()); });
+            data = std::vector<ak_uint8>();
+
+            add("file_encrypt", "stream", 1, [&]() { FileStreamProcessor::process_file(input.string(), output.string(), &key); });
+            add("file_encrypt", "mmap", 1, [&]() { FileStreamProcessor::process_file_mapped(input.string(), output.string(), &key); });
+            add("file_encrypt", "pipeline_threads", 1, [&]()
+            {
+                PipelineProcessor::process_file(input.string(), output.string(), &key, PipelineProcessor::BACKEND_THREADS);
+            });
+
+            if (PipelineProcessor::is_io_uring_available())
+            {
+                add("file_encrypt", "pipeline_io_uring", 1, [&]()
+                {
+                    PipelineProcessor::process_file(input.string(), output.string(), &key, PipelineProcessor::BACKEND_IO_URING);
+                });
+            }
+
+            for (unsigned int threads : thread_counts)
+            {
+                add("file_encrypt", "ctr", threads, [&]()
+                {
+                    CtrEngine::process_file(input.string(), output.string(), "ak-bench", "", algorithm, threads);
+                });
+            }
+
+            for (const std::string mode : {"ofb", "ctr", "mgm"})
+            {
+                AkrOptions container_options;
+                container_options.algorithm = algorithm;
+                container_options.mode      = mode;
+                container_options.verify    = AKR_VERIFY_NONE;
+
+                add("akr_encrypt", mode, max_threads, [&]()
+                {
+                    AkrContainer::encrypt_file(input.string(), output.string(), "ak-bench", container_options);
+                });
+            }
+
+            for (const auto& [verify_name, verify] : {std::pair<const char*, AkrVerify>{"mgm_sampled", AKR_VERIFY_SAMPLED},
+                                                      std::pair<const char*, AkrVerify>{"mgm_full", AKR_VERIFY_FULL}})
+            {
+                AkrOptions container_options;
+                container_options.algorithm = algorithm;
+                container_options.verify    = verify;
+
+                add("akr_encrypt", verify_name, max_threads, [&]()
+                {
+                    AkrContainer::encrypt_file(input.string(), output.string(), "ak-bench", container_options);
+                });
+            }
+
+            add("akr_verify", "mgm", max_threads, [&]() { AkrContainer::authenticate_file(output.string(), "ak-bench"); });
+
+            ak_bckey_destroy(&key);
+        }
+    }
+
+    fs::remove(input);
+    fs::remove(output);
+}
+
+/**
+ * @brief Выводит результаты в формате JSON.
+ *
+ * @param stream Поток вывода.
+ * @param results Результаты замеров.
+ */
+static void write_json(std::ostream& stream, const std::vector<BenchResult>& results)
+{
+    stream << "{\n  \"tool\": \"ak-bench\",\n  \"hardware_threads\": " << std::thread::hardware_concurrency()
+           << ",\n  \"results\": [\n";
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const auto& r = results[i];
+        stream << "    {\"benchmark\": \"" << r.benchmark << "\", \"algorithm\": \"" << r.algorithm
+               << "\", \"variant\": \"" << r.variant << "\", \"size\": " << r.size
+               << ", \"threads\": " << r.threads << ", \"iterations\": " << r.iterations
+               << ", \"mb_per_s\": " << r.mb_per_s << ", \"p50_us\": " << r.p50_us
+               << ", \"p90_us\": " << r.p90_us << ", \"p99_us\": " << r.p99_us << "}"
+               << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+
+    stream << "  ]\n}\n";
+}
+
+/**
+ * @brief Выводит результаты в формате CSV.
+ *
+ * @param stream Поток вывода.
+ * @param results Результаты замеров.
+ */
+static void write_csv(std::ostream& stream, const std::vector<BenchResult>& results)
+{
+    stream << "benchmark,algorithm,variant,size,threads,iterations,mb_per_s,p50_us,p90_us,p99_us\n";
+
+    for (const auto& r : results)
+    {
+        stream << r.benchmark << "," << r.algorithm << "," << r.variant << "," << r.size << ","
+               << r.threads << "," << r.iterations << "," << r.mb_per_s << "," << r.p50_us << ","
+               << r.p90_us << "," << r.p99_us << "\n";
+    }
+}
+
+/**
+ * @brief Разбирает аргументы командной строки.
+ *
+ * @param argc Количество аргументов.
+ * @param argv Аргументы.
+ * @param options Структура для параметров.
+ * @return bool true, если аргументы корректны, иначе false.
+ */
+static bool parse_arguments(int argc, char** argv, BenchOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string argument = argv[i];
+
+        if (argument == "--format" && i + 1 < argc)
+        {
+            options.format = argv[++i];
+        }
+        else if (argument == "--output" && i + 1 < argc)
+        {
+            options.output = argv[++i];
+        }
+        else if (argument == "--algorithm" && i + 1 < argc)
+        {
+            options.algorithms = {argv[++i]};
+        }
+        else if (argument == "--quick")
+        {
+            options.quick = true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return options.format == "json" || options.format == "csv";
+}
+
+/**
+ * @brief Точка входа ak-bench.
+ *
+ * @param argc Количество аргументов.
+ * @param argv Аргументы.
+ * @return int 0 при успехе, 2 при неверных аргументах.
+ */
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+
+    if (!parse_arguments(argc, argv, options))
+    {
+        std::cerr << "Usage: ak-bench [--format json|csv] [--output FILE] [--algorithm magma|kuznechik] [--quick]" << std::endl;
+        return 2;
+    }
+
+    const fs::path directory = fs::temp_directory_path() / ("ak-bench-" + std::to_string(getpid()));
+    fs::create_directories(directory);
+
+    std::vector<BenchResult> results;
+    bench_key_derivation(options, results);
+    bench_buffers(options, results);
+    bench_files(options, directory, results);
+
+    fs::remove_all(directory);
+
+    std::ofstream file;
+    if (!options.output.empty())
+    {
+        file.open(options.output, std::ios::trunc);
+    }
+    std::ostream& stream = options.output.empty() ? std::cout : file;
+
+    if (options.format == "csv")
+    {
+        write_csv(stream, results);
+    }
+    else
+    {
+        write_json(stream, results);
+    }
+
+    return 0;
+}
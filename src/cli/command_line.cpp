@@ -0,0 +1,1125 @@
+/**
+ * @file       <command_line.cpp>
+ * @brief      Основной файл неинтерактивного режима ak-file-encryptor.
+ *
+ *             Позволяет запускать шифрование из скриптов и планировщиков:
+ *             ключевой материал берется из переменной окружения, файла или
+ *             дескриптора, а пакет операций описывается файлом-манифестом.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "command_line.hpp"
+#include "akr_archive.hpp"
+#include "akr_container.hpp"
+#include "akr_incremental.hpp"
+#include "akr_reader.hpp"
+#include "akr_store.hpp"
+#include "buffer_pool.hpp"
+#include "crypto_provider.hpp"
+#include "crypto_session.hpp"
+#include "ctr_engine.hpp"
+#include "directory_job.hpp"
+#include "file_stream.hpp"
+#include "job_stats.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Точка входа неинтерактивного режима.
+ *
+ * Эта функция разбирает аргументы, получает ключевой материал и выполняет
+ * одну команду или все команды из манифеста. Ключи берутся из CryptoSession,
+ * поэтому для одинаковых пароля и соли выработка выполняется один раз.
+ *
+ * @param argc Количество аргументов.
+ * @param argv Аргументы командной строки.
+ * @return int Код возврата: 0 - успех, 1 - ошибка хотя бы одной операции,
+ *         2 - неверные аргументы или ключевой материал.
+ */
+int CommandLine::run(int argc, char** argv)
+{
+    Options options;
+
+    if (!parseArguments(argc, argv, options))
+    {
+        printUsage();
+        return 2;
+    }
+
+    if (options.command == CMD_HELP)
+    {
+        printUsage();
+        return 0;
+    }
+
+    BufferPool::instance().set_huge_pages(options.huge_pages);
+
+    if (options.command == CMD_INFO)
+    {
+        return showInfo(options.arguments) ? 0 : 1;
+    }
+
+    std::vector<Job> jobs;
+
+    if (options.command == CMD_BATCH)
+    {
+        if (options.arguments.size() != 1 || !loadManifest(options.arguments[0], jobs))
+        {
+            return 2;
+        }
+    }
+    else if (options.command == CMD_READ)
+    {
+        if (options.arguments.size() != 1)
+        {
+            printUsage();
+            return 2;
+        }
+    }
+    else if (options.command == CMD_ENCRYPT_DIR)
+    {
+        if (options.arguments.size() != 2 || options.legacy)
+        {
+            printUsage();
+            return 2;
+        }
+    }
+    else if (options.command == CMD_PACK || options.command == CMD_UNPACK || options.command == CMD_LIST)
+    {
+        if (options.arguments.size() != 1 || options.legacy)
+        {
+            printUsage();
+            return 2;
+        }
+    }
+    else if (options.command == CMD_STORE || options.command == CMD_RESTORE)
+    {
+        const size_t count = options.arguments.size();
+        const bool single  = (options.command == CMD_RESTORE || count == 2);
+        if (count < 2 || (options.command == CMD_RESTORE && count != 2) || (!single && !options.output.empty()) || options.legacy)
+        {
+            printUsage();
+            return 2;
+        }
+    }
+    else
+    {
+        const bool verify = (options.command == CMD_VERIFY);
+        const size_t count = options.arguments.size();
+        if (count < 1 || count > (verify ? 2u : 1u) || (verify && !options.output.empty()))
+        {
+            printUsage();
+            return 2;
+        }
+
+        Job job;
+        job.command = options.command;
+        job.input   = options.arguments[0];
+        job.output  = verify ? (count == 2 ? options.arguments[1] : "") : options.output;
+        jobs.push_back(job);
+    }
+
+    std::string password;
+    if (!readKeyMaterial(options, password))
+    {
+        return 2;
+    }
+
+    if (options.command == CMD_READ || options.command == CMD_ENCRYPT_DIR || options.command == CMD_PACK ||
+        options.command == CMD_UNPACK || options.command == CMD_LIST || options.command == CMD_STORE ||
+        options.command == CMD_RESTORE)
+    {
+        const StatsSnapshot start = JobStats::begin();
+        bool result = false;
+
+        if (options.command == CMD_READ)
+        {
+            result = readRange(options, password);
+        }
+        else if (options.command == CMD_ENCRYPT_DIR)
+        {
+            result = encryptTree(options, password);
+        }
+        else if (options.command == CMD_PACK || options.command == CMD_UNPACK || options.command == CMD_LIST)
+        {
+            result = runArchive(options, password);
+        }
+        else
+        {
+            result = runStore(options, password);
+        }
+
+        const std::string& output = (options.command == CMD_ENCRYPT_DIR) ? options.arguments[1] : options.output;
+        writeStats(options, {options.command_name, options.arguments[0], output, result}, start);
+        return result ? 0 : 1;
+    }
+
+    auto key = options.legacy ? CryptoSession::instance().acquire_key(password, "", options.algorithm)
+                              : CryptoSession::KeyHandle(nullptr, [](struct bckey*) noexcept {});
+    if (options.legacy && !key)
+    {
+        return 2;
+    }
+
+    size_t failed = 0;
+
+    for (const auto& job : jobs)
+    {
+        const StatsSnapshot start = JobStats::begin();
+        const bool result = runJob(job, options, password, key.get());
+
+        const char *operation = (job.command == CMD_ENCRYPT) ? "encrypt" : (job.command == CMD_DECRYPT ? "decrypt" : "verify");
+        writeStats(options, {operation, job.input, job.output, result}, start);
+
+        if (!result)
+        {
+            ++failed;
+            if (!options.keep_going)
+            {
+                break;
+            }
+        }
+    }
+
+    if (jobs.size() > 1)
+    {
+        std::cout << "Done: " << jobs.size() - failed << " ok, " << failed << " failed" << std::endl;
+    }
+
+    return failed == 0 ? 0 : 1;
+}
+
+/**
+ * @brief Выводит параметры контейнеров и проверяет хэши их фрагментов.
+ *
+ * Пароль для этой команды не нужен: заголовок хранится открыто,
+ * а хэши считаются от зашифрованных данных. Имитовставки контейнеров MGM
+ * без ключа проверить нельзя, для них выводятся только параметры.
+ *
+ * @param files Пути к контейнерам.
+ * @return bool true, если все файлы являются целыми контейнерами, иначе false.
+ */
+bool CommandLine::showInfo(const std::vector<std::string>& files)
+{
+    if (files.empty())
+    {
+        printUsage();
+        return false;
+    }
+
+    bool result = true;
+
+    for (const auto& file : files)
+    {
+        AkrHeader header;
+        int fd = open(file.c_str(), O_RDONLY);
+        const bool has_header = (fd >= 0) && AkrContainer::read_header(fd, header);
+
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+
+        if (!has_header)
+        {
+            std::cout << file << ": not an AKR v2 container (legacy raw file?)" << std::endl;
+            result = false;
+            continue;
+        }
+
+        std::cout << file << ":\n" << AkrContainer::describe(header);
+
+        if (header.flags & AKR_FLAG_STORE)
+        {
+            continue;
+        }
+
+        if (header.mode == AKR_MODE_MGM)
+        {
+            std::cout << "Chunk tags:    MGM (run 'verify' with the key)" << std::endl;
+            continue;
+        }
+
+        const bool intact = AkrContainer::check_digests(file);
+        std::cout << "Chunk digests: " << (intact ? "ok" : "MISMATCH") << std::endl;
+
+        result = result && intact;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Расшифровывает участок контейнера в файл или стандартный вывод.
+ *
+ * Через AkrReader расшифровываются только фрагменты, покрывающие
+ * диапазон [--offset, --offset + --length). Без --length участок
+ * продолжается до конца данных.
+ *
+ * @param options Разобранные параметры командной строки.
+ * @param password Пароль, из которого вырабатывается ключ.
+ * @return bool true, если участок прочитан и записан, иначе false.
+ */
+bool CommandLine::readRange(const Options& options, const std::string& password)
+{
+    AkrReader reader;
+    if (!reader.open(options.arguments[0], password))
+    {
+        return false;
+    }
+
+    if (options.offset > reader.size())
+    {
+        std::cerr << "Offset is beyond the end of data: " << reader.size() << std::endl;
+        return false;
+    }
+
+    std::ofstream file;
+    if (!options.output.empty())
+    {
+        file.open(options.output, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            std::cerr << "Cannot open output file: " << options.output << std::endl;
+            return false;
+        }
+    }
+
+    std::ostream& output = options.output.empty() ? std::cout : file;
+    const std::uint64_t end = options.offset + std::min(options.length, reader.size() - options.offset);
+    std::vector<ak_uint8> buffer;
+
+    for (std::uint64_t position = options.offset; position < end; position += buffer.size())
+    {
+        const size_t length = static_cast<size_t>(std::min<std::uint64_t>(reader.header().chunk_size, end - position));
+
+        if (!reader.read(position, length, buffer) || buffer.empty())
+        {
+            return false;
+        }
+
+        output.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    }
+
+    output.flush();
+    return static_cast<bool>(output);
+}
+
+/**
+ * @brief Шифрует каталог в выходное дерево контейнеров .akr.
+ *
+ * Исходные файлы не изменяются. Ошибка в одном файле не останавливает
+ * задание, список неудачных файлов выводится в конце.
+ *
+ * @param options Разобранные параметры командной строки.
+ * @param password Пароль, из которого вырабатывается ключ.
+ * @return bool true, если зашифрованы все файлы, иначе false.
+ */
+bool CommandLine::encryptTree(const Options& options, const std::string& password)
+{
+    AkrOptions container_options;
+    container_options.algorithm   = options.algorithm;
+    container_options.mode        = options.mode.empty() ? container_options.mode : options.mode;
+    container_options.compression = options.compress;
+    container_options.level       = options.level;
+    container_options.threads     = options.threads;
+    AkrContainer::parse_verify(options.verify, container_options.verify);
+
+    DirectoryJobResult result;
+    const bool success = DirectoryJob::encrypt_tree(options.arguments[0], options.arguments[1], password, container_options, result);
+
+    for (const auto& file : result.failures)
+    {
+        std::cout << "FAIL encrypt " << file << std::endl;
+    }
+
+    std::cout << "Done: " << result.files - result.failed << " ok, " << result.failed << " failed, "
+              << result.bytes << " bytes, " << result.tasks << " tasks, " << result.steals << " stolen" << std::endl;
+
+    return success;
+}
+
+/**
+ * @brief Упаковывает каталог в архив, извлекает файлы или выводит оглавление.
+ *
+ * pack записывает архив во временный файл и переименовывает его только
+ * после успешной проверки. Без -o архив называется <каталог>.akr,
+ * а unpack извлекает файлы в текущий каталог.
+ *
+ * @param options Разобранные параметры командной строки.
+ * @param password Пароль, из которого вырабатывается ключ.
+ * @return bool true, если операция прошла успешно, иначе false.
+ */
+bool CommandLine::runArchive(const Options& options, const std::string& password)
+{
+    const std::string& archive = options.arguments[0];
+
+    if (options.command == CMD_LIST)
+    {
+        std::vector<AkrArchiveMember> members;
+        if (!AkrArchive::list(archive, password, members))
+        {
+            return false;
+        }
+
+        for (const auto& member : members)
+        {
+            std::cout << member.size << "\t" << member.name << std::endl;
+        }
+        return true;
+    }
+
+    if (options.command == CMD_UNPACK)
+    {
+        const bool result = AkrArchive::extract(archive, password, options.output.empty() ? "." : options.output, options.member);
+        std::cout << (result ? "OK   " : "FAIL ") << "unpack " << archive << std::endl;
+        return result;
+    }
+
+    AkrOptions container_options;
+    container_options.algorithm   = options.algorithm;
+    container_options.mode        = options.mode.empty() ? container_options.mode : options.mode;
+    container_options.compression = options.compress;
+    container_options.level       = options.level;
+    container_options.threads     = options.threads;
+    AkrContainer::parse_verify(options.verify, container_options.verify);
+
+    std::string output_file = options.output;
+    if (output_file.empty())
+    {
+        std::error_code path_error;
+        fs::path path = fs::weakly_canonical(archive, path_error);
+        path.replace_filename(path.filename().string() + DIRECTORY_JOB_SUFFIX);
+        output_file = path.string();
+    }
+    const std::string partial_file = output_file + ".part";
+
+    size_t count = 0;
+    std::error_code error;
+    bool result = AkrArchive::pack(archive, partial_file, password, container_options, &count);
+
+    if (result)
+    {
+        fs::rename(partial_file, output_file, error);
+        result = !error;
+    }
+
+    if (!result)
+    {
+        fs::remove(partial_file, error);
+    }
+
+    std::cout << (result ? "OK   " : "FAIL ") << "pack " << archive << " -> " << output_file
+              << " (" << count << " files)" << std::endl;
+    return result;
+}
+
+/**
+ * @brief Помещает файлы в хранилище фрагментов или восстанавливает файл по описи.
+ *
+ * store помещает файлы по очереди и фиксирует хранилище один раз в конце:
+ * описи <файл>.akref (или -o для одного файла) появляются только после
+ * того, как записаны все фрагменты и индекс. Без --keep-going первая
+ * ошибка прекращает помещение, но уже помещенные файлы фиксируются.
+ * restore пишет результат во временный файл; без -o файл восстанавливается
+ * рядом с описью под именем без суффикса .akref.
+ *
+ * @param options Разобранные параметры командной строки.
+ * @param password Пароль, из которого вырабатывается ключ.
+ * @return bool true, если операция прошла успешно для всех файлов, иначе false.
+ */
+bool CommandLine::runStore(const Options& options, const std::string& password)
+{
+    const std::string& store_dir = options.arguments[0];
+    std::error_code error;
+
+    if (options.command == CMD_RESTORE)
+    {
+        const std::string& ref_file = options.arguments[1];
+        const std::string  suffix   = AKR_STORE_REF_SUFFIX;
+        const bool has_suffix = ref_file.size() > suffix.size() &&
+                                ref_file.compare(ref_file.size() - suffix.size(), suffix.size(), suffix) == 0;
+
+        if (options.output.empty() && !has_suffix)
+        {
+            std::cerr << "Output file is required for a reference without the " << suffix << " suffix" << std::endl;
+            return false;
+        }
+
+        const std::string output_file  = options.output.empty() ? ref_file.substr(0, ref_file.size() - suffix.size()) : options.output;
+        const std::string partial_file = output_file + ".part";
+
+        bool result = AkrStore::restore(store_dir, ref_file, partial_file, password, options.threads);
+
+        if (result)
+        {
+            fs::rename(partial_file, output_file, error);
+            result = !error;
+        }
+
+        if (!result)
+        {
+            fs::remove(partial_file, error);
+        }
+
+        std::cout << (result ? "OK   " : "FAIL ") << "restore " << ref_file << " -> " << output_file << std::endl;
+        return result;
+    }
+
+    AkrOptions container_options;
+    container_options.algorithm   = options.algorithm;
+    container_options.mode        = options.mode.empty() ? container_options.mode : options.mode;
+    container_options.compression = options.compress;
+    container_options.level       = options.level;
+    container_options.threads     = options.threads;
+    AkrContainer::parse_verify(options.verify, container_options.verify);
+
+    AkrStore store;
+    if (!store.open(store_dir, password, container_options))
+    {
+        std::cout << "FAIL store " << store_dir << std::endl;
+        return false;
+    }
+
+    struct Entry
+    {
+        std::string    input;
+        std::string    ref;
+        AkrStoreResult stats;
+        bool           stored = false;
+    };
+
+    std::vector<Entry> entries;
+    size_t failed = 0;
+
+    for (size_t i = 1; i < options.arguments.size(); ++i)
+    {
+        Entry entry;
+        entry.input = options.arguments[i];
+        entry.ref   = options.output.empty() ? entry.input + AKR_STORE_REF_SUFFIX : options.output;
+
+        entry.stored = fs::is_regular_file(entry.input, error) && store.put(entry.input, entry.ref, entry.stats);
+        entries.push_back(entry);
+
+        if (!entry.stored)
+        {
+            ++failed;
+            if (!options.keep_going)
+            {
+                break;
+            }
+        }
+    }
+
+    const bool committed = store.commit();
+    size_t chunks = 0;
+    size_t stored = 0;
+    std::uint64_t written = 0;
+
+    for (const auto& entry : entries)
+    {
+        const bool result = entry.stored && committed;
+
+        std::cout << (result ? "OK   " : "FAIL ") << "store " << entry.input << " -> " << entry.ref;
+        if (result)
+        {
+            std::cout << " (" << entry.stats.stored << " of " << entry.stats.chunks << " chunks new, "
+                      << entry.stats.written << " bytes written)";
+
+            chunks  += entry.stats.chunks;
+            stored  += entry.stats.stored;
+            written += entry.stats.written;
+        }
+        std::cout << std::endl;
+    }
+
+    if (!committed)
+    {
+        failed = entries.size();
+    }
+
+    std::cout << "Done: " << entries.size() - failed << " ok, " << failed << " failed, "
+              << stored << " of " << chunks << " chunks new, " << written << " bytes written, "
+              << store.chunk_count() << " chunks in store" << std::endl;
+
+    return failed == 0 && entries.size() + 1 == options.arguments.size();
+}
+
+/**
+ * @brief Разбирает аргументы командной строки.
+ *
+ * @param argc Количество аргументов.
+ * @param argv Аргументы командной строки.
+ * @param options Структура, в которую записываются разобранные параметры.
+ * @return bool true, если аргументы корректны, иначе false.
+ *
+ * @note Пароль намеренно нельзя передать аргументом: он был бы виден всем
+ * пользователям системы через список процессов.
+ */
+bool CommandLine::parseArguments(int argc, char** argv, Options& options)
+{
+    if (argc < 2)
+    {
+        return false;
+    }
+
+    options.command      = parseCommand(argv[1]);
+    options.command_name = argv[1];
+    if (options.command == CMD_NONE)
+    {
+        std::cerr << "Unknown command: " << argv[1] << std::endl;
+        return false;
+    }
+
+    for (int i = 2; i < argc; ++i)
+    {
+        const std::string argument = argv[i];
+        const bool has_value = (i + 1 < argc);
+
+        if ((argument == "-o" || argument == "--output") && has_value)
+        {
+            options.output = argv[++i];
+        }
+        else if (argument == "--key-env" && has_value)
+        {
+            options.key_env = argv[++i];
+        }
+        else if (argument == "--key-file" && has_value)
+        {
+            options.key_file = argv[++i];
+        }
+        else if (argument == "--key-fd" && has_value)
+        {
+            options.key_fd = std::atoi(argv[++i]);
+        }
+        else if (argument == "--algorithm" && has_value)
+        {
+            options.algorithm = argv[++i];
+        }
+        else if (argument == "--mode" && has_value)
+        {
+            options.mode = argv[++i];
+        }
+        else if (argument == "--threads" && has_value)
+        {
+            options.threads = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (argument == "--keep-going")
+        {
+            options.keep_going = true;
+        }
+        else if (argument == "--verify" && has_value)
+        {
+            options.verify = argv[++i];
+        }
+        else if (argument == "--compress" && has_value)
+        {
+            options.compress = argv[++i];
+        }
+        else if (argument == "--level" && has_value)
+        {
+            options.level = std::atoi(argv[++i]);
+        }
+        else if (argument == "--legacy")
+        {
+            options.legacy = true;
+        }
+        else if (argument == "--incremental")
+        {
+            options.incremental = true;
+        }
+        else if (argument == "--huge-pages")
+        {
+            options.huge_pages = true;
+        }
+        else if (argument == "--offset" && has_value)
+        {
+            options.offset = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (argument == "--length" && has_value)
+        {
+            options.length = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (argument == "--member" && has_value)
+        {
+            options.member = argv[++i];
+        }
+        else if (argument == "--stats" && has_value)
+        {
+            options.stats = argv[++i];
+        }
+        else if (!argument.empty() && argument[0] == '-')
+        {
+            std::cerr << "Unknown option: " << argument << std::endl;
+            return false;
+        }
+        else
+        {
+            options.arguments.push_back(argument);
+        }
+    }
+
+    if (options.algorithm != "magma" && options.algorithm != "kuznechik")
+    {
+        std::cerr << "Unsupported algorithm: " << options.algorithm << std::endl;
+        return false;
+    }
+
+    if (!options.mode.empty() && options.mode != "ofb" && options.mode != "ctr" && options.mode != "mgm")
+    {
+        std::cerr << "Unsupported mode: " << options.mode << std::endl;
+        return false;
+    }
+
+    AkrVerify verify = AKR_VERIFY_NONE;
+    if (!AkrContainer::parse_verify(options.verify, verify))
+    {
+        std::cerr << "Unsupported verification level: " << options.verify << std::endl;
+        return false;
+    }
+
+    if (options.compress != "none" && options.compress != "zlib")
+    {
+        std::cerr << "Unsupported compression: " << options.compress << std::endl;
+        return false;
+    }
+
+    if (options.level < 1 || options.level > 9)
+    {
+        std::cerr << "Compression level must be between 1 and 9: " << options.level << std::endl;
+        return false;
+    }
+
+    if (options.legacy && options.incremental)
+    {
+        std::cerr << "Incremental updates require the AKR v2 container and cannot be used with --legacy" << std::endl;
+        return false;
+    }
+
+    if (options.legacy && options.compress != "none")
+    {
+        std::cerr << "Compression requires the AKR v2 container and cannot be used with --legacy" << std::endl;
+        return false;
+    }
+
+    if (options.legacy && options.mode == "mgm")
+    {
+        std::cerr << "MGM requires the AKR v2 container and cannot be used with --legacy" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Получает ключевой материал (пароль) из указанного источника.
+ *
+ * Поддерживаются переменная окружения (--key-env), файл (--key-file)
+ * и открытый дескриптор (--key-fd). Должен быть указан ровно один источник.
+ * Завершающие символы перевода строки отбрасываются.
+ *
+ * @param options Разобранные параметры командной строки.
+ * @param password Строка, в которую записывается пароль.
+ * @return bool true, если пароль получен и не пуст, иначе false.
+ */
+bool CommandLine::readKeyMaterial(const Options& options, std::string& password)
+{
+    const int sources = !options.key_env.empty() + !options.key_file.empty() + (options.key_fd >= 0);
+    if (sources != 1)
+    {
+        std::cerr << "Exactly one of --key-env, --key-file or --key-fd is required" << std::endl;
+        return false;
+    }
+
+    if (!options.key_env.empty())
+    {
+        const char* value = std::getenv(options.key_env.c_str());
+        if (value)
+        {
+            password = value;
+        }
+    }
+    else if (!options.key_file.empty())
+    {
+        std::ifstream ifs(options.key_file, std::ios::binary);
+        if (!ifs)
+        {
+            std::cerr << "Cannot open key file: " << options.key_file << std::endl;
+            return false;
+        }
+        password.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    }
+    else
+    {
+        char buffer[256];
+        ssize_t result = 0;
+        while ((result = read(options.key_fd, buffer, sizeof(buffer))) > 0)
+        {
+            password.append(buffer, static_cast<size_t>(result));
+        }
+        std::memset(buffer, 0, sizeof(buffer));
+    }
+
+    while (!password.empty() && (password.back() == '\n' || password.back() == '\r'))
+    {
+        password.pop_back();
+    }
+
+    if (password.empty())
+    {
+        std::cerr << "Key material is empty" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Загружает манифест пакетной обработки.
+ *
+ * Каждая непустая строка манифеста, не начинающаяся с '#', описывает одну операцию:
+ * @code
+ * encrypt <input> [output]
+ * decrypt <input> [output]
+ * verify  <input> <encrypted>
+ * @endcode
+ * Пути, содержащие пробелы, заключаются в двойные кавычки.
+ *
+ * @param path Путь к файлу манифеста.
+ * @param jobs Вектор, в который добавляются операции.
+ * @return bool true, если манифест разобран без ошибок, иначе false.
+ */
+bool CommandLine::loadManifest(const std::string& path, std::vector<Job>& jobs)
+{
+    std::ifstream ifs(path);
+    if (!ifs)
+    {
+        std::cerr << "Cannot open manifest: " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    size_t line_number = 0;
+
+    while (std::getline(ifs, line))
+    {
+        ++line_number;
+
+        const auto tokens = splitManifestLine(line);
+        if (tokens.empty() || tokens[0][0] == '#')
+        {
+            continue;
+        }
+
+        Job job;
+        job.command = parseCommand(tokens[0]);
+
+        const bool valid = (job.command == CMD_ENCRYPT || job.command == CMD_DECRYPT)
+                           ? (tokens.size() == 2 || tokens.size() == 3)
+                           : (job.command == CMD_VERIFY && (tokens.size() == 2 || tokens.size() == 3));
+
+        if (!valid)
+        {
+            std::cerr << path << ":" << line_number << ": invalid entry" << std::endl;
+            return false;
+        }
+
+        job.input  = tokens[1];
+        job.output = (tokens.size() == 3) ? tokens[2] : "";
+        jobs.push_back(std::move(job));
+    }
+
+    return true;
+}
+
+/**
+ * @brief Выполняет одну операцию.
+ *
+ * Результат шифрования или расшифрования сначала пишется во временный файл
+ * с суффиксом .part и переименовывается только после успешного завершения,
+ * поэтому прерванный запуск не оставляет недописанных файлов результата.
+ * Проверка одного файла (без открытого текста) с --legacy не выполняется:
+ * у файлов старого формата нет ни заголовка, ни имитовставок.
+ *
+ * @param job Описание операции.
+ * @param options Разобранные параметры командной строки.
+ * @param password Пароль (нужен многопоточному режиму CTR).
+ * @param key Ключ, выработанный из пароля (используется в режиме OFB).
+ * @return bool true, если операция выполнена успешно, иначе false.
+ */
+bool CommandLine::runJob(const Job& job, const Options& options, const std::string& password, struct bckey *key)
+{
+    const bool use_ctr = (options.mode == "ctr");
+    bool result = false;
+
+    if (job.command == CMD_VERIFY)
+    {
+        if (job.output.empty() && options.legacy)
+        {
+            // В файле без заголовка нет имитовставок, сверить его можно только с открытым файлом
+            std::cout << "FAIL verify " << job.input << " (raw files need the original: verify <input> <encrypted> --legacy)" << std::endl;
+            return false;
+        }
+
+        if (job.output.empty())
+        {
+            result = AkrContainer::authenticate_file(job.input, password, options.threads);
+        }
+        else if (!options.legacy)
+        {
+            result = AkrContainer::verify_file(job.input, job.output, password, options.threads, options.algorithm);
+        }
+        else
+        {
+            result = use_ctr ? CtrEngine::verify_file(job.input, job.output, password, "", options.algorithm, options.threads)
+                             : FileStreamProcessor::verify_file(job.input, job.output, key);
+        }
+
+        std::cout << (result ? "OK   " : "FAIL ") << "verify " << job.input
+                  << (job.output.empty() ? "" : " ") << job.output << std::endl;
+        return result;
+    }
+
+    const std::string output_file  = job.output.empty() ? CryptoProvider::get_output_path(job.input) : job.output;
+    const std::string partial_file = output_file + ".part";
+
+    std::error_code error;
+    if (!fs::is_regular_file(job.input, error))
+    {
+        std::cout << "FAIL " << (job.command == CMD_ENCRYPT ? "encrypt " : "decrypt ") << job.input << " (not a regular file)" << std::endl;
+        return false;
+    }
+
+    if (options.legacy)
+    {
+        result = use_ctr ? CtrEngine::process_file(job.input, partial_file, password, "", options.algorithm, options.threads)
+                         : FileStreamProcessor::process_file_auto(job.input, partial_file, key);
+    }
+    else
+    {
+        AkrOptions container_options;
+        container_options.algorithm   = options.algorithm;
+        container_options.mode        = options.mode.empty() ? container_options.mode : options.mode;
+        container_options.compression = options.compress;
+        container_options.level       = options.level;
+        container_options.threads     = options.threads;
+        AkrContainer::parse_verify(options.verify, container_options.verify);
+
+        if (job.command == CMD_ENCRYPT && options.incremental)
+        {
+            return updateIncremental(job.input, output_file, password, container_options);
+        }
+
+        result = (job.command == CMD_ENCRYPT)
+            ? AkrContainer::encrypt_file(job.input, partial_file, password, container_options)
+            : AkrContainer::decrypt_file(job.input, partial_file, password, container_options);
+    }
+
+    if (result)
+    {
+        fs::rename(partial_file, output_file, error);
+        result = !error;
+    }
+
+    if (!result)
+    {
+        fs::remove(partial_file, error);
+    }
+
+    std::cout << (result ? "OK   " : "FAIL ") << (job.command == CMD_ENCRYPT ? "encrypt " : "decrypt ")
+              << job.input << " -> " << output_file << std::endl;
+    return result;
+}
+
+/**
+ * @brief Записывает статистику завершенного задания в файл JSON.
+ *
+ * Путь берется из --stats, а без него - из переменной окружения
+ * AK_STATS_FILE; если не задан ни один, файл не пишется. Файл
+ * перезаписывается после каждого задания пакета.
+ *
+ * @param options Разобранные параметры.
+ * @param report Описание задания.
+ * @param start Снимок счетчиков на начало задания (JobStats::begin).
+ */
+void CommandLine::writeStats(const Options& options, const JobReport& report, const StatsSnapshot& start)
+{
+    const std::string path = options.stats.empty() ? JobStats::default_path() : options.stats;
+    if (path.empty())
+    {
+        return;
+    }
+
+    JobStats::write_json(path, report, JobStats::snapshot().since(start));
+}
+
+/**
+ * @brief Обновляет контейнер, перешифровывая только изменившиеся фрагменты.
+ *
+ * Контейнер изменяется на месте, а не через временный файл: новый
+ * заголовок записывается последним, поэтому прерванное обновление
+ * оставляет предыдущую версию контейнера.
+ *
+ * @param input_file Путь к исходному файлу.
+ * @param output_file Путь к контейнеру.
+ * @param password Пароль, из которого вырабатывается ключ.
+ * @param container_options Параметры контейнера.
+ * @return bool true, если контейнер обновлен, иначе false.
+ */
+bool CommandLine::updateIncremental(const std::string& input_file,
+                                    const std::string& output_file,
+                                    const std::string& password,
+                                    const AkrOptions& container_options)
+{
+    AkrIncrementalResult stats;
+    const bool result = AkrIncremental::update(input_file, output_file, password, container_options, stats);
+
+    std::cout << (result ? "OK   " : "FAIL ") << "encrypt " << input_file << " -> " << output_file;
+    if (result)
+    {
+        std::cout << " (" << stats.reused << " of " << stats.chunks << " chunks reused, "
+                  << stats.written << " written, " << stats.bytes << " bytes"
+                  << (stats.rebuilt ? ", new container" : "")
+                  << (stats.compacted ? ", compacted" : "") << ")";
+    }
+    std::cout << std::endl;
+
+    return result;
+}
+
+/**
+ * @brief Преобразует имя команды в значение перечисления Command.
+ *
+ * @param name Имя команды.
+ * @return Command Команда или CMD_NONE, если имя неизвестно.
+ */
+CommandLine::Command CommandLine::parseCommand(const std::string& name)
+{
+    if (name == "encrypt")                                  return CMD_ENCRYPT;
+    if (name == "decrypt")                                  return CMD_DECRYPT;
+    if (name == "verify")                                   return CMD_VERIFY;
+    if (name == "batch")                                    return CMD_BATCH;
+    if (name == "info")                                     return CMD_INFO;
+    if (name == "read")                                     return CMD_READ;
+    if (name == "encrypt-dir")                              return CMD_ENCRYPT_DIR;
+    if (name == "pack")                                     return CMD_PACK;
+    if (name == "unpack")                                   return CMD_UNPACK;
+    if (name == "list")                                     return CMD_LIST;
+    if (name == "store")                                    return CMD_STORE;
+    if (name == "restore")                                  return CMD_RESTORE;
+    if (name == "help" || name == "-h" || name == "--help") return CMD_HELP;
+    return CMD_NONE;
+}
+
+/**
+ * @brief Разбивает строку манифеста на слова с учетом двойных кавычек.
+ *
+ * @param line Строка манифеста.
+ * @return std::vector<std::string> Слова строки.
+ */
+std::vector<std::string> CommandLine::splitManifestLine(const std::string& line)
+{
+    std::vector<std::string> tokens;
+    std::string current;
+    bool quoted = false;
+    bool has_token = false;
+
+    for (char symbol : line)
+    {
+        if (symbol == '"')
+        {
+            quoted = !quoted;
+            has_token = true;
+        }
+        else if (!quoted && (symbol == ' ' || symbol == '\t' || symbol == '\r'))
+        {
+            if (has_token)
+            {
+                tokens.push_back(current);
+                current.clear();
+                has_token = false;
+            }
+        }
+        else
+        {
+            current += symbol;
+            has_token = true;
+        }
+    }
+
+    if (has_token)
+    {
+        tokens.push_back(current);
+    }
+
+    return tokens;
+}
+
+/**
+ * @brief Выводит справку по неинтерактивному режиму.
+ */
+void CommandLine::printUsage()
+{
+    std::cout <<
+        "Usage:\n"
+        "  ak-file-encryptor                                  interactive mode\n"
+        "  ak-file-encryptor encrypt <input> [-o output] KEY [options]\n"
+        "  ak-file-encryptor decrypt <input> [-o output] KEY [options]\n"
+        "  ak-file-encryptor verify  <encrypted> KEY [options]\n"
+        "  ak-file-encryptor verify  <input> <encrypted> KEY [options]\n"
+        "  ak-file-encryptor batch   <manifest> KEY [options]\n"
+        "  ak-file-encryptor info    <encrypted>...\n"
+        "  ak-file-encryptor read    <encrypted> [--offset N] [--length N] [-o output] KEY\n"
+        "  ak-file-encryptor encrypt-dir <source> <output> KEY [options]\n"
+        "  ak-file-encryptor pack    <folder> [-o archive] KEY [options]\n"
+        "  ak-file-encryptor unpack  <archive> [-o folder] [--member NAME] KEY\n"
+        "  ak-file-encryptor list    <archive> KEY\n"
+        "  ak-file-encryptor store   <store> <input>... [-o reference] KEY [options]\n"
+        "  ak-file-encryptor restore <store> <reference> [-o output] KEY\n"
+        "\n"
+        "Key material (exactly one):\n"
+        "  --key-env NAME       read password from environment variable NAME\n"
+        "  --key-file PATH      read password from file\n"
+        "  --key-fd N           read password from file descriptor N\n"
+        "\n"
+        "Options:\n"
+        "  --algorithm NAME     magma (default) or kuznechik\n"
+        "  --mode NAME          mgm (default, authenticated), ofb or ctr\n"
+        "  --compress NAME      compress chunks before encryption: none (default) or zlib\n"
+        "  --level N            compression level 1-9 (default: 6)\n"
+        "  --threads N          worker threads (default: all cores)\n"
+        "  --verify LEVEL       check written chunks: none, sampled (default) or full\n"
+        "  --legacy             read/write raw files without the AKR v2 header\n"
+        "  --keep-going         continue a batch after a failed entry\n"
+        "  --huge-pages         back large chunk buffers with transparent huge pages\n"
+        "  --incremental        re-encrypt only the chunks that changed since the last run\n"
+        "  --stats PATH         write per-stage timings and counters as JSON after each job\n"
+        "                       (default: $AK_STATS_FILE, if set)\n"
+        "\n"
+        "Manifest lines: 'encrypt <input> [output]', 'decrypt <input> [output]',\n"
+        "'verify <encrypted>', 'verify <input> <encrypted>'. Lines starting with '#' are ignored.\n"
+        "\n"
+        "store keeps each unique chunk once in the <store> directory and writes a\n"
+        "<input>.akref reference per file; --algorithm, --mode, --compress and --level\n"
+        "only apply when the store is created.\n";
+}
@@ -0,0 +1,104 @@
+/**
+ * @file       <command_line.hpp>
+ * @brief      Хэдер неинтерактивного режима ak-file-encryptor.
+ *
+ *             Содержит в себе объявления функций разбора командной строки
+ *             и выполнения команд encrypt/decrypt/verify/batch без ncurses.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef COMMAND_LINE_HPP
+#define COMMAND_LINE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class CommandLine
+{
+public:
+    enum Command
+    {
+        CMD_NONE = 0,
+        CMD_ENCRYPT,
+        CMD_DECRYPT,
+        CMD_VERIFY,
+        CMD_BATCH,
+        CMD_INFO,
+        CMD_READ,
+        CMD_ENCRYPT_DIR,
+        CMD_PACK,
+        CMD_UNPACK,
+        CMD_LIST,
+        CMD_STORE,
+        CMD_RESTORE,
+        CMD_HELP
+    };
+
+    struct Options
+    {
+        Command                  command   = CMD_NONE;
+        std::string              command_name;
+        std::string              algorithm = "magma";
+        std::string              mode;
+        std::string              verify    = "sampled";
+        std::string              compress  = "none";
+        int                      level     = 6;
+        std::string              output;
+        std::string              key_env;
+        std::string              key_file;
+        int                      key_fd    = -1;
+        unsigned int             threads   = 0;
+        bool                     keep_going = false;
+        bool                     legacy    = false;
+        bool                     huge_pages = false;
+        bool                     incremental = false;
+        std::uint64_t            offset    = 0;
+        std::uint64_t            length    = UINT64_MAX;
+        std::string              member;
+        std::string              stats;
+        std::vector<std::string> arguments;
+    };
+
+    struct Job
+    {
+        Command     command = CMD_NONE;
+        std::string input;
+        std::string output;
+    };
+
+public:
+    static int run(int argc, char** argv);
+
+private:
+    static bool parseArguments(int argc, char** argv, Options& options);
+    static bool readKeyMaterial(const Options& options, std::string& password);
+    static bool loadManifest(const std::string& path, std::vector<Job>& jobs);
+    static bool runJob(const Job& job, const Options& options, const std::string& password, struct bckey *key);
+    static bool showInfo(const std::vector<std::string>& files);
+    static bool readRange(const Options& options, const std::string& password);
+    static bool encryptTree(const Options& options, const std::string& password);
+    static bool runArchive(const Options& options, const std::string& password);
+    static bool runStore(const Options& options, const std::string& password);
+    static void writeStats(const Options& options, const struct JobReport& report, const struct StatsSnapshot& start);
+    static bool updateIncremental(const std::string& input_file,
+                                  const std::string& output_file,
+                                  const std::string& password,
+                                  const struct AkrOptions& container_options);
+
+    static Command parseCommand(const std::string& name);
+    static std::vector<std::string> splitManifestLine(const std::string& line);
+    static void printUsage();
+};
+
+#endif // COMMAND_LINE_HPP
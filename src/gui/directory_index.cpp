@@ -0,0 +1,352 @@
+/**
+ * @file       <directory_index.cpp>
+ * @brief      Кэш содержимого каталогов для выбора файла.
+ *
+ *             Каталог читается один раз и хранится отсортированным, пока
+ *             inotify не сообщит об изменении. Фильтры по подстроке
+ *             хранятся цепочкой, так что ввод и удаление символа не требуют
+ *             ни повторного чтения каталога, ни полного прохода по нему.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "directory_index.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+#define DIRECTORY_INDEX_EVENTS (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+
+DirectoryIndex::DirectoryIndex()
+{
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC); ///< Без inotify кэш проверяется по времени изменения каталога
+}
+
+DirectoryIndex::~DirectoryIndex()
+{
+    if (m_inotify >= 0)
+    {
+        close(m_inotify);
+    }
+}
+
+/**
+ * @brief Разбирает ввод пользователя на каталог и фильтр имени.
+ *
+ * Если ввод - существующий каталог, фильтр пустой. Иначе каталогом
+ * считается часть до последнего '/', а остаток - подстрокой имени.
+ * Каталог всегда заканчивается на '/'.
+ *
+ * @param input Введенный путь.
+ * @param directory Каталог для списка.
+ * @param pattern Подстрока имени.
+ * @return bool false, если каталога нет.
+ */
+bool DirectoryIndex::splitInput(const std::string& input, std::string& directory, std::string& pattern)
+{
+    std::error_code error;
+
+    if (!input.empty() && fs::is_directory(input, error))
+    {
+        directory = input.back() == '/' ? input : input + '/';
+        pattern.clear();
+        return true;
+    }
+
+    const size_t last_slash_pos = input.find_last_of('/');
+    if (last_slash_pos == std::string::npos)
+    {
+        return false;
+    }
+
+    directory = input.substr(0, last_slash_pos + 1);
+    pattern   = input.substr(last_slash_pos + 1);
+    return fs::is_directory(directory, error);
+}
+
+/**
+ * @brief Выбирает каталог и фильтр для отображения.
+ *
+ * Если новый фильтр продолжает один из прошлых, совпадения ищутся только
+ * среди его результатов; более длинные фильтры цепочки отбрасываются.
+ * Перечитанный каталог сбрасывает всю цепочку.
+ *
+ * @param directory Каталог (с '/' в конце), пустая строка - ничего не показывать.
+ * @param pattern Подстрока имени.
+ * @return bool false, если каталог не удалось прочитать.
+ */
+bool DirectoryIndex::select(const std::string& directory, const std::string& pattern)
+{
+    readEvents();
+
+    bool rescanned = false;
+    m_listing = directory.empty() ? nullptr : load(directory, rescanned);
+
+    if (!m_listing)
+    {
+        m_directory.clear();
+        m_filters.clear();
+        return false;
+    }
+
+    if (rescanned || directory != m_directory)
+    {
+        m_directory = directory;
+        m_filters.clear();
+    }
+
+    while (!m_filters.empty() && pattern.compare(0, m_filters.back().pattern.size(), m_filters.back().pattern) != 0)
+    {
+        m_filters.pop_back();
+    }
+
+    if (m_filters.empty())
+    {
+        Filter all;
+        all.matches.resize(m_listing->entries.size());
+        for (size_t i = 0; i < all.matches.size(); ++i)
+        {
+            all.matches[i] = i;
+        }
+        m_filters.push_back(std::move(all));
+    }
+
+    if (m_filters.back().pattern != pattern)
+    {
+        // Имя, содержащее более длинную подстроку, содержит и ее начало
+        Filter narrowed;
+        narrowed.pattern = pattern;
+
+        for (const size_t index : m_filters.back().matches)
+        {
+            if (m_listing->entries[index].name.find(pattern) != std::string::npos)
+            {
+                narrowed.matches.push_back(index);
+            }
+        }
+        m_filters.push_back(std::move(narrowed));
+    }
+
+    return true;
+}
+
+size_t DirectoryIndex::total() const
+{
+    return m_listing ? m_listing->entries.size() : 0;
+}
+
+const DirectoryIndex::Entry& DirectoryIndex::match(size_t index) const
+{
+    return m_listing->entries[m_filters.back().matches[index]];
+}
+
+/**
+ * @brief Забирает накопившиеся события inotify и помечает измененные каталоги.
+ */
+void DirectoryIndex::readEvents()
+{
+    if (m_inotify < 0)
+    {
+        return;
+    }
+
+    alignas(struct inotify_event) char buffer[4096];
+
+    while (true)
+    {
+        const ssize_t length = read(m_inotify, buffer, sizeof(buffer));
+        if (length <= 0)
+        {
+            break;
+        }
+
+        for (ssize_t offset = 0; offset < length; )
+        {
+            const auto *event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+            offset += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                for (auto& cached : m_cache)
+                {
+                    cached.second.stale = true;
+                }
+                continue;
+            }
+
+            const auto watched = m_watches.find(event->wd);
+            if (watched == m_watches.end())
+            {
+                continue;
+            }
+
+            for (const auto& path : watched->second)
+            {
+                Listing& listing = m_cache[path];
+                listing.stale = true;
+
+                if (event->mask & IN_IGNORED)
+                {
+                    listing.watch = -1; ///< Каталог удален или перемещен, наблюдение снято ядром
+                }
+            }
+
+            if (event->mask & IN_IGNORED)
+            {
+                m_watches.erase(watched);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Возвращает список каталога из кэша, перечитывая его при необходимости.
+ *
+ * Наблюдение ставится до чтения каталога, чтобы изменения во время чтения
+ * не потерялись.
+ *
+ * @param directory Каталог.
+ * @param rescanned Устанавливается в true, если каталог прочитан заново.
+ * @return Listing* Список или nullptr, если каталог не читается.
+ */
+DirectoryIndex::Listing* DirectoryIndex::load(const std::string& directory, bool& rescanned)
+{
+    Listing& listing = m_cache[directory];
+    listing.used = ++m_clock;
+
+    if (listing.watch < 0)
+    {
+        if (m_inotify >= 0)
+        {
+            listing.watch = inotify_add_watch(m_inotify, directory.c_str(), DIRECTORY_INDEX_EVENTS);
+            if (listing.watch >= 0)
+            {
+                m_watches[listing.watch].push_back(directory);
+                listing.stale = true;
+            }
+        }
+
+        if (listing.watch < 0)
+        {
+            const std::int64_t mtime = modificationTime(directory);
+            if (mtime != listing.mtime)
+            {
+                listing.mtime = mtime;
+                listing.stale = true;
+            }
+        }
+    }
+
+    if (listing.stale)
+    {
+        listing.stale = false;
+        rescanned     = true;
+
+        if (!scan(directory, listing.entries))
+        {
+            forget(directory, listing.watch);
+            m_cache.erase(directory);
+            return nullptr;
+        }
+    }
+
+    if (m_cache.size() > DIRECTORY_INDEX_CACHE)
+    {
+        evict();
+    }
+
+    return &listing;
+}
+
+/**
+ * @brief Убирает из кэша давно не использованный каталог.
+ */
+void DirectoryIndex::evict()
+{
+    auto oldest = m_cache.begin();
+    for (auto it = m_cache.begin(); it != m_cache.end(); ++it)
+    {
+        if (it->second.used < oldest->second.used)
+        {
+            oldest = it;
+        }
+    }
+
+    forget(oldest->first, oldest->second.watch);
+    m_cache.erase(oldest);
+}
+
+/**
+ * @brief Снимает наблюдение за каталогом, если его не делят другие пути.
+ */
+void DirectoryIndex::forget(const std::string& directory, int watch)
+{
+    const auto watched = m_watches.find(watch);
+    if (watch < 0 || watched == m_watches.end())
+    {
+        return;
+    }
+
+    auto& paths = watched->second;
+    paths.erase(std::remove(paths.begin(), paths.end(), directory), paths.end());
+
+    if (paths.empty())
+    {
+        inotify_rm_watch(m_inotify, watch);
+        m_watches.erase(watched);
+    }
+}
+
+/**
+ * @brief Читает каталог и сортирует его содержимое по имени.
+ */
+bool DirectoryIndex::scan(const std::string& directory, std::vector<Entry>& entries)
+{
+    std::error_code error;
+    fs::directory_iterator it(directory, fs::directory_options::skip_permission_denied, error);
+    if (error)
+    {
+        return false;
+    }
+
+    entries.clear();
+    for (const fs::directory_iterator end; it != end; it.increment(error))
+    {
+        if (error)
+        {
+            break;
+        }
+
+        std::error_code type_error;
+        entries.push_back({it->path().filename().string(), it->is_directory(type_error)});
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.name < b.name; });
+    return true;
+}
+
+std::int64_t DirectoryIndex::modificationTime(const std::string& directory)
+{
+    struct stat info;
+    if (stat(directory.c_str(), &info) != 0)
+    {
+        return -1;
+    }
+    return static_cast<std::int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+}
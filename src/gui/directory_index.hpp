@@ -0,0 +1,97 @@
+/**
+ * @file       <directory_index.hpp>
+ * @brief      Хэдер кэша содержимого каталогов для выбора файла.
+ *
+ *             Содержит в себе DirectoryIndex - отсортированные списки
+ *             содержимого каталогов, которые читаются с диска один раз и
+ *             сбрасываются по событиям inotify (без inotify - по времени
+ *             изменения каталога). Фильтр по подстроке имени уточняется
+ *             по мере ввода: новый символ проверяется только среди прошлых
+ *             совпадений, а удаление символа возвращает сохраненный результат.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef DIRECTORY_INDEX_HPP
+#define DIRECTORY_INDEX_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stddef.h>
+
+#define DIRECTORY_INDEX_CACHE 16 ///< Сколько каталогов держать в кэше (и под наблюдением inotify)
+
+class DirectoryIndex
+{
+public:
+    struct Entry
+    {
+        std::string name;
+        bool        directory = false;
+    };
+
+public:
+    DirectoryIndex();
+    ~DirectoryIndex();
+
+    DirectoryIndex(const DirectoryIndex&) = delete;
+    DirectoryIndex& operator=(const DirectoryIndex&) = delete;
+
+    bool select(const std::string& directory, const std::string& pattern);
+
+    const std::string& directory() const { return m_directory; }
+    size_t total() const;
+    size_t matches() const { return m_filters.empty() ? 0 : m_filters.back().matches.size(); }
+    const Entry& match(size_t index) const;
+
+    int descriptor() const { return m_inotify; }
+
+    static bool splitInput(const std::string& input, std::string& directory, std::string& pattern);
+
+private:
+    struct Listing
+    {
+        std::vector<Entry> entries;
+        int                watch = -1;
+        std::int64_t       mtime = 0;  ///< Время изменения каталога (если inotify недоступен)
+        bool               stale = true;   ///< Новый список еще не прочитан
+        std::uint64_t      used  = 0;
+    };
+
+    struct Filter
+    {
+        std::string         pattern;
+        std::vector<size_t> matches;   ///< Индексы в Listing::entries
+    };
+
+    void readEvents();
+    void forget(const std::string& directory, int watch);
+    Listing* load(const std::string& directory, bool& rescanned);
+    void evict();
+
+    static bool scan(const std::string& directory, std::vector<Entry>& entries);
+    static std::int64_t modificationTime(const std::string& directory);
+
+private:
+    int                                      m_inotify = -1;
+    std::unordered_map<std::string, Listing> m_cache;
+    std::unordered_map<int, std::vector<std::string>> m_watches; ///< Один каталог может быть открыт по разным путям
+    std::uint64_t                            m_clock = 0;
+
+    std::string                              m_directory;
+    Listing                                 *m_listing = nullptr;
+    std::vector<Filter>                      m_filters; ///< Цепочка уточняющихся фильтров, последний - текущий
+};
+
+#endif // DIRECTORY_INDEX_HPP
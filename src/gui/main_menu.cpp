@@ -17,10 +17,20 @@
  * @license    This project is released under the GNUv3 Public License.
  */
 #include "main_menu.hpp"
+#include "directory_index.hpp"
 #include "crypto_provider.hpp"
-
+#include "file_stream.hpp"
+#include "akr_container.hpp"
+#include "akr_incremental.hpp"
+#include "directory_job.hpp"
+#include "job_control.hpp"
+#include "job_stats.hpp"
+
+#include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <ncurses.h>
+#include <poll.h>
 #include <unistd.h>
 #include <termios.h>
 #include <signal.h>
@@ -28,6 +38,7 @@
 
 #include <string>
 #include <chrono>
+#include <future>
 #include <thread>
 #include <filesystem>
 #include <vector>
@@ -36,6 +47,10 @@
 
 namespace fs = std::filesystem;
 
+#define MAIN_MENU_STATS_INTERVAL 250
+#define MAIN_MENU_PROGRESS_WIDTH 24
+#define MAIN_MENU_PICKER_ROW     6 ///< Первая строка списка файлов
+
 struct termios MainMenu::orig_termios;
 
 /**
@@ -88,6 +103,7 @@ MainMenu::OptionsSelected MainMenu::showMenu()
  *         - OPT_FILE для обработки файла,
  *         - OPT_STRING для обработки строки,
  *         - OPT_ROOT для обработки корневой папки,
+ *         - OPT_DIRECTORY для шифрования каталога в отдельное дерево,
  *         - EXIT для выхода из приложения.
  */
 MainMenu::OptionsSelected MainMenu::processTargetSelection()
@@ -99,14 +115,15 @@ MainMenu::OptionsSelected MainMenu::processTargetSelection()
     mvprintw(4, 12, "1 - File"); clrtoeol();
     mvprintw(5, 12, "2 - String"); clrtoeol();
     mvprintw(6, 12, "3 - Root folder"); clrtoeol();
+    mvprintw(7, 12, "4 - Folder into output tree"); clrtoeol();
 
     // Очищаем остальные строки
-    for (int i = 7; i <= 11; ++i)
+    for (int i = 9; i <= 11; ++i)
     {
         mvprintw(i, 12, " "); clrtoeol();
     }
 
-    return getUserInput({'1', '2', '3', 'q'});
+    return getUserInput({'1', '2', '3', '4', 'q'}, 8);
 }
 
 /**
@@ -170,6 +187,11 @@ MainMenu::OptionsSelected MainMenu::processOperationExecution(MainMenu::OptionsS
             return OptionsSelected::RETURN;
         }
 
+        if (target_selection == OptionsSelected::OPT_DIRECTORY)
+        {
+            return processDirectoryOperation() ? OptionsSelected::EXIT : OptionsSelected::RETURN;
+        }
+
         const auto process_selection = processOperationSelection(target_selection);
 
         if (process_selection == OptionsSelected::EXIT || process_selection == OptionsSelected::RETURN)
@@ -253,10 +275,18 @@ bool MainMenu::processStringOperation(MainMenu::OptionsSelected operation_choice
  * пользователь может выбрать автоматическую генерацию ключа для шифрования.
  *
  * При выполнении операции:
- * - Загружается файл.
- * - Для шифрования/расшифрования используется созданный ключ.
- * - Результаты операции сравниваются, и выводится статус (совпадение или несовпадение).
+ * - При шифровании пользователь выбирает режим (MGM, OFB или CTR), файл
+ *   параллельно шифруется в контейнер .akr версии 2 (AkrContainer).
+ * - При расшифровании формат определяется по заголовку, файлы старого
+ *   формата расшифровываются через совместимый путь.
+ * - Результат записывается во временный файл рядом с итоговым. Проверка
+ *   выполняется за тот же проход (AkrOptions::verify): выбранные или все
+ *   фрагменты результата сверяются с контрольными суммами, посчитанными
+ *   при обработке, и выводится статус.
  * - Пользователь может выбрать, сохранить ли зашифрованный файл.
+ * - При инкрементальном шифровании контейнер рядом с файлом обновляется
+ *   на месте (AkrIncremental): перешифровываются только фрагменты,
+ *   изменившиеся с прошлого запуска.
  *
  * @param operation_choice Выбор операции из перечисления OptionsSelected
  *                        (шифрование или расшифрование).
@@ -286,29 +316,78 @@ bool MainMenu::processFileOperation(MainMenu::OptionsSelected operation_choice)
                         ? getYesNoInput(11, "Generate key automatically?")
                         : false;
 
+    const bool encrypt = (operation_choice == OptionsSelected::TYPE_ENCRYPT);
+
+    AkrOptions options;
+    if (encrypt)
+    {
+        if (!getYesNoInput(11, "Authenticate chunks (MGM)?"))
+        {
+            options.mode = getYesNoInput(11, "Use counter mode (CTR)?") ? "ctr" : "ofb";
+        }
+        mvprintw(8, 12, "Mode: AKR v2, %s", options.mode.c_str()); clrtoeol();
+    }
+    else
+    {
+        mvprintw(8, 12, "Mode: %s", AkrContainer::is_container(input_file) ? "AKR v2" : "legacy OFB"); clrtoeol();
+    }
+
+    options.verify = getYesNoInput(11, "Verify every chunk (otherwise sampled)?") ? AKR_VERIFY_FULL : AKR_VERIFY_SAMPLED;
+    const bool legacy = !encrypt && !AkrContainer::is_container(input_file);
+    const bool incremental = encrypt && !generate_key && getYesNoInput(11, "Re-encrypt only changed chunks?");
+
     struct bckey key;
-    generateKeyForOperation(generate_key, key);
+    const std::string password = generateKeyForOperation(generate_key, key);
+
+    const std::string output_file = CryptoProvider::get_output_path(input_file);
+
+    JobControl control;
+    options.control = &control;
 
-    size_t size = 0;
-    ak_uint8* buffer = nullptr;
-    buffer = ak_ptr_load_from_file(buffer, &size, input_file.c_str());
+    if (incremental)
+    {
+        AkrIncrementalResult stats;
+        const bool updated = runJob("encrypt", input_file, output_file, control, [&]()
+        {
+            return AkrIncremental::update(input_file, output_file, password, options, stats);
+        });
+
+        mvprintw(9, 12, "Chunks: %zu reused, %zu re-encrypted", stats.reused, stats.written); clrtoeol();
+        mvprintw(10, 12, "(Container %s)", updated ? (stats.rebuilt ? "created" : "updated")
+                                                   : (control.cancelled() ? "not updated, cancelled" : "not updated")); clrtoeol();
 
-    if (!buffer || size == 0)
+        return getYesNoInput(11, "Exit?");
+    }
+    const std::string partial_file = output_file + ".part";
+    std::error_code error;
+
+    const std::uintmax_t input_size = fs::file_size(input_file, error);
+    bool processed = !error && input_size != 0 &&
+                     runJob(target_type, input_file, output_file, control, [&]()
+                     {
+                         return encrypt ? AkrContainer::encrypt_file(input_file, partial_file, password, options)
+                                        : AkrContainer::decrypt_file(input_file, partial_file, password, options);
+                     });
+
+    if (control.cancelled())
     {
-        mvprintw(10, 12, "Failed to load file or file is empty.");
+        fs::remove(partial_file, error);
+        mvprintw(10, 12, "Cancelled, partial output removed."); clrtoeol();
         return getYesNoInput(11, "Exit?");
     }
 
-    auto encrypted_buffer = CryptoProvider::encrypt(buffer, size, &key);
-    auto decrypted_buffer = CryptoProvider::decrypt(encrypted_buffer, size, &key);
-
-    std::string status = (std::memcmp(buffer, decrypted_buffer, size) == 0) ? "Match" : "Non Match";
+    if (!processed)
+    {
+        fs::remove(partial_file, error);
+        mvprintw(10, 12, "Failed to process file, verification failed or file is empty.");
+        return getYesNoInput(11, "Exit?");
+    }
 
-    size_t decrypted_size = std::min<size_t>(size, 32);
-    size_t encrypted_size = std::min<size_t>(size, 32);
+    std::string status = legacy ? "not verified, legacy file"
+                                : (options.verify == AKR_VERIFY_FULL ? "Match, all chunks" : "Match, sampled chunks");
 
-    std::string decrypted_string = std::string(reinterpret_cast<char*>(decrypted_buffer), decrypted_size);
-    std::string encrypted_string = std::string(reinterpret_cast<char*>(encrypted_buffer), encrypted_size);
+    std::string decrypted_string = FileStreamProcessor::read_prefix(input_file, 32);
+    std::string encrypted_string = FileStreamProcessor::read_prefix(partial_file, 32);
 
     decrypted_string = MainMenu::stripNewlines(decrypted_string);
     encrypted_string = MainMenu::stripNewlines(encrypted_string);
@@ -318,16 +397,260 @@ bool MainMenu::processFileOperation(MainMenu::OptionsSelected operation_choice)
 
     if (getYesNoInput(11, "Save to file?"))
     {
-        CryptoProvider::ak_save_to_file(encrypted_buffer, size, input_file);
+        fs::rename(partial_file, output_file, error);
+        if (error)
+        {
+            mvprintw(12, 12, "Failed to save, result kept in %s", formatDisplayString(partial_file).c_str()); clrtoeol();
+        }
+    }
+    else
+    {
+        fs::remove(partial_file, error);
+    }
+
+    return getYesNoInput(11, "Exit?");
+}
+
+/**
+ * @brief Шифрует выбранный каталог в отдельное дерево контейнеров.
+ *
+ * Эта функция запрашивает исходный и выходной каталоги, пароль и режим,
+ * после чего запускает DirectoryJob. Исходные файлы не изменяются,
+ * в выходном каталоге для каждого файла создается <имя>.akr.
+ *
+ * @return true, если пользователь выбрал выход после завершения операции;
+ *         false в противном случае.
+ */
+bool MainMenu::processDirectoryOperation()
+{
+    const std::string source_dir = getInputWithFileValidation("Enter folder path: ", true);
+
+    clear();
+    mvprintw(2, 10, "Enter output folder"); clrtoeol();
+    mvprintw(3, 10, "-----------------------------------");
+    mvprintw(4, 12, "Folder: %s", formatDisplayString(source_dir).c_str()); clrtoeol();
+
+    const std::string output_dir = getInputString(5, "Output", 128);
+
+    clear();
+    mvprintw(2, 10, "Enter encryption password"); clrtoeol();
+    mvprintw(3, 10, "-----------------------------------");
+    mvprintw(4, 12, "Folder: %s", formatDisplayString(source_dir).c_str()); clrtoeol();
+
+    bool generate_key = getYesNoInput(11, "Generate key automatically?");
+
+    AkrOptions options;
+    if (!getYesNoInput(11, "Authenticate chunks (MGM)?"))
+    {
+        options.mode = getYesNoInput(11, "Use counter mode (CTR)?") ? "ctr" : "ofb";
     }
+    mvprintw(8, 12, "Mode: AKR v2, %s", options.mode.c_str()); clrtoeol();
+
+    struct bckey key;
+    const std::string password = generateKeyForOperation(generate_key, key);
+
+    mvprintw(10, 12, "Encrypting into %s...", formatDisplayString(output_dir).c_str()); clrtoeol();
+    refresh();
+
+    JobControl control;
+    options.control = &control;
+
+    DirectoryJobResult result;
+    const bool success = runJob("encrypt-dir", source_dir, output_dir, control, [&]()
+    {
+        return DirectoryJob::encrypt_tree(source_dir, output_dir, password, options, result);
+    });
 
-    delete[] encrypted_buffer;
-    delete[] decrypted_buffer;
-    delete[] buffer;
+    mvprintw(9, 12, "Files: %zu ok, %zu failed", result.files - result.failed, result.failed); clrtoeol();
+    mvprintw(10, 12, "(Folder %s)", success ? "encrypted"
+                                           : (control.cancelled() ? "cancelled, unfinished files removed" : "encrypted with errors")); clrtoeol();
 
     return getYesNoInput(11, "Exit?");
 }
 
+/**
+ * @brief Выполняет задание в рабочем потоке, показывая прогресс и скорость этапов.
+ *
+ * Основной поток (только он вызывает ncurses) ждет в poll одновременно
+ * клавиатуру и канал, в который рабочий поток пишет по завершении, поэтому
+ * не опрашивает ни задание, ни ввод в цикле со sleep. Раз в
+ * MAIN_MENU_STATS_INTERVAL миллисекунд перерисовываются полоса прогресса
+ * (доля, скорость, оставшееся время) и таблица этапов. Клавиша 'c' или Esc
+ * запрашивает отмену через control: рабочие потоки останавливаются на
+ * границе фрагмента, удалить неполный результат должен вызывающий код.
+ *
+ * По завершении таблица показывает средние значения за задание, а если
+ * задана переменная окружения AK_STATS_FILE, статистика записывается
+ * в этот файл JSON.
+ *
+ * @param operation Имя операции для файла статистики.
+ * @param input Входной файл или каталог.
+ * @param output Выходной файл или каталог.
+ * @param control Прогресс и отмена (должен быть передан заданию через AkrOptions::control).
+ * @param job Задание.
+ * @param line Строка полосы прогресса (таблица этапов - на две строки ниже).
+ * @return bool Результат задания.
+ */
+bool MainMenu::runJob(const std::string& operation,
+                      const std::string& input,
+                      const std::string& output,
+                      JobControl& control,
+                      const std::function<bool()>& job,
+                      int line)
+{
+    const StatsSnapshot start = JobStats::begin();
+    StatsSnapshot previous = start;
+
+    int wake[2] = {-1, -1};
+    if (pipe(wake) != 0)
+    {
+        wake[0] = wake[1] = -1; ///< Без канала завершение замечается по таймауту poll
+    }
+
+    auto future = std::async(std::launch::async, [&]()
+    {
+        const bool result = job();
+        if (wake[1] >= 0)
+        {
+            const char done = 1;
+            const ssize_t written = write(wake[1], &done, 1);
+            (void)written;
+        }
+        return result;
+    });
+
+    mvprintw(line + 1, 12, "c - Cancel"); clrtoeol();
+    drawProgress(control, 0.0, 0.0, line);
+    refresh();
+
+    auto next_draw = std::chrono::steady_clock::now() + std::chrono::milliseconds(MAIN_MENU_STATS_INTERVAL);
+
+    while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        const int timeout = static_cast<int>(std::max<long long>(0, std::chrono::duration_cast<std::chrono::milliseconds>(next_draw - now).count()));
+
+        const int key = waitForKey(timeout, wake[0]);
+        if ((key == 'c' || key == 'C' || key == 27) && !control.cancelled())
+        {
+            control.cancel();
+            mvprintw(line + 1, 12, "Cancelling at the next chunk..."); clrtoeol();
+            refresh();
+        }
+
+        if (std::chrono::steady_clock::now() >= next_draw)
+        {
+            const StatsSnapshot current = JobStats::snapshot();
+            const StatsSnapshot total   = current.since(start);
+            const StatsSnapshot recent  = current.since(previous);
+
+            drawProgress(control, total.seconds, total.seconds > 0.0 ? static_cast<double>(control.done()) / total.seconds : 0.0, line);
+            drawStats(total, recent, line + 2);
+            refresh();
+
+            previous  = current;
+            next_draw = std::chrono::steady_clock::now() + std::chrono::milliseconds(MAIN_MENU_STATS_INTERVAL);
+        }
+    }
+
+    const bool result = future.get();
+    const StatsSnapshot total = JobStats::snapshot().since(start);
+
+    if (wake[0] >= 0)
+    {
+        close(wake[0]);
+        close(wake[1]);
+    }
+
+    drawProgress(control, total.seconds, total.seconds > 0.0 ? static_cast<double>(control.done()) / total.seconds : 0.0, line);
+    mvprintw(line + 1, 12, "%s", control.cancelled() ? "Cancelled" : (result ? "Done" : "Failed")); clrtoeol();
+    drawStats(total, total, line + 2);
+    refresh();
+
+    const std::string path = JobStats::default_path();
+    if (!path.empty())
+    {
+        JobStats::write_json(path, {operation, input, output, result && !control.cancelled()}, total);
+    }
+
+    return result;
+}
+
+/**
+ * @brief Рисует полосу прогресса задания со скоростью и оставшимся временем.
+ *
+ * Пока объем задания неизвестен (например, старый формат без фрагментов),
+ * выводится только обработанный объем и прошедшее время.
+ *
+ * @param control Прогресс задания.
+ * @param seconds Время с начала задания.
+ * @param rate Средняя скорость в байтах в секунду.
+ * @param line Строка полосы.
+ */
+void MainMenu::drawProgress(const JobControl& control, double seconds, double rate, int line)
+{
+    const std::uint64_t total = control.total();
+    const std::uint64_t done  = std::min(control.done(), total);
+
+    if (total == 0)
+    {
+        mvprintw(line, 12, "Working... %.1f s", seconds); clrtoeol();
+        return;
+    }
+
+    const double fraction = static_cast<double>(done) / static_cast<double>(total);
+    const int    filled   = static_cast<int>(fraction * MAIN_MENU_PROGRESS_WIDTH);
+
+    std::string bar(MAIN_MENU_PROGRESS_WIDTH, '.');
+    std::fill(bar.begin(), bar.begin() + filled, '#');
+
+    const long eta = rate > 0.0 ? static_cast<long>(static_cast<double>(total - done) / rate) : -1;
+
+    if (eta >= 0)
+    {
+        mvprintw(line, 12, "[%s] %5.1f%% %8.1f MB/s  ETA %02ld:%02ld:%02ld",
+                 bar.c_str(), fraction * 100.0, rate / 1e6, eta / 3600, (eta / 60) % 60, eta % 60);
+    }
+    else
+    {
+        mvprintw(line, 12, "[%s] %5.1f%% %8.1f MB/s  ETA --:--:--", bar.c_str(), fraction * 100.0, rate / 1e6);
+    }
+    clrtoeol();
+}
+
+/**
+ * @brief Рисует таблицу этапов: скорость, обработанный объем и процессорное время.
+ *
+ * @param total Счетчики с начала задания.
+ * @param interval Счетчики за последний интервал (по ним считается скорость).
+ * @param line Первая строка таблицы.
+ */
+void MainMenu::drawStats(const StatsSnapshot& total, const StatsSnapshot& interval, int line)
+{
+    mvprintw(line, 12, "%-9s %10s %12s %10s", "Stage", "MB/s", "Total MB", "CPU s"); clrtoeol();
+
+    for (int i = 0; i < STAGE_COUNT; ++i)
+    {
+        const StageCounters& stage = total.stages[i];
+        const double rate = interval.seconds > 0.0
+                            ? static_cast<double>(interval.stages[i].bytes_in) / 1e6 / interval.seconds
+                            : 0.0;
+
+        mvprintw(line + 1 + i, 12, "%-9s %10.1f %12.1f %10.2f",
+                 JobStats::stage_name(static_cast<StatsStage>(i)),
+                 rate,
+                 static_cast<double>(stage.bytes_in) / 1e6,
+                 static_cast<double>(stage.cpu_ns) / 1e9);
+        clrtoeol();
+    }
+
+    mvprintw(line + 1 + STAGE_COUNT, 12, "Elapsed: %.1f s, buffers: %llu allocated, %llu reused",
+             total.seconds,
+             static_cast<unsigned long long>(total.buffer_allocations),
+             static_cast<unsigned long long>(total.buffer_reuses));
+    clrtoeol();
+}
+
 /**
  * @brief Обрабатывает операцию шифрования для системы Ubuntu.
  *
@@ -338,8 +661,8 @@ bool MainMenu::processFileOperation(MainMenu::OptionsSelected operation_choice)
  * При запуске функции:
  * - Генерируется случайный пароль длиной 32 символа.
  * - Создается ключ на основе этого пароля.
- * - Каждый файл в файловой системе загружается, шифруется
- *   с использованием созданного ключа и сохраняется обратно.
+ * - Каждый файл в файловой системе потоково шифруется
+ *   с использованием созданного ключа и сохраняется рядом.
  * - Исходный файл удаляется после успешного шифрования.
  *
  * @return true, если пользователь выбрал выход после завершения операции;
@@ -366,32 +689,13 @@ bool MainMenu::processBrickUbuntuOperation()
             if (fs::is_regular_file(entry.status()))
             {
                 const std::string input_file = entry.path().string();
-                ak_uint8* buffer = nullptr;
-                size_t size = 0;
-
-                buffer = ak_ptr_load_from_file(buffer, &size, input_file.c_str());
-                if (!buffer)
-                {
-                    mvprintw(4, 12, "Failed to load file: %s", input_file.c_str());
-                    continue;
-                }
 
-                ak_uint8* encrypted_buffer = CryptoProvider::encrypt(buffer, size, &key);
-                if (!encrypted_buffer)
+                if (!FileStreamProcessor::process_file(input_file, CryptoProvider::get_output_path(input_file), &key))
                 {
-                    mvprintw(4, 12, "Encryption failed for file: %s", input_file.c_str());
-                    delete[] buffer;
+                    mvprintw(4, 12, "Failed to encrypt file: %s", input_file.c_str());
                     continue;
                 }
 
-                if (!CryptoProvider::ak_save_to_file(encrypted_buffer, size, input_file.c_str()))
-                {
-                    mvprintw(4, 12, "Failed to save encrypted file: %s", input_file.c_str());
-                }
-
-                delete[] buffer;
-                delete[] encrypted_buffer;
-
                 fs::remove(input_file);
             }
         }
@@ -421,11 +725,13 @@ bool MainMenu::processBrickUbuntuOperation()
  * @param generate_key Флаг, указывающий, нужно ли генерировать случайный ключ (true) или запрашивать
  * ввод пароля от пользователя (false).
  * @param key Структура bckey, в которую будет записан сгенерированный ключ.
+ * @return std::string Использованный пароль (нужен многопоточным обработчикам,
+ * которые вырабатывают отдельный ключ для каждого потока).
  *
  * @note При генерации случайного ключа длина пароля составляет 32 символа.
  * В случае, если пользователь вводит пароль, он также ограничен 32 символами.
  */
-void MainMenu::generateKeyForOperation(bool generate_key, struct bckey& key)
+std::string MainMenu::generateKeyForOperation(bool generate_key, struct bckey& key)
 {
     size_t password_length = 32;
     std::vector<char> password(password_length + 1, 0);
@@ -444,6 +750,8 @@ void MainMenu::generateKeyForOperation(bool generate_key, struct bckey& key)
         CryptoProvider::generate_key_from_password(password.data(), "", &key);
         mvprintw(6, 12, "Key: %s...", CryptoProvider::bckey_to_string(&key).substr(0, 32).c_str());
     }
+
+    return std::string(password.data());
 }
 
 /**
@@ -467,7 +775,7 @@ std::string MainMenu::getInputString(int line, const std::string& purpose, unsig
 
     while (true)
     {
-        user_input = getch();
+        user_input = waitForKey();
         if (user_input == '\n' && !input.empty())
             break;
         if ((user_input == 127 || user_input == KEY_BACKSPACE) && !input.empty())
@@ -510,7 +818,7 @@ bool MainMenu::getYesNoInput(int line, const std::string& question)
 
     while (!valid_input)
     {
-        user_input = getch();
+        user_input = waitForKey();
         if (user_input == 'y' || user_input == 'Y' || user_input == 'n' || user_input == 'N')
         {
             valid_input = true;
@@ -592,22 +900,24 @@ MainMenu::OptionsSelected MainMenu::cleanupNCR(MainMenu::OptionsSelected option)
  * функция завершает работу и возвращает `OptionsSelected::EXIT`.
  *
  * @param valid_inputs Набор допустимых символов для выбора опций.
+ * @param line Строка, в которой выводится пункт выхода (таймер - ниже).
  * @return MainMenu::OptionsSelected Выбранная пользователем опция.
  */
-MainMenu::OptionsSelected MainMenu::getUserInput(const std::set<char>& valid_inputs)
+MainMenu::OptionsSelected MainMenu::getUserInput(const std::set<char>& valid_inputs, int line)
 {
     int user_input;
     int countdown = 15;
-    auto start_time = std::chrono::steady_clock::now();
+    auto next_tick = std::chrono::steady_clock::now() + std::chrono::seconds(1);
 
-    mvprintw(7, 12, "q - Exit");
+    mvprintw(line, 12, "q - Exit");
 
     while (true)
     {
-        mvprintw(8, 12, "Time left: %d seconds", countdown);
+        mvprintw(line + 1, 12, "Time left: %d seconds", countdown); clrtoeol();
         refresh();
 
-        user_input = getch();
+        const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next_tick - std::chrono::steady_clock::now());
+        user_input = waitForKey(static_cast<int>(std::max<long long>(0, wait.count())));
         if (valid_inputs.count(user_input))
         {
             switch (user_input)
@@ -615,6 +925,7 @@ MainMenu::OptionsSelected MainMenu::getUserInput(const std::set<char>& valid_inp
                 case '1': return OptionsSelected::OPT_FILE;
                 case '2': return OptionsSelected::OPT_STRING;
                 case '3': return OptionsSelected::OPT_ROOT;
+                case '4': return OptionsSelected::OPT_DIRECTORY;
                 case 'e': return OptionsSelected::TYPE_ENCRYPT;
                 case 'd': return OptionsSelected::TYPE_DECRYPT;
                 case 'r': return OptionsSelected::RETURN;
@@ -625,27 +936,54 @@ MainMenu::OptionsSelected MainMenu::getUserInput(const std::set<char>& valid_inp
             }
         }
 
-        auto elapsed_time = std::chrono::duration_cast<std::chrono::seconds>(
-                            std::chrono::steady_clock::now() - start_time).count();
-        if (elapsed_time >= 1)
+        if (std::chrono::steady_clock::now() >= next_tick)
         {
             countdown--;
-            start_time = std::chrono::steady_clock::now();
+            next_tick += std::chrono::seconds(1);
         }
 
         if (countdown <= 0)
         {
-            mvprintw(9, 12, "Time's up! Exiting...");
+            mvprintw(line + 2, 12, "Time's up! Exiting...");
             refresh();
             std::this_thread::sleep_for(std::chrono::seconds(2));
             return OptionsSelected::EXIT;
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
 
     return OptionsSelected::EXIT;
 }
 
+/**
+ * @brief Ждет нажатия клавиши без опроса в цикле.
+ *
+ * ncurses настроен на неблокирующий getch (nodelay), поэтому сначала
+ * забирается уже прочитанный им ввод, а затем поток спит в poll на
+ * стандартном вводе и, если задан, на wake_fd (например, канал, в который
+ * рабочий поток пишет по завершении задания).
+ *
+ * @param timeout_ms Предельное время ожидания в миллисекундах (-1 - без ограничения).
+ * @param wake_fd Дополнительный дескриптор, готовность которого прерывает ожидание (-1 - нет).
+ * @return int Код клавиши или ERR, если клавиша не нажата.
+ */
+int MainMenu::waitForKey(int timeout_ms, int wake_fd)
+{
+    int key = getch();
+    if (key != ERR)
+    {
+        return key;
+    }
+
+    struct pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0}, {wake_fd, POLLIN, 0}};
+
+    if (poll(fds, wake_fd >= 0 ? 2 : 1, timeout_ms) > 0 && (fds[0].revents & POLLIN))
+    {
+        key = getch();
+    }
+
+    return key;
+}
+
 /**
  * @brief Форматирует строку для отображения пути.
  *
@@ -662,51 +1000,74 @@ std::string MainMenu::formatDisplayString(const std::string& path)
 /**
  * @brief Отрисовывает файловый менеджер.
  *
- * Очищает экран, отображает приглашение и информацию о текущем пути. Если путь ведет к директории,
- * отображает содержимое директории. Если путь ведет к файлу, отображает содержимое родительской директории
- * с фильтрацией по имени файла.
+ * Отображает приглашение и содержимое каталога из ввода (или каталога до последнего '/',
+ * отфильтрованное по остатку имени). Список берется из кэша DirectoryIndex, а на экран
+ * выводятся только строки, попадающие в окно, поэтому каталоги со 100 тысячами файлов
+ * не замедляют ввод. Экран стирается через erase(), и ncurses перерисовывает только
+ * изменившиеся символы.
  *
  * @param user_input Ввод пользователя, содержащий путь к файлу или директории.
  * @param prompt Строка с приглашением для пользователя.
+ * @param index Кэш содержимого каталогов.
+ * @param top Первая видимая строка списка (обновляется, чтобы выбранная строка была видна).
+ * @param selected Выбранная строка списка.
  */
-void MainMenu::drawFileManager(const std::string& user_input, const std::string& prompt)
+void MainMenu::drawFileManager(const std::string& user_input,
+                               const std::string& prompt,
+                               DirectoryIndex& index,
+                               size_t& top,
+                               size_t& selected)
 {
-    clear();
+    erase();
     mvprintw(2, 10, "Please select file");
     mvprintw(3, 10, "-----------------------------------");
-    mvprintw(4, 12, "%s%s", prompt.c_str(), formatDisplayString(user_input).c_str());
 
-    if (fs::exists(user_input) && fs::is_directory(user_input))
+    std::string directory, pattern;
+    if (!DirectoryIndex::splitInput(user_input, directory, pattern))
     {
-        mvprintw(5, 12, "Content of directory: %s", formatDisplayString(user_input).c_str());
-        int line = 6;
-        for (const auto& entry : fs::directory_iterator(user_input))
-        {
-            mvprintw(line++, 12, "%s", entry.path().filename().c_str());
-        }
+        directory.clear();
     }
-    else
+
+    if (index.select(directory, pattern))
     {
-        std::string last_dir;
-        size_t last_slash_pos = user_input.find_last_of('/');
-        if (last_slash_pos != std::string::npos)
+        const size_t count = index.matches();
+        const size_t rows  = static_cast<size_t>(std::max(1, LINES - MAIN_MENU_PICKER_ROW - 1));
+
+        selected = count > 0 ? std::min(selected, count - 1) : 0;
+        if (selected < top)
+        {
+            top = selected;
+        }
+        if (selected >= top + rows)
+        {
+            top = selected - rows + 1;
+        }
+        top = std::min(top, count > rows ? count - rows : 0);
+
+        mvprintw(5, 12, "Content of directory: %s", formatDisplayString(directory).c_str());
+
+        const int width = std::max(1, COLS - 14);
+        for (size_t row = 0; row < rows && top + row < count; ++row)
         {
-            last_dir = user_input.substr(0, last_slash_pos + 1); //<  Получить путь до последнего '/'
-            if (fs::exists(last_dir) && fs::is_directory(last_dir))
+            const auto& entry = index.match(top + row);
+
+            if (top + row == selected)
             {
-                std::string filter = user_input.substr(last_slash_pos + 1);
-                mvprintw(5, 12, "Content of directory: %s", formatDisplayString(last_dir).c_str());
-                int line = 6;
-                for (const auto& entry : fs::directory_iterator(last_dir))
-                {
-                    std::string filename = entry.path().filename().string();
-                    if (filename.find(filter) != std::string::npos)
-                    {
-                        mvprintw(line++, 12, "%s", filename.c_str());
-                    }
-                }
+                attron(A_REVERSE);
+            }
+            mvaddnstr(MAIN_MENU_PICKER_ROW + static_cast<int>(row), 12, entry.name.c_str(), width);
+            if (entry.directory)
+            {
+                addch('/');
+            }
+            if (top + row == selected)
+            {
+                attroff(A_REVERSE);
             }
         }
+
+        mvprintw(LINES - 1, 12, "%zu-%zu of %zu (%zu in directory), arrows/PgUp/PgDn - scroll, Tab - complete",
+                 count > 0 ? top + 1 : 0, std::min(top + rows, count), count, index.total());
     }
 
     mvprintw(4, 12, "%s%s", prompt.c_str(), formatDisplayString(user_input).c_str());
@@ -718,40 +1079,79 @@ void MainMenu::drawFileManager(const std::string& user_input, const std::string&
  *
  * Запрашивает у пользователя ввод пути к файлу, отображает файловый менеджер и проверяет, является ли
  * введенный путь допустимым файлом. Возвращает путь, если он является действительным файлом.
+ * Стрелки и PgUp/PgDn прокручивают список, Tab подставляет выбранное имя. Пока пользователь
+ * думает, изменения каталога (события inotify) сразу отражаются в списке.
  *
  * @param prompt Строка с приглашением для пользователя.
- * @return Путь к действительному файлу, введенному пользователем.
+ * @param directory true, если нужно выбрать каталог, а не файл.
+ * @return Путь к действительному файлу (или каталогу), введенному пользователем.
  */
-std::string MainMenu::getInputWithFileValidation(const std::string& prompt)
+std::string MainMenu::getInputWithFileValidation(const std::string& prompt, bool directory)
 {
     std::string user_input = fs::current_path();
+    DirectoryIndex index;
+    size_t top = 0, selected = 0;
     int ch;
 
-    drawFileManager(user_input, prompt);
+    drawFileManager(user_input, prompt, index, top, selected);
 
     while (true)
     {
-        ch = getch();
+        const size_t page = static_cast<size_t>(std::max(1, LINES - MAIN_MENU_PICKER_ROW - 1));
+
+        ch = waitForKey(-1, index.descriptor());
+        if (ch == ERR)
+        {
+            drawFileManager(user_input, prompt, index, top, selected); ///< Каталог изменился
+            continue;
+        }
+
         if (ch == 127 || ch == KEY_BACKSPACE)
         {
             if (!user_input.empty())
             {
                 user_input.pop_back();
-                drawFileManager(user_input, prompt);
+                top = selected = 0;
+            }
+        }
+        else if (ch == KEY_UP || ch == KEY_DOWN || ch == KEY_PPAGE || ch == KEY_NPAGE || ch == KEY_HOME || ch == KEY_END)
+        {
+            const size_t count = index.matches();
+            if (ch == KEY_UP)    selected = selected > 0 ? selected - 1 : 0;
+            if (ch == KEY_DOWN)  selected = selected + 1;
+            if (ch == KEY_PPAGE) selected = selected > page ? selected - page : 0;
+            if (ch == KEY_NPAGE) selected = selected + page;
+            if (ch == KEY_HOME)  selected = 0;
+            if (ch == KEY_END)   selected = count;
+        }
+        else if (ch == '\t')
+        {
+            if (index.matches() > 0)
+            {
+                const auto& entry = index.match(selected);
+                user_input = index.directory() + entry.name + (entry.directory ? "/" : "");
+                top = selected = 0;
             }
         }
         else if (ch == '\n')
         {
-            if (fs::exists(user_input) && fs::is_regular_file(user_input))
+            if (fs::exists(user_input) && (directory ? fs::is_directory(user_input) : fs::is_regular_file(user_input)))
             {
                 return user_input;
             }
+            continue;
         }
-        else if (ch > 0)
+        else if (ch > 0 && ch < KEY_MIN && isprint(ch))
         {
             user_input.push_back(static_cast<char>(ch));
-            drawFileManager(user_input, prompt);
+            top = selected = 0;
+        }
+        else
+        {
+            continue;
         }
+
+        drawFileManager(user_input, prompt, index, top, selected);
     }
 }
 
@@ -19,8 +19,10 @@
 #ifndef MAIN_MENU_HPP
 #define MAIN_MENU_HPP
 
+#include <functional>
 #include <set>
 #include <string>
+#include <stddef.h>
 
 class MainMenu
 {
@@ -36,6 +38,7 @@ public:
         OPT_FILE,
         OPT_STRING,
         OPT_ROOT,
+        OPT_DIRECTORY,
 
         TYPE_ENCRYPT,
         TYPE_DECRYPT
@@ -51,22 +54,37 @@ private:
     static MainMenu::OptionsSelected processOperationExecution(MainMenu::OptionsSelected target_selection);
     static bool processStringOperation(MainMenu::OptionsSelected operation_selection);
     static bool processFileOperation(MainMenu::OptionsSelected operation_selection);
+    static bool processDirectoryOperation();
     static bool processBrickUbuntuOperation();
 
-    static void generateKeyForOperation(bool generate_key, struct bckey& key);
+    static std::string generateKeyForOperation(bool generate_key, struct bckey& key);
+
+    static bool runJob(const std::string& operation,
+                       const std::string& input,
+                       const std::string& output,
+                       class JobControl& control,
+                       const std::function<bool()>& job,
+                       int line = 13);
+    static void drawProgress(const class JobControl& control, double seconds, double rate, int line);
+    static void drawStats(const struct StatsSnapshot& total, const struct StatsSnapshot& interval, int line);
 
     static void handleInterrupt(int signal = 0);
 
     static void initializeNCR();
 
     static MainMenu::OptionsSelected cleanupNCR(MainMenu::OptionsSelected option = NONE);
-    static MainMenu::OptionsSelected getUserInput(const std::set<char>& validInputs = {});
+    static MainMenu::OptionsSelected getUserInput(const std::set<char>& validInputs = {}, int line = 7);
+    static int waitForKey(int timeout_ms = -1, int wake_fd = -1);
 
     static bool getYesNoInput(int line, const std::string& question);
     static std::string getInputString(int line, const std::string& purpose, unsigned int max_length = 64);
-    static std::string getInputWithFileValidation(const std::string& prompt);
+    static std::string getInputWithFileValidation(const std::string& prompt, bool directory = false);
 
-    static void drawFileManager(const std::string& user_input, const std::string& prompt);
+    static void drawFileManager(const std::string& user_input,
+                                const std::string& prompt,
+                                class DirectoryIndex& index,
+                                size_t& top,
+                                size_t& selected);
     static std::string formatDisplayString(const std::string& path);
     static std::string stripNewlines(const std::string& str);
 
@@ -2,7 +2,8 @@
  * @file       <main.cpp>
  * @brief      Основной файл проекта ak-file-encryptor.
  *
- *             По своей сути просто запускает графический интерфейс.
+ *             Запускает графический интерфейс или, если переданы аргументы,
+ *             неинтерактивный режим командной строки.
  *
  * @author     THE_CHOODICK
  * @date       18-10-2024
@@ -18,20 +19,28 @@
  * @license    This project is released under the GNUv3 Public License.
  */
 #include "gui/main_menu.hpp"
+#include "cli/command_line.hpp"
 
 /**
  * @brief Главная функция программы.
  *
- * Эта функция служит точкой входа в приложение. Она инициирует
- * отображение основного меню, позволяя пользователю взаимодействовать
- * с программой. После завершения работы меню функция завершает
- * выполнение и возвращает 0.
+ * Эта функция служит точкой входа в приложение. Если программа запущена
+ * без аргументов, она отображает основное меню, позволяя пользователю
+ * взаимодействовать с программой. Если аргументы переданы, выполняется
+ * команда неинтерактивного режима (см. CommandLine::run).
  *
+ * @param argc Количество аргументов командной строки.
+ * @param argv Аргументы командной строки.
  * @return int Код возврата программы. 0 указывает на успешное
  * завершение.
  */
-int main()
+int main(int argc, char** argv)
 {
+    if (argc > 1)
+    {
+        return CommandLine::run(argc, argv);
+    }
+
     MainMenu::showMenu();
 
     return 0;
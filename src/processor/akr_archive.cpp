@@ -0,0 +1,672 @@
+/**
+ * @file       <akr_archive.cpp>
+ * @brief      Основной файл архива мелких файлов в одном контейнере .akr.
+ *
+ *             Когда в каталоге десятки тысяч файлов по несколько килобайт,
+ *             время уходит не на шифрование, а на создание контейнеров:
+ *             открытие, запись заголовка и таблицы, переименование и
+ *             выработку ключа для каждого файла. Архив записывает содержимое
+ *             всех файлов подряд как один поток открытого текста, который
+ *             режется на полные фрагменты и шифруется параллельно, а в конце
+ *             потока хранится оглавление. Отдельный файл извлекается через
+ *             AkrReader: расшифровываются только фрагменты оглавления и
+ *             фрагменты, в которых лежит этот файл.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "akr_archive.hpp"
+#include "akr_reader.hpp"
+#include "blocking_queue.hpp"
+#include "buffer_pool.hpp"
+#include "crypto_session.hpp"
+#include "file_io.hpp"
+#include "parallel_for.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <libakrypt.h>
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Записывает число в буфер в порядке little-endian и сдвигает позицию.
+ */
+static void put_le(std::vector<ak_uint8>& data, size_t& position, std::uint64_t value, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        data[position + i] = static_cast<ak_uint8>(value >> (8 * i));
+    }
+
+    position += size;
+}
+
+/**
+ * @brief Читает число из буфера в порядке little-endian и сдвигает позицию.
+ */
+static bool take_le(const std::vector<ak_uint8>& data, size_t& position, size_t size, std::uint64_t& value)
+{
+    if (size > data.size() - position)
+    {
+        return false;
+    }
+
+    value = 0;
+    for (size_t i = 0; i < size; ++i)
+    {
+        value |= static_cast<std::uint64_t>(data[position + i]) << (8 * i);
+    }
+
+    position += size;
+    return true;
+}
+
+/**
+ * @brief Упаковывает обычные файлы каталога в один контейнер.
+ *
+ * Эта функция рекурсивно обходит source_dir и записывает содержимое файлов
+ * (в порядке путей) одним потоком открытого текста, за которым следует
+ * оглавление. Вызывающий поток читает файлы прямо в буферы фрагментов,
+ * полные фрагменты шифруются и записываются рабочими потоками, у каждого
+ * из которых свои ключ и контекст хэширования. Количество буферов
+ * ограничено (AKR_ARCHIVE_SLOTS на поток), поэтому память не зависит
+ * от размера каталога.
+ *
+ * Ключ вырабатывается один раз на архив, а на каждый файл приходится
+ * только open, fstat, pread и close. Файлы, которые не удалось открыть,
+ * пропускаются с предупреждением. Архив внутри упаковываемого каталога
+ * не принимается: он попал бы в собственное содержимое.
+ *
+ * @param source_dir Упаковываемый каталог.
+ * @param archive_file Путь к файлу архива.
+ * @param password Пароль, из которого вырабатывается ключ.
+ * @param options Алгоритм, режим, размер фрагмента, количество потоков и уровень проверки.
+ * @param member_count Если не nullptr, сюда записывается количество упакованных файлов.
+ * @return bool true, если архив записан и проверка пройдена, иначе false.
+ */
+bool AkrArchive::pack(const std::string& source_dir,
+                      const std::string& archive_file,
+                      const std::string& password,
+                      const AkrOptions& options,
+                      size_t* member_count)
+{
+    AkrHeader header;
+    if (!AkrContainer::init_header(options, header))
+    {
+        return false;
+    }
+    header.flags |= AKR_FLAG_ARCHIVE;
+
+    std::error_code error;
+    const fs::path source = fs::weakly_canonical(source_dir, error);
+    if (error || !fs::is_directory(source))
+    {
+        std::cerr << "Исходный каталог не найден: " << source_dir << std::endl;
+        return false;
+    }
+
+    fs::path target = fs::absolute(archive_file, error);
+    if (!error)
+    {
+        target = fs::weakly_canonical(target, error);
+    }
+
+    const fs::path relative = target.lexically_relative(source);
+    if (error || relative.empty() || *relative.begin() != "..")
+    {
+        std::cerr << "Архив не может находиться внутри упаковываемого каталога: " << archive_file << std::endl;
+        return false;
+    }
+
+    std::vector<fs::path> files;
+    auto it = fs::recursive_directory_iterator(source, fs::directory_options::skip_permission_denied, error);
+    for (; !error && it != fs::recursive_directory_iterator(); it.increment(error))
+    {
+        std::error_code status_error;
+        if (fs::is_regular_file(it->symlink_status(status_error)))
+        {
+            files.push_back(it->path());
+        }
+    }
+
+    if (error)
+    {
+        std::cerr << "Не удалось обойти каталог: " << source_dir << " (" << error.message() << ")" << std::endl;
+        return false;
+    }
+
+    std::sort(files.begin(), files.end());
+
+    int output_fd = open(archive_file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (output_fd < 0)
+    {
+        std::cerr << "Не удалось открыть файл для записи: " << archive_file << std::endl;
+        return false;
+    }
+
+    const size_t chunk_size = header.chunk_size;
+    const unsigned int threads = ParallelFor::resolve_threads(options.threads, SIZE_MAX);
+
+    struct Item
+    {
+        size_t slot;
+        size_t index;
+        size_t size;
+    };
+
+    std::vector<PooledBuffer> buffers;
+    BlockingQueue<size_t> free_slots;
+    BlockingQueue<Item>   filled;
+    std::atomic<bool>     failed{false};
+    std::atomic<std::uint64_t> stored_end{AKR_HEADER_SIZE};
+
+    for (size_t i = 0; i < threads * AKR_ARCHIVE_SLOTS; ++i)
+    {
+        buffers.push_back(BufferPool::instance().acquire(chunk_size));
+        if (!buffers.back())
+        {
+            close(output_fd);
+            return false;
+        }
+        free_slots.push(i);
+    }
+
+    std::mutex done_mutex;
+    std::vector<std::pair<AkrChunkEntry, std::uint32_t>> done;
+
+    auto worker = [&]()
+    {
+        auto key = CryptoSession::instance().acquire_key(password, AkrContainer::salt_string(header), AkrContainer::algorithm_name(header));
+        struct hash hash_ctx;
+        const bool ready = key && ak_hash_create_streebog256(&hash_ctx) == ak_error_ok;
+
+        if (!ready)
+        {
+            failed = true;
+            free_slots.close();
+        }
+
+        while (auto item = filled.pop())
+        {
+            if (!failed)
+            {
+                ak_uint8 *data = buffers[item->slot].data();
+
+                AkrChunkEntry entry;
+                entry.plain_offset  = static_cast<std::uint64_t>(item->index) * chunk_size;
+                entry.stored_offset = AKR_HEADER_SIZE + entry.plain_offset;
+                entry.plain_size    = static_cast<std::uint32_t>(item->size);
+                entry.stored_size   = entry.plain_size;
+                entry.nonce         = item->index;
+
+                const std::uint32_t checksum = AkrContainer::plain_checksum(data, item->size);
+
+                if (AkrContainer::store_chunk(output_fd, key.get(), &hash_ctx, header, entry, data, stored_end))
+                {
+                    std::lock_guard<std::mutex> lock(done_mutex);
+                    done.emplace_back(entry, checksum);
+                }
+                else
+                {
+                    failed = true;
+                    free_slots.close();
+                }
+            }
+
+            free_slots.push(item->slot);
+        }
+
+        if (ready)
+        {
+            ak_hash_destroy(&hash_ctx);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < threads; ++i)
+    {
+        workers.emplace_back(worker);
+    }
+
+    std::optional<size_t> slot = free_slots.pop();
+    size_t fill  = 0;
+    size_t index = 0;
+    std::uint64_t position = 0;
+
+    ///< Отдает заполненный фрагмент рабочим потокам и берет свободный буфер
+    auto flush = [&]()
+    {
+        if (fill > 0)
+        {
+            filled.push({*slot, index++, fill});
+            fill = 0;
+            slot = free_slots.pop();
+        }
+        return slot.has_value() && !failed;
+    };
+
+    std::vector<AkrArchiveMember> members;
+    members.reserve(files.size());
+
+    for (const auto& path : files)
+    {
+        if (!slot || failed)
+        {
+            break;
+        }
+
+        int input_fd = open(path.c_str(), O_RDONLY);
+        struct stat input_stat;
+
+        if (input_fd < 0 || fstat(input_fd, &input_stat) != 0)
+        {
+            std::cerr << "Файл пропущен, не удалось открыть: " << path.string() << std::endl;
+            if (input_fd >= 0)
+            {
+                close(input_fd);
+            }
+            continue;
+        }
+
+        AkrArchiveMember member;
+        member.name   = path.lexically_relative(source).generic_string();
+        member.offset = position;
+        member.size   = static_cast<std::uint64_t>(input_stat.st_size);
+        member.mode   = static_cast<std::uint32_t>(input_stat.st_mode & 07777);
+        member.mtime  = static_cast<std::int64_t>(input_stat.st_mtime);
+
+        for (std::uint64_t offset = 0; offset < member.size && !failed; )
+        {
+            const size_t size = static_cast<size_t>(std::min<std::uint64_t>(chunk_size - fill, member.size - offset));
+
+            if (!FileIO::pread_exact(input_fd, buffers[*slot].data() + fill, size, static_cast<off_t>(offset)))
+            {
+                std::cerr << "Не удалось прочитать файл: " << path.string() << std::endl;
+                failed = true;
+                break;
+            }
+
+            fill     += size;
+            offset   += size;
+            position += size;
+
+            if (fill == chunk_size && !flush())
+            {
+                break;
+            }
+        }
+
+        close(input_fd);
+        members.push_back(std::move(member));
+    }
+
+    const std::vector<ak_uint8> index_data = encode_index(members);
+    header.index_offset = position;
+    header.index_size   = index_data.size();
+
+    for (size_t offset = 0; offset < index_data.size() && slot && !failed; )
+    {
+        const size_t size = std::min(chunk_size - fill, index_data.size() - offset);
+        std::memcpy(buffers[*slot].data() + fill, index_data.data() + offset, size);
+
+        fill     += size;
+        offset   += size;
+        position += size;
+
+        if (fill == chunk_size && !flush())
+        {
+            break;
+        }
+    }
+
+    if (slot && !failed)
+    {
+        flush();
+    }
+
+    filled.close();
+    for (auto& thread : workers)
+    {
+        thread.join();
+    }
+
+    bool success = !failed && done.size() == index;
+
+    if (success)
+    {
+        std::sort(done.begin(), done.end(), [](const auto& a, const auto& b) { return a.first.nonce < b.first.nonce; });
+
+        std::vector<AkrChunkEntry> entries;
+        std::vector<std::uint32_t> checksums;
+        entries.reserve(done.size());
+        checksums.reserve(done.size());
+
+        for (const auto& chunk : done)
+        {
+            entries.push_back(chunk.first);
+            checksums.push_back(chunk.second);
+        }
+
+        header.plain_size   = position;
+        header.chunk_count  = entries.size();
+        header.table_offset = AKR_HEADER_SIZE + position;
+        AkrContainer::close_layout(header, stored_end);
+
+        success = AkrContainer::finish_file(output_fd, header, entries, checksums, options.verify, password, options.threads);
+    }
+
+    close(output_fd);
+
+    if (!success)
+    {
+        std::cerr << "Не удалось упаковать каталог: " << source_dir << std::endl;
+    }
+    else if (member_count)
+    {
+        *member_count = members.size();
+    }
+
+    return success;
+}
+
+/**
+ * @brief Читает оглавление архива.
+ *
+ * @param archive_file Путь к архиву.
+ * @param password Пароль, из которого вырабатывается ключ.
+ * @param members Вектор, в который записывается оглавление.
+ * @return bool true, если оглавление прочитано, иначе false.
+ */
+bool AkrArchive::list(const std::string& archive_file, const std::string& password, std::vector<AkrArchiveMember>& members)
+{
+    AkrReader reader;
+    return reader.open(archive_file, password) && read_index(reader, members);
+}
+
+/**
+ * @brief Извлекает все файлы архива или один файл по имени.
+ *
+ * Расшифровываются только фрагменты оглавления и фрагменты с содержимым
+ * извлекаемых файлов. Права доступа и время изменения восстанавливаются.
+ * Имена с абсолютным путем или компонентом ".." отвергаются.
+ *
+ * @param archive_file Путь к архиву.
+ * @param password Пароль, из которого вырабатывается ключ.
+ * @param output_dir Каталог, в который извлекаются файлы.
+ * @param member Имя файла в архиве (пустая строка - все файлы).
+ * @return bool true, если все запрошенные файлы извлечены, иначе false.
+ */
+bool AkrArchive::extract(const std::string& archive_file,
+                         const std::string& password,
+                         const std::string& output_dir,
+                         const std::string& member)
+{
+    AkrReader reader;
+    std::vector<AkrArchiveMember> members;
+
+    if (!reader.open(archive_file, password) || !read_index(reader, members))
+    {
+        return false;
+    }
+
+    bool found = member.empty();
+    bool success = true;
+
+    for (const auto& entry : members)
+    {
+        if (!member.empty() && entry.name != member)
+        {
+            continue;
+        }
+
+        found = true;
+        success = extract_member(reader, entry, output_dir) && success;
+    }
+
+    if (!found)
+    {
+        std::cerr << "Файл не найден в архиве: " << member << std::endl;
+        return false;
+    }
+
+    return success;
+}
+
+/**
+ * @brief Проверяет, является ли контейнер архивом.
+ *
+ * @param header Заголовок контейнера.
+ * @return bool true, если установлен флаг AKR_FLAG_ARCHIVE.
+ */
+bool AkrArchive::is_archive(const AkrHeader& header)
+{
+    return (header.flags & AKR_FLAG_ARCHIVE) != 0;
+}
+
+/**
+ * @brief Кодирует оглавление.
+ *
+ * Формат: сигнатура AKR_ARCHIVE_INDEX_MAGIC, количество записей (8 байт),
+ * затем для каждой записи длина имени (4), имя, offset (8), size (8),
+ * mode (4), mtime (8). Числа в порядке little-endian.
+ *
+ * @param members Оглавление.
+ * @return std::vector<ak_uint8> Закодированное оглавление.
+ */
+std::vector<ak_uint8> AkrArchive::encode_index(const std::vector<AkrArchiveMember>& members)
+{
+    size_t total = AKR_MAGIC_SIZE + 8;
+    for (const auto& member : members)
+    {
+        total += 4 + member.name.size() + 8 + 8 + 4 + 8;
+    }
+
+    std::vector<ak_uint8> data(total);
+    std::memcpy(data.data(), AKR_ARCHIVE_INDEX_MAGIC, AKR_MAGIC_SIZE);
+
+    size_t position = AKR_MAGIC_SIZE;
+    put_le(data, position, members.size(), 8);
+
+    for (const auto& member : members)
+    {
+        put_le(data, position, member.name.size(), 4);
+        std::memcpy(data.data() + position, member.name.data(), member.name.size());
+        position += member.name.size();
+        put_le(data, position, member.offset, 8);
+        put_le(data, position, member.size, 8);
+        put_le(data, position, member.mode, 4);
+        put_le(data, position, static_cast<std::uint64_t>(member.mtime), 8);
+    }
+
+    return data;
+}
+
+/**
+ * @brief Разбирает оглавление и проверяет, что записи не выходят за данные.
+ *
+ * @param data Закодированное оглавление.
+ * @param data_size Размер данных файлов (смещение оглавления).
+ * @param members Вектор, в который записывается оглавление.
+ * @return bool true, если оглавление корректно, иначе false.
+ */
+bool AkrArchive::decode_index(const std::vector<ak_uint8>& data, std::uint64_t data_size, std::vector<AkrArchiveMember>& members)
+{
+    members.clear();
+
+    if (data.size() < AKR_MAGIC_SIZE || std::memcmp(data.data(), AKR_ARCHIVE_INDEX_MAGIC, AKR_MAGIC_SIZE) != 0)
+    {
+        return false;
+    }
+
+    size_t position = AKR_MAGIC_SIZE;
+    std::uint64_t count = 0;
+
+    if (!take_le(data, position, 8, count) || count > data.size())
+    {
+        return false;
+    }
+
+    members.reserve(static_cast<size_t>(count));
+
+    for (std::uint64_t i = 0; i < count; ++i)
+    {
+        AkrArchiveMember member;
+        std::uint64_t name_size = 0, mode = 0, mtime = 0;
+
+        if (!take_le(data, position, 4, name_size) ||
+            name_size > AKR_ARCHIVE_MAX_NAME || name_size > data.size() - position)
+        {
+            return false;
+        }
+
+        member.name.assign(reinterpret_cast<const char*>(data.data() + position), static_cast<size_t>(name_size));
+        position += static_cast<size_t>(name_size);
+
+        if (!take_le(data, position, 8, member.offset) ||
+            !take_le(data, position, 8, member.size) ||
+            !take_le(data, position, 4, mode) ||
+            !take_le(data, position, 8, mtime) ||
+            member.offset > data_size || member.size > data_size - member.offset)
+        {
+            return false;
+        }
+
+        member.mode  = static_cast<std::uint32_t>(mode);
+        member.mtime = static_cast<std::int64_t>(mtime);
+        members.push_back(std::move(member));
+    }
+
+    return position == data.size();
+}
+
+/**
+ * @brief Расшифровывает и разбирает оглавление открытого архива.
+ *
+ * @param reader Открытый контейнер.
+ * @param members Вектор, в который записывается оглавление.
+ * @return bool true, если оглавление прочитано, иначе false.
+ */
+bool AkrArchive::read_index(AkrReader& reader, std::vector<AkrArchiveMember>& members)
+{
+    const AkrHeader& header = reader.header();
+
+    if (!is_archive(header))
+    {
+        std::cerr << "Контейнер не является архивом" << std::endl;
+        return false;
+    }
+
+    std::vector<ak_uint8> data;
+    if (!reader.read(header.index_offset, static_cast<size_t>(header.index_size), data) ||
+        data.size() != header.index_size ||
+        !decode_index(data, header.index_offset, members))
+    {
+        std::cerr << "Поврежденное оглавление архива" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Извлекает один файл архива.
+ *
+ * @param reader Открытый контейнер.
+ * @param member Запись оглавления.
+ * @param output_dir Каталог, в который извлекается файл.
+ * @return bool true, если файл извлечен, иначе false.
+ */
+bool AkrArchive::extract_member(AkrReader& reader, const AkrArchiveMember& member, const std::string& output_dir)
+{
+    if (!is_safe_name(member.name))
+    {
+        std::cerr << "Недопустимое имя файла в архиве: " << member.name << std::endl;
+        return false;
+    }
+
+    const fs::path target = fs::path(output_dir) / member.name;
+    std::error_code error;
+    fs::create_directories(target.parent_path(), error);
+
+    int fd = open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC, member.mode & 0777);
+    if (fd < 0)
+    {
+        std::cerr << "Не удалось открыть файл для записи: " << target.string() << std::endl;
+        return false;
+    }
+
+    std::vector<ak_uint8> buffer;
+    bool success = true;
+
+    for (std::uint64_t offset = 0; offset < member.size && success; offset += buffer.size())
+    {
+        const size_t size = static_cast<size_t>(std::min<std::uint64_t>(reader.header().chunk_size, member.size - offset));
+
+        success = reader.read(member.offset + offset, size, buffer) && buffer.size() == size &&
+                  FileIO::pwrite_exact(fd, buffer.data(), buffer.size(), static_cast<off_t>(offset));
+    }
+
+    if (success)
+    {
+        const time_t mtime = static_cast<time_t>(member.mtime);
+        const struct timespec times[2] = { {mtime, 0}, {mtime, 0} };
+        futimens(fd, times);
+    }
+
+    close(fd);
+
+    if (!success)
+    {
+        std::cerr << "Не удалось извлечь файл: " << member.name << std::endl;
+    }
+
+    return success;
+}
+
+/**
+ * @brief Проверяет, что имя файла не выводит за пределы выходного каталога.
+ *
+ * @param name Имя файла в архиве.
+ * @return bool true, если путь относительный и не содержит "..".
+ */
+bool AkrArchive::is_safe_name(const std::string& name)
+{
+    const fs::path path(name);
+
+    if (name.empty() || path.is_absolute() || path.has_root_path())
+    {
+        return false;
+    }
+
+    for (const auto& part : path)
+    {
+        if (part == "..")
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file       <akr_archive.hpp>
+ * @brief      Хэдер архива мелких файлов в одном контейнере .akr.
+ *
+ *             Содержит в себе объявление архива, который упаковывает
+ *             файлы каталога в один контейнер AKR v2 с оглавлением
+ *             и позволяет извлекать их по одному.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef AKR_ARCHIVE_HPP
+#define AKR_ARCHIVE_HPP
+
+#include "akr_container.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+#define AKR_ARCHIVE_INDEX_MAGIC "AKRI"
+#define AKR_ARCHIVE_MAX_NAME    4096
+#define AKR_ARCHIVE_SLOTS       2
+
+class AkrReader;
+
+/**
+ * @brief Запись оглавления архива.
+ *
+ * name - путь относительно упакованного каталога с разделителем '/',
+ * offset и size - положение содержимого в открытом тексте контейнера.
+ */
+struct AkrArchiveMember
+{
+    std::string   name;
+    std::uint64_t offset = 0;
+    std::uint64_t size   = 0;
+    std::uint32_t mode   = 0644;
+    std::int64_t  mtime  = 0;
+};
+
+class AkrArchive
+{
+public:
+    static bool pack(const std::string& source_dir,
+                     const std::string& archive_file,
+                     const std::string& password,
+                     const AkrOptions& options = AkrOptions(),
+                     size_t* member_count = nullptr);
+
+    static bool list(const std::string& archive_file, const std::string& password, std::vector<AkrArchiveMember>& members);
+    static bool extract(const std::string& archive_file,
+                        const std::string& password,
+                        const std::string& output_dir,
+                        const std::string& member = "");
+
+    static bool is_archive(const AkrHeader& header);
+
+private:
+    static std::vector<ak_uint8> encode_index(const std::vector<AkrArchiveMember>& members);
+    static bool decode_index(const std::vector<ak_uint8>& data, std::uint64_t data_size, std::vector<AkrArchiveMember>& members);
+    static bool read_index(AkrReader& reader, std::vector<AkrArchiveMember>& members);
+    static bool extract_member(AkrReader& reader, const AkrArchiveMember& member, const std::string& output_dir);
+    static bool is_safe_name(const std::string& name);
+};
+
+#endif // AKR_ARCHIVE_HPP
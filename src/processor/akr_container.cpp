@@ -0,0 +1,1953 @@
+/**
+ * @file       <akr_container.cpp>
+ * @brief      Основной файл формата контейнера .akr версии 2.
+ *
+ *             Контейнер состоит из заголовка фиксированного размера, данных
+ *             фрагментов и таблицы фрагментов в конце файла. Заголовок хранит
+ *             алгоритм, режим, параметры выработки ключа, случайные соль и
+ *             синхропосылку файла. Таблица позволяет найти, проверить и
+ *             расшифровать любой фрагмент независимо от остальных.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "akr_container.hpp"
+#include "buffer_pool.hpp"
+#include "chunk_codec.hpp"
+#include "crypto_provider.hpp"
+#include "crypto_session.hpp"
+#include "file_io.hpp"
+#include "file_stream.hpp"
+#include "job_stats.hpp"
+#include "parallel_for.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <libakrypt.h>
+#include <zlib.h>
+
+/**
+ * @brief Состояние рабочего потока: ключ, контекст хэширования и буферы.
+ */
+struct ChunkWorker
+{
+    CryptoSession::KeyHandle key;
+    struct hash              hash_ctx;
+    bool                     hash_ready = false;
+    PooledBuffer             buffer;
+    PooledBuffer             reference;
+    std::vector<PooledBuffer> extra;   ///< Дополнительные буферы группы фрагментов
+    std::vector<ak_uint8*>   buffers;  ///< buffer и extra подряд
+
+    explicit ChunkWorker(CryptoSession::KeyHandle handle) noexcept : key(std::move(handle)) {}
+
+    ~ChunkWorker()
+    {
+        if (hash_ready)
+        {
+            ak_hash_destroy(&hash_ctx);
+        }
+    }
+};
+
+/**
+ * @brief Создает состояние рабочего потока.
+ *
+ * @param header Заголовок контейнера.
+ * @param password Пароль (пустой указатель - ключ не нужен).
+ * @param need_hash Нужен ли контекст хэширования.
+ * @param need_reference Нужен ли второй буфер для сравнения.
+ * @param group Сколько буферов фрагментов нужно (для групп из stream_group).
+ * @return std::shared_ptr<ChunkWorker> Состояние или пустой указатель при ошибке.
+ */
+static std::shared_ptr<ChunkWorker> make_chunk_worker(const AkrHeader& header,
+                                                      const std::string* password,
+                                                      bool need_hash,
+                                                      bool need_reference,
+                                                      size_t group = 1)
+{
+    auto worker = std::make_shared<ChunkWorker>(
+        password ? CryptoSession::instance().acquire_key(*password, AkrContainer::salt_string(header), AkrContainer::algorithm_name(header))
+                 : CryptoSession::KeyHandle(nullptr, [](struct bckey*) noexcept {}));
+
+    if (password && !worker->key)
+    {
+        return nullptr;
+    }
+
+    if (need_hash)
+    {
+        if (ak_hash_create_streebog256(&worker->hash_ctx) != ak_error_ok)
+        {
+            return nullptr;
+        }
+        worker->hash_ready = true;
+    }
+
+    worker->buffer = BufferPool::instance().acquire(header.chunk_size);
+    if (need_reference)
+    {
+        worker->reference = BufferPool::instance().acquire(header.chunk_size);
+    }
+
+    if (!worker->buffer || (need_reference && !worker->reference))
+    {
+        return nullptr;
+    }
+
+    worker->buffers.push_back(worker->buffer.data());
+    for (size_t i = 1; i < group; ++i)
+    {
+        worker->extra.push_back(BufferPool::instance().acquire(header.chunk_size));
+        if (!worker->extra.back())
+        {
+            return nullptr;
+        }
+        worker->buffers.push_back(worker->extra.back().data());
+    }
+
+    return worker;
+}
+
+/**
+ * @brief Записывает число в буфер в порядке little-endian.
+ */
+static void put_le(ak_uint8 *data, std::uint64_t value, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        data[i] = static_cast<ak_uint8>(value >> (8 * i));
+    }
+}
+
+/**
+ * @brief Читает число из буфера в порядке little-endian.
+ */
+static std::uint64_t get_le(const ak_uint8 *data, size_t size)
+{
+    std::uint64_t value = 0;
+    for (size_t i = 0; i < size; ++i)
+    {
+        value |= static_cast<std::uint64_t>(data[i]) << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * @brief Суммирует длины фрагментов диапазона для прогресса задания.
+ *
+ * @param entries Таблица фрагментов.
+ * @param first Номер первого фрагмента.
+ * @param count Количество фрагментов (диапазон обрезается по концу таблицы).
+ * @param stored true - хранимые длины (вход расшифрования), false - длины открытого текста.
+ */
+static std::uint64_t range_bytes(const std::vector<AkrChunkEntry>& entries, size_t first, size_t count, bool stored)
+{
+    std::uint64_t bytes = 0;
+    for (size_t i = first; i < std::min(first + count, entries.size()); ++i)
+    {
+        bytes += stored ? entries[i].stored_size : entries[i].plain_size;
+    }
+    return bytes;
+}
+
+/**
+ * @brief Возвращает текущее число итераций PBKDF2 в libakrypt.
+ */
+std::uint32_t AkrContainer::current_kdf_iterations()
+{
+    const ak_int64 iterations = ak_libakrypt_get_option_by_name("pbkdf2_iteration_count");
+    return iterations > 0 ? static_cast<std::uint32_t>(iterations) : 0;
+}
+
+/**
+ * @brief Проверяет, начинается ли файл с сигнатуры контейнера.
+ *
+ * @param file Путь к файлу.
+ * @return bool true, если файл является контейнером .akr версии 2.
+ */
+bool AkrContainer::is_container(const std::string& file)
+{
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    ak_uint8 magic[AKR_MAGIC_SIZE] = {0};
+    const bool result = FileIO::pread_exact(fd, magic, sizeof(magic), 0) &&
+                        std::memcmp(magic, AKR_MAGIC, AKR_MAGIC_SIZE) == 0;
+
+    close(fd);
+    return result;
+}
+
+/**
+ * @brief Читает и разбирает заголовок контейнера.
+ *
+ * @param fd Дескриптор файла контейнера.
+ * @param header Структура, в которую записывается заголовок.
+ * @return bool true, если заголовок прочитан и поддерживается, иначе false.
+ */
+bool AkrContainer::read_header(int fd, AkrHeader& header)
+{
+    ak_uint8 data[AKR_HEADER_SIZE] = {0};
+
+    if (!FileIO::pread_exact(fd, data, sizeof(data), 0) ||
+        std::memcmp(data, AKR_MAGIC, AKR_MAGIC_SIZE) != 0)
+    {
+        return false;
+    }
+
+    header.version = static_cast<std::uint16_t>(get_le(data + 4, 2));
+    if (header.version != AKR_VERSION ||
+        get_le(data + 6, 2) != AKR_HEADER_SIZE ||
+        get_le(data + 80, 4) != AKR_ENTRY_SIZE)
+    {
+        std::cerr << "Неподдерживаемая версия контейнера: " << header.version << std::endl;
+        return false;
+    }
+
+    header.algorithm      = data[8];
+    header.mode           = data[9];
+    header.kdf            = data[10];
+    header.codec          = data[11];
+    header.codec_level    = data[100];
+    header.next_nonce     = get_le(data + 104, 8);
+    std::memcpy(header.table_tag, data + 112, AKR_DIGEST_SIZE);
+    header.kdf_iterations = static_cast<std::uint32_t>(get_le(data + 12, 4));
+    header.chunk_size     = static_cast<std::uint32_t>(get_le(data + 16, 4));
+    header.flags          = static_cast<std::uint32_t>(get_le(data + 20, 4));
+    std::memcpy(header.salt, data + 24, AKR_SALT_SIZE);
+    std::memcpy(header.iv, data + 40, AKR_IV_SIZE);
+    header.plain_size     = get_le(data + 56, 8);
+    header.chunk_count    = get_le(data + 64, 8);
+    header.table_offset   = get_le(data + 72, 8);
+    header.index_offset   = get_le(data + 84, 8);
+    header.index_size     = get_le(data + 92, 8);
+
+    if ((header.algorithm != AKR_ALGORITHM_MAGMA && header.algorithm != AKR_ALGORITHM_KUZNECHIK) ||
+        (header.mode != AKR_MODE_OFB && header.mode != AKR_MODE_CTR && header.mode != AKR_MODE_MGM) ||
+        header.kdf != AKR_KDF_PBKDF2_STREEBOG512 ||
+        (header.codec != AKR_CODEC_NONE && header.codec != AKR_CODEC_ZLIB) ||
+        header.chunk_size == 0 || header.chunk_size > AKR_MAX_CHUNK_SIZE ||
+        ((header.flags & AKR_FLAG_ARCHIVE) &&
+         (header.index_offset > header.plain_size || header.index_size > header.plain_size - header.index_offset)))
+    {
+        std::cerr << "Поврежденный или неподдерживаемый заголовок контейнера" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Записывает заголовок контейнера в начало файла.
+ *
+ * @param fd Дескриптор файла контейнера.
+ * @param header Заголовок.
+ * @return bool true, если запись прошла успешно, иначе false.
+ */
+bool AkrContainer::write_header(int fd, const AkrHeader& header)
+{
+    ak_uint8 data[AKR_HEADER_SIZE] = {0};
+
+    std::memcpy(data, AKR_MAGIC, AKR_MAGIC_SIZE);
+    put_le(data + 4, header.version, 2);
+    put_le(data + 6, AKR_HEADER_SIZE, 2);
+    data[8]  = header.algorithm;
+    data[9]  = header.mode;
+    data[10] = header.kdf;
+    data[11] = header.codec;
+    put_le(data + 12, header.kdf_iterations, 4);
+    put_le(data + 16, header.chunk_size, 4);
+    put_le(data + 20, header.flags, 4);
+    std::memcpy(data + 24, header.salt, AKR_SALT_SIZE);
+    std::memcpy(data + 40, header.iv, AKR_IV_SIZE);
+    put_le(data + 56, header.plain_size, 8);
+    put_le(data + 64, header.chunk_count, 8);
+    put_le(data + 72, header.table_offset, 8);
+    put_le(data + 80, AKR_ENTRY_SIZE, 4);
+    put_le(data + 84, header.index_offset, 8);
+    put_le(data + 92, header.index_size, 8);
+    data[100] = header.codec_level;
+    put_le(data + 104, header.next_nonce, 8);
+    std::memcpy(data + 112, header.table_tag, AKR_DIGEST_SIZE);
+
+    return FileIO::pwrite_exact(fd, data, sizeof(data), 0);
+}
+
+/**
+ * @brief Читает таблицу фрагментов контейнера.
+ *
+ * @param fd Дескриптор файла контейнера.
+ * @param header Заголовок контейнера.
+ * @param entries Вектор, в который записываются записи таблицы.
+ * @return bool true, если таблица прочитана и согласована с заголовком, иначе false.
+ */
+bool AkrContainer::read_table(int fd, const AkrHeader& header, std::vector<AkrChunkEntry>& entries)
+{
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0)
+    {
+        return false;
+    }
+
+    const std::uint64_t file_size = static_cast<std::uint64_t>(file_stat.st_size);
+
+    if (header.flags & AKR_FLAG_STORE)
+    {
+        std::cerr << "Это хранилище фрагментов: файлы из него восстанавливаются по описи" << std::endl;
+        return false;
+    }
+
+    if (header.table_offset < AKR_HEADER_SIZE ||
+        header.table_offset > file_size ||
+        header.chunk_count > (file_size - header.table_offset) / AKR_ENTRY_SIZE)
+    {
+        std::cerr << "Поврежденная таблица фрагментов контейнера" << std::endl;
+        return false;
+    }
+
+    std::vector<ak_uint8> data(header.chunk_count * AKR_ENTRY_SIZE);
+    if (!FileIO::pread_exact(fd, data.data(), data.size(), static_cast<off_t>(header.table_offset)))
+    {
+        return false;
+    }
+
+    entries.assign(header.chunk_count, AkrChunkEntry());
+
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const ak_uint8 *record = data.data() + i * AKR_ENTRY_SIZE;
+        AkrChunkEntry& entry = entries[i];
+
+        entry.plain_offset  = get_le(record, 8);
+        entry.stored_offset = get_le(record + 8, 8);
+        entry.plain_size    = static_cast<std::uint32_t>(get_le(record + 16, 4));
+        entry.stored_size   = static_cast<std::uint32_t>(get_le(record + 20, 4));
+        entry.nonce         = get_le(record + 24, 8);
+        entry.flags         = static_cast<std::uint32_t>(get_le(record + 32, 4));
+        std::memcpy(entry.digest, record + 40, AKR_DIGEST_SIZE);
+    }
+
+    if (!validate(header, entries, file_size))
+    {
+        std::cerr << "Поврежденная таблица фрагментов контейнера" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Записывает таблицу фрагментов по смещению header.table_offset.
+ *
+ * @param fd Дескриптор файла контейнера.
+ * @param header Заголовок контейнера.
+ * @param entries Записи таблицы.
+ * @return bool true, если запись прошла успешно, иначе false.
+ */
+bool AkrContainer::write_table(int fd, const AkrHeader& header, const std::vector<AkrChunkEntry>& entries)
+{
+    std::vector<ak_uint8> data(entries.size() * AKR_ENTRY_SIZE, 0);
+
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        ak_uint8 *record = data.data() + i * AKR_ENTRY_SIZE;
+        const AkrChunkEntry& entry = entries[i];
+
+        put_le(record, entry.plain_offset, 8);
+        put_le(record + 8, entry.stored_offset, 8);
+        put_le(record + 16, entry.plain_size, 4);
+        put_le(record + 20, entry.stored_size, 4);
+        put_le(record + 24, entry.nonce, 8);
+        put_le(record + 32, entry.flags, 4);
+        std::memcpy(record + 40, entry.digest, AKR_DIGEST_SIZE);
+    }
+
+    return FileIO::pwrite_exact(fd, data.data(), data.size(), static_cast<off_t>(header.table_offset));
+}
+
+/**
+ * @brief Проверяет, что записи таблицы не выходят за пределы файла и буферов.
+ *
+ * Сжатый фрагмент допустим только в контейнере со сжатием и должен быть
+ * короче открытого текста, несжатый хранится байт в байт. Фрагменты
+ * должны покрывать открытый текст подряд и без пропусков, а в обновляемом
+ * контейнере их nonce должны быть меньше header.next_nonce.
+ *
+ * @param header Заголовок контейнера.
+ * @param entries Записи таблицы.
+ * @param file_size Размер файла контейнера.
+ * @return bool true, если таблица согласована, иначе false.
+ */
+bool AkrContainer::validate(const AkrHeader& header, const std::vector<AkrChunkEntry>& entries, std::uint64_t file_size)
+{
+    std::uint64_t total = 0;
+
+    for (const auto& entry : entries)
+    {
+        const bool compressed = (entry.flags & AKR_CHUNK_COMPRESSED) != 0;
+
+        if (entry.plain_size > header.chunk_size ||
+            (compressed ? (header.codec == AKR_CODEC_NONE || entry.stored_size >= entry.plain_size)
+                        : entry.stored_size != entry.plain_size) ||
+            entry.plain_offset != total ||
+            entry.plain_offset > header.plain_size ||
+            ((header.flags & AKR_FLAG_INCREMENTAL) && entry.nonce >= header.next_nonce) ||
+            entry.plain_size > header.plain_size - entry.plain_offset ||
+            entry.stored_offset < AKR_HEADER_SIZE ||
+            entry.stored_offset > header.table_offset ||
+            entry.stored_size > header.table_offset - entry.stored_offset ||
+            header.table_offset > file_size)
+        {
+            return false;
+        }
+
+        total += entry.plain_size;
+    }
+
+    return total == header.plain_size;
+}
+
+/**
+ * @brief Заполняет буфер случайными байтами из /dev/urandom.
+ *
+ * @param data Буфер.
+ * @param size Длина буфера.
+ * @return bool true, если буфер заполнен, иначе false.
+ */
+bool AkrContainer::fill_random(ak_uint8 *data, size_t size)
+{
+    struct random generator;
+
+    if (ak_random_create_urandom(&generator) != ak_error_ok)
+    {
+        std::cerr << "Не удалось создать генератор случайных чисел" << std::endl;
+        return false;
+    }
+
+    const bool result = (ak_random_ptr(&generator, data, size) == ak_error_ok);
+    ak_random_destroy(&generator);
+
+    return result;
+}
+
+/**
+ * @brief Код алгоритма в заголовке для политики шифра.
+ */
+template <typename Cipher>
+static constexpr std::uint8_t header_algorithm()
+{
+    return std::is_same_v<Cipher, Kuznechik> ? AKR_ALGORITHM_KUZNECHIK : AKR_ALGORITHM_MAGMA;
+}
+
+/**
+ * @brief Код режима в заголовке для политики режима.
+ */
+template <typename Mode>
+static constexpr std::uint8_t header_mode()
+{
+    if constexpr (std::is_same_v<Mode, Ctr>)
+    {
+        return AKR_MODE_CTR;
+    }
+    else if constexpr (std::is_same_v<Mode, Mgm>)
+    {
+        return AKR_MODE_MGM;
+    }
+    else
+    {
+        return AKR_MODE_OFB;
+    }
+}
+
+/**
+ * @brief Заполняет заголовок нового контейнера по параметрам шифрования.
+ *
+ * Эта функция выбирает Engine по именам алгоритма и режима (dispatch_engine),
+ * записывает в заголовок их коды, выравнивает размер фрагмента
+ * по блоку алгоритма и генерирует случайную синхропосылку файла. Соль
+ * генерируется, только если она не передана: несколько файлов одного
+ * задания могут использовать общую соль и, значит, один выработанный ключ.
+ *
+ * @param options Алгоритм, режим, сжатие и размер фрагмента.
+ * @param header Заголовок, который будет заполнен.
+ * @param salt Соль длиной AKR_SALT_SIZE или nullptr для случайной соли.
+ * @return bool true, если параметры поддерживаются, иначе false.
+ */
+bool AkrContainer::init_header(const AkrOptions& options, AkrHeader& header, const ak_uint8 *salt)
+{
+    header = AkrHeader();
+
+    size_t block_size = 0;
+
+    const bool known = dispatch_engine(options.algorithm, options.mode, [&](auto engine)
+    {
+        using E = decltype(engine);
+
+        header.algorithm = header_algorithm<typename E::cipher_type>();
+        header.mode      = header_mode<typename E::mode_type>();
+        block_size       = E::block_size;
+    });
+
+    if (!known)
+    {
+        if (!dispatch_cipher(options.algorithm, [](auto) {}))
+        {
+            std::cerr << "Неподдерживаемый алгоритм: " << options.algorithm << std::endl;
+        }
+        else
+        {
+            std::cerr << "Неподдерживаемый режим: " << options.mode << std::endl;
+        }
+        return false;
+    }
+
+    if (options.compression == "zlib")
+    {
+        if (options.level < 1 || options.level > 9)
+        {
+            std::cerr << "Уровень сжатия должен быть от 1 до 9: " << options.level << std::endl;
+            return false;
+        }
+
+        header.codec       = AKR_CODEC_ZLIB;
+        header.codec_level = static_cast<std::uint8_t>(options.level);
+    }
+    else if (options.compression != "none")
+    {
+        std::cerr << "Неподдерживаемое сжатие: " << options.compression << std::endl;
+        return false;
+    }
+
+    size_t chunk_size = std::min<size_t>(options.chunk_size, AKR_MAX_CHUNK_SIZE);
+    chunk_size -= chunk_size % block_size;
+
+    header.chunk_size     = static_cast<std::uint32_t>(chunk_size ? chunk_size : AKR_CHUNK_SIZE);
+    header.kdf_iterations = current_kdf_iterations();
+
+    if (salt)
+    {
+        std::memcpy(header.salt, salt, AKR_SALT_SIZE);
+    }
+    else if (!fill_random(header.salt, AKR_SALT_SIZE))
+    {
+        return false;
+    }
+
+    return fill_random(header.iv, AKR_IV_SIZE);
+}
+
+/**
+ * @brief Строит таблицу фрагментов для файла заданного размера.
+ *
+ * Фрагменты хранятся подряд сразу за заголовком, таблица - за ними.
+ * Для контейнера со сжатием это верхняя оценка: настоящие смещения
+ * назначает store_chunk, а положение таблицы - close_layout.
+ *
+ * @param header Заголовок с заполненным chunk_size. Функция записывает в него
+ *               plain_size, chunk_count и table_offset.
+ * @param plain_size Размер открытого текста.
+ * @param entries Таблица фрагментов, которая будет заполнена.
+ */
+void AkrContainer::plan_chunks(AkrHeader& header, std::uint64_t plain_size, std::vector<AkrChunkEntry>& entries)
+{
+    header.plain_size   = plain_size;
+    header.chunk_count  = (header.plain_size + header.chunk_size - 1) / header.chunk_size;
+    header.table_offset = AKR_HEADER_SIZE + header.plain_size;
+
+    entries.assign(header.chunk_count, AkrChunkEntry());
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        entries[i].plain_offset  = static_cast<std::uint64_t>(i) * header.chunk_size;
+        entries[i].stored_offset = AKR_HEADER_SIZE + entries[i].plain_offset;
+        entries[i].plain_size    = static_cast<std::uint32_t>(std::min<std::uint64_t>(header.chunk_size, header.plain_size - entries[i].plain_offset));
+        entries[i].stored_size   = entries[i].plain_size;
+        entries[i].nonce         = i;
+    }
+}
+
+/**
+ * @brief Шифрует подряд идущие фрагменты файла.
+ *
+ * Для каждого фрагмента открытый текст читается из input_fd, запоминается
+ * его CRC32, фрагмент сжимается, шифруется и записывается в output_fd
+ * (store_chunk). Разные диапазоны одного файла можно шифровать из разных
+ * потоков, если у каждого потока свои ключ, контекст и буферы.
+ *
+ * Если буферов несколько и stream_group разрешает группы, фрагменты
+ * читаются группами и шифруются одним вызовом apply_ciphers, который
+ * обрабатывает их как независимые потоки OFB одновременно.
+ *
+ * @param input_fd Дескриптор исходного файла.
+ * @param output_fd Дескриптор контейнера.
+ * @param key Ключ шифрования.
+ * @param ctx Контекст хэширования Стрибог-256.
+ * @param buffers Буферы размером не меньше header.chunk_size каждый.
+ * @param buffer_count Количество буферов (не меньше одного).
+ * @param header Заголовок контейнера.
+ * @param entries Таблица фрагментов (заполняются digest записей диапазона).
+ * @param checksums Контрольные суммы открытого текста по фрагментам.
+ * @param stored_end Конец записанных данных контейнера (общий для всех потоков файла).
+ * @param first Номер первого фрагмента диапазона.
+ * @param count Количество фрагментов.
+ * @return bool true, если все фрагменты диапазона зашифрованы и записаны.
+ */
+bool AkrContainer::encrypt_range(int input_fd,
+                                 int output_fd,
+                                 struct bckey *key,
+                                 struct hash *ctx,
+                                 ak_uint8 *const *buffers,
+                                 size_t buffer_count,
+                                 const AkrHeader& header,
+                                 std::vector<AkrChunkEntry>& entries,
+                                 std::vector<std::uint32_t>& checksums,
+                                 std::atomic<std::uint64_t>& stored_end,
+                                 size_t first,
+                                 size_t count)
+{
+    const size_t end   = std::min(first + count, entries.size());
+    const size_t group = std::min(buffer_count, stream_group(header, key));
+
+    for (size_t index = first; index < end; index += group)
+    {
+        const size_t size = std::min(group, end - index);
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            AkrChunkEntry& entry = entries[index + i];
+
+            if (!FileIO::pread_exact(input_fd, buffers[i], entry.plain_size, static_cast<off_t>(entry.plain_offset)))
+            {
+                return false;
+            }
+
+            checksums[index + i] = plain_checksum(buffers[i], entry.plain_size);
+        }
+
+        if (size == 1)
+        {
+            if (!store_chunk(output_fd, key, ctx, header, entries[index], buffers[0], stored_end))
+            {
+                return false;
+            }
+            continue;
+        }
+
+        // Группы бывают только без сжатия, поэтому место фрагментов уже задано plan_chunks
+        for (size_t i = 0; i < size; ++i)
+        {
+            entries[index + i].flags       = 0;
+            entries[index + i].stored_size = entries[index + i].plain_size;
+        }
+
+        if (!apply_ciphers(key, header, &entries[index], buffers, size))
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            AkrChunkEntry& entry = entries[index + i];
+
+            chunk_digest(ctx, buffers[i], entry.stored_size, entry.digest);
+
+            if (!FileIO::pwrite_exact(output_fd, buffers[i], entry.stored_size, static_cast<off_t>(entry.stored_offset)))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Сколько фрагментов выгодно шифровать одной группой.
+ *
+ * В режиме OFB блоки одного фрагмента шифруются строго по очереди, но
+ * разные фрагменты независимы. Если ключ связан с MagmaKernel, несколько
+ * фрагментов шифруются одновременно (CryptoSession::ofb_streams), и группа
+ * равна числу его дорожек. Группа ограничена AKR_GROUP_BYTES, чтобы
+ * буферы потока не росли вместе с размером фрагмента, а при сжатии
+ * группы не используются (сжатый фрагмент лежит в буфере ChunkCodec,
+ * общем для потока).
+ *
+ * @param header Заголовок контейнера.
+ * @param key Ключ контейнера.
+ * @param chunks Количество фрагментов (0 - не ограничивать).
+ * @param threads Количество потоков, между которыми делятся фрагменты.
+ * @return size_t Размер группы (1 - фрагменты шифруются по одному).
+ */
+size_t AkrContainer::stream_group(const AkrHeader& header, struct bckey *key, size_t chunks, unsigned int threads)
+{
+    if (header.mode != AKR_MODE_OFB || header.codec != AKR_CODEC_NONE || !key)
+    {
+        return 1;
+    }
+
+    size_t group = std::min(CryptoSession::instance().stream_lanes(key),
+                            std::max<size_t>(1, AKR_GROUP_BYTES / std::max<std::uint32_t>(1, header.chunk_size)));
+
+    // Группы не должны оставлять потоки без работы
+    if (chunks > 0)
+    {
+        group = std::min(group, chunks / ParallelFor::resolve_threads(threads, chunks));
+    }
+
+    return std::max<size_t>(1, group);
+}
+
+/**
+ * @brief Сжимает, шифрует и записывает один фрагмент.
+ *
+ * Если в заголовке выбрано сжатие, фрагмент сначала сжимается; несжимаемый
+ * фрагмент хранится как есть. Сжатому фрагменту место в контейнере
+ * выделяется в момент записи сдвигом stored_end, поэтому потоки пишут
+ * без ожидания друг друга. Без сжатия используется смещение из таблицы.
+ *
+ * @param output_fd Дескриптор контейнера.
+ * @param key Ключ шифрования.
+ * @param ctx Контекст хэширования Стрибог-256.
+ * @param header Заголовок контейнера.
+ * @param entry Запись таблицы с заполненными plain_offset, plain_size и nonce.
+ * @param data Буфер с открытым текстом фрагмента (портится при шифровании).
+ * @param stored_end Конец записанных данных контейнера.
+ * @return bool true, если фрагмент записан, иначе false.
+ */
+bool AkrContainer::store_chunk(int output_fd,
+                               struct bckey *key,
+                               struct hash *ctx,
+                               const AkrHeader& header,
+                               AkrChunkEntry& entry,
+                               ak_uint8 *data,
+                               std::atomic<std::uint64_t>& stored_end)
+{
+    ak_uint8 *stored = data;
+
+    entry.flags       = 0;
+    entry.stored_size = entry.plain_size;
+
+    if (header.codec != AKR_CODEC_NONE)
+    {
+        StageTimer timer(STAGE_COMPRESS, entry.plain_size);
+        size_t packed_size = 0;
+
+        if (ChunkCodec::local().compress(data, entry.plain_size, header.codec_level, stored, packed_size))
+        {
+            entry.flags      |= AKR_CHUNK_COMPRESSED;
+            entry.stored_size = static_cast<std::uint32_t>(packed_size);
+            timer.set_output(packed_size);
+        }
+    }
+
+    if (!encrypt_chunk(key, ctx, header, entry, stored))
+    {
+        return false;
+    }
+
+    if (header.codec != AKR_CODEC_NONE)
+    {
+        entry.stored_offset = stored_end.fetch_add(entry.stored_size);
+    }
+
+    return FileIO::pwrite_exact(output_fd, stored, entry.stored_size, static_cast<off_t>(entry.stored_offset));
+}
+
+/**
+ * @brief Переносит таблицу фрагментов за последний записанный фрагмент.
+ *
+ * Для контейнера без сжатия положение таблицы уже задано plan_chunks.
+ *
+ * @param header Заголовок контейнера.
+ * @param stored_end Конец записанных данных контейнера.
+ */
+void AkrContainer::close_layout(AkrHeader& header, std::uint64_t stored_end)
+{
+    if (header.codec != AKR_CODEC_NONE)
+    {
+        header.table_offset = stored_end;
+    }
+}
+
+/**
+ * @brief Вычисляет имитовставку таблицы фрагментов.
+ *
+ * Имитовставка MGM без шифрования вычисляется от хэша Стрибог-256 соли,
+ * размера открытого текста, next_nonce и последовательности (длина, флаги,
+ * nonce) всех фрагментов. Синхропосылка берется для nonce AKR_TABLE_NONCE,
+ * который никогда не выдается фрагментам.
+ *
+ * @param key Ключ контейнера.
+ * @param header Заголовок контейнера.
+ * @param entries Таблица фрагментов.
+ * @param tag Буфер на AKR_DIGEST_SIZE байт для результата.
+ * @return bool true, если имитовставка вычислена, иначе false.
+ */
+bool AkrContainer::table_tag(struct bckey *key, const AkrHeader& header, const std::vector<AkrChunkEntry>& entries, ak_uint8 *tag)
+{
+    std::vector<ak_uint8> data(AKR_SALT_SIZE + 16 + entries.size() * 16, 0);
+
+    std::memcpy(data.data(), header.salt, AKR_SALT_SIZE);
+    put_le(data.data() + AKR_SALT_SIZE, header.plain_size, 8);
+    put_le(data.data() + AKR_SALT_SIZE + 8, header.next_nonce, 8);
+
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        ak_uint8 *record = data.data() + AKR_SALT_SIZE + 16 + i * 16;
+
+        put_le(record, entries[i].plain_size, 4);
+        put_le(record + 4, entries[i].flags, 4);
+        put_le(record + 8, entries[i].nonce, 8);
+    }
+
+    struct hash ctx;
+    ak_uint8 digest[32] = {0};
+
+    if (ak_hash_create_streebog256(&ctx) != ak_error_ok)
+    {
+        return false;
+    }
+    ak_hash_ptr(&ctx, data.data(), data.size(), digest, sizeof(digest));
+    ak_hash_destroy(&ctx);
+
+    const size_t block_size = engine(header).block_size;
+    ak_uint8 iv[AKR_IV_SIZE] = {0};
+
+    chunk_iv(header, AKR_TABLE_NONCE, iv, block_size);
+    std::memset(tag, 0, AKR_DIGEST_SIZE);
+
+    return ak_bckey_encrypt_mgm(key, nullptr,
+                                digest, sizeof(digest),
+                                nullptr, nullptr, 0,
+                                iv, block_size,
+                                tag, block_size) == ak_error_ok;
+}
+
+/**
+ * @brief Проверяет имитовставку таблицы обновляемого контейнера MGM.
+ *
+ * Для остальных контейнеров порядок фрагментов защищен их собственными
+ * имитовставками (или не защищен вовсе в OFB и CTR), и функция ничего не делает.
+ *
+ * @param key Ключ контейнера.
+ * @param header Заголовок контейнера.
+ * @param entries Таблица фрагментов.
+ * @return bool true, если таблица подлинна или проверка не нужна, иначе false.
+ */
+bool AkrContainer::check_table(struct bckey *key, const AkrHeader& header, const std::vector<AkrChunkEntry>& entries)
+{
+    if (!(header.flags & AKR_FLAG_INCREMENTAL) || header.mode != AKR_MODE_MGM)
+    {
+        return true;
+    }
+
+    ak_uint8 tag[AKR_DIGEST_SIZE] = {0};
+
+    if (!table_tag(key, header, entries, tag) ||
+        std::memcmp(tag, header.table_tag, AKR_DIGEST_SIZE) != 0)
+    {
+        std::cerr << "Неверная имитовставка таблицы фрагментов" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Завершает запись контейнера.
+ *
+ * Эта функция записывает таблицу фрагментов, обрезает файл по концу
+ * таблицы (место, зарезервированное под несжатые данные, больше не нужно),
+ * сверяет выбранные по verify фрагменты с контрольными суммами и последним
+ * шагом записывает заголовок.
+ *
+ * Обновляемый на месте контейнер перед записью заголовка сбрасывается
+ * на диск: пока новый заголовок не записан, действует старый заголовок
+ * со старой таблицей, и сбой или непройденная проверка в середине
+ * обновления не портят контейнер.
+ *
+ * @param fd Дескриптор контейнера, открытый на чтение и запись.
+ * @param header Заголовок контейнера.
+ * @param entries Таблица фрагментов.
+ * @param checksums Контрольные суммы открытого текста по фрагментам.
+ * @param verify Уровень проверки.
+ * @param password Пароль, из которого вырабатывается ключ.
+ * @param threads Количество потоков для проверки (0 - по числу ядер).
+ * @return bool true, если контейнер записан и проверка пройдена.
+ */
+bool AkrContainer::finish_file(int fd,
+                               const AkrHeader& header,
+                               const std::vector<AkrChunkEntry>& entries,
+                               const std::vector<std::uint32_t>& checksums,
+                               AkrVerify verify,
+                               const std::string& password,
+                               unsigned int threads)
+{
+    return write_table(fd, header, entries) &&
+           ftruncate(fd, static_cast<off_t>(header.table_offset + entries.size() * AKR_ENTRY_SIZE)) == 0 &&
+           confirm_chunks(fd, header, entries, checksums, verify, &password, threads) &&
+           (!(header.flags & AKR_FLAG_INCREMENTAL) || fdatasync(fd) == 0) &&
+           write_header(fd, header);
+}
+
+/**
+ * @brief Шифрует файл в контейнер .akr версии 2.
+ *
+ * Эта функция генерирует случайные соль и синхропосылку файла, делит
+ * файл на фрагменты по options.chunk_size байт и шифрует их параллельно.
+ * В режиме MGM для каждого фрагмента в таблицу записывается имитовставка,
+ * в режимах OFB и CTR - хэш зашифрованных данных, по которому целостность
+ * контейнера можно проверить без пароля. Если в options выбрано сжатие,
+ * фрагменты сжимаются перед шифрованием (store_chunk).
+ *
+ * Исходный файл читается один раз: во время шифрования для каждого
+ * фрагмента запоминается CRC32 открытого текста. Затем, в зависимости от
+ * options.verify, ни одного, несколько (AKR_VERIFY_SAMPLED) или все
+ * фрагменты записанного контейнера расшифровываются и сверяются с этими
+ * суммами. Повторное чтение исходного файла и побайтовое сравнение не нужны.
+ *
+ * Если задан options.control, в него добавляются обработанные байты
+ * открытого текста, а после отмены потоки не берут новые фрагменты
+ * и функция возвращает false (временный файл удаляет вызывающий код).
+ *
+ * @param input_file Путь к исходному файлу.
+ * @param output_file Путь к файлу контейнера.
+ * @param password Пароль, из которого вырабатывается ключ.
+ * @param options Алгоритм, режим, размер фрагмента, количество потоков и уровень проверки.
+ * @return bool true, если шифрование и проверка прошли успешно, иначе false.
+ */
+bool AkrContainer::encrypt_file(const std::string& input_file,
+                                const std::string& output_file,
+                                const std::string& password,
+                                const AkrOptions& options)
+{
+    AkrHeader header;
+    if (!init_header(options, header))
+    {
+        return false;
+    }
+
+    int input_fd = open(input_file.c_str(), O_RDONLY);
+    if (input_fd < 0)
+    {
+        std::cerr << "Не удалось открыть файл для чтения: " << input_file << std::endl;
+        return false;
+    }
+
+    struct stat input_stat;
+    if (fstat(input_fd, &input_stat) != 0)
+    {
+        std::cerr << "Не удалось получить размер файла: " << input_file << std::endl;
+        close(input_fd);
+        return false;
+    }
+
+    std::vector<AkrChunkEntry> entries;
+    plan_chunks(header, static_cast<std::uint64_t>(input_stat.st_size), entries);
+
+    if (options.control)
+    {
+        options.control->expect(header.plain_size);
+    }
+
+    int output_fd = open(output_file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (output_fd < 0)
+    {
+        std::cerr << "Не удалось открыть файл для записи: " << output_file << std::endl;
+        close(input_fd);
+        return false;
+    }
+
+    std::vector<std::uint32_t> checksums(entries.size(), 0);
+    std::atomic<std::uint64_t> stored_end{AKR_HEADER_SIZE};
+    bool success = ftruncate(output_fd, static_cast<off_t>(header.table_offset + entries.size() * AKR_ENTRY_SIZE)) == 0;
+
+    size_t group = 1;
+    {
+        auto key = CryptoSession::instance().acquire_key(password, salt_string(header), algorithm_name(header));
+        group = stream_group(header, key.get(), entries.size(), options.threads);
+    }
+
+    success = success && ParallelFor::run((entries.size() + group - 1) / group, options.threads, [&]() -> ParallelFor::Task
+    {
+        auto worker = make_chunk_worker(header, &password, true, false, group);
+        if (!worker)
+        {
+            return nullptr;
+        }
+
+        return [&, worker](size_t index)
+        {
+            if (JobControl::cancelled(options.control) ||
+                !encrypt_range(input_fd, output_fd, worker->key.get(), &worker->hash_ctx,
+                               worker->buffers.data(), worker->buffers.size(),
+                               header, entries, checksums, stored_end, index * group, group))
+            {
+                return false;
+            }
+
+            if (options.control)
+            {
+                options.control->advance(range_bytes(entries, index * group, group, false));
+            }
+            return true;
+        };
+    });
+
+    close_layout(header, stored_end);
+    success = success && finish_file(output_fd, header, entries, checksums, options.verify, password, options.threads);
+
+    close(input_fd);
+    close(output_fd);
+
+    if (!success && !JobControl::cancelled(options.control))
+    {
+        std::cerr << "Не удалось зашифровать файл: " << input_file << std::endl;
+    }
+
+    return success;
+}
+
+/**
+ * @brief Расшифровывает контейнер .akr.
+ *
+ * Для файлов без заголовка используется старый путь: OFB по всему файлу
+ * с ключом из пароля и пустой соли, алгоритм берется из options.algorithm.
+ *
+ * Для каждого фрагмента запоминается CRC32 расшифрованного текста, и после
+ * записи выбранные по options.verify фрагменты результата читаются заново
+ * и сверяются с этими суммами (без повторного расшифрования).
+ *
+ * @param input_file Путь к файлу контейнера.
+ * @param output_file Путь к файлу, в который будет записан результат.
+ * @param password Пароль, из которого вырабатывается ключ.
+ * @param options Количество потоков и уровень проверки (алгоритм и режим берутся из заголовка,
+ *                options.algorithm - только для файлов без заголовка).
+ * @return bool true, если расшифрование и проверка прошли успешно, иначе false.
+ */
+bool AkrContainer::decrypt_file(const std::string& input_file,
+                                const std::string& output_file,
+                                const std::string& password,
+                                const AkrOptions& options)
+{
+    if (!is_container(input_file))
+    {
+        return legacy_decrypt(input_file, output_file, password, options.algorithm);
+    }
+
+    int input_fd = open(input_file.c_str(), O_RDONLY);
+    if (input_fd < 0)
+    {
+        std::cerr << "Не удалось открыть файл для чтения: " << input_file << std::endl;
+        return false;
+    }
+
+    AkrHeader header;
+    std::vector<AkrChunkEntry> entries;
+
+    if (!read_header(input_fd, header) || !read_table(input_fd, header, entries))
+    {
+        close(input_fd);
+        return false;
+    }
+
+    if (header.kdf_iterations != current_kdf_iterations())
+    {
+        std::cerr << "Контейнер создан с другим числом итераций PBKDF2: " << header.kdf_iterations << std::endl;
+        close(input_fd);
+        return false;
+    }
+
+    size_t group = 1;
+    {
+        auto key = CryptoSession::instance().acquire_key(password, salt_string(header), algorithm_name(header));
+        if (!key || !check_table(key.get(), header, entries))
+        {
+            close(input_fd);
+            return false;
+        }
+        group = stream_group(header, key.get(), entries.size(), options.threads);
+    }
+
+    int output_fd = open(output_file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (output_fd < 0)
+    {
+        std::cerr << "Не удалось открыть файл для записи: " << output_file << std::endl;
+        close(input_fd);
+        return false;
+    }
+
+    std::vector<std::uint32_t> checksums(entries.size(), 0);
+    bool success = ftruncate(output_fd, static_cast<off_t>(header.plain_size)) == 0;
+
+    if (options.control)
+    {
+        options.control->expect(range_bytes(entries, 0, entries.size(), true));
+    }
+
+    success = success && ParallelFor::run((entries.size() + group - 1) / group, options.threads, [&]() -> ParallelFor::Task
+    {
+        auto worker = make_chunk_worker(header, &password, false, false, group);
+        if (!worker)
+        {
+            return nullptr;
+        }
+
+        return [&, worker](size_t task)
+        {
+            const size_t first = task * group;
+            const size_t size  = std::min(group, entries.size() - first);
+
+            if (JobControl::cancelled(options.control))
+            {
+                return false;
+            }
+
+            for (size_t i = 0; i < size; ++i)
+            {
+                const AkrChunkEntry& entry = entries[first + i];
+
+                if (!FileIO::pread_exact(input_fd, worker->buffers[i], entry.stored_size, static_cast<off_t>(entry.stored_offset)))
+                {
+                    return false;
+                }
+            }
+
+            if (size == 1 ? !decrypt_chunk(worker->key.get(), header, entries[first], worker->buffers[0])
+                          : !apply_ciphers(worker->key.get(), header, &entries[first], worker->buffers.data(), size))
+            {
+                return false;
+            }
+
+            for (size_t i = 0; i < size; ++i)
+            {
+                const AkrChunkEntry& entry = entries[first + i];
+
+                checksums[first + i] = plain_checksum(worker->buffers[i], entry.plain_size);
+
+                if (!FileIO::pwrite_exact(output_fd, worker->buffers[i], entry.plain_size, static_cast<off_t>(entry.plain_offset)))
+                {
+                    return false;
+                }
+            }
+
+            if (options.control)
+            {
+                options.control->advance(range_bytes(entries, first, size, true));
+            }
+            return true;
+        };
+    });
+
+    success = success && confirm_chunks(output_fd, header, entries, checksums, options.verify, nullptr, options.threads);
+
+    close(input_fd);
+    close(output_fd);
+
+    if (!success && !JobControl::cancelled(options.control))
+    {
+        std::cerr << "Не удалось расшифровать файл: " << input_file << std::endl;
+    }
+
+    return success;
+}
+
+/**
+ * @brief Проверяет, что контейнер расшифровывается в заданный файл.
+ *
+ * Эта функция параллельно расшифровывает фрагменты контейнера и сравнивает
+ * их с соответствующими участками открытого файла, ничего не записывая на диск.
+ * Файл без заголовка проверяется старым путем (OFB по всему файлу).
+ *
+ * @param plain_file Путь к открытому файлу.
+ * @param container_file Путь к файлу контейнера.
+ * @param password Пароль, из которого вырабатывается ключ.
+ * @param threads Количество потоков (0 - по числу ядер).
+ * @param legacy_algorithm Алгоритм для файла без заголовка.
+ * @return bool true, если содержимое совпадает, иначе false.
+ */
+bool AkrContainer::verify_file(const std::string& plain_file,
+                               const std::string& container_file,
+                               const std::string& password,
+                               unsigned int threads,
+                               const std::string& legacy_algorithm)
+{
+    if (!is_container(container_file))
+    {
+        return legacy_verify(plain_file, container_file, password, legacy_algorithm);
+    }
+
+    int container_fd = open(container_file.c_str(), O_RDONLY);
+    int plain_fd     = open(plain_file.c_str(), O_RDONLY);
+
+    AkrHeader header;
+    std::vector<AkrChunkEntry> entries;
+    struct stat plain_stat;
+
+    bool success = container_fd >= 0 && plain_fd >= 0 &&
+                   read_header(container_fd, header) &&
+                   read_table(container_fd, header, entries) &&
+                   fstat(plain_fd, &plain_stat) == 0 &&
+                   static_cast<std::uint64_t>(plain_stat.st_size) == header.plain_size;
+
+    success = success && ParallelFor::run(entries.size(), threads, [&]() -> ParallelFor::Task
+    {
+        auto worker = make_chunk_worker(header, &password, false, true);
+        if (!worker)
+        {
+            return nullptr;
+        }
+
+        return [&, worker](size_t index)
+        {
+            const AkrChunkEntry& entry = entries[index];
+
+            return FileIO::pread_exact(container_fd, worker->buffer.data(), entry.stored_size, static_cast<off_t>(entry.stored_offset)) &&
+                   decrypt_chunk(worker->key.get(), header, entry, worker->buffer.data()) &&
+                   FileIO::pread_exact(plain_fd, worker->reference.data(), entry.plain_size, static_cast<off_t>(entry.plain_offset)) &&
+                   std::memcmp(worker->buffer.data(), worker->reference.data(), entry.plain_size) == 0;
+        };
+    });
+
+    if (container_fd >= 0)
+    {
+        close(container_fd);
+    }
+    if (plain_fd >= 0)
+    {
+        close(plain_fd);
+    }
+
+    return success;
+}
+
+/**
+ * @brief Проверяет хэши всех фрагментов контейнера без расшифрования.
+ *
+ * Пароль для проверки не нужен: хэши считаются от зашифрованных данных.
+ * Такая проверка обнаруживает повреждение файла, но не подмену.
+ *
+ * @param container_file Путь к файлу контейнера.
+ * @param threads Количество потоков (0 - по числу ядер).
+ * @return bool true, если все хэши совпадают, иначе false.
+ */
+bool AkrContainer::check_digests(const std::string& container_file, unsigned int threads)
+{
+    int fd = open(container_file.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "Не удалось открыть файл для чтения: " << container_file << std::endl;
+        return false;
+    }
+
+    AkrHeader header;
+    std::vector<AkrChunkEntry> entries;
+
+    bool success = read_header(fd, header) && read_table(fd, header, entries);
+
+    if (success && header.mode == AKR_MODE_MGM)
+    {
+        std::cerr << "Фрагменты MGM защищены имитовставками, для проверки нужен пароль" << std::endl;
+        success = false;
+    }
+
+    success = success && ParallelFor::run(entries.size(), threads, [&]() -> ParallelFor::Task
+    {
+        auto worker = make_chunk_worker(header, nullptr, true, false);
+        if (!worker)
+        {
+            return nullptr;
+        }
+
+        return [&, worker](size_t index)
+        {
+            const AkrChunkEntry& entry = entries[index];
+            ak_uint8 digest[AKR_DIGEST_SIZE] = {0};
+
+            if (!FileIO::pread_exact(fd, worker->buffer.data(), entry.stored_size, static_cast<off_t>(entry.stored_offset)))
+            {
+                return false;
+            }
+
+            chunk_digest(&worker->hash_ctx, worker->buffer.data(), entry.stored_size, digest);
+
+            if (std::memcmp(digest, entry.digest, AKR_DIGEST_SIZE) != 0)
+            {
+                std::cerr << "Поврежден фрагмент " << index << " по смещению " << entry.stored_offset << std::endl;
+                return false;
+            }
+
+            return true;
+        };
+    });
+
+    close(fd);
+    return success;
+}
+
+/**
+ * @brief Проверяет имитовставки всех фрагментов контейнера.
+ *
+ * Фрагменты расшифровываются в память параллельно, открытый текст на диск
+ * не записывается. Фрагменты раздаются потокам по возрастанию номеров,
+ * и проверка прекращается на первом фрагменте с неверной имитовставкой,
+ * поэтому поврежденный контейнер не читается до конца.
+ *
+ * Для контейнеров OFB и CTR имитовставок нет, вместо них проверяются хэши.
+ *
+ * @param container_file Путь к файлу контейнера.
+ * @param password Пароль, из которого вырабатывается ключ.
+ * @param threads Количество потоков (0 - по числу ядер).
+ * @return bool true, если все фрагменты подлинны, иначе false.
+ */
+bool AkrContainer::authenticate_file(const std::string& container_file, const std::string& password, unsigned int threads)
+{
+    if (!is_container(container_file))
+    {
+        std::cerr << "Файл старого формата не содержит данных для проверки целостности: " << container_file << std::endl;
+        return false;
+    }
+
+    int fd = open(container_file.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "Не удалось открыть файл для чтения: " << container_file << std::endl;
+        return false;
+    }
+
+    AkrHeader header;
+    std::vector<AkrChunkEntry> entries;
+
+    if (!read_header(fd, header) || !read_table(fd, header, entries))
+    {
+        close(fd);
+        return false;
+    }
+
+    if (header.mode != AKR_MODE_MGM)
+    {
+        close(fd);
+        return check_digests(container_file, threads);
+    }
+
+    {
+        auto key = CryptoSession::instance().acquire_key(password, salt_string(header), algorithm_name(header));
+        if (!key || !check_table(key.get(), header, entries))
+        {
+            close(fd);
+            return false;
+        }
+    }
+
+    const bool success = ParallelFor::run(entries.size(), threads, [&]() -> ParallelFor::Task
+    {
+        auto worker = make_chunk_worker(header, &password, false, false);
+        if (!worker)
+        {
+            return nullptr;
+        }
+
+        return [&, worker](size_t index)
+        {
+            const AkrChunkEntry& entry = entries[index];
+
+            if (!FileIO::pread_exact(fd, worker->buffer.data(), entry.stored_size, static_cast<off_t>(entry.stored_offset)))
+            {
+                return false;
+            }
+
+            if (!decrypt_chunk(worker->key.get(), header, entry, worker->buffer.data()))
+            {
+                std::cerr << "Неверная имитовставка фрагмента " << index << " по смещению " << entry.stored_offset << std::endl;
+                return false;
+            }
+
+            return true;
+        };
+    });
+
+    close(fd);
+    return success;
+}
+
+/**
+ * @brief Формирует текстовое описание заголовка контейнера.
+ *
+ * @param header Заголовок контейнера.
+ * @return std::string Описание для вывода пользователю.
+ */
+std::string AkrContainer::describe(const AkrHeader& header)
+{
+    auto to_hex = [](const ak_uint8 *data, size_t size)
+    {
+        std::ostringstream stream;
+        for (size_t i = 0; i < size; ++i)
+        {
+            stream << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(data[i]);
+        }
+        return stream.str();
+    };
+
+    std::ostringstream out;
+    out << "Format:        AKR v" << header.version << "\n"
+        << "Algorithm:     " << algorithm_name(header) << "\n"
+        << "Mode:          " << mode_name(header) << "\n"
+        << "KDF:           PBKDF2-Streebog512, " << header.kdf_iterations << " iterations\n"
+        << "Compression:   " << codec_name(header);
+
+    if (header.codec != AKR_CODEC_NONE)
+    {
+        out << ", level " << static_cast<int>(header.codec_level);
+    }
+
+    out << "\n"
+        << "Salt:          " << to_hex(header.salt, AKR_SALT_SIZE) << "\n"
+        << "IV:            " << to_hex(header.iv, AKR_IV_SIZE) << "\n"
+        << "Chunk size:    " << header.chunk_size << "\n"
+        << "Chunks:        " << header.chunk_count << "\n"
+        << "Plain size:    " << header.plain_size << "\n";
+
+    if (header.flags & AKR_FLAG_ARCHIVE)
+    {
+        out << "Archive index: " << header.index_size << " bytes at " << header.index_offset << "\n";
+    }
+
+    if (header.flags & AKR_FLAG_INCREMENTAL)
+    {
+        out << "Incremental:   next nonce " << header.next_nonce << "\n";
+    }
+
+    if (header.flags & AKR_FLAG_STORE)
+    {
+        out << "Chunk store:   " << header.table_offset - AKR_HEADER_SIZE << " bytes stored, next nonce " << header.next_nonce << "\n";
+    }
+
+    return out.str();
+}
+
+/**
+ * @brief Возвращает описание Engine для шифра и режима контейнера.
+ *
+ * Это единственное место, где поля algorithm и mode заголовка превращаются
+ * в специализацию Engine<Cipher, Mode>: таблица собирается при компиляции,
+ * а выбор - обращение по индексу без сравнения строк, поэтому его можно
+ * делать для каждого фрагмента.
+ *
+ * @param header Заголовок контейнера.
+ * @return const EngineInfo& Описание (неизвестные значения - как Магма и OFB).
+ */
+const EngineInfo& AkrContainer::engine(const AkrHeader& header)
+{
+    static constexpr EngineInfo engines[2][3] =
+    {
+        { engine_info<Magma, Ofb>(),     engine_info<Magma, Ctr>(),     engine_info<Magma, Mgm>()     },
+        { engine_info<Kuznechik, Ofb>(), engine_info<Kuznechik, Ctr>(), engine_info<Kuznechik, Mgm>() }
+    };
+
+    const size_t cipher = (header.algorithm == AKR_ALGORITHM_KUZNECHIK) ? 1 : 0;
+    const size_t mode   = (header.mode == AKR_MODE_CTR) ? 1 : (header.mode == AKR_MODE_MGM) ? 2 : 0;
+
+    return engines[cipher][mode];
+}
+
+/**
+ * @brief Возвращает имя алгоритма контейнера в формате CryptoProvider.
+ *
+ * @param header Заголовок контейнера.
+ * @return std::string kuznechik или magma.
+ */
+std::string AkrContainer::algorithm_name(const AkrHeader& header)
+{
+    return engine(header).algorithm;
+}
+
+/**
+ * @brief Возвращает имя режима шифрования контейнера.
+ *
+ * @param header Заголовок контейнера.
+ * @return std::string ofb, ctr или mgm.
+ */
+std::string AkrContainer::mode_name(const AkrHeader& header)
+{
+    return engine(header).mode;
+}
+
+/**
+ * @brief Возвращает имя алгоритма сжатия контейнера.
+ *
+ * @param header Заголовок контейнера.
+ * @return std::string none или zlib.
+ */
+std::string AkrContainer::codec_name(const AkrHeader& header)
+{
+    return (header.codec == AKR_CODEC_ZLIB) ? "zlib" : "none";
+}
+
+/**
+ * @brief Разбирает название уровня проверки.
+ *
+ * @param name none, sampled или full.
+ * @param verify Переменная, в которую записывается уровень проверки.
+ * @return bool true, если название известно, иначе false.
+ */
+bool AkrContainer::parse_verify(const std::string& name, AkrVerify& verify)
+{
+    if (name == "none")         verify = AKR_VERIFY_NONE;
+    else if (name == "sampled") verify = AKR_VERIFY_SAMPLED;
+    else if (name == "full")    verify = AKR_VERIFY_FULL;
+    else                        return false;
+
+    return true;
+}
+
+/**
+ * @brief Вырабатывает синхропосылку фрагмента.
+ *
+ * Синхропосылка фрагмента получается из синхропосылки файла сложением
+ * по модулю 2 с nonce фрагмента, записанным в последние байты.
+ *
+ * @param header Заголовок контейнера.
+ * @param nonce Nonce фрагмента.
+ * @param iv Буфер для синхропосылки.
+ * @param iv_size Длина синхропосылки (не больше AKR_IV_SIZE).
+ */
+void AkrContainer::chunk_iv(const AkrHeader& header, std::uint64_t nonce, ak_uint8 *iv, size_t iv_size)
+{
+    std::memcpy(iv, header.iv, iv_size);
+
+    for (size_t i = 0; i < iv_size && i < sizeof(nonce); ++i)
+    {
+        iv[iv_size - 1 - i] ^= static_cast<ak_uint8>(nonce >> (8 * i));
+    }
+}
+
+/**
+ * @brief Шифрует или расшифровывает фрагмент на месте.
+ *
+ * Длина синхропосылки и функция гаммирования берутся из Engine шифра
+ * и режима контейнера (engine): в режиме OFB синхропосылка равна длине
+ * блока, в режиме CTR - половине длины блока. Оба режима симметричны,
+ * поэтому функция используется и для шифрования, и для расшифрования.
+ *
+ * @param key Указатель на ключ.
+ * @param header Заголовок контейнера.
+ * @param entry Запись таблицы фрагмента.
+ * @param data Буфер с данными фрагмента (entry.stored_size байт).
+ * @return bool true, если операция прошла успешно, иначе false.
+ */
+bool AkrContainer::apply_cipher(struct bckey *key, const AkrHeader& header, const AkrChunkEntry& entry, ak_uint8 *data)
+{
+    const EngineInfo& cipher = engine(header);
+    ak_uint8 iv[AKR_IV_SIZE] = {0};
+
+    if (!cipher.apply)
+    {
+        return false;
+    }
+
+    chunk_iv(header, entry.nonce, iv, cipher.iv_size);
+
+    StageTimer timer(STAGE_CIPHER, entry.stored_size);
+    int error = cipher.apply(key, data, data, entry.stored_size, iv);
+
+    if (error != ak_error_ok)
+    {
+        std::cerr << "Ошибка шифрования фрагмента: " << error << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Шифрует или расшифровывает группу фрагментов на месте.
+ *
+ * В режиме OFB фрагменты передаются в CryptoSession::ofb_streams как
+ * независимые потоки, в остальных режимах обрабатываются по одному
+ * (apply_cipher). Результат для каждого фрагмента такой же, как у apply_cipher.
+ *
+ * @param key Указатель на ключ.
+ * @param header Заголовок контейнера.
+ * @param entries Записи таблицы фрагментов группы (count подряд).
+ * @param data Буферы с данными фрагментов.
+ * @param count Количество фрагментов.
+ * @return bool true, если операция прошла успешно, иначе false.
+ */
+bool AkrContainer::apply_ciphers(struct bckey *key, const AkrHeader& header, const AkrChunkEntry *entries, ak_uint8 *const *data, size_t count)
+{
+    if (header.mode != AKR_MODE_OFB || count == 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (!apply_cipher(key, header, entries[i], data[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const size_t iv_size = engine(header).iv_size;
+    std::vector<ak_uint8> ivs(count * AKR_IV_SIZE, 0);
+    std::vector<CipherStream> streams(count);
+    StageTimer timer(STAGE_CIPHER);
+    size_t total = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        chunk_iv(header, entries[i].nonce, ivs.data() + i * AKR_IV_SIZE, iv_size);
+        total += entries[i].stored_size;
+
+        streams[i].in      = data[i];
+        streams[i].out     = data[i];
+        streams[i].size    = entries[i].stored_size;
+        streams[i].iv      = ivs.data() + i * AKR_IV_SIZE;
+        streams[i].iv_size = iv_size;
+    }
+
+    timer.set_input(total);
+    int error = CryptoSession::instance().ofb_streams(key, streams.data(), streams.size());
+
+    if (error != ak_error_ok)
+    {
+        std::cerr << "Ошибка шифрования фрагмента: " << error << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Шифрует фрагмент на месте и заполняет entry.digest.
+ *
+ * В режиме MGM фрагмент шифруется с выработкой имитовставки, которая
+ * покрывает также соль файла и положение фрагмента (chunk_adata), поэтому
+ * фрагменты нельзя незаметно переставить или перенести в другой контейнер.
+ * В режимах OFB и CTR в entry.digest записывается хэш зашифрованных данных.
+ *
+ * @param key Указатель на ключ.
+ * @param ctx Контекст хэширования Стрибог-256 (не используется в режиме MGM).
+ * @param header Заголовок контейнера.
+ * @param entry Запись таблицы фрагмента.
+ * @param data Буфер с хранимым открытым текстом фрагмента (entry.stored_size байт).
+ * @return bool true, если операция прошла успешно, иначе false.
+ */
+bool AkrContainer::encrypt_chunk(struct bckey *key, struct hash *ctx, const AkrHeader& header, AkrChunkEntry& entry, ak_uint8 *data)
+{
+    if (header.mode != AKR_MODE_MGM)
+    {
+        if (!apply_cipher(key, header, entry, data))
+        {
+            return false;
+        }
+
+        chunk_digest(ctx, data, entry.stored_size, entry.digest);
+        return true;
+    }
+
+    const size_t block_size = engine(header).block_size;
+    ak_uint8 iv[AKR_IV_SIZE] = {0};
+    ak_uint8 adata[AKR_ADATA_SIZE] = {0};
+
+    chunk_iv(header, entry.nonce, iv, block_size);
+    std::memset(entry.digest, 0, AKR_DIGEST_SIZE);
+
+    StageTimer timer(STAGE_CIPHER, entry.stored_size);
+    int error = ak_bckey_encrypt_mgm(key, key,
+                                     adata, chunk_adata(header, entry, adata),
+                                     data, data, entry.stored_size,
+                                     iv, block_size,
+                                     entry.digest, block_size);
+
+    if (error != ak_error_ok)
+    {
+        std::cerr << "Ошибка шифрования фрагмента в режиме MGM: " << error << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Расшифровывает фрагмент на месте.
+ *
+ * В режиме MGM перед возвратом проверяется имитовставка; при несовпадении
+ * функция возвращает false, и расшифрованные данные использовать нельзя.
+ * Сжатый фрагмент после расшифрования распаковывается в тот же буфер.
+ *
+ * @param key Указатель на ключ.
+ * @param header Заголовок контейнера.
+ * @param entry Запись таблицы фрагмента.
+ * @param data Буфер с зашифрованными данными фрагмента (entry.stored_size байт)
+ *             размером не меньше entry.plain_size.
+ * @return bool true, если фрагмент расшифрован и подлинен, иначе false.
+ */
+bool AkrContainer::decrypt_chunk(struct bckey *key, const AkrHeader& header, const AkrChunkEntry& entry, ak_uint8 *data)
+{
+    bool success = false;
+
+    if (header.mode != AKR_MODE_MGM)
+    {
+        success = apply_cipher(key, header, entry, data);
+    }
+    else
+    {
+        const size_t block_size = engine(header).block_size;
+        ak_uint8 iv[AKR_IV_SIZE] = {0};
+        ak_uint8 adata[AKR_ADATA_SIZE] = {0};
+        ak_uint8 tag[AKR_DIGEST_SIZE] = {0};
+
+        chunk_iv(header, entry.nonce, iv, block_size);
+        std::memcpy(tag, entry.digest, AKR_DIGEST_SIZE);
+
+        StageTimer timer(STAGE_CIPHER, entry.stored_size);
+        success = ak_bckey_decrypt_mgm(key, key,
+                                       adata, chunk_adata(header, entry, adata),
+                                       data, data, entry.stored_size,
+                                       iv, block_size,
+                                       tag, block_size) == ak_error_ok;
+    }
+
+    if (success && (entry.flags & AKR_CHUNK_COMPRESSED))
+    {
+        StageTimer timer(STAGE_COMPRESS, entry.stored_size);
+        timer.set_output(entry.plain_size);
+        success = ChunkCodec::local().decompress(data, entry.stored_size, entry.plain_size);
+    }
+
+    return success;
+}
+
+/**
+ * @brief Формирует ассоциированные данные фрагмента для режима MGM.
+ *
+ * Флаги фрагмента добавляются, только если они не нулевые, поэтому
+ * ассоциированные данные несжатых фрагментов не изменились. В обновляемом
+ * контейнере смещение фрагмента не входит в ассоциированные данные, чтобы
+ * неизмененный фрагмент мог переехать без перешифрования; порядок таких
+ * фрагментов защищает имитовставка таблицы (table_tag). То же относится
+ * к хранилищу фрагментов, где один фрагмент входит в несколько файлов.
+ *
+ * @param header Заголовок контейнера.
+ * @param entry Запись таблицы фрагмента.
+ * @param adata Буфер на AKR_ADATA_SIZE байт.
+ * @return size_t Длина ассоциированных данных.
+ */
+size_t AkrContainer::chunk_adata(const AkrHeader& header, const AkrChunkEntry& entry, ak_uint8 *adata)
+{
+    std::memcpy(adata, header.salt, AKR_SALT_SIZE);
+    put_le(adata + 16, (header.flags & (AKR_FLAG_INCREMENTAL | AKR_FLAG_STORE)) ? 0 : entry.plain_offset, 8);
+    put_le(adata + 24, entry.plain_size, 4);
+    put_le(adata + 28, entry.nonce, 8);
+
+    if (entry.flags == 0)
+    {
+        return AKR_ADATA_SIZE - 4;
+    }
+
+    put_le(adata + 36, entry.flags, 4);
+    return AKR_ADATA_SIZE;
+}
+
+/**
+ * @brief Вычисляет хэш фрагмента для таблицы.
+ *
+ * @param ctx Контекст хэширования Стрибог-256.
+ * @param data Данные фрагмента.
+ * @param size Длина данных.
+ * @param digest Буфер на AKR_DIGEST_SIZE байт для результата.
+ */
+void AkrContainer::chunk_digest(struct hash *ctx, const ak_uint8 *data, size_t size, ak_uint8 *digest)
+{
+    ak_uint8 full[32] = {0};
+
+    ak_hash_ptr(ctx, const_cast<ak_uint8*>(data), size, full, sizeof(full));
+    std::memcpy(digest, full, AKR_DIGEST_SIZE);
+}
+
+/**
+ * @brief Вычисляет контрольную сумму CRC32 открытого текста фрагмента.
+ *
+ * Контрольная сумма нужна только для сверки с тем, что было прочитано
+ * или записано в этом же запуске, поэтому достаточно быстрого CRC32 из zlib
+ * вместо криптографического хэша.
+ *
+ * @param data Открытый текст фрагмента.
+ * @param size Длина данных.
+ * @return std::uint32_t Контрольная сумма.
+ */
+std::uint32_t AkrContainer::plain_checksum(const ak_uint8 *data, size_t size)
+{
+    return static_cast<std::uint32_t>(crc32_z(0L, data, size));
+}
+
+/**
+ * @brief Возвращает соль контейнера в виде строки для выработки ключа.
+ *
+ * @param header Заголовок контейнера.
+ * @return std::string Соль.
+ */
+std::string AkrContainer::salt_string(const AkrHeader& header)
+{
+    return std::string(reinterpret_cast<const char*>(header.salt), AKR_SALT_SIZE);
+}
+
+/**
+ * @brief Выбирает номера фрагментов для проверки.
+ *
+ * При выборочной проверке всегда проверяются первый и последний фрагменты
+ * (на них чаще всего сказываются ошибки смещений и усечение файла),
+ * остальные AKR_VERIFY_SAMPLE_CHUNKS - 2 выбираются случайно.
+ *
+ * @param count Количество фрагментов.
+ * @param verify Уровень проверки.
+ * @return std::vector<size_t> Номера фрагментов по возрастанию, без повторов.
+ */
+std::vector<size_t> AkrContainer::verify_indices(size_t count, AkrVerify verify)
+{
+    std::vector<size_t> indices;
+
+    if (verify == AKR_VERIFY_NONE || count == 0)
+    {
+        return indices;
+    }
+
+    if (verify == AKR_VERIFY_FULL || count <= AKR_VERIFY_SAMPLE_CHUNKS)
+    {
+        indices.resize(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            indices[i] = i;
+        }
+        return indices;
+    }
+
+    std::uint64_t random[AKR_VERIFY_SAMPLE_CHUNKS] = {0};
+    fill_random(reinterpret_cast<ak_uint8*>(random), sizeof(random));
+
+    indices.push_back(0);
+    indices.push_back(count - 1);
+    for (size_t i = 2; i < AKR_VERIFY_SAMPLE_CHUNKS; ++i)
+    {
+        indices.push_back(static_cast<size_t>(random[i] % count));
+    }
+
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+    return indices;
+}
+
+/**
+ * @brief Сверяет записанные фрагменты с контрольными суммами открытого текста.
+ *
+ * Если передан пароль, fd - это контейнер: фрагменты читаются, расшифровываются
+ * и сверяются. Иначе fd - это расшифрованный файл, и фрагменты только читаются.
+ *
+ * @param fd Дескриптор записанного файла.
+ * @param header Заголовок контейнера.
+ * @param entries Записи таблицы фрагментов.
+ * @param checksums CRC32 открытого текста каждого фрагмента.
+ * @param verify Уровень проверки.
+ * @param password Пароль или nullptr для расшифрованного файла.
+ * @param threads Количество потоков (0 - по числу ядер).
+ * @return bool true, если все проверенные фрагменты совпали, иначе false.
+ */
+bool AkrContainer::confirm_chunks(int fd,
+                                  const AkrHeader& header,
+                                  const std::vector<AkrChunkEntry>& entries,
+                                  const std::vector<std::uint32_t>& checksums,
+                                  AkrVerify verify,
+                                  const std::string* password,
+                                  unsigned int threads)
+{
+    const std::vector<size_t> indices = verify_indices(entries.size(), verify);
+    if (indices.empty())
+    {
+        return true;
+    }
+
+    return ParallelFor::run(indices.size(), threads, [&]() -> ParallelFor::Task
+    {
+        auto worker = make_chunk_worker(header, password, false, false);
+        if (!worker)
+        {
+            return nullptr;
+        }
+
+        return [&, worker](size_t position)
+        {
+            const size_t index = indices[position];
+            const AkrChunkEntry& entry = entries[index];
+
+            const bool loaded = password
+                ? FileIO::pread_exact(fd, worker->buffer.data(), entry.stored_size, static_cast<off_t>(entry.stored_offset)) &&
+                  decrypt_chunk(worker->key.get(), header, entry, worker->buffer.data())
+                : FileIO::pread_exact(fd, worker->buffer.data(), entry.plain_size, static_cast<off_t>(entry.plain_offset));
+
+            if (!loaded || plain_checksum(worker->buffer.data(), entry.plain_size) != checksums[index])
+            {
+                std::cerr << "Проверка фрагмента " << index << " не пройдена" << std::endl;
+                return false;
+            }
+
+            return true;
+        };
+    });
+}
+
+/**
+ * @brief Расшифровывает файл старого формата (OFB без заголовка).
+ */
+bool AkrContainer::legacy_decrypt(const std::string& input_file,
+                                  const std::string& output_file,
+                                  const std::string& password,
+                                  const std::string& algorithm)
+{
+    auto key = CryptoSession::instance().acquire_key(password, "", algorithm);
+    if (!key)
+    {
+        return false;
+    }
+
+    return FileStreamProcessor::process_file_auto(input_file, output_file, key.get());
+}
+
+/**
+ * @brief Проверяет файл старого формата (OFB без заголовка).
+ */
+bool AkrContainer::legacy_verify(const std::string& plain_file,
+                                 const std::string& container_file,
+                                 const std::string& password,
+                                 const std::string& algorithm)
+{
+    auto key = CryptoSession::instance().acquire_key(password, "", algorithm);
+    if (!key)
+    {
+        return false;
+    }
+
+    return FileStreamProcessor::verify_file(plain_file, container_file, key.get());
+}
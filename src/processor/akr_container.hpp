@@ -0,0 +1,252 @@
+/**
+ * @file       <akr_container.hpp>
+ * @brief      Хэдер формата контейнера .akr версии 2.
+ *
+ *             Содержит в себе описание заголовка и таблицы фрагментов контейнера,
+ *             а также объявление функций для шифрования, расшифрования и проверки
+ *             файлов в этом формате. Файлы без заголовка считаются файлами
+ *             старого формата (OFB без заголовка) и обрабатываются отдельно.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef AKR_CONTAINER_HPP
+#define AKR_CONTAINER_HPP
+
+#include "cipher_policy.hpp"
+#include "job_control.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+#define AKR_MAGIC "AKR2"
+#define AKR_MAGIC_SIZE 4
+#define AKR_VERSION 2
+#define AKR_HEADER_SIZE 128
+#define AKR_ENTRY_SIZE 64
+#define AKR_SALT_SIZE 16
+#define AKR_IV_SIZE 16
+#define AKR_DIGEST_SIZE 16
+#define AKR_ADATA_SIZE 40
+#define AKR_CHUNK_SIZE (1 << 20)
+#define AKR_MAX_CHUNK_SIZE (64 << 20)
+#define AKR_VERIFY_SAMPLE_CHUNKS 8
+#define AKR_GROUP_BYTES (8 << 20)
+
+#define AKR_FLAG_ARCHIVE 0x1
+#define AKR_FLAG_INCREMENTAL 0x2
+#define AKR_FLAG_STORE 0x4
+#define AKR_TABLE_NONCE UINT64_MAX
+#define AKR_CHUNK_COMPRESSED 0x1
+#define AKR_COMPRESSION_LEVEL 6
+
+typedef unsigned char ak_uint8;
+
+enum AkrAlgorithm : std::uint8_t
+{
+    AKR_ALGORITHM_MAGMA     = 1,
+    AKR_ALGORITHM_KUZNECHIK = 2
+};
+
+enum AkrMode : std::uint8_t
+{
+    AKR_MODE_OFB = 1,
+    AKR_MODE_CTR = 2,
+    AKR_MODE_MGM = 3
+};
+
+enum AkrKdf : std::uint8_t
+{
+    AKR_KDF_PBKDF2_STREEBOG512 = 1
+};
+
+enum AkrCodec : std::uint8_t
+{
+    AKR_CODEC_NONE = 0,
+    AKR_CODEC_ZLIB = 1
+};
+
+/**
+ * @brief Заголовок контейнера, хранится в начале файла.
+ *
+ * Все числа записываются в порядке little-endian. Данные фрагментов идут
+ * сразу за заголовком, таблица фрагментов - в конце файла по смещению
+ * table_offset. Если установлен флаг AKR_FLAG_ARCHIVE, открытый текст -
+ * это содержимое нескольких файлов подряд, за которым идет оглавление
+ * архива (index_offset и index_size - его положение в открытом тексте).
+ *
+ * Если codec не AKR_CODEC_NONE, фрагменты перед шифрованием сжимаются
+ * с уровнем codec_level. Тогда размеры хранимых фрагментов заранее
+ * неизвестны, фрагменты лежат за заголовком в порядке записи, а их
+ * положение определяется только таблицей.
+ *
+ * Если установлен флаг AKR_FLAG_INCREMENTAL, контейнер обновляется на месте
+ * (AkrIncremental): фрагменты могут иметь разную длину и переезжать в
+ * открытом тексте, next_nonce - первый неиспользованный nonce, а в режиме
+ * MGM порядок фрагментов защищен имитовставкой таблицы table_tag.
+ *
+ * Флаг AKR_FLAG_STORE означает файл данных хранилища фрагментов (AkrStore):
+ * таблицы нет, table_offset - конец записанных данных, а фрагменты
+ * находятся по описям файлов и индексу хранилища.
+ */
+struct AkrHeader
+{
+    std::uint16_t version        = AKR_VERSION;
+    std::uint8_t  algorithm      = AKR_ALGORITHM_MAGMA;
+    std::uint8_t  mode           = AKR_MODE_OFB;
+    std::uint8_t  kdf            = AKR_KDF_PBKDF2_STREEBOG512;
+    std::uint8_t  codec          = AKR_CODEC_NONE;
+    std::uint8_t  codec_level    = 0;
+    std::uint32_t kdf_iterations = 0;
+    std::uint32_t chunk_size     = AKR_CHUNK_SIZE;
+    std::uint32_t flags          = 0;
+    ak_uint8      salt[AKR_SALT_SIZE] = {0};
+    ak_uint8      iv[AKR_IV_SIZE]     = {0};
+    std::uint64_t plain_size     = 0;
+    std::uint64_t chunk_count    = 0;
+    std::uint64_t table_offset   = 0;
+    std::uint64_t index_offset   = 0;
+    std::uint64_t index_size     = 0;
+    std::uint64_t next_nonce     = 0;
+    ak_uint8      table_tag[AKR_DIGEST_SIZE] = {0};
+};
+
+/**
+ * @brief Запись таблицы фрагментов.
+ *
+ * Каждый фрагмент шифруется независимо со своей синхропосылкой,
+ * полученной из синхропосылки файла и nonce. В режимах OFB и CTR digest -
+ * первые AKR_DIGEST_SIZE байт хэша Стрибог-256 от хранимых (зашифрованных)
+ * данных, в режиме MGM - имитовставка фрагмента длиной в блок алгоритма.
+ * Флаг AKR_CHUNK_COMPRESSED означает, что хранится сжатый открытый текст
+ * и stored_size меньше plain_size.
+ */
+struct AkrChunkEntry
+{
+    std::uint64_t plain_offset  = 0;
+    std::uint64_t stored_offset = 0;
+    std::uint32_t plain_size    = 0;
+    std::uint32_t stored_size   = 0;
+    std::uint64_t nonce         = 0;
+    std::uint32_t flags         = 0;
+    ak_uint8      digest[AKR_DIGEST_SIZE] = {0};
+};
+
+enum AkrVerify
+{
+    AKR_VERIFY_NONE = 0,
+    AKR_VERIFY_SAMPLED,
+    AKR_VERIFY_FULL
+};
+
+struct AkrOptions
+{
+    std::string  algorithm   = "magma";
+    std::string  mode        = "mgm";
+    std::string  compression = "none";
+    int          level       = AKR_COMPRESSION_LEVEL;
+    size_t       chunk_size  = AKR_CHUNK_SIZE;
+    unsigned int threads     = 0;
+    AkrVerify    verify      = AKR_VERIFY_SAMPLED;
+    JobControl  *control     = nullptr; ///< Прогресс и отмена (nullptr - без управления)
+};
+
+class AkrContainer
+{
+public:
+    static bool is_container(const std::string& file);
+    static bool read_header(int fd, AkrHeader& header);
+    static bool read_table(int fd, const AkrHeader& header, std::vector<AkrChunkEntry>& entries);
+    static bool write_header(int fd, const AkrHeader& header);
+
+    static bool init_header(const AkrOptions& options, AkrHeader& header, const ak_uint8 *salt = nullptr);
+    static void plan_chunks(AkrHeader& header, std::uint64_t plain_size, std::vector<AkrChunkEntry>& entries);
+    static bool encrypt_range(int input_fd,
+                              int output_fd,
+                              struct bckey *key,
+                              struct hash *ctx,
+                              ak_uint8 *const *buffers,
+                              size_t buffer_count,
+                              const AkrHeader& header,
+                              std::vector<AkrChunkEntry>& entries,
+                              std::vector<std::uint32_t>& checksums,
+                              std::atomic<std::uint64_t>& stored_end,
+                              size_t first,
+                              size_t count);
+    static bool store_chunk(int output_fd,
+                            struct bckey *key,
+                            struct hash *ctx,
+                            const AkrHeader& header,
+                            AkrChunkEntry& entry,
+                            ak_uint8 *data,
+                            std::atomic<std::uint64_t>& stored_end);
+    static size_t stream_group(const AkrHeader& header, struct bckey *key, size_t chunks = 0, unsigned int threads = 0);
+    static void close_layout(AkrHeader& header, std::uint64_t stored_end);
+    static bool table_tag(struct bckey *key, const AkrHeader& header, const std::vector<AkrChunkEntry>& entries, ak_uint8 *tag);
+    static bool check_table(struct bckey *key, const AkrHeader& header, const std::vector<AkrChunkEntry>& entries);
+    static bool finish_file(int fd,
+                            const AkrHeader& header,
+                            const std::vector<AkrChunkEntry>& entries,
+                            const std::vector<std::uint32_t>& checksums,
+                            AkrVerify verify,
+                            const std::string& password,
+                            unsigned int threads = 0);
+
+    static bool encrypt_file(const std::string& input_file, const std::string& output_file, const std::string& password, const AkrOptions& options = AkrOptions());
+    static bool decrypt_file(const std::string& input_file, const std::string& output_file, const std::string& password, const AkrOptions& options = AkrOptions());
+    static bool verify_file(const std::string& plain_file,
+                            const std::string& container_file,
+                            const std::string& password,
+                            unsigned int threads = 0,
+                            const std::string& legacy_algorithm = "magma");
+    static bool check_digests(const std::string& container_file, unsigned int threads = 0);
+    static bool authenticate_file(const std::string& container_file, const std::string& password, unsigned int threads = 0);
+
+    static std::string describe(const AkrHeader& header);
+    static const EngineInfo& engine(const AkrHeader& header);
+    static std::string algorithm_name(const AkrHeader& header);
+    static std::string mode_name(const AkrHeader& header);
+    static std::string codec_name(const AkrHeader& header);
+    static bool parse_verify(const std::string& name, AkrVerify& verify);
+
+    static void chunk_iv(const AkrHeader& header, std::uint64_t nonce, ak_uint8 *iv, size_t iv_size);
+    static bool apply_cipher(struct bckey *key, const AkrHeader& header, const AkrChunkEntry& entry, ak_uint8 *data);
+    static bool apply_ciphers(struct bckey *key, const AkrHeader& header, const AkrChunkEntry *entries, ak_uint8 *const *data, size_t count);
+    static bool encrypt_chunk(struct bckey *key, struct hash *ctx, const AkrHeader& header, AkrChunkEntry& entry, ak_uint8 *data);
+    static bool decrypt_chunk(struct bckey *key, const AkrHeader& header, const AkrChunkEntry& entry, ak_uint8 *data);
+    static void chunk_digest(struct hash *ctx, const ak_uint8 *data, size_t size, ak_uint8 *digest);
+    static std::uint32_t plain_checksum(const ak_uint8 *data, size_t size);
+    static std::string salt_string(const AkrHeader& header);
+    static std::uint32_t current_kdf_iterations();
+    static std::vector<size_t> verify_indices(size_t count, AkrVerify verify);
+
+private:
+    static bool write_table(int fd, const AkrHeader& header, const std::vector<AkrChunkEntry>& entries);
+    static bool validate(const AkrHeader& header, const std::vector<AkrChunkEntry>& entries, std::uint64_t file_size);
+    static bool fill_random(ak_uint8 *data, size_t size);
+    static size_t chunk_adata(const AkrHeader& header, const AkrChunkEntry& entry, ak_uint8 *adata);
+    static bool confirm_chunks(int fd,
+                               const AkrHeader& header,
+                               const std::vector<AkrChunkEntry>& entries,
+                               const std::vector<std::uint32_t>& checksums,
+                               AkrVerify verify,
+                               const std::string* password,
+                               unsigned int threads);
+
+    static bool legacy_decrypt(const std::string& input_file, const std::string& output_file, const std::string& password, const std::string& algorithm);
+    static bool legacy_verify(const std::string& plain_file, const std::string& container_file, const std::string& password, const std::string& algorithm);
+};
+
+#endif // AKR_CONTAINER_HPP
@@ -0,0 +1,711 @@
+/**
+ * @file       <akr_incremental.cpp>
+ * @brief      Основной файл инкрементального перешифрования в контейнер .akr.
+ *
+ *             Контейнер с флагом AKR_FLAG_INCREMENTAL обновляется на месте:
+ *             неизмененные фрагменты остаются там, где были, измененные
+ *             дописываются в конец файла вместе с новой таблицей, и только
+ *             после этого записывается новый заголовок. Место, которое
+ *             занимали удаленные фрагменты, освобождается уплотнением,
+ *             когда его становится больше AKR_INCREMENTAL_GARBAGE процентов.
+ *
+ *             Манифест <контейнер>.manifest хранит отпечатки открытого
+ *             текста фрагментов: первые AKR_DIGEST_SIZE байт хэша Стрибог-256,
+ *             зашифрованного в режиме простой замены ключом, выработанным
+ *             из пароля и соли контейнера. Без пароля по манифесту нельзя
+ *             проверить догадку о содержимом фрагмента.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "akr_incremental.hpp"
+#include "buffer_pool.hpp"
+#include "content_chunker.hpp"
+#include "crypto_session.hpp"
+#include "file_io.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <libakrypt.h>
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Записывает число в буфер в порядке little-endian.
+ */
+static void put_le(ak_uint8 *data, std::uint64_t value, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        data[i] = static_cast<ak_uint8>(value >> (8 * i));
+    }
+}
+
+/**
+ * @brief Читает число из буфера в порядке little-endian.
+ */
+static std::uint64_t get_le(const ak_uint8 *data, size_t size)
+{
+    std::uint64_t value = 0;
+    for (size_t i = 0; i < size; ++i)
+    {
+        value |= static_cast<std::uint64_t>(data[i]) << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * @brief Состояние рабочего потока: ключ контейнера и контекст хэширования.
+ */
+struct ChunkHasher
+{
+    CryptoSession::KeyHandle key;
+    struct hash              hash_ctx;
+    bool                     hash_ready = false;
+
+    explicit ChunkHasher(CryptoSession::KeyHandle handle) : key(std::move(handle))
+    {
+        hash_ready = ak_hash_create_streebog256(&hash_ctx) == ak_error_ok;
+    }
+
+    ~ChunkHasher()
+    {
+        if (hash_ready)
+        {
+            ak_hash_destroy(&hash_ctx);
+        }
+    }
+};
+
+/**
+ * @brief Проверяет, что существующий контейнер можно обновлять с новыми параметрами.
+ */
+static bool same_layout(const AkrHeader& header, const AkrHeader& fresh)
+{
+    return (header.flags & AKR_FLAG_INCREMENTAL) &&
+           header.algorithm      == fresh.algorithm &&
+           header.mode           == fresh.mode &&
+           header.codec          == fresh.codec &&
+           header.codec_level    == fresh.codec_level &&
+           header.chunk_size     == fresh.chunk_size &&
+           header.kdf_iterations == fresh.kdf_iterations;
+}
+
+/**
+ * @brief Вычисляет отпечаток открытого текста фрагмента.
+ *
+ * Ключ манифеста общий для всех потоков, поэтому шифрование хэша
+ * выполняется под мьютексом; оно занимает несколько блоков и не мешает
+ * параллельному хэшированию.
+ */
+static void make_fingerprint(struct hash *ctx,
+                             struct bckey *key,
+                             std::mutex& key_mutex,
+                             const ak_uint8 *data,
+                             size_t size,
+                             AkrIncremental::Fingerprint& fingerprint)
+{
+    ak_uint8 digest[32] = {0};
+    ak_uint8 empty = 0;
+
+    ak_hash_ptr(ctx, const_cast<ak_uint8*>(size ? data : &empty), size, digest, sizeof(digest));
+
+    {
+        std::lock_guard<std::mutex> lock(key_mutex);
+        CryptoSession::instance().encrypt_ecb(key, digest, digest, sizeof(digest));
+    }
+
+    std::memcpy(fingerprint.data(), digest, fingerprint.size());
+}
+
+/**
+ * @brief Шифрует файл в обновляемый контейнер или обновляет существующий.
+ *
+ * Файл делится на фрагменты по содержимому (ContentChunker::split_file)
+ * длиной от chunk_size / 4 до chunk_size. Рабочие потоки считают
+ * отпечатки фрагментов и ищут их в манифесте: найденный фрагмент берется из старой таблицы без
+ * перешифрования (даже если он сдвинулся), остальные получают новые
+ * nonce, шифруются и дописываются в конец контейнера.
+ *
+ * Контейнер создается заново (через временный файл), если его нет, если
+ * манифест отсутствует или устарел, или если изменились алгоритм, режим,
+ * сжатие или размер фрагмента. Если манифест создан с другим паролем,
+ * функция завершается с ошибкой и контейнер не трогает.
+ *
+ * @param input_file Путь к исходному файлу.
+ * @param container_file Путь к контейнеру.
+ * @param password Пароль, из которого вырабатывается ключ.
+ * @param options Параметры нового контейнера, количество потоков и уровень проверки.
+ * @param result Статистика обновления.
+ * @return bool true, если контейнер и манифест обновлены, иначе false.
+ */
+bool AkrIncremental::update(const std::string& input_file,
+                            const std::string& container_file,
+                            const std::string& password,
+                            const AkrOptions& options,
+                            AkrIncrementalResult& result)
+{
+    result = AkrIncrementalResult();
+
+    AkrHeader fresh;
+    if (!AkrContainer::init_header(options, fresh))
+    {
+        return false;
+    }
+    fresh.flags |= AKR_FLAG_INCREMENTAL;
+
+    int input_fd = open(input_file.c_str(), O_RDONLY);
+    struct stat input_stat;
+
+    if (input_fd < 0 || fstat(input_fd, &input_stat) != 0)
+    {
+        std::cerr << "Не удалось открыть файл для чтения: " << input_file << std::endl;
+        if (input_fd >= 0)
+        {
+            close(input_fd);
+        }
+        return false;
+    }
+
+    const std::uint64_t plain_size    = static_cast<std::uint64_t>(input_stat.st_size);
+    const std::string   manifest_file = manifest_path(container_file);
+    const std::string   partial_file  = container_file + ".part";
+
+    AkrHeader header;
+    std::vector<AkrChunkEntry> old_entries;
+    std::unordered_map<std::string, size_t> known;
+    CryptoSession::KeyHandle key;
+    CryptoSession::KeyHandle manifest_key;
+    Fingerprint check{};
+    std::mutex key_mutex;
+    struct hash hash_ctx;
+
+    if (ak_hash_create_streebog256(&hash_ctx) != ak_error_ok)
+    {
+        close(input_fd);
+        return false;
+    }
+
+    ///< Вырабатывает ключи контейнера и манифеста для соли из header
+    auto acquire_keys = [&]()
+    {
+        key          = CryptoSession::instance().acquire_key(password, AkrContainer::salt_string(header), AkrContainer::algorithm_name(header));
+        manifest_key = CryptoSession::instance().acquire_key(password, AkrContainer::salt_string(header) + AKR_MANIFEST_MAGIC,
+                                                             AkrContainer::algorithm_name(header));
+        if (key && manifest_key)
+        {
+            make_fingerprint(&hash_ctx, manifest_key.get(), key_mutex, nullptr, 0, check);
+        }
+        return key && manifest_key;
+    };
+
+    int fd = open(container_file.c_str(), O_RDWR);
+    bool reuse = fd >= 0 &&
+                 AkrContainer::read_header(fd, header) &&
+                 same_layout(header, fresh) &&
+                 AkrContainer::read_table(fd, header, old_entries);
+    bool success = true;
+
+    if (reuse)
+    {
+        const ManifestState state = acquire_keys() ? load_manifest(manifest_file, header, old_entries, check, known) : MANIFEST_FOREIGN;
+
+        if (state == MANIFEST_FOREIGN || !AkrContainer::check_table(key.get(), header, old_entries))
+        {
+            std::cerr << "Пароль не подходит к существующему контейнеру: " << container_file << std::endl;
+            success = false;
+        }
+
+        reuse = (state == MANIFEST_VALID);
+    }
+
+    ///< Остатки прерванного обновления за старой таблицей отбрасываются,
+    ///< чтобы их nonce не оказались в файле рядом с новыми данными
+    const std::uint64_t table_end = header.table_offset + old_entries.size() * AKR_ENTRY_SIZE;
+    success = success && (!reuse || ftruncate(fd, static_cast<off_t>(table_end)) == 0);
+
+    if (success && !reuse)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+
+        header = fresh;
+        old_entries.clear();
+        known.clear();
+        result.rebuilt = true;
+
+        fd = open(partial_file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+        {
+            std::cerr << "Не удалось открыть файл для записи: " << partial_file << std::endl;
+        }
+        success = fd >= 0 && acquire_keys();
+    }
+
+    if (!success)
+    {
+        ak_hash_destroy(&hash_ctx);
+        close(input_fd);
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return false;
+    }
+
+    const ContentChunker chunker(header.chunk_size);
+
+    if (options.control)
+    {
+        options.control->expect(plain_size);
+    }
+
+    struct Done
+    {
+        size_t        index;
+        AkrChunkEntry entry;
+        std::uint32_t checksum;
+        Fingerprint   fingerprint;
+        bool          reused;
+    };
+
+    std::atomic<std::uint64_t> stored_end{reuse ? table_end : AKR_HEADER_SIZE};
+    std::atomic<std::uint64_t> next_nonce{header.next_nonce};
+    std::mutex done_mutex;
+    std::vector<Done> done;
+    size_t count = 0;
+
+    success = chunker.split_file(input_fd, plain_size, options.threads, AKR_INCREMENTAL_SLOTS, [&]() -> ContentChunker::Task
+    {
+        auto worker = std::make_shared<ChunkHasher>(
+            CryptoSession::instance().acquire_key(password, AkrContainer::salt_string(header), AkrContainer::algorithm_name(header)));
+
+        if (!worker->key || !worker->hash_ready)
+        {
+            return nullptr;
+        }
+
+        return [&, worker](const ContentChunk& item)
+        {
+            if (JobControl::cancelled(options.control))
+            {
+                return false;
+            }
+
+            Done chunk;
+            chunk.index    = item.index;
+            chunk.checksum = AkrContainer::plain_checksum(item.data, item.size);
+            chunk.reused   = false;
+            make_fingerprint(&worker->hash_ctx, manifest_key.get(), key_mutex, item.data, item.size, chunk.fingerprint);
+
+            const auto it = known.find(fingerprint_key(chunk.fingerprint, static_cast<std::uint32_t>(item.size)));
+
+            if (it != known.end())
+            {
+                chunk.entry  = old_entries[it->second];
+                chunk.reused = true;
+            }
+            else
+            {
+                chunk.entry.plain_size = static_cast<std::uint32_t>(item.size);
+                chunk.entry.nonce      = next_nonce++;
+
+                if (header.codec == AKR_CODEC_NONE)
+                {
+                    chunk.entry.stored_offset = stored_end.fetch_add(item.size);
+                }
+
+                if (!AkrContainer::store_chunk(fd, worker->key.get(), &worker->hash_ctx, header, chunk.entry, item.data, stored_end))
+                {
+                    return false;
+                }
+            }
+
+            chunk.entry.plain_offset = item.offset;
+
+            if (options.control)
+            {
+                options.control->advance(item.size);
+            }
+
+            std::lock_guard<std::mutex> lock(done_mutex);
+            done.push_back(chunk);
+            return true;
+        };
+    }, count);
+
+    close(input_fd);
+    ak_hash_destroy(&hash_ctx);
+
+    success = success && done.size() == count;
+
+    std::vector<AkrChunkEntry> entries;
+    std::vector<std::uint32_t> checksums;
+    std::vector<Fingerprint>   fingerprints;
+
+    if (success)
+    {
+        std::sort(done.begin(), done.end(), [](const Done& a, const Done& b) { return a.index < b.index; });
+
+        entries.reserve(done.size());
+        checksums.reserve(done.size());
+        fingerprints.reserve(done.size());
+
+        for (const auto& chunk : done)
+        {
+            entries.push_back(chunk.entry);
+            checksums.push_back(chunk.checksum);
+            fingerprints.push_back(chunk.fingerprint);
+
+            if (chunk.reused)
+            {
+                ++result.reused;
+            }
+            else
+            {
+                ++result.written;
+                result.bytes += chunk.entry.stored_size;
+            }
+        }
+
+        result.chunks = entries.size();
+
+        header.plain_size   = plain_size;
+        header.chunk_count  = entries.size();
+        header.next_nonce   = next_nonce;
+        header.table_offset = stored_end;
+
+        success = (header.mode != AKR_MODE_MGM || AkrContainer::table_tag(key.get(), header, entries, header.table_tag)) &&
+                  AkrContainer::finish_file(fd, header, entries, checksums, options.verify, password, options.threads);
+    }
+
+    if (!success && reuse)
+    {
+        ///< finish_file пишет заголовок последним, на диске остался старый - дописанное после старой таблицы отбрасывается
+        if (ftruncate(fd, static_cast<off_t>(table_end)) != 0)
+        {
+            std::cerr << "Не удалось отбросить недописанные фрагменты: " << container_file << std::endl;
+        }
+    }
+
+    const std::uint64_t data_bytes = header.table_offset - AKR_HEADER_SIZE;
+    const bool fragmented = success && reuse &&
+                            (data_bytes - live_bytes(entries)) * 100 > data_bytes * AKR_INCREMENTAL_GARBAGE;
+
+    if (fragmented)
+    {
+        result.compacted = compact(container_file, fd, header, entries, checksums, password, options);
+    }
+
+    close(fd);
+
+    std::error_code error;
+    if (!reuse)
+    {
+        if (success)
+        {
+            fs::rename(partial_file, container_file, error);
+            success = !error;
+        }
+        if (!success)
+        {
+            fs::remove(partial_file, error);
+        }
+    }
+
+    success = success && save_manifest(manifest_file, header, entries, fingerprints, check);
+
+    if (!success)
+    {
+        std::cerr << "Не удалось обновить контейнер: " << container_file << std::endl;
+    }
+
+    return success;
+}
+
+/**
+ * @brief Возвращает путь к манифесту контейнера.
+ *
+ * @param container_file Путь к контейнеру.
+ * @return std::string <контейнер>.manifest.
+ */
+std::string AkrIncremental::manifest_path(const std::string& container_file)
+{
+    return container_file + AKR_MANIFEST_SUFFIX;
+}
+
+/**
+ * @brief Читает манифест и строит словарь отпечатков старых фрагментов.
+ *
+ * Манифест считается действительным, только если он относится к тому же
+ * состоянию контейнера: совпадают соль, next_nonce и записи таблицы.
+ * Отпечаток пустых данных (check) позволяет отличить устаревший манифест
+ * от манифеста, созданного с другим паролем.
+ *
+ * @param manifest_file Путь к манифесту.
+ * @param header Заголовок контейнера.
+ * @param entries Таблица фрагментов контейнера.
+ * @param check Отпечаток пустых данных для текущего пароля.
+ * @param known Словарь (отпечаток, длина) -> номер записи таблицы.
+ * @return ManifestState Состояние манифеста.
+ */
+AkrIncremental::ManifestState AkrIncremental::load_manifest(const std::string& manifest_file,
+                                                            const AkrHeader& header,
+                                                            const std::vector<AkrChunkEntry>& entries,
+                                                            const Fingerprint& check,
+                                                            std::unordered_map<std::string, size_t>& known)
+{
+    const size_t expected = AKR_MANIFEST_HEADER_SIZE + entries.size() * AKR_MANIFEST_RECORD_SIZE;
+    std::vector<ak_uint8> data(expected);
+
+    int fd = open(manifest_file.c_str(), O_RDONLY);
+    struct stat manifest_stat;
+
+    const bool loaded = fd >= 0 &&
+                        fstat(fd, &manifest_stat) == 0 &&
+                        static_cast<std::uint64_t>(manifest_stat.st_size) == expected &&
+                        FileIO::pread_exact(fd, data.data(), data.size(), 0);
+
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+
+    if (!loaded ||
+        std::memcmp(data.data(), AKR_MANIFEST_MAGIC, 4) != 0 ||
+        get_le(data.data() + 4, 2) != AKR_MANIFEST_VERSION ||
+        get_le(data.data() + 6, 2) != AKR_MANIFEST_RECORD_SIZE ||
+        std::memcmp(data.data() + 8, header.salt, AKR_SALT_SIZE) != 0)
+    {
+        return MANIFEST_STALE;
+    }
+
+    if (std::memcmp(data.data() + 40, check.data(), check.size()) != 0)
+    {
+        return MANIFEST_FOREIGN;
+    }
+
+    if (get_le(data.data() + 24, 8) != header.next_nonce ||
+        get_le(data.data() + 32, 8) != entries.size())
+    {
+        return MANIFEST_STALE;
+    }
+
+    known.clear();
+    known.reserve(entries.size());
+
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const ak_uint8 *record = data.data() + AKR_MANIFEST_HEADER_SIZE + i * AKR_MANIFEST_RECORD_SIZE;
+
+        if (get_le(record, 8) != entries[i].nonce ||
+            get_le(record + 8, 4) != entries[i].plain_size)
+        {
+            known.clear();
+            return MANIFEST_STALE;
+        }
+
+        Fingerprint fingerprint;
+        std::memcpy(fingerprint.data(), record + 16, fingerprint.size());
+        known.emplace(fingerprint_key(fingerprint, entries[i].plain_size), i);
+    }
+
+    return MANIFEST_VALID;
+}
+
+/**
+ * @brief Записывает манифест через временный файл.
+ *
+ * @param manifest_file Путь к манифесту.
+ * @param header Заголовок контейнера.
+ * @param entries Таблица фрагментов.
+ * @param fingerprints Отпечатки фрагментов в порядке таблицы.
+ * @param check Отпечаток пустых данных для текущего пароля.
+ * @return bool true, если манифест записан, иначе false.
+ */
+bool AkrIncremental::save_manifest(const std::string& manifest_file,
+                                   const AkrHeader& header,
+                                   const std::vector<AkrChunkEntry>& entries,
+                                   const std::vector<Fingerprint>& fingerprints,
+                                   const Fingerprint& check)
+{
+    std::vector<ak_uint8> data(AKR_MANIFEST_HEADER_SIZE + entries.size() * AKR_MANIFEST_RECORD_SIZE, 0);
+
+    std::memcpy(data.data(), AKR_MANIFEST_MAGIC, 4);
+    put_le(data.data() + 4, AKR_MANIFEST_VERSION, 2);
+    put_le(data.data() + 6, AKR_MANIFEST_RECORD_SIZE, 2);
+    std::memcpy(data.data() + 8, header.salt, AKR_SALT_SIZE);
+    put_le(data.data() + 24, header.next_nonce, 8);
+    put_le(data.data() + 32, entries.size(), 8);
+    std::memcpy(data.data() + 40, check.data(), check.size());
+
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        ak_uint8 *record = data.data() + AKR_MANIFEST_HEADER_SIZE + i * AKR_MANIFEST_RECORD_SIZE;
+
+        put_le(record, entries[i].nonce, 8);
+        put_le(record + 8, entries[i].plain_size, 4);
+        std::memcpy(record + 16, fingerprints[i].data(), fingerprints[i].size());
+    }
+
+    const std::string partial = manifest_file + ".part";
+    int fd = open(partial.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+    {
+        std::cerr << "Не удалось открыть файл для записи: " << partial << std::endl;
+        return false;
+    }
+
+    bool success = FileIO::pwrite_exact(fd, data.data(), data.size(), 0);
+    close(fd);
+
+    std::error_code error;
+    if (success)
+    {
+        fs::rename(partial, manifest_file, error);
+        success = !error;
+    }
+    if (!success)
+    {
+        fs::remove(partial, error);
+    }
+
+    return success;
+}
+
+/**
+ * @brief Переписывает контейнер без места, занятого удаленными фрагментами.
+ *
+ * Зашифрованные фрагменты копируются как есть: их синхропосылки и
+ * имитовставки не зависят от положения в файле. Фрагменты, на которые
+ * ссылается несколько записей таблицы, копируются один раз.
+ *
+ * @param container_file Путь к контейнеру.
+ * @param fd Дескриптор обновленного контейнера.
+ * @param header Заголовок (обновляется table_offset).
+ * @param entries Таблица фрагментов (обновляются stored_offset).
+ * @param checksums Контрольные суммы открытого текста по фрагментам.
+ * @param password Пароль, из которого вырабатывается ключ.
+ * @param options Количество потоков и уровень проверки.
+ * @return bool true, если контейнер уплотнен, иначе false (обновленный контейнер остается как есть).
+ */
+bool AkrIncremental::compact(const std::string& container_file,
+                             int fd,
+                             AkrHeader& header,
+                             std::vector<AkrChunkEntry>& entries,
+                             const std::vector<std::uint32_t>& checksums,
+                             const std::string& password,
+                             const AkrOptions& options)
+{
+    const std::string partial = container_file + ".part";
+    int output_fd = open(partial.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (output_fd < 0)
+    {
+        std::cerr << "Не удалось открыть файл для записи: " << partial << std::endl;
+        return false;
+    }
+
+    AkrHeader compacted = header;
+    std::vector<AkrChunkEntry> moved_entries = entries;
+    std::unordered_map<std::uint64_t, std::uint64_t> moved;
+    std::uint64_t position = AKR_HEADER_SIZE;
+
+    PooledBuffer buffer = BufferPool::instance().acquire(header.chunk_size);
+    bool success = static_cast<bool>(buffer);
+
+    for (auto& entry : moved_entries)
+    {
+        if (!success)
+        {
+            break;
+        }
+
+        auto it = moved.find(entry.stored_offset);
+        if (it == moved.end())
+        {
+            success = FileIO::pread_exact(fd, buffer.data(), entry.stored_size, static_cast<off_t>(entry.stored_offset)) &&
+                      FileIO::pwrite_exact(output_fd, buffer.data(), entry.stored_size, static_cast<off_t>(position));
+
+            it = moved.emplace(entry.stored_offset, position).first;
+            position += entry.stored_size;
+        }
+
+        entry.stored_offset = it->second;
+    }
+
+    compacted.table_offset = position;
+
+    success = success && AkrContainer::finish_file(output_fd, compacted, moved_entries, checksums,
+                                                   options.verify, password, options.threads);
+    close(output_fd);
+
+    std::error_code error;
+    if (success)
+    {
+        fs::rename(partial, container_file, error);
+        success = !error;
+    }
+
+    if (!success)
+    {
+        fs::remove(partial, error);
+        std::cerr << "Не удалось уплотнить контейнер, он оставлен без уплотнения: " << container_file << std::endl;
+        return false;
+    }
+
+    header  = compacted;
+    entries = std::move(moved_entries);
+
+    return true;
+}
+
+/**
+ * @brief Считает объем данных, на который ссылается таблица.
+ */
+std::uint64_t AkrIncremental::live_bytes(const std::vector<AkrChunkEntry>& entries)
+{
+    std::unordered_set<std::uint64_t> seen;
+    std::uint64_t total = 0;
+
+    for (const auto& entry : entries)
+    {
+        if (seen.insert(entry.stored_offset).second)
+        {
+            total += entry.stored_size;
+        }
+    }
+
+    return total;
+}
+
+/**
+ * @brief Формирует ключ словаря отпечатков: отпечаток и длина фрагмента.
+ */
+std::string AkrIncremental::fingerprint_key(const Fingerprint& fingerprint, std::uint32_t plain_size)
+{
+    std::string key(reinterpret_cast<const char*>(fingerprint.data()), fingerprint.size());
+    key.append(reinterpret_cast<const char*>(&plain_size), sizeof(plain_size));
+    return key;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file       <akr_incremental.hpp>
+ * @brief      Хэдер инкрементального перешифрования файла в контейнер .akr.
+ *
+ *             Содержит в себе объявление обновления контейнера, при котором
+ *             файл делится на фрагменты по содержимому, а заново шифруются
+ *             и записываются только фрагменты, изменившиеся с прошлого
+ *             запуска. Отпечатки фрагментов хранятся в манифесте рядом
+ *             с контейнером.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef AKR_INCREMENTAL_HPP
+#define AKR_INCREMENTAL_HPP
+
+#include "akr_container.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stddef.h>
+
+#define AKR_MANIFEST_MAGIC        "AKRM"
+#define AKR_MANIFEST_VERSION      1
+#define AKR_MANIFEST_SUFFIX       ".manifest"
+#define AKR_MANIFEST_HEADER_SIZE  64
+#define AKR_MANIFEST_RECORD_SIZE  32
+#define AKR_INCREMENTAL_SLOTS     2
+#define AKR_INCREMENTAL_GARBAGE   50
+
+struct AkrIncrementalResult
+{
+    size_t        chunks    = 0;
+    size_t        reused    = 0;
+    size_t        written   = 0;
+    std::uint64_t bytes     = 0;
+    bool          rebuilt   = false;
+    bool          compacted = false;
+};
+
+class AkrIncremental
+{
+public:
+    using Fingerprint = std::array<ak_uint8, AKR_DIGEST_SIZE>;
+
+public:
+    static bool update(const std::string& input_file,
+                       const std::string& container_file,
+                       const std::string& password,
+                       const AkrOptions& options,
+                       AkrIncrementalResult& result);
+
+    static std::string manifest_path(const std::string& container_file);
+
+private:
+    enum ManifestState
+    {
+        MANIFEST_VALID,
+        MANIFEST_STALE,
+        MANIFEST_FOREIGN
+    };
+
+    static ManifestState load_manifest(const std::string& manifest_file,
+                                       const AkrHeader& header,
+                                       const std::vector<AkrChunkEntry>& entries,
+                                       const Fingerprint& check,
+                                       std::unordered_map<std::string, size_t>& known);
+    static bool save_manifest(const std::string& manifest_file,
+                              const AkrHeader& header,
+                              const std::vector<AkrChunkEntry>& entries,
+                              const std::vector<Fingerprint>& fingerprints,
+                              const Fingerprint& check);
+    static bool compact(const std::string& container_file,
+                        int fd,
+                        AkrHeader& header,
+                        std::vector<AkrChunkEntry>& entries,
+                        const std::vector<std::uint32_t>& checksums,
+                        const std::string& password,
+                        const AkrOptions& options);
+
+    static std::uint64_t live_bytes(const std::vector<AkrChunkEntry>& entries);
+    static std::string fingerprint_key(const Fingerprint& fingerprint, std::uint32_t plain_size);
+};
+
+#endif // AKR_INCREMENTAL_HPP
@@ -0,0 +1,261 @@
+/**
+ * @file       <akr_reader.cpp>
+ * @brief      Основной файл чтения произвольных участков контейнера .akr.
+ *
+ *             Чтобы прочитать несколько килобайт из середины большого контейнера,
+ *             достаточно найти по таблице фрагменты, покрывающие диапазон,
+ *             и расшифровать только их. Повторные и соседние чтения
+ *             обслуживаются из кэша без повторной работы шифра.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "akr_reader.hpp"
+#include "file_io.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * @brief Закрывает контейнер.
+ */
+AkrReader::~AkrReader()
+{
+    close();
+}
+
+/**
+ * @brief Открывает контейнер для чтения произвольных участков.
+ *
+ * Эта функция читает заголовок и таблицу фрагментов и берет ключ из
+ * CryptoSession. Файлы старого формата не поддерживаются: в них нет
+ * таблицы фрагментов, и OFB можно расшифровать только с начала файла.
+ *
+ * @param path Путь к контейнеру.
+ * @param password Пароль, из которого вырабатывается ключ.
+ * @param cache_chunks Максимальное количество расшифрованных фрагментов в кэше.
+ * @return bool true, если контейнер открыт, иначе false.
+ */
+bool AkrReader::open(const std::string& path, const std::string& password, size_t cache_chunks)
+{
+    close();
+
+    m_fd = ::open(path.c_str(), O_RDONLY);
+    if (m_fd < 0)
+    {
+        std::cerr << "Не удалось открыть файл для чтения: " << path << std::endl;
+        return false;
+    }
+
+    if (!AkrContainer::read_header(m_fd, m_header) || !AkrContainer::read_table(m_fd, m_header, m_entries))
+    {
+        std::cerr << "Чтение произвольных участков возможно только для контейнеров AKR v2: " << path << std::endl;
+        close();
+        return false;
+    }
+
+    if (m_header.kdf_iterations != AkrContainer::current_kdf_iterations())
+    {
+        std::cerr << "Контейнер создан с другим числом итераций PBKDF2: " << m_header.kdf_iterations << std::endl;
+        close();
+        return false;
+    }
+
+    m_key = CryptoSession::instance().acquire_key(password, AkrContainer::salt_string(m_header), AkrContainer::algorithm_name(m_header));
+    if (!m_key || !AkrContainer::check_table(m_key.get(), m_header, m_entries))
+    {
+        close();
+        return false;
+    }
+
+    m_cache.resize(std::max<size_t>(cache_chunks, 1));
+    return true;
+}
+
+/**
+ * @brief Закрывает контейнер, освобождает ключ и очищает кэш.
+ */
+void AkrReader::close()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+    m_key.reset();
+    m_entries.clear();
+    m_cache.clear();
+    m_clock  = 0;
+    m_header = AkrHeader();
+}
+
+/**
+ * @brief Расшифровывает диапазон [offset, offset + length) открытого текста.
+ *
+ * Расшифровываются только фрагменты, которые пересекаются с диапазоном.
+ * Диапазон, выходящий за конец данных, обрезается. Если output уже имеет
+ * достаточную емкость, чтение не выделяет память.
+ *
+ * @param offset Смещение в открытом тексте.
+ * @param length Длина диапазона.
+ * @param output Вектор, в который записываются расшифрованные данные.
+ * @return bool true, если диапазон прочитан, иначе false.
+ */
+bool AkrReader::read(std::uint64_t offset, size_t length, std::vector<ak_uint8>& output)
+{
+    output.clear();
+
+    std::lock_guard<std::mutex> lock(m_mutex); ///< Дескриптор и заголовок меняет close() из другого потока
+
+    if (m_fd < 0 || offset > m_header.plain_size)
+    {
+        return false;
+    }
+
+    const std::uint64_t end = offset + std::min<std::uint64_t>(length, m_header.plain_size - offset);
+    output.reserve(static_cast<size_t>(end - offset));
+
+    for (std::uint64_t position = offset; position < end; )
+    {
+        const size_t index = find_chunk(position);
+        if (index >= m_entries.size())
+        {
+            return false;
+        }
+
+        const CacheSlot* chunk = load_chunk(index);
+        if (!chunk)
+        {
+            return false;
+        }
+
+        const AkrChunkEntry& entry = m_entries[index];
+        const size_t begin = static_cast<size_t>(position - entry.plain_offset);
+        const size_t count = static_cast<size_t>(std::min<std::uint64_t>(entry.plain_size - begin, end - position));
+
+        output.insert(output.end(), chunk->data.data() + begin, chunk->data.data() + begin + count);
+        position += count;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Количество фрагментов, выданных из кэша.
+ *
+ * @return size_t Количество попаданий.
+ */
+size_t AkrReader::cache_hits() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_hits;
+}
+
+/**
+ * @brief Количество фрагментов, которые пришлось расшифровать.
+ *
+ * @return size_t Количество промахов.
+ */
+size_t AkrReader::cache_misses() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_misses;
+}
+
+/**
+ * @brief Находит фрагмент, содержащий заданное смещение открытого текста.
+ *
+ * Записи таблицы упорядочены по plain_offset, поэтому используется
+ * двоичный поиск.
+ *
+ * @param offset Смещение в открытом тексте.
+ * @return size_t Номер фрагмента или m_entries.size(), если фрагмент не найден.
+ */
+size_t AkrReader::find_chunk(std::uint64_t offset) const
+{
+    auto it = std::upper_bound(m_entries.begin(), m_entries.end(), offset,
+                               [](std::uint64_t value, const AkrChunkEntry& entry) { return value < entry.plain_offset; });
+
+    if (it == m_entries.begin())
+    {
+        return m_entries.size();
+    }
+
+    --it;
+    if (offset >= it->plain_offset + it->plain_size)
+    {
+        return m_entries.size();
+    }
+
+    return static_cast<size_t>(it - m_entries.begin());
+}
+
+/**
+ * @brief Возвращает расшифрованный фрагмент из кэша или расшифровывает его.
+ *
+ * Кэш - это фиксированный набор слотов с буферами из BufferPool. Промах
+ * занимает слот, к которому дольше всего не обращались, и переиспользует
+ * его буфер, поэтому после заполнения кэша память не выделяется.
+ * Вызывается под m_mutex.
+ *
+ * @param index Номер фрагмента.
+ * @return const CacheSlot* Слот с расшифрованными данными или nullptr при ошибке.
+ */
+const AkrReader::CacheSlot* AkrReader::load_chunk(size_t index)
+{
+    CacheSlot* victim = &m_cache.front();
+
+    for (auto& slot : m_cache)
+    {
+        if (slot.index == index)
+        {
+            slot.last_used = ++m_clock;
+            ++m_hits;
+            return &slot;
+        }
+
+        if (slot.last_used < victim->last_used)
+        {
+            victim = &slot;
+        }
+    }
+
+    ++m_misses;
+
+    const AkrChunkEntry& entry = m_entries[index];
+    victim->index = SIZE_MAX;
+
+    if (victim->data.capacity() < m_header.chunk_size)
+    {
+        victim->data = BufferPool::instance().acquire(m_header.chunk_size);
+    }
+
+    if (!victim->data ||
+        !victim->data.resize(std::max<size_t>(entry.plain_size, entry.stored_size)) ||
+        !FileIO::pread_exact(m_fd, victim->data.data(), entry.stored_size, static_cast<off_t>(entry.stored_offset)) ||
+        !AkrContainer::decrypt_chunk(m_key.get(), m_header, entry, victim->data.data()))
+    {
+        return nullptr;
+    }
+
+    victim->index     = index;
+    victim->last_used = ++m_clock;
+
+    return victim;
+}
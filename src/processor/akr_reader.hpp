@@ -0,0 +1,81 @@
+/**
+ * @file       <akr_reader.hpp>
+ * @brief      Хэдер чтения произвольных участков контейнера .akr.
+ *
+ *             Содержит в себе объявление класса, который расшифровывает только
+ *             фрагменты, покрывающие запрошенный диапазон, и хранит последние
+ *             расшифрованные фрагменты в LRU-кэше.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef AKR_READER_HPP
+#define AKR_READER_HPP
+
+#include "akr_container.hpp"
+#include "buffer_pool.hpp"
+#include "crypto_session.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+#define AKR_READER_CACHE_CHUNKS 32
+
+class AkrReader
+{
+public:
+    AkrReader() = default;
+    ~AkrReader();
+
+    AkrReader(const AkrReader&) = delete;
+    AkrReader& operator=(const AkrReader&) = delete;
+
+    bool open(const std::string& path, const std::string& password, size_t cache_chunks = AKR_READER_CACHE_CHUNKS);
+    void close();
+
+    bool read(std::uint64_t offset, size_t length, std::vector<ak_uint8>& output);
+
+    const AkrHeader& header() const { return m_header; }
+    std::uint64_t size() const { return m_header.plain_size; }
+
+    size_t cache_hits() const;
+    size_t cache_misses() const;
+
+private:
+    struct CacheSlot
+    {
+        size_t        index     = SIZE_MAX;
+        std::uint64_t last_used = 0;
+        PooledBuffer  data;
+    };
+
+private:
+    size_t find_chunk(std::uint64_t offset) const;
+    const CacheSlot* load_chunk(size_t index);
+
+private:
+    int                        m_fd = -1;
+    AkrHeader                  m_header;
+    std::vector<AkrChunkEntry> m_entries;
+    CryptoSession::KeyHandle   m_key{nullptr, [](struct bckey*) noexcept {}};
+
+    mutable std::mutex         m_mutex;
+    std::vector<CacheSlot>     m_cache;
+    std::uint64_t              m_clock  = 0;
+    size_t                     m_hits   = 0;
+    size_t                     m_misses = 0;
+};
+
+#endif // AKR_READER_HPP
@@ -0,0 +1,1029 @@
+/**
+ * @file       <akr_store.cpp>
+ * @brief      Основной файл хранилища фрагментов с дедупликацией между файлами.
+ *
+ *             Хранилище - это каталог из двух файлов. pack начинается с
+ *             заголовка контейнера с флагом AKR_FLAG_STORE, за которым
+ *             дописываются зашифрованные фрагменты. index хранит для каждого
+ *             фрагмента его отпечаток (первые AKR_DIGEST_SIZE байт хэша
+ *             Стрибог-256 открытого текста, зашифрованного ключом хранилища)
+ *             и запись таблицы. Помещенный файл делится на фрагменты по
+ *             содержимому, и шифруются и записываются только фрагменты,
+ *             отпечатков которых еще нет в индексе; сам файл заменяется
+ *             описью <файл>.akref со ссылками на фрагменты.
+ *
+ *             Индекс и описи защищены имитовставкой MGM, поэтому подмена
+ *             записей обнаруживается, а неверный пароль не портит хранилище.
+ *             Все nonce, в том числе для имитовставок, выдаются из одного
+ *             счетчика next_nonce в заголовке pack и резервируются на диске
+ *             до шифрования, поэтому не повторяются даже после сбоя.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "akr_store.hpp"
+#include "buffer_pool.hpp"
+#include "content_chunker.hpp"
+#include "crypto_session.hpp"
+#include "file_io.hpp"
+#include "parallel_for.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <libakrypt.h>
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Состояние рабочего потока: ключи, контекст хэширования и буфер.
+ */
+struct StoreWorker
+{
+    CryptoSession::KeyHandle key;
+    CryptoSession::KeyHandle fingerprint_key{nullptr, [](struct bckey*) noexcept {}};
+    struct hash              hash_ctx;
+    bool                     hash_ready = false;
+    PooledBuffer             buffer;
+
+    explicit StoreWorker(CryptoSession::KeyHandle handle) noexcept : key(std::move(handle)) {}
+
+    ~StoreWorker()
+    {
+        if (hash_ready)
+        {
+            ak_hash_destroy(&hash_ctx);
+        }
+    }
+};
+
+/**
+ * @brief Записывает число в буфер в порядке little-endian.
+ */
+static void put_le(ak_uint8 *data, std::uint64_t value, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        data[i] = static_cast<ak_uint8>(value >> (8 * i));
+    }
+}
+
+/**
+ * @brief Читает число из буфера в порядке little-endian.
+ */
+static std::uint64_t get_le(const ak_uint8 *data, size_t size)
+{
+    std::uint64_t value = 0;
+    for (size_t i = 0; i < size; ++i)
+    {
+        value |= static_cast<std::uint64_t>(data[i]) << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * @brief Записывает ссылку на фрагмент (AKR_STORE_REF_RECORD байт).
+ *
+ * Такая же запись хранится в индексе сразу за отпечатком фрагмента.
+ */
+static void put_entry(ak_uint8 *record, const AkrChunkEntry& entry)
+{
+    put_le(record, entry.stored_offset, 8);
+    put_le(record + 8, entry.nonce, 8);
+    put_le(record + 16, entry.plain_size, 4);
+    put_le(record + 20, entry.stored_size, 4);
+    put_le(record + 24, entry.flags, 4);
+    std::memcpy(record + 32, entry.digest, AKR_DIGEST_SIZE);
+}
+
+/**
+ * @brief Читает ссылку на фрагмент, записанную put_entry.
+ */
+static AkrChunkEntry get_entry(const ak_uint8 *record)
+{
+    AkrChunkEntry entry;
+
+    entry.stored_offset = get_le(record, 8);
+    entry.nonce         = get_le(record + 8, 8);
+    entry.plain_size    = static_cast<std::uint32_t>(get_le(record + 16, 4));
+    entry.stored_size   = static_cast<std::uint32_t>(get_le(record + 20, 4));
+    entry.flags         = static_cast<std::uint32_t>(get_le(record + 24, 4));
+    std::memcpy(entry.digest, record + 32, AKR_DIGEST_SIZE);
+
+    return entry;
+}
+
+/**
+ * @brief Проверяет, что ссылка указывает на записанные данные хранилища.
+ */
+static bool valid_entry(const AkrHeader& header, const AkrChunkEntry& entry)
+{
+    const bool compressed = (entry.flags & AKR_CHUNK_COMPRESSED) != 0;
+
+    return entry.plain_size > 0 &&
+           entry.plain_size <= header.chunk_size &&
+           (compressed ? (header.codec != AKR_CODEC_NONE && entry.stored_size < entry.plain_size)
+                       : entry.stored_size == entry.plain_size) &&
+           entry.stored_offset >= AKR_HEADER_SIZE &&
+           entry.stored_offset <= header.table_offset &&
+           entry.stored_size <= header.table_offset - entry.stored_offset &&
+           entry.nonce < header.next_nonce;
+}
+
+/**
+ * @brief Вычисляет отпечаток открытого текста фрагмента.
+ *
+ * @param ctx Контекст хэширования Стрибог-256.
+ * @param key Ключ отпечатков хранилища.
+ * @param data Открытый текст фрагмента.
+ * @param size Длина открытого текста.
+ * @param fingerprint Отпечаток.
+ */
+static void make_fingerprint(struct hash *ctx, struct bckey *key, const ak_uint8 *data, size_t size, AkrStore::Fingerprint& fingerprint)
+{
+    ak_uint8 digest[32] = {0};
+
+    ak_hash_ptr(ctx, const_cast<ak_uint8*>(data), size, digest, sizeof(digest));
+    CryptoSession::instance().encrypt_ecb(key, digest, digest, sizeof(digest));
+
+    std::memcpy(fingerprint.data(), digest, fingerprint.size());
+}
+
+AkrStore::~AkrStore()
+{
+    close();
+}
+
+/**
+ * @brief Открывает хранилище для записи, создавая его при необходимости.
+ *
+ * Хранилище блокируется (flock) до вызова close(), поэтому в него пишет
+ * только один процесс. Алгоритм, режим, сжатие и размер фрагмента из
+ * options используются только при создании хранилища, дальше действуют
+ * параметры из заголовка pack. Данные, записанные после последней
+ * фиксации (прерванный запуск), отбрасываются.
+ *
+ * @param store_dir Каталог хранилища.
+ * @param password Пароль, из которого вырабатывается ключ.
+ * @param options Параметры нового хранилища, количество потоков и уровень проверки.
+ * @return bool true, если хранилище открыто и пароль подходит, иначе false.
+ */
+bool AkrStore::open(const std::string& store_dir, const std::string& password, const AkrOptions& options)
+{
+    close();
+
+    AkrHeader fresh;
+    if (!AkrContainer::init_header(options, fresh))
+    {
+        return false;
+    }
+
+    std::error_code error;
+    fs::create_directories(store_dir, error);
+    if (error)
+    {
+        std::cerr << "Не удалось создать каталог хранилища: " << store_dir << std::endl;
+        return false;
+    }
+
+    m_dir      = store_dir;
+    m_password = password;
+    m_options  = options;
+
+    const std::string pack_file = (fs::path(m_dir) / AKR_STORE_PACK).string();
+    m_pack_fd = ::open(pack_file.c_str(), O_RDWR | O_CREAT, 0644);
+    if (m_pack_fd < 0)
+    {
+        std::cerr << "Не удалось открыть файл для записи: " << pack_file << std::endl;
+        return false;
+    }
+
+    if (flock(m_pack_fd, LOCK_EX | LOCK_NB) != 0)
+    {
+        std::cerr << "Хранилище уже используется другим процессом: " << store_dir << std::endl;
+        close();
+        return false;
+    }
+
+    struct stat pack_stat;
+    bool success = fstat(m_pack_fd, &pack_stat) == 0;
+
+    if (success && pack_stat.st_size == 0)
+    {
+        m_header = fresh;
+        m_header.flags       |= AKR_FLAG_STORE;
+        m_header.table_offset = AKR_HEADER_SIZE;
+        success = create();
+    }
+    else if (success)
+    {
+        success = AkrContainer::read_header(m_pack_fd, m_header);
+
+        if (success && (!(m_header.flags & AKR_FLAG_STORE) ||
+                        m_header.table_offset < AKR_HEADER_SIZE ||
+                        m_header.table_offset > static_cast<std::uint64_t>(pack_stat.st_size)))
+        {
+            std::cerr << "Файл не является хранилищем фрагментов: " << pack_file << std::endl;
+            success = false;
+        }
+
+        if (success && m_header.kdf_iterations != fresh.kdf_iterations)
+        {
+            std::cerr << "Хранилище создано с другим числом итераций PBKDF2: " << m_header.kdf_iterations << std::endl;
+            success = false;
+        }
+
+        success = success && load_index();
+    }
+
+    ///< Фрагменты, записанные после последней фиксации, не попали в индекс
+    success = success && ftruncate(m_pack_fd, static_cast<off_t>(m_header.table_offset)) == 0;
+    m_stored_end = m_header.table_offset;
+
+    if (!success)
+    {
+        close();
+    }
+
+    return success;
+}
+
+/**
+ * @brief Помещает файл в хранилище.
+ *
+ * Файл делится на фрагменты по содержимому (ContentChunker::split_file),
+ * рабочие потоки считают отпечатки и ищут их в индексе. Найденный
+ * фрагмент не шифруется и не записывается повторно - в опись попадает
+ * ссылка на уже сохраненный. Новые фрагменты шифруются и дописываются
+ * в pack. Одинаковые фрагменты внутри одного файла тоже сохраняются один раз.
+ *
+ * Опись готовится в памяти и записывается только функцией commit()
+ * после того, как на диск записаны все фрагменты и индекс.
+ *
+ * @param input_file Путь к исходному файлу.
+ * @param ref_file Путь к описи, которая будет записана при фиксации.
+ * @param result Статистика по файлу.
+ * @return bool true, если файл помещен в хранилище, иначе false.
+ */
+bool AkrStore::put(const std::string& input_file, const std::string& ref_file, AkrStoreResult& result)
+{
+    result = AkrStoreResult();
+
+    if (m_pack_fd < 0)
+    {
+        return false;
+    }
+
+    int input_fd = ::open(input_file.c_str(), O_RDONLY);
+    struct stat input_stat;
+
+    if (input_fd < 0 || fstat(input_fd, &input_stat) != 0)
+    {
+        std::cerr << "Не удалось открыть файл для чтения: " << input_file << std::endl;
+        if (input_fd >= 0)
+        {
+            ::close(input_fd);
+        }
+        return false;
+    }
+
+    const std::uint64_t plain_size = static_cast<std::uint64_t>(input_stat.st_size);
+    const ContentChunker chunker(m_header.chunk_size);
+
+    ///< Все фрагменты, кроме последнего, не короче min_size, поэтому
+    ///< nonce хватит на любое разбиение; еще один nonce нужен описи
+    const std::uint64_t bound = plain_size / chunker.min_size() + 1;
+    std::uint64_t first_nonce = 0;
+
+    if (!reserve_nonces(bound + 1, first_nonce))
+    {
+        ::close(input_fd);
+        return false;
+    }
+
+    const std::uint64_t ref_nonce = first_nonce + bound;
+    const size_t before = m_records.size();
+
+    std::atomic<std::uint64_t> next_nonce{first_nonce};
+    std::atomic<std::uint64_t> stored_end{m_stored_end};
+    std::atomic<std::uint64_t> written{0};
+    std::mutex mutex;
+    std::vector<std::pair<size_t, size_t>> refs;
+    size_t count = 0;
+
+    bool success = chunker.split_file(input_fd, plain_size, m_options.threads, AKR_STORE_SLOTS, [&]() -> ContentChunker::Task
+    {
+        auto worker = std::make_shared<StoreWorker>(
+            CryptoSession::instance().acquire_key(m_password, AkrContainer::salt_string(m_header), AkrContainer::algorithm_name(m_header)));
+
+        worker->fingerprint_key = CryptoSession::instance().acquire_key(m_password, AkrContainer::salt_string(m_header) + AKR_STORE_KEY_SUFFIX,
+                                                                        AkrContainer::algorithm_name(m_header));
+        worker->hash_ready = ak_hash_create_streebog256(&worker->hash_ctx) == ak_error_ok;
+
+        if (!worker->key || !worker->fingerprint_key || !worker->hash_ready)
+        {
+            return nullptr;
+        }
+
+        return [&, worker](const ContentChunk& item)
+        {
+            Fingerprint fingerprint;
+            make_fingerprint(&worker->hash_ctx, worker->fingerprint_key.get(), item.data, item.size, fingerprint);
+
+            size_t record   = 0;
+            bool   inserted = false;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                auto it  = m_known.emplace(fingerprint_key(fingerprint, static_cast<std::uint32_t>(item.size)), m_records.size());
+                inserted = it.second;
+                record   = it.first->second;
+
+                if (inserted)
+                {
+                    m_records.push_back({fingerprint, AkrChunkEntry()});
+                    m_checksums.push_back(0);
+                }
+
+                refs.emplace_back(item.index, record);
+            }
+
+            if (!inserted)
+            {
+                return true;
+            }
+
+            AkrChunkEntry entry;
+            entry.plain_size = static_cast<std::uint32_t>(item.size);
+            entry.nonce      = next_nonce++;
+
+            const std::uint32_t checksum = AkrContainer::plain_checksum(item.data, item.size);
+
+            if (m_header.codec == AKR_CODEC_NONE)
+            {
+                entry.stored_offset = stored_end.fetch_add(item.size);
+            }
+
+            if (entry.nonce >= ref_nonce ||
+                !AkrContainer::store_chunk(m_pack_fd, worker->key.get(), &worker->hash_ctx, m_header, entry, item.data, stored_end))
+            {
+                return false;
+            }
+
+            written += entry.stored_size;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            m_records[record].entry           = entry;
+            m_checksums[record - m_committed] = checksum;
+            return true;
+        };
+    }, count);
+
+    ::close(input_fd);
+    m_stored_end = stored_end;
+
+    success = success && refs.size() == count;
+
+    std::vector<ak_uint8> data(AKR_STORE_HEADER_SIZE + count * AKR_STORE_REF_RECORD, 0);
+
+    if (success)
+    {
+        std::sort(refs.begin(), refs.end());
+
+        std::memcpy(data.data(), AKR_STORE_REF_MAGIC, 4);
+        put_le(data.data() + 4, AKR_STORE_VERSION, 2);
+        put_le(data.data() + 6, AKR_STORE_REF_RECORD, 2);
+        std::memcpy(data.data() + 8, m_header.salt, AKR_SALT_SIZE);
+        put_le(data.data() + 24, plain_size, 8);
+        put_le(data.data() + 32, count, 8);
+        put_le(data.data() + 40, ref_nonce, 8);
+
+        for (size_t i = 0; i < refs.size(); ++i)
+        {
+            put_entry(data.data() + AKR_STORE_HEADER_SIZE + i * AKR_STORE_REF_RECORD, m_records[refs[i].second].entry);
+        }
+
+        auto key = CryptoSession::instance().acquire_key(m_password, AkrContainer::salt_string(m_header), AkrContainer::algorithm_name(m_header));
+        success = key && seal(key.get(), m_header, ref_nonce, data.data(), data.size(), 48, data.data() + 48);
+    }
+
+    if (!success)
+    {
+        rollback(before);
+        std::cerr << "Не удалось поместить файл в хранилище: " << input_file << std::endl;
+        return false;
+    }
+
+    m_refs.push_back({ref_file, std::move(data)});
+
+    result.chunks  = count;
+    result.stored  = m_records.size() - before;
+    result.bytes   = plain_size;
+    result.written = written;
+
+    return true;
+}
+
+/**
+ * @brief Фиксирует помещенные файлы: записывает индекс и описи.
+ *
+ * Порядок записи защищает хранилище от сбоя: сначала на диск сбрасываются
+ * фрагменты, затем заголовок pack с новым концом данных, затем индекс и
+ * только потом описи. Если сбой произошел раньше, чем записан индекс,
+ * новые фрагменты просто не используются, а старые описи остаются верными.
+ *
+ * Перед фиксацией выбранные по options.verify новые фрагменты читаются,
+ * расшифровываются и сверяются с контрольными суммами открытого текста.
+ *
+ * @return bool true, если все фрагменты, индекс и описи записаны, иначе false.
+ */
+bool AkrStore::commit()
+{
+    if (m_pack_fd < 0)
+    {
+        return false;
+    }
+
+    if (m_records.size() == m_committed && m_refs.empty())
+    {
+        return true;
+    }
+
+    if (!confirm_chunks())
+    {
+        rollback(m_committed);
+        m_refs.clear();
+        return false;
+    }
+
+    bool success = true;
+
+    ///< Если все фрагменты уже были в хранилище, индекс не меняется
+    if (m_records.size() > m_committed)
+    {
+        for (size_t i = m_committed; i < m_records.size(); ++i)
+        {
+            m_header.plain_size += m_records[i].entry.plain_size;
+        }
+
+        const std::uint64_t index_nonce = m_header.next_nonce++;
+
+        m_header.table_offset = m_stored_end;
+        m_header.chunk_count  = m_records.size();
+
+        success = fdatasync(m_pack_fd) == 0 &&
+                  AkrContainer::write_header(m_pack_fd, m_header) &&
+                  fdatasync(m_pack_fd) == 0 &&
+                  write_index(index_nonce);
+    }
+
+    if (!success)
+    {
+        std::cerr << "Не удалось записать индекс хранилища: " << m_dir << std::endl;
+        m_refs.clear();
+        return false;
+    }
+
+    m_checksums.clear();
+
+    for (const auto& ref : m_refs)
+    {
+        const std::string partial = ref.path + ".part";
+        int fd = ::open(partial.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        bool written = fd >= 0 && FileIO::pwrite_exact(fd, ref.data.data(), ref.data.size(), 0) && fdatasync(fd) == 0;
+
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+
+        std::error_code error;
+        if (written)
+        {
+            fs::rename(partial, ref.path, error);
+            written = !error;
+        }
+
+        if (!written)
+        {
+            fs::remove(partial, error);
+            std::cerr << "Не удалось записать опись: " << ref.path << std::endl;
+            success = false;
+        }
+    }
+
+    m_refs.clear();
+    return success;
+}
+
+/**
+ * @brief Закрывает хранилище и снимает блокировку.
+ *
+ * Файлы, помещенные после последнего commit(), отбрасываются.
+ */
+void AkrStore::close()
+{
+    if (m_index_fd >= 0)
+    {
+        ::close(m_index_fd);
+        m_index_fd = -1;
+    }
+
+    if (m_pack_fd >= 0)
+    {
+        ::close(m_pack_fd);
+        m_pack_fd = -1;
+    }
+
+    m_records.clear();
+    m_checksums.clear();
+    m_known.clear();
+    m_refs.clear();
+    m_password.clear();
+    m_committed  = 0;
+    m_stored_end = AKR_HEADER_SIZE;
+}
+
+/**
+ * @brief Восстанавливает файл по описи.
+ *
+ * Хранилище открывается только на чтение и не блокируется: зафиксированные
+ * фрагменты никогда не изменяются, поэтому восстанавливать можно во время
+ * записи в хранилище. Фрагменты расшифровываются параллельно.
+ *
+ * @param store_dir Каталог хранилища.
+ * @param ref_file Путь к описи.
+ * @param output_file Путь к восстановленному файлу.
+ * @param password Пароль, из которого вырабатывается ключ.
+ * @param threads Количество потоков (0 - по числу ядер).
+ * @return bool true, если файл восстановлен, иначе false.
+ */
+bool AkrStore::restore(const std::string& store_dir,
+                       const std::string& ref_file,
+                       const std::string& output_file,
+                       const std::string& password,
+                       unsigned int threads)
+{
+    const std::string pack_file = (fs::path(store_dir) / AKR_STORE_PACK).string();
+    int pack_fd = ::open(pack_file.c_str(), O_RDONLY);
+    if (pack_fd < 0)
+    {
+        std::cerr << "Не удалось открыть файл для чтения: " << pack_file << std::endl;
+        return false;
+    }
+
+    AkrHeader header;
+    std::vector<AkrChunkEntry> entries;
+
+    bool success = AkrContainer::read_header(pack_fd, header);
+
+    if (success && !(header.flags & AKR_FLAG_STORE))
+    {
+        std::cerr << "Файл не является хранилищем фрагментов: " << pack_file << std::endl;
+        success = false;
+    }
+
+    if (success)
+    {
+        auto key = CryptoSession::instance().acquire_key(password, AkrContainer::salt_string(header), AkrContainer::algorithm_name(header));
+        success = key && read_ref(ref_file, key.get(), header, entries);
+    }
+
+    int output_fd = success ? ::open(output_file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) : -1;
+    if (success && output_fd < 0)
+    {
+        std::cerr << "Не удалось открыть файл для записи: " << output_file << std::endl;
+        success = false;
+    }
+
+    const std::uint64_t plain_size = entries.empty() ? 0 : entries.back().plain_offset + entries.back().plain_size;
+    success = success && ftruncate(output_fd, static_cast<off_t>(plain_size)) == 0;
+
+    success = success && ParallelFor::run(entries.size(), threads, [&]() -> ParallelFor::Task
+    {
+        auto worker = std::make_shared<StoreWorker>(
+            CryptoSession::instance().acquire_key(password, AkrContainer::salt_string(header), AkrContainer::algorithm_name(header)));
+        worker->buffer = BufferPool::instance().acquire(header.chunk_size);
+
+        if (!worker->key || !worker->buffer)
+        {
+            return nullptr;
+        }
+
+        return [&, worker](size_t index)
+        {
+            const AkrChunkEntry& entry = entries[index];
+
+            return FileIO::pread_exact(pack_fd, worker->buffer.data(), entry.stored_size, static_cast<off_t>(entry.stored_offset)) &&
+                   AkrContainer::decrypt_chunk(worker->key.get(), header, entry, worker->buffer.data()) &&
+                   FileIO::pwrite_exact(output_fd, worker->buffer.data(), entry.plain_size, static_cast<off_t>(entry.plain_offset));
+        };
+    });
+
+    ::close(pack_fd);
+    if (output_fd >= 0)
+    {
+        ::close(output_fd);
+    }
+
+    if (!success)
+    {
+        std::cerr << "Не удалось восстановить файл: " << ref_file << std::endl;
+    }
+
+    return success;
+}
+
+/**
+ * @brief Создает пустой индекс нового хранилища.
+ *
+ * Имитовставка пустого индекса позволяет уже при втором открытии
+ * отличить неверный пароль.
+ */
+bool AkrStore::create()
+{
+    const std::string index_file = (fs::path(m_dir) / AKR_STORE_INDEX).string();
+
+    m_index_fd = ::open(index_file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (m_index_fd < 0)
+    {
+        std::cerr << "Не удалось открыть файл для записи: " << index_file << std::endl;
+        return false;
+    }
+
+    const std::uint64_t index_nonce = m_header.next_nonce++;
+
+    return AkrContainer::write_header(m_pack_fd, m_header) &&
+           fdatasync(m_pack_fd) == 0 &&
+           write_index(index_nonce);
+}
+
+/**
+ * @brief Читает индекс, проверяет его имитовставку и строит словарь отпечатков.
+ *
+ * Записи за последней зафиксированной (недописанная фиксация) отбрасываются.
+ * Если индекса нет, а в pack еще не зафиксировано ни одного фрагмента,
+ * индекс создается заново.
+ */
+bool AkrStore::load_index()
+{
+    const std::string index_file = (fs::path(m_dir) / AKR_STORE_INDEX).string();
+
+    m_index_fd = ::open(index_file.c_str(), O_RDWR);
+    if (m_index_fd < 0)
+    {
+        if (errno == ENOENT && m_header.chunk_count == 0)
+        {
+            return create();
+        }
+
+        std::cerr << "Не удалось открыть индекс хранилища: " << index_file << std::endl;
+        return false;
+    }
+
+    struct stat index_stat;
+    ak_uint8 head[AKR_STORE_HEADER_SIZE] = {0};
+
+    if (fstat(m_index_fd, &index_stat) != 0 ||
+        !FileIO::pread_exact(m_index_fd, head, sizeof(head), 0) ||
+        std::memcmp(head, AKR_STORE_INDEX_MAGIC, 4) != 0 ||
+        get_le(head + 4, 2) != AKR_STORE_VERSION ||
+        get_le(head + 6, 2) != AKR_STORE_INDEX_RECORD ||
+        std::memcmp(head + 8, m_header.salt, AKR_SALT_SIZE) != 0 ||
+        get_le(head + 24, 8) > (static_cast<std::uint64_t>(index_stat.st_size) - AKR_STORE_HEADER_SIZE) / AKR_STORE_INDEX_RECORD ||
+        get_le(head + 32, 8) >= m_header.next_nonce)
+    {
+        std::cerr << "Поврежденный индекс хранилища: " << index_file << std::endl;
+        return false;
+    }
+
+    const size_t count = static_cast<size_t>(get_le(head + 24, 8));
+    std::vector<ak_uint8> data(AKR_STORE_HEADER_SIZE + count * AKR_STORE_INDEX_RECORD);
+    ak_uint8 tag[AKR_DIGEST_SIZE] = {0};
+    ak_uint8 stored_tag[AKR_DIGEST_SIZE] = {0};
+
+    auto key = CryptoSession::instance().acquire_key(m_password, AkrContainer::salt_string(m_header), AkrContainer::algorithm_name(m_header));
+
+    if (!key || !FileIO::pread_exact(m_index_fd, data.data(), data.size(), 0))
+    {
+        return false;
+    }
+
+    std::memcpy(stored_tag, data.data() + 48, AKR_DIGEST_SIZE);
+
+    if (!seal(key.get(), m_header, get_le(head + 32, 8), data.data(), data.size(), 48, tag) ||
+        std::memcmp(tag, stored_tag, AKR_DIGEST_SIZE) != 0)
+    {
+        std::cerr << "Неверный пароль или поврежденный индекс хранилища: " << m_dir << std::endl;
+        return false;
+    }
+
+    m_records.resize(count);
+    m_known.reserve(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const ak_uint8 *record = data.data() + AKR_STORE_HEADER_SIZE + i * AKR_STORE_INDEX_RECORD;
+
+        std::memcpy(m_records[i].fingerprint.data(), record, AKR_DIGEST_SIZE);
+        m_records[i].entry = get_entry(record + AKR_DIGEST_SIZE);
+
+        if (!valid_entry(m_header, m_records[i].entry))
+        {
+            std::cerr << "Поврежденный индекс хранилища: " << index_file << std::endl;
+            return false;
+        }
+
+        m_known.emplace(fingerprint_key(m_records[i].fingerprint, m_records[i].entry.plain_size), i);
+    }
+
+    m_committed = count;
+
+    return ftruncate(m_index_fd, static_cast<off_t>(data.size())) == 0;
+}
+
+/**
+ * @brief Дописывает новые записи индекса и записывает его заголовок.
+ *
+ * Записи сбрасываются на диск раньше заголовка: пока заголовок не записан,
+ * действует старое количество записей и старая имитовставка.
+ *
+ * @param nonce Nonce имитовставки индекса.
+ * @return bool true, если индекс записан, иначе false.
+ */
+bool AkrStore::write_index(std::uint64_t nonce)
+{
+    std::vector<ak_uint8> data(AKR_STORE_HEADER_SIZE + m_records.size() * AKR_STORE_INDEX_RECORD, 0);
+
+    std::memcpy(data.data(), AKR_STORE_INDEX_MAGIC, 4);
+    put_le(data.data() + 4, AKR_STORE_VERSION, 2);
+    put_le(data.data() + 6, AKR_STORE_INDEX_RECORD, 2);
+    std::memcpy(data.data() + 8, m_header.salt, AKR_SALT_SIZE);
+    put_le(data.data() + 24, m_records.size(), 8);
+    put_le(data.data() + 32, nonce, 8);
+
+    for (size_t i = 0; i < m_records.size(); ++i)
+    {
+        ak_uint8 *record = data.data() + AKR_STORE_HEADER_SIZE + i * AKR_STORE_INDEX_RECORD;
+
+        std::memcpy(record, m_records[i].fingerprint.data(), AKR_DIGEST_SIZE);
+        put_entry(record + AKR_DIGEST_SIZE, m_records[i].entry);
+    }
+
+    auto key = CryptoSession::instance().acquire_key(m_password, AkrContainer::salt_string(m_header), AkrContainer::algorithm_name(m_header));
+
+    if (!key || !seal(key.get(), m_header, nonce, data.data(), data.size(), 48, data.data() + 48))
+    {
+        return false;
+    }
+
+    const size_t first = AKR_STORE_HEADER_SIZE + m_committed * AKR_STORE_INDEX_RECORD;
+
+    const bool success = FileIO::pwrite_exact(m_index_fd, data.data() + first, data.size() - first, static_cast<off_t>(first)) &&
+                         fdatasync(m_index_fd) == 0 &&
+                         FileIO::pwrite_exact(m_index_fd, data.data(), AKR_STORE_HEADER_SIZE, 0) &&
+                         fdatasync(m_index_fd) == 0;
+
+    if (success)
+    {
+        m_committed = m_records.size();
+    }
+
+    return success;
+}
+
+/**
+ * @brief Резервирует на диске count последовательных nonce.
+ *
+ * @param count Количество nonce.
+ * @param first Первый зарезервированный nonce.
+ * @return bool true, если новый next_nonce записан на диск, иначе false.
+ */
+bool AkrStore::reserve_nonces(std::uint64_t count, std::uint64_t& first)
+{
+    if (m_header.next_nonce > AKR_TABLE_NONCE - count)
+    {
+        std::cerr << "В хранилище закончились nonce: " << m_dir << std::endl;
+        return false;
+    }
+
+    first = m_header.next_nonce;
+    m_header.next_nonce += count;
+
+    return AkrContainer::write_header(m_pack_fd, m_header) && fdatasync(m_pack_fd) == 0;
+}
+
+/**
+ * @brief Сверяет выбранные новые фрагменты с контрольными суммами открытого текста.
+ */
+bool AkrStore::confirm_chunks()
+{
+    const std::vector<size_t> indices = AkrContainer::verify_indices(m_records.size() - m_committed, m_options.verify);
+
+    const bool success = ParallelFor::run(indices.size(), m_options.threads, [&]() -> ParallelFor::Task
+    {
+        auto worker = std::make_shared<StoreWorker>(
+            CryptoSession::instance().acquire_key(m_password, AkrContainer::salt_string(m_header), AkrContainer::algorithm_name(m_header)));
+        worker->buffer = BufferPool::instance().acquire(m_header.chunk_size);
+
+        if (!worker->key || !worker->buffer)
+        {
+            return nullptr;
+        }
+
+        return [&, worker](size_t index)
+        {
+            const AkrChunkEntry& entry = m_records[m_committed + indices[index]].entry;
+
+            return FileIO::pread_exact(m_pack_fd, worker->buffer.data(), entry.stored_size, static_cast<off_t>(entry.stored_offset)) &&
+                   AkrContainer::decrypt_chunk(worker->key.get(), m_header, entry, worker->buffer.data()) &&
+                   AkrContainer::plain_checksum(worker->buffer.data(), entry.plain_size) == m_checksums[indices[index]];
+        };
+    });
+
+    if (!success)
+    {
+        std::cerr << "Записанные фрагменты не совпадают с исходными данными: " << m_dir << std::endl;
+    }
+
+    return success;
+}
+
+/**
+ * @brief Отменяет незафиксированные записи начиная с номера records.
+ *
+ * Уже записанные в pack фрагменты остаются неиспользуемыми и отбрасываются
+ * при следующем открытии, если до этого не будет фиксации.
+ */
+void AkrStore::rollback(size_t records)
+{
+    for (size_t i = records; i < m_records.size(); ++i)
+    {
+        m_known.erase(fingerprint_key(m_records[i].fingerprint, m_records[i].entry.plain_size));
+    }
+
+    m_records.resize(records);
+    m_checksums.resize(records - m_committed);
+}
+
+/**
+ * @brief Вычисляет имитовставку индекса или описи.
+ *
+ * Имитовставка MGM без шифрования вычисляется от хэша Стрибог-256 всего
+ * файла, в котором поле имитовставки обнулено. Синхропосылка получается
+ * из nonce, выданного из общего счетчика хранилища.
+ *
+ * @param key Ключ хранилища.
+ * @param header Заголовок pack.
+ * @param nonce Nonce имитовставки.
+ * @param data Содержимое файла (поле имитовставки обнуляется).
+ * @param size Длина содержимого.
+ * @param tag_offset Смещение поля имитовставки (AKR_DIGEST_SIZE байт).
+ * @param tag Буфер на AKR_DIGEST_SIZE байт для результата.
+ * @return bool true, если имитовставка вычислена, иначе false.
+ */
+bool AkrStore::seal(struct bckey *key, const AkrHeader& header, std::uint64_t nonce, ak_uint8 *data, size_t size, size_t tag_offset, ak_uint8 *tag)
+{
+    struct hash ctx;
+    ak_uint8 digest[32] = {0};
+
+    std::memset(data + tag_offset, 0, AKR_DIGEST_SIZE);
+
+    if (ak_hash_create_streebog256(&ctx) != ak_error_ok)
+    {
+        return false;
+    }
+    ak_hash_ptr(&ctx, data, size, digest, sizeof(digest));
+    ak_hash_destroy(&ctx);
+
+    const size_t block_size = AkrContainer::engine(header).block_size;
+    ak_uint8 iv[AKR_IV_SIZE] = {0};
+
+    AkrContainer::chunk_iv(header, nonce, iv, block_size);
+    std::memset(tag, 0, AKR_DIGEST_SIZE);
+
+    return ak_bckey_encrypt_mgm(key, nullptr,
+                                digest, sizeof(digest),
+                                nullptr, nullptr, 0,
+                                iv, block_size,
+                                tag, block_size) == ak_error_ok;
+}
+
+/**
+ * @brief Читает опись и проверяет ее имитовставку и ссылки.
+ *
+ * @param ref_file Путь к описи.
+ * @param key Ключ хранилища.
+ * @param header Заголовок pack.
+ * @param entries Записи фрагментов файла с заполненными plain_offset.
+ * @return bool true, если опись подлинна и относится к этому хранилищу, иначе false.
+ */
+bool AkrStore::read_ref(const std::string& ref_file, struct bckey *key, const AkrHeader& header, std::vector<AkrChunkEntry>& entries)
+{
+    int fd = ::open(ref_file.c_str(), O_RDONLY);
+    struct stat ref_stat;
+
+    if (fd < 0 || fstat(fd, &ref_stat) != 0 || ref_stat.st_size < AKR_STORE_HEADER_SIZE)
+    {
+        std::cerr << "Не удалось прочитать опись: " << ref_file << std::endl;
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        return false;
+    }
+
+    std::vector<ak_uint8> data(static_cast<size_t>(ref_stat.st_size));
+    const bool loaded = FileIO::pread_exact(fd, data.data(), data.size(), 0);
+    ::close(fd);
+
+    if (!loaded ||
+        std::memcmp(data.data(), AKR_STORE_REF_MAGIC, 4) != 0 ||
+        get_le(data.data() + 4, 2) != AKR_STORE_VERSION ||
+        get_le(data.data() + 6, 2) != AKR_STORE_REF_RECORD ||
+        get_le(data.data() + 32, 8) != (data.size() - AKR_STORE_HEADER_SIZE) / AKR_STORE_REF_RECORD ||
+        (data.size() - AKR_STORE_HEADER_SIZE) % AKR_STORE_REF_RECORD != 0)
+    {
+        std::cerr << "Поврежденная опись: " << ref_file << std::endl;
+        return false;
+    }
+
+    if (std::memcmp(data.data() + 8, header.salt, AKR_SALT_SIZE) != 0)
+    {
+        std::cerr << "Опись относится к другому хранилищу: " << ref_file << std::endl;
+        return false;
+    }
+
+    const std::uint64_t plain_size = get_le(data.data() + 24, 8);
+    const std::uint64_t nonce      = get_le(data.data() + 40, 8);
+    ak_uint8 tag[AKR_DIGEST_SIZE] = {0};
+    ak_uint8 stored_tag[AKR_DIGEST_SIZE] = {0};
+
+    std::memcpy(stored_tag, data.data() + 48, AKR_DIGEST_SIZE);
+
+    if (nonce >= header.next_nonce ||
+        !seal(key, header, nonce, data.data(), data.size(), 48, tag) ||
+        std::memcmp(tag, stored_tag, AKR_DIGEST_SIZE) != 0)
+    {
+        std::cerr << "Неверный пароль или поврежденная опись: " << ref_file << std::endl;
+        return false;
+    }
+
+    const size_t count = (data.size() - AKR_STORE_HEADER_SIZE) / AKR_STORE_REF_RECORD;
+    std::uint64_t position = 0;
+
+    entries.assign(count, AkrChunkEntry());
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        entries[i] = get_entry(data.data() + AKR_STORE_HEADER_SIZE + i * AKR_STORE_REF_RECORD);
+        entries[i].plain_offset = position;
+
+        if (!valid_entry(header, entries[i]))
+        {
+            std::cerr << "Опись ссылается на отсутствующие данные хранилища: " << ref_file << std::endl;
+            return false;
+        }
+
+        position += entries[i].plain_size;
+    }
+
+    if (position != plain_size)
+    {
+        std::cerr << "Поврежденная опись: " << ref_file << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Формирует ключ словаря отпечатков: отпечаток и длина фрагмента.
+ */
+std::string AkrStore::fingerprint_key(const Fingerprint& fingerprint, std::uint32_t plain_size)
+{
+    std::string key(reinterpret_cast<const char*>(fingerprint.data()), fingerprint.size());
+    key.append(reinterpret_cast<const char*>(&plain_size), sizeof(plain_size));
+    return key;
+}
@@ -0,0 +1,120 @@
+/**
+ * @file       <akr_store.hpp>
+ * @brief      Хэдер хранилища фрагментов с дедупликацией между файлами.
+ *
+ *             Содержит в себе объявление хранилища, в котором одинаковые
+ *             фрагменты разных файлов шифруются и записываются один раз.
+ *             Файл, помещенный в хранилище, превращается в опись - список
+ *             ссылок на фрагменты, по которой его можно восстановить.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef AKR_STORE_HPP
+#define AKR_STORE_HPP
+
+#include "akr_container.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stddef.h>
+
+#define AKR_STORE_PACK           "pack"
+#define AKR_STORE_INDEX          "index"
+#define AKR_STORE_REF_SUFFIX     ".akref"
+#define AKR_STORE_INDEX_MAGIC    "AKRX"
+#define AKR_STORE_REF_MAGIC      "AKRF"
+#define AKR_STORE_KEY_SUFFIX     "AKRS"
+#define AKR_STORE_VERSION        1
+#define AKR_STORE_HEADER_SIZE    64
+#define AKR_STORE_INDEX_RECORD   64
+#define AKR_STORE_REF_RECORD     48
+#define AKR_STORE_SLOTS          2
+
+struct AkrStoreResult
+{
+    size_t        chunks  = 0;
+    size_t        stored  = 0;
+    std::uint64_t bytes   = 0;
+    std::uint64_t written = 0;
+};
+
+class AkrStore
+{
+public:
+    using Fingerprint = std::array<ak_uint8, AKR_DIGEST_SIZE>;
+
+public:
+    AkrStore() = default;
+    ~AkrStore();
+
+    AkrStore(const AkrStore&) = delete;
+    AkrStore& operator=(const AkrStore&) = delete;
+
+    bool open(const std::string& store_dir, const std::string& password, const AkrOptions& options);
+    bool put(const std::string& input_file, const std::string& ref_file, AkrStoreResult& result);
+    bool commit();
+    void close();
+
+    const AkrHeader& header() const { return m_header; }
+    size_t chunk_count() const { return m_records.size(); }
+
+    static bool restore(const std::string& store_dir,
+                        const std::string& ref_file,
+                        const std::string& output_file,
+                        const std::string& password,
+                        unsigned int threads = 0);
+
+private:
+    struct Record
+    {
+        Fingerprint   fingerprint{};
+        AkrChunkEntry entry;
+    };
+
+    struct PendingRef
+    {
+        std::string           path;
+        std::vector<ak_uint8> data;
+    };
+
+private:
+    bool create();
+    bool load_index();
+    bool write_index(std::uint64_t nonce);
+    bool reserve_nonces(std::uint64_t count, std::uint64_t& first);
+    bool confirm_chunks();
+    void rollback(size_t records);
+
+    static bool seal(struct bckey *key, const AkrHeader& header, std::uint64_t nonce, ak_uint8 *data, size_t size, size_t tag_offset, ak_uint8 *tag);
+    static bool read_ref(const std::string& ref_file, struct bckey *key, const AkrHeader& header, std::vector<AkrChunkEntry>& entries);
+    static std::string fingerprint_key(const Fingerprint& fingerprint, std::uint32_t plain_size);
+
+private:
+    std::string                             m_dir;
+    std::string                             m_password;
+    AkrOptions                              m_options;
+    AkrHeader                               m_header;
+    int                                     m_pack_fd  = -1;
+    int                                     m_index_fd = -1;
+    std::vector<Record>                     m_records;
+    std::vector<std::uint32_t>              m_checksums; ///< CRC32 фрагментов, записанных после последней фиксации
+    std::unordered_map<std::string, size_t> m_known;
+    std::vector<PendingRef>                 m_refs;
+    size_t                                  m_committed = 0;
+    std::uint64_t                           m_stored_end = AKR_HEADER_SIZE;
+};
+
+#endif // AKR_STORE_HPP
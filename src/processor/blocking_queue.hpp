@@ -0,0 +1,93 @@
+/**
+ * @file       <blocking_queue.hpp>
+ * @brief      Хэдер блокирующей очереди для обмена данными между потоками.
+ *
+ *             Используется стадиями конвейера чтение -> шифрование -> запись.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef BLOCKING_QUEUE_HPP
+#define BLOCKING_QUEUE_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+template <typename T>
+class BlockingQueue
+{
+public:
+    /**
+     * @brief Помещает элемент в очередь и будит одного ожидающего потребителя.
+     *
+     * @param value Элемент.
+     */
+    void push(T value)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queue.push_back(std::move(value));
+        }
+        m_condition.notify_one();
+    }
+
+    /**
+     * @brief Извлекает элемент, ожидая его появления.
+     *
+     * @return std::optional<T> Элемент или std::nullopt, если очередь закрыта и пуста.
+     */
+    std::optional<T> pop()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this]() { return !m_queue.empty() || m_closed; });
+
+        if (m_queue.empty())
+        {
+            return std::nullopt;
+        }
+
+        T value = std::move(m_queue.front());
+        m_queue.pop_front();
+        return value;
+    }
+
+    /**
+     * @brief Возвращает число элементов в очереди (для статистики, значение сразу устаревает).
+     */
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_queue.size();
+    }
+
+    /**
+     * @brief Закрывает очередь: pop() больше не ждет и возвращает оставшиеся элементы.
+     */
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_condition.notify_all();
+    }
+
+private:
+    mutable std::mutex      m_mutex;
+    std::condition_variable m_condition;
+    std::deque<T>           m_queue;
+    bool                    m_closed = false;
+};
+
+#endif // BLOCKING_QUEUE_HPP
@@ -0,0 +1,330 @@
+/**
+ * @file       <buffer_pool.cpp>
+ * @brief      Основной файл пула буферов для шифрования.
+ *
+ *             При пакетной обработке каждый файл и каждый рабочий поток
+ *             запрашивают буферы одних и тех же размеров. Пул хранит
+ *             освобожденные буферы по классам размеров (степени двойки),
+ *             поэтому в установившемся режиме память не выделяется заново
+ *             и не происходит повторных page fault на свежих страницах.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "buffer_pool.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+#include <string.h>
+#include <sys/mman.h>
+
+/**
+ * @brief Создает дескриптор буфера, выданного пулом.
+ */
+PooledBuffer::PooledBuffer(BufferPool* pool, ak_uint8* data, size_t size, size_t capacity)
+    : m_pool(pool), m_data(data), m_size(size), m_capacity(capacity), m_used(size)
+{
+}
+
+/**
+ * @brief Возвращает буфер в пул.
+ */
+PooledBuffer::~PooledBuffer()
+{
+    reset();
+}
+
+PooledBuffer::PooledBuffer(PooledBuffer&& other) noexcept
+    : m_pool(std::exchange(other.m_pool, nullptr)),
+      m_data(std::exchange(other.m_data, nullptr)),
+      m_size(std::exchange(other.m_size, 0)),
+      m_capacity(std::exchange(other.m_capacity, 0)),
+      m_used(std::exchange(other.m_used, 0))
+{
+}
+
+PooledBuffer& PooledBuffer::operator=(PooledBuffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        reset();
+        m_pool     = std::exchange(other.m_pool, nullptr);
+        m_data     = std::exchange(other.m_data, nullptr);
+        m_size     = std::exchange(other.m_size, 0);
+        m_capacity = std::exchange(other.m_capacity, 0);
+        m_used     = std::exchange(other.m_used, 0);
+    }
+    return *this;
+}
+
+/**
+ * @brief Изменяет используемый размер буфера в пределах его емкости.
+ *
+ * Писать в буфер можно только в пределах size(): при возврате в пул
+ * затирается наибольший размер, который был у буфера.
+ *
+ * @param size Новый размер.
+ * @return bool true, если размер не превышает емкость, иначе false.
+ */
+bool PooledBuffer::resize(size_t size)
+{
+    if (size > m_capacity)
+    {
+        return false;
+    }
+
+    m_size = size;
+    m_used = std::max(m_used, size);
+    return true;
+}
+
+/**
+ * @brief Досрочно возвращает буфер в пул.
+ */
+void PooledBuffer::reset()
+{
+    if (m_data && m_pool)
+    {
+        m_pool->release(m_data, m_capacity, m_used);
+    }
+
+    m_pool     = nullptr;
+    m_data     = nullptr;
+    m_size     = 0;
+    m_capacity = 0;
+    m_used     = 0;
+}
+
+/**
+ * @brief Возвращает единственный экземпляр пула.
+ *
+ * @return BufferPool& Ссылка на пул.
+ */
+BufferPool& BufferPool::instance()
+{
+    static BufferPool pool;
+    return pool;
+}
+
+/**
+ * @brief Резервирует списки свободных буферов.
+ *
+ * Благодаря резерву возврат буфера в пул сам не выделяет память.
+ */
+BufferPool::BufferPool()
+{
+    for (auto& list : m_free)
+    {
+        list.reserve(BUFFER_POOL_MAX_CACHED);
+    }
+}
+
+/**
+ * @brief Освобождает все буферы пула.
+ */
+BufferPool::~BufferPool()
+{
+    trim();
+}
+
+/**
+ * @brief Выдает буфер не меньше заданного размера.
+ *
+ * Емкость буфера округляется вверх до степени двойки (не меньше страницы),
+ * адрес выровнен по странице, а при включенных huge pages и емкости от 2 МиБ -
+ * по размеру huge page.
+ *
+ * @param size Требуемый размер в байтах.
+ * @return PooledBuffer Буфер или пустой дескриптор, если память не выделена.
+ *
+ * @note Содержимое буфера не определено (память из пула не обнуляется при выдаче).
+ */
+PooledBuffer BufferPool::acquire(size_t size)
+{
+    const size_t index = size_class(size);
+    if (index >= BUFFER_POOL_CLASSES)
+    {
+        return PooledBuffer();
+    }
+
+    const size_t capacity = static_cast<size_t>(1) << index;
+    bool huge_pages = false;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto& list = m_free[index];
+        if (!list.empty())
+        {
+            ak_uint8* data = list.back();
+            list.pop_back();
+            ++m_reuses;
+            return PooledBuffer(this, data, size, capacity);
+        }
+
+        ++m_allocations;
+        huge_pages = m_huge_pages;
+    }
+
+    ak_uint8* data = allocate(capacity, huge_pages);
+    return data ? PooledBuffer(this, data, size, capacity) : PooledBuffer();
+}
+
+/**
+ * @brief Включает или выключает transparent huge pages для новых буферов.
+ *
+ * Уже выделенные буферы не меняются.
+ *
+ * @param enabled true - запрашивать huge pages для буферов от 2 МиБ.
+ */
+void BufferPool::set_huge_pages(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_huge_pages = enabled;
+}
+
+/**
+ * @brief Проверяет, включены ли huge pages.
+ *
+ * @return bool true, если huge pages включены.
+ */
+bool BufferPool::huge_pages() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_huge_pages;
+}
+
+/**
+ * @brief Освобождает все свободные буферы пула.
+ */
+void BufferPool::trim()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (size_t index = 0; index < m_free.size(); ++index)
+    {
+        for (auto* data : m_free[index])
+        {
+            deallocate(data, static_cast<size_t>(1) << index);
+        }
+        m_free[index].clear();
+    }
+}
+
+/**
+ * @brief Количество буферов, для которых выделялась новая память.
+ *
+ * @return size_t Количество выделений.
+ */
+size_t BufferPool::allocations() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_allocations;
+}
+
+/**
+ * @brief Количество буферов, выданных повторно из пула.
+ *
+ * @return size_t Количество повторных выдач.
+ */
+size_t BufferPool::reuses() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_reuses;
+}
+
+/**
+ * @brief Принимает буфер обратно в пул.
+ *
+ * Затирается только использованная часть буфера (емкость класса может быть
+ * почти вдвое больше), чтобы открытый текст одного файла не оставался
+ * в памяти до следующего использования. explicit_bzero не убирается
+ * компилятором, даже если затем буфер освобождается. Если список класса
+ * заполнен, буфер освобождается.
+ *
+ * @param data Указатель на буфер.
+ * @param capacity Емкость буфера.
+ * @param used Сколько байт буфера могло быть записано.
+ */
+void BufferPool::release(ak_uint8* data, size_t capacity, size_t used)
+{
+    explicit_bzero(data, std::min(used, capacity));
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto& list = m_free[size_class(capacity)];
+        if (list.size() < BUFFER_POOL_MAX_CACHED)
+        {
+            list.push_back(data);
+            return;
+        }
+    }
+
+    deallocate(data, capacity);
+}
+
+/**
+ * @brief Возвращает номер класса размера (log2 емкости).
+ *
+ * @param size Требуемый размер.
+ * @return size_t Номер класса.
+ */
+size_t BufferPool::size_class(size_t size)
+{
+    size_t index = 12;
+    while ((static_cast<size_t>(1) << index) < size && index < BUFFER_POOL_CLASSES)
+    {
+        ++index;
+    }
+    return index;
+}
+
+/**
+ * @brief Выделяет выровненную память.
+ *
+ * @param capacity Емкость буфера.
+ * @param huge_pages Запрашивать ли transparent huge pages.
+ * @return ak_uint8* Указатель на память или nullptr.
+ */
+ak_uint8* BufferPool::allocate(size_t capacity, bool huge_pages)
+{
+    const bool use_huge = huge_pages && capacity >= BUFFER_POOL_HUGE_PAGE;
+    void* data = nullptr;
+
+    if (posix_memalign(&data, use_huge ? BUFFER_POOL_HUGE_PAGE : BUFFER_POOL_ALIGNMENT, capacity) != 0)
+    {
+        return nullptr;
+    }
+
+#ifdef MADV_HUGEPAGE
+    if (use_huge)
+    {
+        madvise(data, capacity, MADV_HUGEPAGE);
+    }
+#endif
+
+    return static_cast<ak_uint8*>(data);
+}
+
+/**
+ * @brief Освобождает память буфера.
+ *
+ * @param data Указатель на буфер.
+ * @param capacity Емкость буфера (не используется).
+ */
+void BufferPool::deallocate(ak_uint8* data, size_t /*capacity*/)
+{
+    std::free(data);
+}
@@ -0,0 +1,108 @@
+/**
+ * @file       <buffer_pool.hpp>
+ * @brief      Хэдер пула буферов для шифрования.
+ *
+ *             Содержит в себе объявление пула выровненных по странице буферов
+ *             и владеющего дескриптора PooledBuffer, который возвращает буфер
+ *             в пул при уничтожении.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef BUFFER_POOL_HPP
+#define BUFFER_POOL_HPP
+
+#include <array>
+#include <mutex>
+#include <vector>
+#include <stddef.h>
+
+#define BUFFER_POOL_ALIGNMENT   4096
+#define BUFFER_POOL_HUGE_PAGE   (2 << 20)
+#define BUFFER_POOL_MAX_CACHED  64
+#define BUFFER_POOL_CLASSES     48
+
+typedef unsigned char ak_uint8;
+
+class BufferPool;
+
+class PooledBuffer
+{
+public:
+    PooledBuffer() = default;
+    ~PooledBuffer();
+
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+    PooledBuffer(PooledBuffer&& other) noexcept;
+    PooledBuffer& operator=(PooledBuffer&& other) noexcept;
+
+    ak_uint8* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    size_t capacity() const { return m_capacity; }
+    bool resize(size_t size);
+    void reset();
+
+    explicit operator bool() const { return m_data != nullptr; }
+
+private:
+    friend class BufferPool;
+
+    PooledBuffer(BufferPool* pool, ak_uint8* data, size_t size, size_t capacity);
+
+private:
+    BufferPool* m_pool     = nullptr;
+    ak_uint8*   m_data     = nullptr;
+    size_t      m_size     = 0;
+    size_t      m_capacity = 0;
+    size_t      m_used     = 0; ///< Наибольший размер за время владения - столько байт затирается при возврате
+};
+
+class BufferPool
+{
+public:
+    static BufferPool& instance();
+
+    PooledBuffer acquire(size_t size);
+
+    void set_huge_pages(bool enabled);
+    bool huge_pages() const;
+    void trim();
+
+    size_t allocations() const;
+    size_t reuses() const;
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+private:
+    friend class PooledBuffer;
+
+    BufferPool();
+    ~BufferPool();
+
+    void release(ak_uint8* data, size_t capacity, size_t used);
+
+    static size_t size_class(size_t size);
+    static ak_uint8* allocate(size_t capacity, bool huge_pages);
+    static void deallocate(ak_uint8* data, size_t capacity);
+
+private:
+    mutable std::mutex                                        m_mutex;
+    std::array<std::vector<ak_uint8*>, BUFFER_POOL_CLASSES>   m_free;
+    bool                                                      m_huge_pages  = false;
+    size_t                                                    m_allocations = 0;
+    size_t                                                    m_reuses      = 0;
+};
+
+#endif // BUFFER_POOL_HPP
@@ -0,0 +1,198 @@
+/**
+ * @file       <chunk_codec.cpp>
+ * @brief      Основной файл сжатия фрагментов контейнера перед шифрованием.
+ *
+ *             Фрагмент сжимается raw deflate без заголовка и контрольной суммы
+ *             zlib: целостность фрагмента уже защищена хэшем или имитовставкой
+ *             контейнера. Потоки deflate и inflate создаются один раз на поток
+ *             и переиспользуются, поэтому на каждый фрагмент не выделяется память.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "chunk_codec.hpp"
+
+#include <cstring>
+#include <iostream>
+
+/**
+ * @brief Возвращает кодек текущего потока.
+ *
+ * @return ChunkCodec& Кодек, который живет до завершения потока.
+ */
+ChunkCodec& ChunkCodec::local()
+{
+    static thread_local ChunkCodec codec;
+    return codec;
+}
+
+ChunkCodec::~ChunkCodec()
+{
+    if (m_deflate_ready)
+    {
+        deflateEnd(&m_deflate);
+    }
+    if (m_inflate_ready)
+    {
+        inflateEnd(&m_inflate);
+    }
+}
+
+/**
+ * @brief Сжимает фрагмент, если это дает выигрыш.
+ *
+ * Эта функция сначала сжимает с минимальным уровнем пробу из середины
+ * большого фрагмента: если проба не сжимается, фрагмент считается
+ * несжимаемым (уже сжатые или зашифрованные данные) и полное сжатие
+ * не запускается. Сжатие прерывается, как только результат перестает
+ * быть хотя бы на 1/CHUNK_CODEC_MIN_SAVING меньше исходных данных.
+ *
+ * @param data Открытый текст фрагмента.
+ * @param size Длина открытого текста.
+ * @param level Уровень сжатия zlib (1-9).
+ * @param packed Указатель на сжатые данные во внутреннем буфере кодека,
+ *               действителен до следующего вызова на этом потоке.
+ * @param packed_size Длина сжатых данных.
+ * @return bool true, если фрагмент сжат, false - если его нужно хранить как есть.
+ */
+bool ChunkCodec::compress(const ak_uint8 *data, size_t size, int level, ak_uint8*& packed, size_t& packed_size)
+{
+    if (size < CHUNK_CODEC_MIN_SAVING || !reserve(size))
+    {
+        return false;
+    }
+
+    size_t written = 0;
+
+    if (size > 2 * CHUNK_CODEC_PROBE_SIZE &&
+        !deflate_into(data + (size - CHUNK_CODEC_PROBE_SIZE) / 2, CHUNK_CODEC_PROBE_SIZE,
+                      CHUNK_CODEC_PROBE_LEVEL, saving_limit(CHUNK_CODEC_PROBE_SIZE), written))
+    {
+        return false;
+    }
+
+    if (!deflate_into(data, size, level, saving_limit(size), written))
+    {
+        return false;
+    }
+
+    packed      = m_scratch.data();
+    packed_size = written;
+
+    return true;
+}
+
+/**
+ * @brief Распаковывает фрагмент на месте.
+ *
+ * @param data Буфер со сжатыми данными (stored_size байт) размером не меньше plain_size.
+ * @param stored_size Длина сжатых данных.
+ * @param plain_size Ожидаемая длина открытого текста.
+ * @return bool true, если данные распакованы ровно в plain_size байт, иначе false.
+ */
+bool ChunkCodec::decompress(ak_uint8 *data, size_t stored_size, size_t plain_size)
+{
+    if (!reserve(plain_size))
+    {
+        return false;
+    }
+
+    if (!m_inflate_ready)
+    {
+        if (inflateInit2(&m_inflate, -MAX_WBITS) != Z_OK)
+        {
+            return false;
+        }
+        m_inflate_ready = true;
+    }
+    else if (inflateReset(&m_inflate) != Z_OK)
+    {
+        return false;
+    }
+
+    m_inflate.next_in   = data;
+    m_inflate.avail_in  = static_cast<uInt>(stored_size);
+    m_inflate.next_out  = m_scratch.data();
+    m_inflate.avail_out = static_cast<uInt>(plain_size);
+
+    if (inflate(&m_inflate, Z_FINISH) != Z_STREAM_END ||
+        m_inflate.avail_in != 0 || m_inflate.avail_out != 0)
+    {
+        std::cerr << "Поврежденные сжатые данные фрагмента" << std::endl;
+        return false;
+    }
+
+    std::memcpy(data, m_scratch.data(), plain_size);
+    return true;
+}
+
+/**
+ * @brief Гарантирует, что внутренний буфер вмещает size байт.
+ */
+bool ChunkCodec::reserve(size_t size)
+{
+    if (m_scratch.capacity() < size)
+    {
+        m_scratch = BufferPool::instance().acquire(size);
+    }
+
+    return m_scratch && m_scratch.resize(size); ///< Размер учитывается пулом при затирании
+}
+
+/**
+ * @brief Сжимает данные во внутренний буфер, записывая не больше limit байт.
+ *
+ * @return bool true, если поток сжатия завершен в пределах limit, иначе false.
+ */
+bool ChunkCodec::deflate_into(const ak_uint8 *data, size_t size, int level, size_t limit, size_t& written)
+{
+    if (!m_deflate_ready)
+    {
+        if (deflateInit2(&m_deflate, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            return false;
+        }
+        m_deflate_ready = true;
+        m_level         = level;
+    }
+    else if (deflateReset(&m_deflate) != Z_OK)
+    {
+        return false;
+    }
+
+    if (level != m_level)
+    {
+        if (deflateParams(&m_deflate, level, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            return false;
+        }
+        m_level = level;
+    }
+
+    m_deflate.next_in   = const_cast<Bytef*>(data);
+    m_deflate.avail_in  = static_cast<uInt>(size);
+    m_deflate.next_out  = m_scratch.data();
+    m_deflate.avail_out = static_cast<uInt>(limit);
+
+    const int result = deflate(&m_deflate, Z_FINISH);
+    written = limit - m_deflate.avail_out;
+
+    return result == Z_STREAM_END;
+}
+
+/**
+ * @brief Возвращает наибольший размер сжатых данных, при котором сжатие имеет смысл.
+ */
+size_t ChunkCodec::saving_limit(size_t size)
+{
+    return size - size / CHUNK_CODEC_MIN_SAVING;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file       <chunk_codec.hpp>
+ * @brief      Хэдер сжатия фрагментов контейнера перед шифрованием.
+ *
+ *             Содержит в себе объявление кодека, который сжимает фрагмент
+ *             открытого текста deflate до шифрования и восстанавливает его
+ *             после расшифрования. Несжимаемые фрагменты распознаются
+ *             заранее и хранятся как есть.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef CHUNK_CODEC_HPP
+#define CHUNK_CODEC_HPP
+
+#include "buffer_pool.hpp"
+
+#include <zlib.h>
+#include <stddef.h>
+
+#define CHUNK_CODEC_PROBE_SIZE  (64 << 10)
+#define CHUNK_CODEC_PROBE_LEVEL 1
+#define CHUNK_CODEC_MIN_SAVING  16
+
+class ChunkCodec
+{
+public:
+    static ChunkCodec& local();
+
+    bool compress(const ak_uint8 *data, size_t size, int level, ak_uint8*& packed, size_t& packed_size);
+    bool decompress(ak_uint8 *data, size_t stored_size, size_t plain_size);
+
+    ChunkCodec(const ChunkCodec&) = delete;
+    ChunkCodec& operator=(const ChunkCodec&) = delete;
+
+private:
+    ChunkCodec() = default;
+    ~ChunkCodec();
+
+    bool reserve(size_t size);
+    bool deflate_into(const ak_uint8 *data, size_t size, int level, size_t limit, size_t& written);
+
+    static size_t saving_limit(size_t size);
+
+private:
+    z_stream     m_deflate{};
+    z_stream     m_inflate{};
+    bool         m_deflate_ready = false;
+    bool         m_inflate_ready = false;
+    int          m_level         = -1;
+    PooledBuffer m_scratch;
+};
+
+#endif // CHUNK_CODEC_HPP
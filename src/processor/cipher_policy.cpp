@@ -0,0 +1,80 @@
+/**
+ * @file       <cipher_policy.cpp>
+ * @brief      Реализация политик шифров и режимов шифрования.
+ *
+ *             Содержит в себе вызовы libakrypt, которые стоят за политиками:
+ *             создание ключа нужного шифра и гаммирование в режимах OFB и CTR.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "cipher_policy.hpp"
+#include "crypto_session.hpp"
+
+#include <libakrypt.h>
+
+/**
+ * @brief Создает пустой ключ Магмы.
+ *
+ * @param key Структура ключа.
+ * @return int Код ошибки libakrypt (ak_error_ok при успехе).
+ */
+int Magma::create(struct bckey *key)
+{
+    return ak_bckey_create_magma(key);
+}
+
+/**
+ * @brief Создает пустой ключ Кузнечика.
+ *
+ * @param key Структура ключа.
+ * @return int Код ошибки libakrypt (ak_error_ok при успехе).
+ */
+int Kuznechik::create(struct bckey *key)
+{
+    return ak_bckey_create_kuznechik(key);
+}
+
+/**
+ * @brief Гаммирование в режиме OFB через libakrypt.
+ *
+ * @param key Ключ.
+ * @param in Входные данные.
+ * @param out Буфер для результата (может совпадать с in).
+ * @param size Длина данных в байтах.
+ * @param iv Синхропосылка или nullptr для продолжения гаммы.
+ * @param iv_size Длина синхропосылки.
+ * @return int Код ошибки libakrypt (ak_error_ok при успехе).
+ */
+int Ofb::apply(struct bckey *key, const ak_uint8 *in, ak_uint8 *out, size_t size, const ak_uint8 *iv, size_t iv_size)
+{
+    return ak_bckey_ofb(key, const_cast<ak_uint8*>(in), out, size, const_cast<ak_uint8*>(iv), iv_size);
+}
+
+/**
+ * @brief Гаммирование в режиме CTR.
+ *
+ * Вызов передается в CryptoSession::ctr, которая использует собственную
+ * реализацию шифра, если она связана с ключом.
+ *
+ * @param key Ключ.
+ * @param in Входные данные.
+ * @param out Буфер для результата (может совпадать с in).
+ * @param size Длина данных в байтах.
+ * @param iv Синхропосылка или nullptr для продолжения гаммы.
+ * @param iv_size Длина синхропосылки.
+ * @return int Код ошибки libakrypt (ak_error_ok при успехе).
+ */
+int Ctr::apply(struct bckey *key, const ak_uint8 *in, ak_uint8 *out, size_t size, const ak_uint8 *iv, size_t iv_size)
+{
+    return CryptoSession::instance().ctr(key, in, out, size, iv, iv_size);
+}
@@ -0,0 +1,232 @@
+/**
+ * @file       <cipher_policy.hpp>
+ * @brief      Хэдер политик шифров и режимов шифрования.
+ *
+ *             Содержит в себе типы-политики шифров (Magma, Kuznechik) и режимов
+ *             (Ofb, Ctr, Mgm) и шаблон Engine<Cipher, Mode>, в котором длины
+ *             блока и синхропосылки и тип собственной реализации шифра известны
+ *             при компиляции. Строковые имена алгоритма и режима разбираются
+ *             один раз, в dispatch_cipher/dispatch_engine, при запуске задания;
+ *             дальше код работает с конкретной специализацией Engine или с ее
+ *             описанием EngineInfo.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef CIPHER_POLICY_HPP
+#define CIPHER_POLICY_HPP
+
+#include "kuznechik_kernel.hpp"
+#include "magma_kernel.hpp"
+
+#include <string>
+#include <stddef.h>
+
+struct bckey;
+
+/**
+ * @brief Шифр Магма (ГОСТ Р 34.12-2015, блок 64 бита).
+ */
+struct Magma
+{
+    using Kernel = MagmaKernel;
+
+    static constexpr const char *name       = "magma";
+    static constexpr size_t      block_size = MAGMA_BLOCK_SIZE;
+    static constexpr size_t      key_size   = MAGMA_KEY_SIZE;
+
+    static int create(struct bckey *key);
+};
+
+/**
+ * @brief Шифр Кузнечик (ГОСТ Р 34.12-2015, блок 128 бит).
+ */
+struct Kuznechik
+{
+    using Kernel = KuznechikKernel;
+
+    static constexpr const char *name       = "kuznechik";
+    static constexpr size_t      block_size = KUZNECHIK_BLOCK_SIZE;
+    static constexpr size_t      key_size   = KUZNECHIK_KEY_SIZE;
+
+    static int create(struct bckey *key);
+};
+
+/**
+ * @brief Режим гаммирования с обратной связью по выходу (синхропосылка - блок).
+ */
+struct Ofb
+{
+    static constexpr const char *name = "ofb";
+
+    template <typename Cipher>
+    static constexpr size_t iv_size = Cipher::block_size;
+
+    static int apply(struct bckey *key, const ak_uint8 *in, ak_uint8 *out, size_t size, const ak_uint8 *iv, size_t iv_size);
+};
+
+/**
+ * @brief Режим гаммирования (синхропосылка - половина блока).
+ */
+struct Ctr
+{
+    static constexpr const char *name = "ctr";
+
+    template <typename Cipher>
+    static constexpr size_t iv_size = Cipher::block_size / 2;
+
+    static int apply(struct bckey *key, const ak_uint8 *in, ak_uint8 *out, size_t size, const ak_uint8 *iv, size_t iv_size);
+};
+
+/**
+ * @brief Режим MGM: синхропосылка и имитовставка длиной в блок.
+ *
+ * Шифрование с имитовставкой вызывается отдельно (ak_bckey_encrypt_mgm),
+ * поэтому apply у режима нет.
+ */
+struct Mgm
+{
+    static constexpr const char *name = "mgm";
+
+    template <typename Cipher>
+    static constexpr size_t iv_size = Cipher::block_size;
+
+    template <typename Cipher>
+    static constexpr size_t tag_size = Cipher::block_size;
+};
+
+/**
+ * @brief Сочетание шифра и режима с параметрами, известными при компиляции.
+ */
+template <typename Cipher, typename Mode>
+struct Engine
+{
+    using cipher_type = Cipher;
+    using mode_type   = Mode;
+    using kernel_type = typename Cipher::Kernel;
+
+    static constexpr size_t block_size = Cipher::block_size;
+    static constexpr size_t iv_size    = Mode::template iv_size<Cipher>;
+
+    /**
+     * @brief Зашифровывает или расшифровывает данные (синхропосылка длиной iv_size).
+     *
+     * @param key Ключ.
+     * @param in Входные данные.
+     * @param out Буфер для результата (может совпадать с in).
+     * @param size Длина данных в байтах.
+     * @param iv Синхропосылка или nullptr для продолжения гаммы.
+     * @return int Код ошибки libakrypt (ak_error_ok при успехе).
+     */
+    static int apply(struct bckey *key, const ak_uint8 *in, ak_uint8 *out, size_t size, const ak_uint8 *iv)
+    {
+        return Mode::apply(key, in, out, size, iv, iv ? iv_size : 0);
+    }
+};
+
+/**
+ * @brief Описание специализации Engine для кода, который выбирает ее по заголовку файла.
+ */
+struct EngineInfo
+{
+    const char *algorithm  = nullptr;
+    const char *mode       = nullptr;
+    size_t      block_size = 0;
+    size_t      iv_size    = 0;
+    int       (*apply)(struct bckey*, const ak_uint8*, ak_uint8*, size_t, const ak_uint8*) = nullptr; ///< nullptr для MGM
+};
+
+/**
+ * @brief Возвращает описание специализации Engine.
+ *
+ * @return EngineInfo Имена, длины и указатель на Engine::apply.
+ */
+template <typename Cipher, typename Mode>
+constexpr EngineInfo engine_info()
+{
+    using E = Engine<Cipher, Mode>;
+
+    EngineInfo info;
+    info.algorithm  = Cipher::name;
+    info.mode       = Mode::name;
+    info.block_size = E::block_size;
+    info.iv_size    = E::iv_size;
+
+    if constexpr (requires { &Mode::apply; })
+    {
+        info.apply = &E::apply;
+    }
+
+    return info;
+}
+
+/**
+ * @brief Выбирает политику шифра по имени и вызывает с ней visitor.
+ *
+ * @param algorithm Имя алгоритма (kuznechik или magma).
+ * @param visitor Вызывается как visitor(Magma{}) или visitor(Kuznechik{}).
+ * @return bool false, если алгоритм неизвестен (visitor не вызывается).
+ */
+template <typename Visitor>
+bool dispatch_cipher(const std::string& algorithm, Visitor&& visitor)
+{
+    if (algorithm == Magma::name)
+    {
+        visitor(Magma{});
+        return true;
+    }
+    if (algorithm == Kuznechik::name)
+    {
+        visitor(Kuznechik{});
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Выбирает Engine по именам алгоритма и режима и вызывает с ним visitor.
+ *
+ * @param algorithm Имя алгоритма (kuznechik или magma).
+ * @param mode Имя режима (ofb, ctr или mgm).
+ * @param visitor Вызывается как visitor(Engine<Cipher, Mode>{}).
+ * @return bool false, если алгоритм или режим неизвестен.
+ */
+template <typename Visitor>
+bool dispatch_engine(const std::string& algorithm, const std::string& mode, Visitor&& visitor)
+{
+    bool found = false;
+
+    dispatch_cipher(algorithm, [&](auto cipher)
+    {
+        using Cipher = decltype(cipher);
+
+        if (mode == Ofb::name)
+        {
+            visitor(Engine<Cipher, Ofb>{});
+            found = true;
+        }
+        else if (mode == Ctr::name)
+        {
+            visitor(Engine<Cipher, Ctr>{});
+            found = true;
+        }
+        else if (mode == Mgm::name)
+        {
+            visitor(Engine<Cipher, Mgm>{});
+            found = true;
+        }
+    });
+
+    return found;
+}
+
+#endif // CIPHER_POLICY_HPP
@@ -0,0 +1,262 @@
+/**
+ * @file       <content_chunker.cpp>
+ * @brief      Основной файл разбиения данных на фрагменты по содержимому.
+ *
+ *             Используется gear-хэш с нормализацией длины (как в FastCDC):
+ *             первые min_size байт фрагмента не проверяются, до avg_size
+ *             граница ищется по более строгой маске, после - по более
+ *             мягкой, а на max_size фрагмент обрывается принудительно.
+ *             Таблица gear строится детерминированно, поэтому границы
+ *             одинаковы от запуска к запуску.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "content_chunker.hpp"
+#include "blocking_queue.hpp"
+#include "buffer_pool.hpp"
+#include "file_io.hpp"
+#include "parallel_for.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Строит таблицу gear из 256 псевдослучайных чисел (splitmix64).
+ */
+static constexpr std::array<std::uint64_t, 256> make_gear_table()
+{
+    std::array<std::uint64_t, 256> table{};
+    std::uint64_t state = CONTENT_CHUNKER_SEED;
+
+    for (auto& value : table)
+    {
+        state += 0x9e3779b97f4a7c15ULL;
+
+        std::uint64_t mixed = state;
+        mixed = (mixed ^ (mixed >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        mixed = (mixed ^ (mixed >> 27)) * 0x94d049bb133111ebULL;
+        value = mixed ^ (mixed >> 31);
+    }
+
+    return table;
+}
+
+static constexpr std::array<std::uint64_t, 256> GEAR = make_gear_table();
+
+/**
+ * @brief Возвращает маску из старших bits разрядов.
+ *
+ * В gear-хэше старшие разряды зависят от последних 64 байт, а младшие -
+ * только от последних байт, поэтому граница проверяется по старшим.
+ */
+static std::uint64_t high_mask(unsigned int bits)
+{
+    bits = std::clamp(bits, 1u, 63u);
+    return ~0ULL << (64 - bits);
+}
+
+/**
+ * @brief Создает разбиение для фрагментов длиной не больше max_size.
+ *
+ * @param max_size Наибольшая длина фрагмента (обычно chunk_size контейнера).
+ */
+ContentChunker::ContentChunker(size_t max_size)
+    : m_min_size(std::max<size_t>(max_size / CONTENT_CHUNKER_MIN_DIVISOR, 1)),
+      m_avg_size(std::max<size_t>(max_size / CONTENT_CHUNKER_AVG_DIVISOR, 1)),
+      m_max_size(std::max<size_t>(max_size, 1))
+{
+    unsigned int bits = 0;
+    while ((static_cast<size_t>(2) << bits) <= m_avg_size)
+    {
+        ++bits;
+    }
+
+    m_mask_small = high_mask(bits + 1);
+    m_mask_large = high_mask(bits > 1 ? bits - 1 : 1);
+}
+
+/**
+ * @brief Находит конец первого фрагмента в данных.
+ *
+ * Если данных меньше max_size, считается, что это конец файла, и последний
+ * фрагмент может быть короче min_size.
+ *
+ * @param data Данные, начинающиеся с начала фрагмента.
+ * @param size Длина данных.
+ * @return size_t Длина фрагмента (от 1 до min(size, max_size); 0 только для пустых данных).
+ */
+size_t ContentChunker::find_cut(const std::uint8_t *data, size_t size) const
+{
+    if (size <= m_min_size)
+    {
+        return size;
+    }
+
+    const size_t limit  = std::min(size, m_max_size);
+    const size_t normal = std::min(limit, m_avg_size);
+    std::uint64_t hash  = 0;
+    size_t position     = m_min_size;
+
+    for (; position < normal; ++position)
+    {
+        hash = (hash << 1) + GEAR[data[position]];
+        if ((hash & m_mask_small) == 0)
+        {
+            return position + 1;
+        }
+    }
+
+    for (; position < limit; ++position)
+    {
+        hash = (hash << 1) + GEAR[data[position]];
+        if ((hash & m_mask_large) == 0)
+        {
+            return position + 1;
+        }
+    }
+
+    return limit;
+}
+
+/**
+ * @brief Делит файл на фрагменты по содержимому и обрабатывает их параллельно.
+ *
+ * Вызывающий поток читает файл один раз прямо в буферы фрагментов:
+ * буфер дочитывается до max_size, фрагмент отрезается по содержимому,
+ * а хвост за границей переносится в начало следующего буфера. Буферы
+ * (slots на поток) переиспользуются, поэтому память не зависит от размера
+ * файла. Как и в ParallelFor::run, каждый поток один раз вызывает
+ * make_worker; фрагменты обрабатываются в произвольном порядке, номер
+ * фрагмента передается в ContentChunk::index.
+ *
+ * @param fd Дескриптор файла.
+ * @param file_size Размер файла.
+ * @param threads Количество потоков (0 - по числу ядер).
+ * @param slots Количество буферов на поток.
+ * @param make_worker Фабрика обработчиков фрагментов. Пустой обработчик означает ошибку.
+ * @param count Количество фрагментов файла.
+ * @return bool true, если файл прочитан целиком и все фрагменты обработаны, иначе false.
+ */
+bool ContentChunker::split_file(int fd,
+                                std::uint64_t file_size,
+                                unsigned int threads,
+                                size_t slots,
+                                const WorkerFactory& make_worker,
+                                size_t& count) const
+{
+    struct Item
+    {
+        size_t        slot;
+        size_t        index;
+        std::uint64_t offset;
+        size_t        size;
+    };
+
+    threads = ParallelFor::resolve_threads(threads, SIZE_MAX);
+
+    std::vector<PooledBuffer> buffers;
+    BlockingQueue<size_t>     free_slots;
+    BlockingQueue<Item>       filled;
+    std::atomic<bool>         failed{false};
+
+    for (size_t i = 0; i < threads * std::max<size_t>(slots, 1) && !failed; ++i)
+    {
+        buffers.push_back(BufferPool::instance().acquire(m_max_size));
+        failed = !buffers.back();
+        free_slots.push(i);
+    }
+
+    auto worker = [&]()
+    {
+        Task task = failed ? nullptr : make_worker();
+
+        if (!task)
+        {
+            failed = true;
+            free_slots.close();
+        }
+
+        while (auto item = filled.pop())
+        {
+            if (!failed && !task({item->index, item->offset, buffers[item->slot].data(), item->size}))
+            {
+                failed = true;
+                free_slots.close();
+            }
+
+            free_slots.push(item->slot);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < threads; ++i)
+    {
+        workers.emplace_back(worker);
+    }
+
+    std::optional<size_t> slot = failed ? std::nullopt : free_slots.pop();
+    std::uint64_t read_offset = 0;
+    std::uint64_t position    = 0;
+    size_t fill = 0;
+
+    count = 0;
+
+    while (slot && !failed)
+    {
+        std::uint8_t *data = buffers[*slot].data();
+        const size_t size = static_cast<size_t>(std::min<std::uint64_t>(m_max_size - fill, file_size - read_offset));
+
+        if (size > 0 && !FileIO::pread_exact(fd, data + fill, size, static_cast<off_t>(read_offset)))
+        {
+            std::cerr << "Не удалось прочитать файл" << std::endl;
+            failed = true;
+            break;
+        }
+
+        fill        += size;
+        read_offset += size;
+
+        if (fill == 0)
+        {
+            break;
+        }
+
+        const size_t cut = find_cut(data, fill);
+        std::optional<size_t> next = free_slots.pop();
+
+        if (next && fill > cut)
+        {
+            std::memcpy(buffers[*next].data(), data + cut, fill - cut);
+        }
+
+        filled.push({*slot, count++, position, cut});
+
+        position += cut;
+        fill     -= cut;
+        slot      = next;
+    }
+
+    filled.close();
+    for (auto& thread : workers)
+    {
+        thread.join();
+    }
+
+    return !failed && position == file_size;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file       <content_chunker.hpp>
+ * @brief      Хэдер разбиения данных на фрагменты по содержимому.
+ *
+ *             Содержит в себе объявление разбиения, при котором границы
+ *             фрагментов определяются скользящим хэшем от самих данных,
+ *             а не фиксированными смещениями. Вставка или удаление байтов
+ *             меняет только соседние фрагменты, остальные границы сохраняются.
+ *             Также объявляет конвейер, который читает файл и раздает
+ *             такие фрагменты рабочим потокам.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef CONTENT_CHUNKER_HPP
+#define CONTENT_CHUNKER_HPP
+
+#include <cstdint>
+#include <functional>
+#include <stddef.h>
+
+#define CONTENT_CHUNKER_MIN_DIVISOR 4
+#define CONTENT_CHUNKER_AVG_DIVISOR 2
+#define CONTENT_CHUNKER_SEED        0x414b5232434443ULL
+
+/**
+ * @brief Фрагмент файла, выданный рабочему потоку.
+ *
+ * data указывает на буфер конвейера и действителен только до возврата
+ * из обработчика; обработчик может портить его содержимое.
+ */
+struct ContentChunk
+{
+    size_t        index  = 0;
+    std::uint64_t offset = 0;
+    std::uint8_t *data   = nullptr;
+    size_t        size   = 0;
+};
+
+class ContentChunker
+{
+public:
+    using Task          = std::function<bool(const ContentChunk& chunk)>;
+    using WorkerFactory = std::function<Task()>;
+
+public:
+    explicit ContentChunker(size_t max_size);
+
+    size_t find_cut(const std::uint8_t *data, size_t size) const;
+    bool split_file(int fd,
+                    std::uint64_t file_size,
+                    unsigned int threads,
+                    size_t slots,
+                    const WorkerFactory& make_worker,
+                    size_t& count) const;
+
+    size_t min_size() const { return m_min_size; }
+    size_t avg_size() const { return m_avg_size; }
+    size_t max_size() const { return m_max_size; }
+
+private:
+    size_t        m_min_size   = 0;
+    size_t        m_avg_size   = 0;
+    size_t        m_max_size   = 0;
+    std::uint64_t m_mask_small = 0;
+    std::uint64_t m_mask_large = 0;
+};
+
+#endif // CONTENT_CHUNKER_HPP
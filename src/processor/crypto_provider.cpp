@@ -17,21 +17,29 @@
  * @license    This project is released under the GNUv3 Public License.
  */
 #include "crypto_provider.hpp"
+#include "cipher_policy.hpp"
+#include "crypto_session.hpp"
+#include "file_io.hpp"
+#include "job_stats.hpp"
 
 #include <iostream>
 #include <filesystem>
-#include <fstream>
 #include <libakrypt.h>
 #include <sstream>
 #include <iomanip>
+#include <stdexcept>
 #include <vector>
 
+#include <fcntl.h>
+#include <unistd.h>
+
 namespace fs = std::filesystem;
 
 /**
  * @brief Генерирует ключ на основе пароля и соли.
  *
- * Эта функция инициализирует библиотеку libakrypt и создает ключ,
+ * Эта функция проверяет, что библиотека libakrypt инициализирована
+ * (это однократно делает CryptoSession), и создает ключ,
  * используя указанный алгоритм (kuznechik или magma). Затем она
  * устанавливает ключ на основе предоставленного пароля и соли.
  *
@@ -46,23 +54,15 @@ int CryptoProvider::generate_key_from_password(const std::string &password,
                                                struct bckey *key,
                                                const std::string &algorithm)
 {
-    if (ak_libakrypt_create(ak_function_log_syslog) != ak_true)
+    if (!CryptoSession::instance().is_ready())
     {
-        std::cerr << "Ошибка инициализации libakrypt" << std::endl;
         return EXIT_FAILURE;
     }
 
     int error_code = ak_error_ok;
 
-    if (algorithm == "kuznechik")
-    {
-        error_code = ak_bckey_create_kuznechik(key);
-    }
-    else if (algorithm == "magma")
-    {
-        error_code = ak_bckey_create_magma(key);
-    }
-    else
+    // Единственное место, где имя алгоритма превращается в тип шифра
+    if (!dispatch_cipher(algorithm, [&](auto cipher) { error_code = decltype(cipher)::create(key); }))
     {
         std::cerr << "Неподдерживаемый алгоритм: " << algorithm << std::endl;
         return EXIT_FAILURE;
@@ -74,6 +74,8 @@ int CryptoProvider::generate_key_from_password(const std::string &password,
         return EXIT_FAILURE;
     }
 
+    StageTimer timer(STAGE_KDF);
+
     error_code = ak_bckey_set_key_from_password(
         key,
         static_cast<void*>(const_cast<char*>(password.data())),
@@ -91,6 +93,20 @@ int CryptoProvider::generate_key_from_password(const std::string &password,
     return EXIT_SUCCESS;
 }
 
+/**
+ * @brief Возвращает длину блока алгоритма шифрования.
+ *
+ * @param algorithm Алгоритм шифрования (kuznechik или magma).
+ * @return size_t Длина блока в байтах (Kuznechik::block_size или Magma::block_size,
+ *         для неизвестного алгоритма - как у Магмы).
+ */
+size_t CryptoProvider::get_block_size(const std::string &algorithm)
+{
+    size_t block_size = Magma::block_size;
+    dispatch_cipher(algorithm, [&](auto cipher) { block_size = decltype(cipher)::block_size; });
+    return block_size;
+}
+
 /**
  * @brief Генерирует случайную строку заданной длины.
  *
@@ -134,20 +150,9 @@ void CryptoProvider::generate_random_string(size_t length, char *output)
  */
 std::string CryptoProvider::encrypt(const std::string& plain_text, struct bckey *key)
 {
-    ak_uint8 iv[8] = { 0x01, 0x02, 0x03, 0x04, 0x11, 0xaa, 0x4e, 0x12 };
-    std::string cipher_text = plain_text;
-
-    int error = ak_bckey_ofb(key,
-                             static_cast<void*>(const_cast<char*>(plain_text.data())),
-                             static_cast<void*>(cipher_text.data()),
-                             plain_text.size(),
-                             iv,
-                             sizeof(iv));
+    std::string cipher_text(plain_text.size(), '\0');
 
-    if (error != ak_error_ok)
-    {
-        throw std::runtime_error("Шифрование не удалось");
-    }
+    encrypt(std::as_bytes(std::span(plain_text)), std::as_writable_bytes(std::span(cipher_text)), key);
 
     return cipher_text;
 }
@@ -170,28 +175,29 @@ std::string CryptoProvider::decrypt(const std::string& cipher_text, struct bckey
 /**
  * @brief Шифрует массив байтов с использованием указанного ключа.
  *
- * Эта функция выполняет шифрование массива байтов, возвращая
- * зашифрованный массив.
+ * Эта функция выполняет шифрование массива байтов в буфер из BufferPool.
+ * Буфер возвращается в пул при уничтожении дескриптора, поэтому при
+ * повторных вызовах с теми же размерами память не выделяется заново.
  *
  * @param plain_text Указатель на открытый текст для шифрования.
  * @param size Размер массива.
  * @param key Указатель на структуру bckey, содержащую ключ.
- * @return ak_uint8* Указатель на зашифрованный массив байтов.
- * @throws std::runtime_error Если шифрование не удалось.
+ * @return PooledBuffer Буфер с зашифрованными данными.
+ * @throws std::runtime_error Если буфер не выделен или шифрование не удалось.
  */
-ak_uint8* CryptoProvider::encrypt(ak_uint8* plain_text, size_t size, struct bckey *key)
+PooledBuffer CryptoProvider::encrypt(const ak_uint8* plain_text, size_t size, struct bckey *key)
 {
-    ak_uint8 iv[8] = { 0x01, 0x02, 0x03, 0x04, 0x11, 0xaa, 0x4e, 0x12 };
-    ak_uint8* cipher_text = new ak_uint8[size];
-
-    int error = ak_bckey_ofb(key, plain_text, cipher_text, size, iv, sizeof(iv));
+    PooledBuffer cipher_text = BufferPool::instance().acquire(size);
 
-    if (error != ak_error_ok)
+    if (!cipher_text)
     {
-        delete[] cipher_text;
-        throw std::runtime_error("Шифрование не удалось");
+        throw std::runtime_error("Не удалось выделить буфер");
     }
 
+    encrypt(std::span(reinterpret_cast<const std::byte*>(plain_text), size),
+            std::span(reinterpret_cast<std::byte*>(cipher_text.data()), size),
+            key);
+
     return cipher_text;
 }
 
@@ -203,18 +209,98 @@ ak_uint8* CryptoProvider::encrypt(ak_uint8* plain_text, size_t size, struct bcke
  * @param cipher_text Указатель на зашифрованный текст для дешифрования.
  * @param size Размер массива.
  * @param key Указатель на структуру bckey, содержащую ключ.
- * @return ak_uint8* Указатель на открытый текст.
+ * @return PooledBuffer Буфер с открытым текстом.
  */
-ak_uint8* CryptoProvider::decrypt(ak_uint8* cipher_text, size_t size, struct bckey *key)
+PooledBuffer CryptoProvider::decrypt(const ak_uint8* cipher_text, size_t size, struct bckey *key)
 {
     return encrypt(cipher_text, size, key);
 }
 
+/**
+ * @brief Шифрует данные в буфер, принадлежащий вызывающему коду.
+ *
+ * Эта функция не выделяет память и не копирует данные: гамма OFB
+ * накладывается на plain_text и сразу записывается в cipher_text.
+ * Буферы могут совпадать (см. encrypt_in_place), но не должны
+ * частично перекрываться.
+ *
+ * @param plain_text Открытый текст.
+ * @param cipher_text Буфер для шифртекста, не меньше plain_text.
+ * @param key Указатель на структуру bckey, содержащую ключ.
+ * @throws std::runtime_error Если буфер слишком мал или шифрование не удалось.
+ */
+void CryptoProvider::encrypt(std::span<const std::byte> plain_text, std::span<std::byte> cipher_text, struct bckey *key)
+{
+    ak_uint8 iv[IV_SIZE] = IV;
+
+    if (cipher_text.size() < plain_text.size())
+    {
+        throw std::runtime_error("Буфер для шифртекста меньше открытого текста");
+    }
+
+    if (plain_text.empty())
+    {
+        return;
+    }
+
+    int error = ak_bckey_ofb(key,
+                             static_cast<void*>(const_cast<std::byte*>(plain_text.data())),
+                             static_cast<void*>(cipher_text.data()),
+                             plain_text.size(),
+                             iv,
+                             sizeof(iv));
+
+    if (error != ak_error_ok)
+    {
+        throw std::runtime_error("Шифрование не удалось");
+    }
+}
+
+/**
+ * @brief Дешифрует данные в буфер, принадлежащий вызывающему коду.
+ *
+ * @param cipher_text Шифртекст.
+ * @param plain_text Буфер для открытого текста, не меньше cipher_text.
+ * @param key Указатель на структуру bckey, содержащую ключ.
+ * @throws std::runtime_error Если буфер слишком мал или дешифрование не удалось.
+ */
+void CryptoProvider::decrypt(std::span<const std::byte> cipher_text, std::span<std::byte> plain_text, struct bckey *key)
+{
+    encrypt(cipher_text, plain_text, key);
+}
+
+/**
+ * @brief Шифрует данные на месте.
+ *
+ * Эта функция позволяет шифровать прямо в сетевых буферах и буферах
+ * хранилища, не заводя для результата отдельную память.
+ *
+ * @param data Данные, которые будут заменены шифртекстом.
+ * @param key Указатель на структуру bckey, содержащую ключ.
+ * @throws std::runtime_error Если шифрование не удалось.
+ */
+void CryptoProvider::encrypt_in_place(std::span<std::byte> data, struct bckey *key)
+{
+    encrypt(data, data, key);
+}
+
+/**
+ * @brief Дешифрует данные на месте.
+ *
+ * @param data Данные, которые будут заменены открытым текстом.
+ * @param key Указатель на структуру bckey, содержащую ключ.
+ * @throws std::runtime_error Если дешифрование не удалось.
+ */
+void CryptoProvider::decrypt_in_place(std::span<std::byte> data, struct bckey *key)
+{
+    encrypt(data, data, key);
+}
+
 /**
  * @brief Сохраняет данные в файл.
  *
- * Эта функция сохраняет указанный массив байтов в файл.
- * Если файл имеет расширение .akr, оно будет удалено. Если нет,
+ * Эта функция сохраняет указанный массив байтов в файл без промежуточного
+ * буфера потока. Если файл имеет расширение .akr, оно будет удалено. Если нет,
  * будет добавлено расширение .akr.
  *
  * @param data Указатель на данные для сохранения.
@@ -224,26 +310,19 @@ ak_uint8* CryptoProvider::decrypt(ak_uint8* cipher_text, size_t size, struct bck
  */
 bool CryptoProvider::ak_save_to_file(const ak_uint8* data, size_t size, const std::string& original_file)
 {
-    std::filesystem::path original_path(original_file);
-
-    if (original_path.extension() == ".akr")
-    {
-        original_path.replace_extension();
-    }
-    else
-    {
-        original_path += ".akr";
-    }
+    std::filesystem::path original_path(get_output_path(original_file));
 
-    std::ofstream ofs(original_path.string(), std::ios::binary);
-    if (!ofs)
+    int fd = open(original_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
     {
         std::cerr << "Не удалось открыть файл для записи: " << original_path << std::endl;
         return false;
     }
 
-    ofs.write(reinterpret_cast<const char*>(data), size);
-    if (!ofs)
+    const bool written = FileIO::pwrite_exact(fd, data, size, 0);
+    close(fd);
+
+    if (!written)
     {
         std::cerr << "Не удалось записать данные в файл: " << original_path << std::endl;
         return false;
@@ -252,6 +331,31 @@ bool CryptoProvider::ak_save_to_file(const ak_uint8* data, size_t size, const st
     return true;
 }
 
+/**
+ * @brief Возвращает путь к файлу результата для исходного файла.
+ *
+ * Если файл имеет расширение .akr, оно будет удалено. Если нет,
+ * будет добавлено расширение .akr.
+ *
+ * @param original_file Имя исходного файла.
+ * @return std::string Имя файла результата.
+ */
+std::string CryptoProvider::get_output_path(const std::string& original_file)
+{
+    std::filesystem::path original_path(original_file);
+
+    if (original_path.extension() == ".akr")
+    {
+        original_path.replace_extension();
+    }
+    else
+    {
+        original_path += ".akr";
+    }
+
+    return original_path.string();
+}
+
 /**
  * @brief Преобразует ключ в строку в шестнадцатеричном формате.
  *
@@ -20,6 +20,10 @@
 #ifndef CRYPO_PROVIDER_HPP
 #define CRYPO_PROVIDER_HPP
 
+#include "buffer_pool.hpp"
+
+#include <cstddef>
+#include <span>
 #include <string>
 #include <stddef.h>
 
@@ -29,21 +33,27 @@
 #define IV { 0x01, 0x02, 0x03, 0x04, 0x11, 0xaa, 0x4e, 0x12 }
 #define IV_SIZE 8
 
-typedef unsigned char ak_uint8;
-
 class CryptoProvider
 {
 public:
     static int generate_key_from_password(const std::string &password, const std::string &salt, struct bckey *key, const std::string &algorithm = "magma");
     static void generate_random_string(size_t length, char *output);
+    static size_t get_block_size(const std::string &algorithm);
 
     static std::string encrypt(const std::string& plain_text, struct bckey *key);
     static std::string decrypt(const std::string& cipher_text, struct bckey *key);
 
-    static ak_uint8* encrypt(ak_uint8* plain_text, size_t size, struct bckey *key);
-    static ak_uint8* decrypt(ak_uint8* cipher_text, size_t size, struct bckey *key);
+    static PooledBuffer encrypt(const ak_uint8* plain_text, size_t size, struct bckey *key);
+    static PooledBuffer decrypt(const ak_uint8* cipher_text, size_t size, struct bckey *key);
+
+    static void encrypt(std::span<const std::byte> plain_text, std::span<std::byte> cipher_text, struct bckey *key);
+    static void decrypt(std::span<const std::byte> cipher_text, std::span<std::byte> plain_text, struct bckey *key);
+
+    static void encrypt_in_place(std::span<std::byte> data, struct bckey *key);
+    static void decrypt_in_place(std::span<std::byte> data, struct bckey *key);
 
     static bool ak_save_to_file(const ak_uint8* data, size_t size, const std::string& original_file);
+    static std::string get_output_path(const std::string& original_file);
 
     static std::string bckey_to_string(struct bckey *key);
 };
@@ -0,0 +1,781 @@
+/**
+ * @file       <crypto_session.cpp>
+ * @brief      Основной файл криптографической сессии ak-file-encryptor.
+ *
+ *             Выработка ключа из пароля (PBKDF2) - самая дорогая часть подготовки
+ *             к шифрованию файла. Сессия хранит уже выработанные ключи, поэтому
+ *             при пакетной обработке с одинаковыми паролем и солью она выполняется
+ *             один раз на поток, а не для каждого файла.
+ *
+ *             Ключи Кузнечика и Магмы дополнительно связываются с KuznechikKernel
+ *             и MagmaKernel. Связь устанавливается, только если реализация дает
+ *             тот же результат, что и libakrypt с этим ключом; иначе все вызовы
+ *             идут в libakrypt.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "crypto_session.hpp"
+#include "cipher_policy.hpp"
+#include "crypto_provider.hpp"
+#include "job_stats.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+
+#include <string.h>
+
+#include <libakrypt.h>
+
+#ifdef AK_HAVE_SIMD_KUZNECHIK
+#define SESSION_KUZNECHIK_KERNEL true
+#else
+#define SESSION_KUZNECHIK_KERNEL false
+#endif
+
+#ifdef AK_HAVE_MULTI_BUFFER_MAGMA
+#define SESSION_MAGMA_KERNEL true
+#else
+#define SESSION_MAGMA_KERNEL false
+#endif
+
+/**
+ * @brief Включена ли при сборке собственная реализация шифра Cipher.
+ */
+template <typename Cipher>
+static constexpr bool kernel_enabled = false;
+
+template <>
+constexpr bool kernel_enabled<Kuznechik> = SESSION_KUZNECHIK_KERNEL;
+
+template <>
+constexpr bool kernel_enabled<Magma> = SESSION_MAGMA_KERNEL;
+
+/**
+ * @brief Проверяет, есть ли для алгоритма собственная реализация.
+ *
+ * @param algorithm Алгоритм шифрования.
+ * @return bool true, если реализация включена при сборке и доступна на процессоре.
+ */
+static bool kernel_supported(const std::string& algorithm)
+{
+    bool supported = false;
+
+    dispatch_cipher(algorithm, [&](auto cipher)
+    {
+        using Cipher = decltype(cipher);
+        supported = kernel_enabled<Cipher> && Cipher::Kernel::is_available();
+    });
+
+    return supported;
+}
+
+/**
+ * @brief Заполняет буферы для сравнения реализации с libakrypt.
+ */
+static void fill_pattern(ak_uint8 *data, size_t size, ak_uint8 *iv, size_t iv_size)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        data[i] = static_cast<ak_uint8>(i * 29 + 11);
+    }
+    for (size_t i = 0; i < iv_size; ++i)
+    {
+        iv[i] = static_cast<ak_uint8>(0xf0 - i * 17);
+    }
+}
+
+/**
+ * @brief Сравнивает реализацию шифра с libakrypt в режимах ECB и CTR.
+ *
+ * Проверяются три блока ECB и три с лишним блока CTR (с неполным последним
+ * блоком). Синхропосылка ключа при этом меняется, что допустимо: первый
+ * вызов ak_bckey_ctr после acquire_key всегда передает синхропосылку явно.
+ *
+ * @param key Ключ libakrypt.
+ * @param kernel Проверяемая реализация шифра Cipher.
+ * @return bool true, если результаты совпали.
+ */
+template <typename Cipher>
+static bool matches_libakrypt(struct bckey *key, const typename Cipher::Kernel& kernel)
+{
+    using Kernel = typename Cipher::Kernel;
+    constexpr size_t BlockSize = Cipher::block_size;
+
+    ak_uint8 data[3 * BlockSize + 5];
+    ak_uint8 expected[sizeof(data)];
+    ak_uint8 actual[sizeof(data)];
+    ak_uint8 iv[Engine<Cipher, Ctr>::iv_size];
+    ak_uint8 counter[BlockSize];
+
+    fill_pattern(data, sizeof(data), iv, sizeof(iv));
+
+    if (ak_bckey_encrypt_ecb(key, data, expected, 3 * BlockSize) != ak_error_ok)
+    {
+        return false;
+    }
+    kernel.encrypt_ecb(data, actual, 3);
+    if (std::memcmp(expected, actual, 3 * BlockSize) != 0)
+    {
+        return false;
+    }
+
+    if (ak_bckey_ctr(key, data, expected, sizeof(data), iv, sizeof(iv)) != ak_error_ok)
+    {
+        return false;
+    }
+    Kernel::ctr_counter(iv, counter);
+    kernel.ctr(data, actual, sizeof(data), counter);
+
+    return std::memcmp(expected, actual, sizeof(data)) == 0;
+}
+
+/**
+ * @brief Сравнивает MagmaKernel::ofb с ak_bckey_ofb.
+ *
+ * @param key Ключ libakrypt.
+ * @param kernel Проверяемая реализация.
+ * @return bool true, если результаты совпали.
+ */
+static bool magma_ofb_matches(struct bckey *key, const MagmaKernel& kernel)
+{
+    ak_uint8 data[3 * Magma::block_size + 5];
+    ak_uint8 expected[sizeof(data)];
+    ak_uint8 actual[sizeof(data)];
+    ak_uint8 iv[Engine<Magma, Ofb>::iv_size];
+
+    fill_pattern(data, sizeof(data), iv, sizeof(iv));
+
+    if (ak_bckey_ofb(key, data, expected, sizeof(data), iv, sizeof(iv)) != ak_error_ok)
+    {
+        return false;
+    }
+
+    MagmaStream stream;
+    stream.in   = data;
+    stream.out  = actual;
+    stream.size = sizeof(data);
+    stream.iv   = iv;
+    kernel.ofb(&stream, 1);
+
+    return std::memcmp(expected, actual, sizeof(data)) == 0;
+}
+
+/**
+ * @brief Возвращает единственный экземпляр сессии.
+ *
+ * Экземпляр создается при первом обращении (потокобезопасно) и живет
+ * до завершения процесса.
+ *
+ * @return CryptoSession& Ссылка на сессию.
+ */
+CryptoSession& CryptoSession::instance()
+{
+    static CryptoSession session;
+    return session;
+}
+
+/**
+ * @brief Инициализирует libakrypt.
+ *
+ * ak_libakrypt_create выполняет самотестирование всех алгоритмов, поэтому
+ * вызывается только один раз за время работы процесса.
+ */
+CryptoSession::CryptoSession()
+{
+    m_ready = (ak_libakrypt_create(ak_function_log_syslog) == ak_true);
+
+    if (!m_ready)
+    {
+        std::cerr << "Ошибка инициализации libakrypt" << std::endl;
+    }
+}
+
+/**
+ * @brief Уничтожает закэшированные ключи и завершает работу libakrypt.
+ */
+CryptoSession::~CryptoSession()
+{
+    clear();
+
+    if (m_ready)
+    {
+        ak_libakrypt_destroy();
+    }
+}
+
+/**
+ * @brief Выдает ключ, выработанный из пароля и соли.
+ *
+ * Ключи с одинаковыми алгоритмом, паролем и солью хранятся в пуле. Если
+ * в пуле есть свободный ключ, он выдается без выработки. Иначе ключ
+ * создается функцией create_key и полностью совпадает с ключом, полученным
+ * через CryptoProvider::generate_key_from_password.
+ *
+ * Каждый выданный ключ принадлежит только одному владельцу, поэтому ключи
+ * можно одновременно использовать в разных потоках. При уничтожении
+ * KeyHandle ключ возвращается в пул.
+ *
+ * @param password Пароль.
+ * @param salt Соль.
+ * @param algorithm Алгоритм шифрования (kuznechik или magma).
+ * @return KeyHandle Владеющий указатель на ключ или пустой указатель при ошибке.
+ *
+ * @note Синхропосылка в возвращенном ключе может остаться от предыдущего
+ * использования, поэтому первый вызов ak_bckey_ofb/ak_bckey_ctr должен
+ * передавать синхропосылку явно.
+ */
+CryptoSession::KeyHandle CryptoSession::acquire_key(const std::string& password,
+                                                    const std::string& salt,
+                                                    const std::string& algorithm)
+{
+    if (!m_ready)
+    {
+        return KeyHandle(nullptr, destroy_key);
+    }
+
+    auto entry = find_or_insert(make_cache_id(password, salt, algorithm));
+    struct bckey* key = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(entry->mutex);
+        if (!entry->pool.empty())
+        {
+            key = entry->pool.back();
+            entry->pool.pop_back();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++(key ? m_hits : m_misses);
+    }
+
+    if (!key)
+    {
+        key = create_key(*entry, password, salt, algorithm);
+        if (!key)
+        {
+            return KeyHandle(nullptr, destroy_key);
+        }
+    }
+
+    std::weak_ptr<CacheEntry> weak_entry = entry;
+
+    return KeyHandle(key, [this, weak_entry](struct bckey* released)
+    {
+        if (auto owner = weak_entry.lock())
+        {
+            std::lock_guard<std::mutex> lock(owner->mutex);
+            if (owner->pool.size() < SESSION_POOL_SIZE)
+            {
+                owner->pool.push_back(released);
+                return;
+            }
+        }
+        unbind_kernel(released);
+        destroy_key(released);
+    });
+}
+
+/**
+ * @brief Удаляет все закэшированные ключи.
+ *
+ * Ключи, выданные до вызова, остаются действительными и уничтожаются
+ * при освобождении KeyHandle.
+ */
+void CryptoSession::clear()
+{
+    std::list<std::shared_ptr<CacheEntry>> entries;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        entries.swap(m_entries);
+    }
+
+    for (auto& entry : entries)
+    {
+        std::lock_guard<std::mutex> lock(entry->mutex);
+        for (auto* key : entry->pool)
+        {
+            unbind_kernel(key);
+            destroy_key(key);
+        }
+        entry->pool.clear();
+    }
+}
+
+/**
+ * @brief Зашифровывает или расшифровывает данные в режиме CTR.
+ *
+ * Эта функция заменяет ak_bckey_ctr и принимает те же аргументы: вызов
+ * с синхропосылкой начинает гамму заново, вызов без нее продолжает гамму
+ * предыдущего вызова. Если ключ связан с KuznechikKernel, данные
+ * обрабатываются им (так же для Магмы и MagmaKernel), иначе вызов
+ * передается в libakrypt.
+ *
+ * @param key Ключ, выданный acquire_key (или любой другой ключ libakrypt).
+ * @param in Входные данные.
+ * @param out Буфер для результата (может совпадать с in).
+ * @param size Длина данных в байтах.
+ * @param iv Синхропосылка или nullptr для продолжения гаммы.
+ * @param iv_size Длина синхропосылки.
+ * @return int Код ошибки libakrypt (ak_error_ok при успехе).
+ */
+int CryptoSession::ctr(struct bckey *key, const ak_uint8 *in, ak_uint8 *out, size_t size, const ak_uint8 *iv, size_t iv_size)
+{
+    KernelBinding *binding = find_kernel(key);
+
+    if (binding)
+    {
+        const size_t kernel_iv_size = binding->kernel ? Engine<Kuznechik, Ctr>::iv_size : Engine<Magma, Ctr>::iv_size;
+
+        if (iv ? iv_size == kernel_iv_size : binding->started)
+        {
+            if (iv)
+            {
+                if (binding->kernel)
+                {
+                    KuznechikKernel::ctr_counter(iv, binding->counter);
+                }
+                else
+                {
+                    MagmaKernel::ctr_counter(iv, binding->counter);
+                }
+                binding->started = true;
+            }
+
+            if (binding->kernel)
+            {
+                binding->kernel->ctr(in, out, size, binding->counter);
+            }
+            else
+            {
+                binding->magma->ctr(in, out, size, binding->counter);
+            }
+            return ak_error_ok;
+        }
+
+        binding->started = false;
+    }
+
+    return ak_bckey_ctr(key, const_cast<ak_uint8*>(in), out, size, const_cast<ak_uint8*>(iv), iv_size);
+}
+
+/**
+ * @brief Зашифровывает данные в режиме простой замены (ECB).
+ *
+ * Эта функция заменяет ak_bckey_encrypt_ecb; данные длиной, кратной
+ * блоку, для ключа, связанного с KuznechikKernel или MagmaKernel,
+ * шифруются ими.
+ *
+ * @param key Ключ.
+ * @param in Открытый текст.
+ * @param out Буфер для результата (может совпадать с in).
+ * @param size Длина данных в байтах.
+ * @return int Код ошибки libakrypt (ak_error_ok при успехе).
+ */
+int CryptoSession::encrypt_ecb(struct bckey *key, const ak_uint8 *in, ak_uint8 *out, size_t size)
+{
+    KernelBinding *binding = find_kernel(key);
+
+    if (binding && binding->kernel && size % Kuznechik::block_size == 0)
+    {
+        binding->kernel->encrypt_ecb(in, out, size / Kuznechik::block_size);
+        return ak_error_ok;
+    }
+
+    if (binding && binding->magma && size % Magma::block_size == 0)
+    {
+        binding->magma->encrypt_ecb(in, out, size / Magma::block_size);
+        return ak_error_ok;
+    }
+
+    return ak_bckey_encrypt_ecb(key, const_cast<ak_uint8*>(in), out, size);
+}
+
+/**
+ * @brief Зашифровывает или расшифровывает несколько независимых потоков в режиме OFB.
+ *
+ * Результат для каждого потока такой же, как у вызова ak_bckey_ofb с его
+ * синхропосылкой. Если ключ связан с MagmaKernel, потоки обрабатываются
+ * одновременно (по блоку каждого потока за проход), иначе - по очереди
+ * через libakrypt. Выгоднее всего передавать stream_lanes() потоков.
+ *
+ * @param key Ключ.
+ * @param streams Потоки.
+ * @param count Количество потоков.
+ * @return int Код ошибки libakrypt (ak_error_ok при успехе).
+ */
+int CryptoSession::ofb_streams(struct bckey *key, const CipherStream *streams, size_t count)
+{
+    KernelBinding *binding = find_kernel(key);
+
+    const bool block_ivs = std::all_of(streams, streams + count, [](const CipherStream& stream)
+    {
+        return stream.iv_size == Engine<Magma, Ofb>::iv_size;
+    });
+
+    if (binding && binding->magma && block_ivs)
+    {
+        std::vector<MagmaStream> lanes(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            lanes[i].in   = streams[i].in;
+            lanes[i].out  = streams[i].out;
+            lanes[i].size = streams[i].size;
+            lanes[i].iv   = streams[i].iv;
+        }
+
+        binding->magma->ofb(lanes.data(), lanes.size());
+        return ak_error_ok;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        int error = ak_bckey_ofb(key,
+                                 const_cast<ak_uint8*>(streams[i].in),
+                                 streams[i].out,
+                                 streams[i].size,
+                                 const_cast<ak_uint8*>(streams[i].iv),
+                                 streams[i].iv_size);
+        if (error != ak_error_ok)
+        {
+            return error;
+        }
+    }
+
+    return ak_error_ok;
+}
+
+/**
+ * @brief Сколько потоков выгодно передавать в ofb_streams за один вызов.
+ *
+ * @param key Ключ.
+ * @return size_t Число дорожек MagmaKernel или 1, если ключ обрабатывает libakrypt.
+ */
+size_t CryptoSession::stream_lanes(const struct bckey *key)
+{
+    KernelBinding *binding = find_kernel(key);
+    return (binding && binding->magma) ? MagmaKernel::lanes() : 1;
+}
+
+/**
+ * @brief Количество ключей, выданных из кэша без выработки.
+ *
+ * @return size_t Количество попаданий.
+ */
+size_t CryptoSession::cache_hits() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_hits;
+}
+
+/**
+ * @brief Количество ключей, для которых потребовалась выработка из пароля.
+ *
+ * @return size_t Количество промахов.
+ */
+size_t CryptoSession::cache_misses() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_misses;
+}
+
+/**
+ * @brief Формирует идентификатор записи кэша.
+ *
+ * Сам пароль в кэше не хранится: идентификатор содержит алгоритм, соль
+ * и хэш пароля по Стрибог-256.
+ *
+ * @param password Пароль.
+ * @param salt Соль.
+ * @param algorithm Алгоритм шифрования.
+ * @return std::string Идентификатор записи.
+ */
+std::string CryptoSession::make_cache_id(const std::string& password, const std::string& salt, const std::string& algorithm)
+{
+    struct hash ctx;
+    ak_uint8 digest[32] = {0};
+
+    ak_hash_create_streebog256(&ctx);
+    ak_hash_ptr(&ctx, static_cast<void*>(const_cast<char*>(password.data())), password.size(), digest, sizeof(digest));
+    ak_hash_destroy(&ctx);
+
+    std::string id = algorithm;
+    id += '\0';
+    id += std::to_string(salt.size());
+    id += ':';
+    id += salt;
+    id.append(reinterpret_cast<const char*>(digest), sizeof(digest));
+
+    return id;
+}
+
+/**
+ * @brief Находит запись кэша или создает новую, вытесняя самую старую.
+ *
+ * @param id Идентификатор записи.
+ * @return std::shared_ptr<CacheEntry> Запись кэша.
+ */
+std::shared_ptr<CryptoSession::CacheEntry> CryptoSession::find_or_insert(const std::string& id)
+{
+    std::shared_ptr<CacheEntry> evicted;
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+    {
+        if ((*it)->id == id)
+        {
+            m_entries.splice(m_entries.begin(), m_entries, it);
+            return m_entries.front();
+        }
+    }
+
+    auto entry = std::make_shared<CacheEntry>();
+    entry->id = id;
+    m_entries.push_front(entry);
+
+    if (m_entries.size() > SESSION_CACHE_SIZE)
+    {
+        evicted = m_entries.back();
+        m_entries.pop_back();
+
+        std::lock_guard<std::mutex> entry_lock(evicted->mutex);
+        for (auto* key : evicted->pool)
+        {
+            unbind_kernel(key);
+            destroy_key(key);
+        }
+        evicted->pool.clear();
+    }
+
+    return entry;
+}
+
+/**
+ * @brief Создает новый ключ для записи кэша.
+ *
+ * Для Кузнечика и Магмы первый ключ записи вырабатывается обычным способом,
+ * а заодно проверяется собственная реализация шифра (derive_kernel). Если
+ * проверка прошла, следующие ключи записи создаются из сохраненного ключа
+ * через ak_bckey_set_key без повторного PBKDF2. Остальные ключи
+ * вырабатываются через CryptoProvider::generate_key_from_password.
+ *
+ * @param entry Запись кэша.
+ * @param password Пароль.
+ * @param salt Соль.
+ * @param algorithm Алгоритм шифрования.
+ * @return struct bckey* Новый ключ или nullptr при ошибке.
+ */
+struct bckey* CryptoSession::create_key([[maybe_unused]] CacheEntry& entry, const std::string& password, const std::string& salt, const std::string& algorithm)
+{
+    if (kernel_supported(algorithm))
+    {
+        struct bckey *derived = nullptr;
+        std::call_once(entry.kernel_once, [&]() { derived = derive_kernel(entry, password, salt, algorithm); });
+
+        if (derived)
+        {
+            return derived;
+        }
+
+        if (entry.kernel || entry.magma)
+        {
+            struct bckey *key = new struct bckey;
+            const int error = entry.kernel ? Kuznechik::create(key) : Magma::create(key);
+
+            if (error == ak_error_ok)
+            {
+                if (ak_bckey_set_key(key, entry.secret.data(), entry.secret.size()) == ak_error_ok &&
+                    kernel_matches(key, entry))
+                {
+                    bind_kernel(key, entry);
+                    return key;
+                }
+                ak_bckey_destroy(key);
+            }
+            delete key;
+        }
+    }
+
+    struct bckey *key = new struct bckey;
+    if (CryptoProvider::generate_key_from_password(password, salt, key, algorithm) != EXIT_SUCCESS)
+    {
+        delete key;
+        return nullptr;
+    }
+
+    return key;
+}
+
+/**
+ * @brief Вырабатывает первый ключ записи и проверяет для него собственную реализацию шифра.
+ *
+ * Ключ bckey вырабатывается обычным способом, а ключ для KuznechikKernel
+ * или MagmaKernel - тем же PBKDF2 (Стрибог-512, число итераций из настроек
+ * libakrypt), что использует ak_bckey_set_key_from_password. Реализация
+ * связывается с записью, только если она дает с этим ключом тот же
+ * результат, что и libakrypt; так возможное расхождение (порядок байтов,
+ * устройство счетчика) приводит лишь к отказу от ускорения.
+ *
+ * @param entry Запись кэша.
+ * @param password Пароль.
+ * @param salt Соль.
+ * @param algorithm Алгоритм шифрования (kuznechik или magma).
+ * @return struct bckey* Выработанный ключ или nullptr при ошибке.
+ */
+struct bckey* CryptoSession::derive_kernel(CacheEntry& entry, const std::string& password, const std::string& salt, const std::string& algorithm)
+{
+    struct bckey *key = new struct bckey;
+    if (CryptoProvider::generate_key_from_password(password, salt, key, algorithm) != EXIT_SUCCESS)
+    {
+        delete key;
+        return nullptr;
+    }
+
+    const ak_int64 iterations = ak_libakrypt_get_option_by_name("pbkdf2_iteration_count");
+    ak_uint8 secret[KUZNECHIK_KEY_SIZE] = {0};
+    bool derived = false;
+
+    if (iterations > 0)
+    {
+        StageTimer timer(STAGE_KDF);
+        derived = ak_hmac_pbkdf2_streebog512(static_cast<void*>(const_cast<char*>(password.data())),
+                                             password.size(),
+                                             static_cast<void*>(const_cast<char*>(salt.data())),
+                                             salt.size(),
+                                             static_cast<size_t>(iterations),
+                                             sizeof(secret),
+                                             secret) == ak_error_ok;
+    }
+
+    if (derived)
+    {
+        dispatch_cipher(algorithm, [&](auto cipher)
+        {
+            if constexpr (std::is_same_v<decltype(cipher), Kuznechik>)
+            {
+                entry.kernel = std::make_shared<const KuznechikKernel>(secret);
+            }
+            else
+            {
+                entry.magma = std::make_shared<const MagmaKernel>(secret);
+            }
+        });
+
+        if (kernel_matches(key, entry))
+        {
+            std::memcpy(entry.secret.data(), secret, sizeof(secret));
+            bind_kernel(key, entry);
+        }
+        else
+        {
+            entry.kernel.reset();
+            entry.magma.reset();
+        }
+    }
+
+    explicit_bzero(secret, sizeof(secret));
+    return key;
+}
+
+/**
+ * @brief Сравнивает реализацию шифра записи с libakrypt на данном ключе.
+ *
+ * Для Магмы кроме ECB и CTR проверяется и OFB, который выполняет
+ * ofb_streams.
+ *
+ * @param key Ключ libakrypt.
+ * @param entry Запись кэша с проверяемой реализацией.
+ * @return bool true, если результаты совпали.
+ */
+bool CryptoSession::kernel_matches(struct bckey *key, const CacheEntry& entry)
+{
+    if (entry.kernel)
+    {
+        return matches_libakrypt<Kuznechik>(key, *entry.kernel);
+    }
+
+    if (entry.magma)
+    {
+        return matches_libakrypt<Magma>(key, *entry.magma) &&
+               magma_ofb_matches(key, *entry.magma);
+    }
+
+    return false;
+}
+
+/**
+ * @brief Находит связь ключа с собственной реализацией шифра.
+ *
+ * Узлы unordered_map не перемещаются, а ключ в каждый момент принадлежит
+ * одному владельцу, поэтому указатель можно использовать без блокировки.
+ *
+ * @param key Ключ.
+ * @return KernelBinding* Связь или nullptr.
+ */
+CryptoSession::KernelBinding* CryptoSession::find_kernel(const struct bckey *key)
+{
+    std::lock_guard<std::mutex> lock(m_kernel_mutex);
+    auto it = m_kernels.find(key);
+    return it != m_kernels.end() ? &it->second : nullptr;
+}
+
+/**
+ * @brief Связывает ключ с реализацией шифра записи кэша.
+ *
+ * @param key Ключ.
+ * @param entry Запись, реализация которой проверена на этом ключе.
+ */
+void CryptoSession::bind_kernel(const struct bckey *key, const CacheEntry& entry)
+{
+    std::lock_guard<std::mutex> lock(m_kernel_mutex);
+    KernelBinding& binding = m_kernels[key];
+    binding.kernel = entry.kernel;
+    binding.magma  = entry.magma;
+}
+
+/**
+ * @brief Удаляет связь ключа с реализацией шифра перед уничтожением ключа.
+ *
+ * @param key Ключ.
+ */
+void CryptoSession::unbind_kernel(const struct bckey *key)
+{
+    std::lock_guard<std::mutex> lock(m_kernel_mutex);
+    m_kernels.erase(key);
+}
+
+/**
+ * @brief Затирает сохраненный ключ записи.
+ */
+CryptoSession::CacheEntry::~CacheEntry()
+{
+    explicit_bzero(secret.data(), secret.size());
+}
+
+/**
+ * @brief Уничтожает ключ и освобождает память под структуру.
+ *
+ * @param key Указатель на ключ.
+ */
+void CryptoSession::destroy_key(struct bckey *key)
+{
+    if (key)
+    {
+        ak_bckey_destroy(key);
+        delete key;
+    }
+}
@@ -0,0 +1,128 @@
+/**
+ * @file       <crypto_session.hpp>
+ * @brief      Хэдер криптографической сессии ak-file-encryptor.
+ *
+ *             Содержит в себе объявление сессии, которая один раз за время работы
+ *             процесса инициализирует libakrypt, владеет ключами bckey и кэширует
+ *             ключи, выработанные из пароля. Для ключей Кузнечика и Магмы сессия
+ *             также хранит собственные реализации шифров (KuznechikKernel,
+ *             MagmaKernel), через которые выполняются режимы CTR, ECB и
+ *             многопоточный OFB.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef CRYPTO_SESSION_HPP
+#define CRYPTO_SESSION_HPP
+
+#include "kuznechik_kernel.hpp"
+#include "magma_kernel.hpp"
+
+#include <array>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stddef.h>
+
+#define SESSION_CACHE_SIZE 16
+#define SESSION_POOL_SIZE  64
+
+/**
+ * @brief Один поток для CryptoSession::ofb_streams.
+ */
+struct CipherStream
+{
+    const ak_uint8 *in      = nullptr;
+    ak_uint8       *out     = nullptr; ///< Может совпадать с in
+    size_t          size    = 0;
+    const ak_uint8 *iv      = nullptr;
+    size_t          iv_size = 0;
+};
+
+class CryptoSession
+{
+public:
+    using KeyHandle = std::unique_ptr<struct bckey, std::function<void(struct bckey*)>>;
+
+public:
+    static CryptoSession& instance();
+
+    bool is_ready() const { return m_ready; }
+
+    KeyHandle acquire_key(const std::string& password, const std::string& salt, const std::string& algorithm = "magma");
+    void clear();
+
+    int ctr(struct bckey *key, const ak_uint8 *in, ak_uint8 *out, size_t size, const ak_uint8 *iv, size_t iv_size);
+    int encrypt_ecb(struct bckey *key, const ak_uint8 *in, ak_uint8 *out, size_t size);
+    int ofb_streams(struct bckey *key, const CipherStream *streams, size_t count);
+    size_t stream_lanes(const struct bckey *key);
+
+    size_t cache_hits() const;
+    size_t cache_misses() const;
+
+    CryptoSession(const CryptoSession&) = delete;
+    CryptoSession& operator=(const CryptoSession&) = delete;
+
+private:
+    struct CacheEntry
+    {
+        ~CacheEntry();
+
+        std::string                               id;
+        std::mutex                                mutex;
+        std::vector<struct bckey*>                pool;
+        std::once_flag                            kernel_once;
+        std::shared_ptr<const KuznechikKernel>    kernel; ///< Пусто, если реализация не совпала с libakrypt
+        std::shared_ptr<const MagmaKernel>        magma;  ///< То же для Магмы
+        std::array<ak_uint8, KUZNECHIK_KEY_SIZE>  secret{}; ///< Ключ, выработанный из пароля (если kernel не пуст)
+    };
+
+    struct KernelBinding
+    {
+        std::shared_ptr<const KuznechikKernel> kernel;
+        std::shared_ptr<const MagmaKernel>     magma;
+        ak_uint8                               counter[KUZNECHIK_BLOCK_SIZE] = {0};
+        bool                                   started = false;
+    };
+
+private:
+    CryptoSession();
+    ~CryptoSession();
+
+    std::string make_cache_id(const std::string& password, const std::string& salt, const std::string& algorithm);
+    std::shared_ptr<CacheEntry> find_or_insert(const std::string& id);
+
+    struct bckey* create_key(CacheEntry& entry, const std::string& password, const std::string& salt, const std::string& algorithm);
+    struct bckey* derive_kernel(CacheEntry& entry, const std::string& password, const std::string& salt, const std::string& algorithm);
+    KernelBinding* find_kernel(const struct bckey *key);
+    void bind_kernel(const struct bckey *key, const CacheEntry& entry);
+    void unbind_kernel(const struct bckey *key);
+
+    static bool kernel_matches(struct bckey *key, const CacheEntry& entry);
+    static void destroy_key(struct bckey *key);
+
+private:
+    bool                                    m_ready = false;
+    mutable std::mutex                      m_mutex;
+    std::list<std::shared_ptr<CacheEntry>>  m_entries; ///< Начало списка - последние использованные
+    size_t                                  m_hits   = 0;
+    size_t                                  m_misses = 0;
+
+    std::mutex                                              m_kernel_mutex;
+    std::unordered_map<const struct bckey*, KernelBinding>  m_kernels; ///< Ключи, для которых работает собственная реализация шифра
+};
+
+#endif // CRYPTO_SESSION_HPP
@@ -0,0 +1,281 @@
+/**
+ * @file       <ctr_engine.cpp>
+ * @brief      Основной файл многопоточного обработчика файлов в режиме гаммирования (CTR).
+ *
+ *             Файл делится на сегменты фиксированного размера. Каждый сегмент
+ *             шифруется независимо со своей синхропосылкой, поэтому сегменты
+ *             раздаются потокам в любом порядке, а результат не зависит от
+ *             количества потоков.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "ctr_engine.hpp"
+#include "buffer_pool.hpp"
+#include "cipher_policy.hpp"
+#include "crypto_provider.hpp"
+#include "crypto_session.hpp"
+#include "file_stream.hpp"
+#include "file_io.hpp"
+#include "job_stats.hpp"
+#include "parallel_for.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <libakrypt.h>
+
+/**
+ * @brief Шифрует файл в режиме CTR на нескольких потоках.
+ *
+ * Эта функция делит файл на сегменты по segment_size байт и раздает их
+ * рабочим потокам через ParallelFor. Каждый поток получает собственный ключ из CryptoSession,
+ * так как структура bckey хранит состояние счетчика и не может разделяться
+ * между потоками. При повторных вызовах с тем же паролем ключи берутся
+ * из кэша сессии без повторной выработки.
+ *
+ * @param input_file Путь к исходному файлу.
+ * @param output_file Путь к файлу, в который будет записан результат.
+ * @param password Пароль, из которого вырабатывается ключ.
+ * @param salt Соль, используемая для выработки ключа.
+ * @param algorithm Алгоритм шифрования (kuznechik или magma).
+ * @param threads Количество потоков (0 - по числу ядер).
+ * @param segment_size Размер независимого сегмента в байтах.
+ * @return bool true, если обработка прошла успешно, иначе false.
+ *
+ * @note Режим CTR симметричен, эта же функция используется и для расшифрования.
+ */
+bool CtrEngine::process_file(const std::string& input_file,
+                             const std::string& output_file,
+                             const std::string& password,
+                             const std::string& salt,
+                             const std::string& algorithm,
+                             unsigned int threads,
+                             size_t segment_size)
+{
+    return run_segments(input_file, output_file, password, salt, algorithm, threads, segment_size, false);
+}
+
+/**
+ * @brief Проверяет, что выходной файл расшифровывается в исходный.
+ *
+ * Эта функция параллельно расшифровывает сегменты выходного файла и сравнивает
+ * их с соответствующими участками исходного файла, ничего не записывая на диск.
+ *
+ * @param input_file Путь к исходному файлу.
+ * @param output_file Путь к зашифрованному файлу.
+ * @param password Пароль, из которого вырабатывается ключ.
+ * @param salt Соль, используемая для выработки ключа.
+ * @param algorithm Алгоритм шифрования (kuznechik или magma).
+ * @param threads Количество потоков (0 - по числу ядер).
+ * @param segment_size Размер независимого сегмента в байтах.
+ * @return bool true, если содержимое совпадает, иначе false.
+ */
+bool CtrEngine::verify_file(const std::string& input_file,
+                            const std::string& output_file,
+                            const std::string& password,
+                            const std::string& salt,
+                            const std::string& algorithm,
+                            unsigned int threads,
+                            size_t segment_size)
+{
+    return run_segments(input_file, output_file, password, salt, algorithm, threads, segment_size, true);
+}
+
+/**
+ * @brief Вырабатывает синхропосылку для сегмента.
+ *
+ * Синхропосылка сегмента получается из базовой синхропосылки IV сложением
+ * по модулю 2 с номером сегмента, записанным в последние байты. Так каждый
+ * сегмент получает уникальное начальное значение счетчика.
+ *
+ * @param segment Номер сегмента.
+ * @param iv Буфер для синхропосылки.
+ * @param iv_size Длина синхропосылки (половина длины блока алгоритма).
+ */
+void CtrEngine::make_segment_iv(size_t segment, ak_uint8 *iv, size_t iv_size)
+{
+    const ak_uint8 base_iv[IV_SIZE] = IV;
+
+    for (size_t i = 0; i < iv_size; ++i)
+    {
+        iv[i] = base_iv[i % IV_SIZE];
+    }
+
+    for (size_t i = 0; i < iv_size && i < sizeof(segment); ++i)
+    {
+        iv[iv_size - 1 - i] ^= static_cast<ak_uint8>(segment >> (8 * i));
+    }
+}
+
+/**
+ * @brief Раздает сегменты файла рабочим потокам.
+ *
+ * @param input_file Путь к исходному файлу.
+ * @param output_file Путь к файлу результата.
+ * @param password Пароль, из которого вырабатывается ключ.
+ * @param salt Соль, используемая для выработки ключа.
+ * @param algorithm Алгоритм шифрования (kuznechik или magma).
+ * @param threads Количество потоков (0 - по числу ядер).
+ * @param segment_size Размер независимого сегмента в байтах.
+ * @param verify_only Если true, результат не записывается, а сравнивается с исходным файлом.
+ * @return bool true, если все сегменты обработаны успешно, иначе false.
+ */
+bool CtrEngine::run_segments(const std::string& input_file,
+                             const std::string& output_file,
+                             const std::string& password,
+                             const std::string& salt,
+                             const std::string& algorithm,
+                             unsigned int threads,
+                             size_t segment_size,
+                             bool verify_only)
+{
+    // Алгоритм выбирается один раз; дальше сегменты шифрует Engine<Cipher, Ctr>
+    EngineInfo cipher;
+    if (!dispatch_cipher(algorithm, [&](auto policy) { cipher = engine_info<decltype(policy), Ctr>(); }))
+    {
+        std::cerr << "Неподдерживаемый алгоритм: " << algorithm << std::endl;
+        return false;
+    }
+
+    segment_size -= segment_size % BLOCK_SIZE;
+    if (segment_size == 0)
+    {
+        segment_size = CTR_SEGMENT_SIZE;
+    }
+
+    int input_fd = open(input_file.c_str(), O_RDONLY);
+    if (input_fd < 0)
+    {
+        std::cerr << "Не удалось открыть файл для чтения: " << input_file << std::endl;
+        return false;
+    }
+
+    struct stat input_stat;
+    if (fstat(input_fd, &input_stat) != 0)
+    {
+        std::cerr << "Не удалось получить размер файла: " << input_file << std::endl;
+        close(input_fd);
+        return false;
+    }
+    const size_t file_size = static_cast<size_t>(input_stat.st_size);
+
+    int output_fd = verify_only ? open(output_file.c_str(), O_RDONLY)
+                                : open(output_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (output_fd < 0)
+    {
+        std::cerr << "Не удалось открыть файл: " << output_file << std::endl;
+        close(input_fd);
+        return false;
+    }
+
+    if (verify_only)
+    {
+        struct stat output_stat;
+        if (fstat(output_fd, &output_stat) != 0 || static_cast<size_t>(output_stat.st_size) != file_size)
+        {
+            close(input_fd);
+            close(output_fd);
+            return false;
+        }
+    }
+    else if (ftruncate(output_fd, static_cast<off_t>(file_size)) != 0)
+    {
+        std::cerr << "Не удалось изменить размер файла: " << output_file << std::endl;
+        close(input_fd);
+        close(output_fd);
+        return false;
+    }
+
+    const size_t iv_size = cipher.iv_size;
+    const size_t segment_count = (file_size + segment_size - 1) / segment_size;
+
+    const bool success = ParallelFor::run(segment_count, threads, [&]() -> ParallelFor::Task
+    {
+        auto key = std::make_shared<CryptoSession::KeyHandle>(CryptoSession::instance().acquire_key(password, salt, algorithm));
+        if (!*key)
+        {
+            return nullptr;
+        }
+
+        auto buffer = std::make_shared<PooledBuffer>(BufferPool::instance().acquire(std::min<size_t>(STREAM_CHUNK_SIZE, segment_size)));
+        auto reference = std::make_shared<PooledBuffer>(verify_only ? BufferPool::instance().acquire(buffer->size()) : PooledBuffer());
+        if (!*buffer || (verify_only && !*reference))
+        {
+            return nullptr;
+        }
+
+        return [&, key, buffer, reference](size_t segment)
+        {
+            std::vector<ak_uint8> iv(iv_size);
+            make_segment_iv(segment, iv.data(), iv.size());
+
+            const size_t begin = segment * segment_size;
+            const size_t end   = std::min(begin + segment_size, file_size);
+
+            for (size_t offset = begin; offset < end; offset += buffer->size())
+            {
+                const size_t size = std::min(buffer->size(), end - offset);
+                const bool first_chunk = (offset == begin);
+
+                if (!FileIO::pread_exact(verify_only ? output_fd : input_fd, buffer->data(), size, static_cast<off_t>(offset)))
+                {
+                    return false;
+                }
+
+                int error = ak_error_ok;
+                {
+                    StageTimer timer(STAGE_CIPHER, size);
+                    error = cipher.apply(key->get(),
+                                         buffer->data(),
+                                         buffer->data(),
+                                         size,
+                                         first_chunk ? iv.data() : nullptr);
+                }
+
+                if (error != ak_error_ok)
+                {
+                    return false;
+                }
+
+                bool chunk_ok = verify_only
+                    ? FileIO::pread_exact(input_fd, reference->data(), size, static_cast<off_t>(offset)) &&
+                      std::memcmp(reference->data(), buffer->data(), size) == 0
+                    : FileIO::pwrite_exact(output_fd, buffer->data(), size, static_cast<off_t>(offset));
+
+                if (!chunk_ok)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        };
+    });
+
+    close(input_fd);
+    close(output_fd);
+
+    if (!success && !verify_only)
+    {
+        std::cerr << "Шифрование в режиме CTR не удалось: " << input_file << std::endl;
+    }
+
+    return success;
+}
@@ -0,0 +1,62 @@
+/**
+ * @file       <ctr_engine.hpp>
+ * @brief      Хэдер многопоточного обработчика файлов в режиме гаммирования (CTR).
+ *
+ *             Содержит в себе объявления функций, которые делят файл на независимые
+ *             сегменты и шифруют их параллельно на нескольких ядрах.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef CTR_ENGINE_HPP
+#define CTR_ENGINE_HPP
+
+#include <string>
+#include <stddef.h>
+
+#define CTR_SEGMENT_SIZE (64 << 20)
+
+typedef unsigned char ak_uint8;
+
+class CtrEngine
+{
+public:
+    static bool process_file(const std::string& input_file,
+                             const std::string& output_file,
+                             const std::string& password,
+                             const std::string& salt,
+                             const std::string& algorithm = "magma",
+                             unsigned int threads = 0,
+                             size_t segment_size = CTR_SEGMENT_SIZE);
+
+    static bool verify_file(const std::string& input_file,
+                            const std::string& output_file,
+                            const std::string& password,
+                            const std::string& salt,
+                            const std::string& algorithm = "magma",
+                            unsigned int threads = 0,
+                            size_t segment_size = CTR_SEGMENT_SIZE);
+
+    static void make_segment_iv(size_t segment, ak_uint8 *iv, size_t iv_size);
+
+private:
+    static bool run_segments(const std::string& input_file,
+                             const std::string& output_file,
+                             const std::string& password,
+                             const std::string& salt,
+                             const std::string& algorithm,
+                             unsigned int threads,
+                             size_t segment_size,
+                             bool verify_only);
+};
+
+#endif // CTR_ENGINE_HPP
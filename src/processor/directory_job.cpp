@@ -0,0 +1,550 @@
+/**
+ * @file       <directory_job.cpp>
+ * @brief      Основной файл шифрования каталога в отдельное дерево.
+ *
+ *             В резервных каталогах сотни тысяч файлов, и их размеры
+ *             отличаются на много порядков. Чтобы ядра не простаивали,
+ *             работа делится на задачи примерно одного объема: мелкие файлы
+ *             собираются в пачки, огромные файлы режутся на диапазоны
+ *             фрагментов, а задачи выполняются пулом с перехватом задач
+ *             (WorkStealingPool).
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "directory_job.hpp"
+#include "buffer_pool.hpp"
+#include "crypto_session.hpp"
+#include "work_stealing_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <libakrypt.h>
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Состояние рабочего потока: контекст хэширования и буферы фрагментов.
+ */
+struct JobWorker
+{
+    struct hash               hash_ctx;
+    bool                      hash_ready = false;
+    PooledBuffer              buffer;
+    std::vector<PooledBuffer> extra;   ///< Дополнительные буферы для групп OFB
+    std::vector<ak_uint8*>    buffers; ///< buffer и extra подряд
+
+    ~JobWorker()
+    {
+        if (hash_ready)
+        {
+            ak_hash_destroy(&hash_ctx);
+        }
+    }
+};
+
+/**
+ * @brief Один файл задания.
+ *
+ * Дескрипторы открываются только тогда, когда до файла доходит очередь,
+ * поэтому количество открытых файлов не зависит от размера каталога.
+ */
+struct JobFile
+{
+    std::string                 source;
+    std::string                 target;
+    std::uint64_t               size      = 0;
+    int                         input_fd  = -1;
+    int                         output_fd = -1;
+    AkrHeader                   header;
+    std::vector<AkrChunkEntry>  entries;
+    std::vector<std::uint32_t>  checksums;
+    std::atomic<std::uint64_t>  stored_end{AKR_HEADER_SIZE};
+    std::atomic<size_t>         remaining{0};
+    std::atomic<bool>           failed{false};
+};
+
+/**
+ * @brief Общее состояние задания.
+ */
+struct JobContext
+{
+    const std::string&                      password;
+    const AkrOptions&                       options;
+    ak_uint8                                salt[AKR_SALT_SIZE] = {0};
+    bool                                    share_salt = false;
+    size_t                                  chunk_size = AKR_CHUNK_SIZE;
+    size_t                                  group      = 1;
+    std::vector<std::unique_ptr<JobWorker>> workers;
+
+    std::atomic<size_t>                     files{0};
+    std::atomic<size_t>                     failed{0};
+    std::atomic<std::uint64_t>              bytes{0};
+    std::atomic<size_t>                     tasks{0};
+    std::mutex                              failures_mutex;
+    std::vector<std::string>                failures;
+
+    JobContext(const std::string& job_password, const AkrOptions& job_options)
+        : password(job_password), options(job_options) {}
+};
+
+/**
+ * @brief Возвращает состояние потока, создавая его при первом обращении.
+ *
+ * К элементу workers[index] обращается только поток с этим номером,
+ * поэтому блокировка не нужна.
+ */
+static JobWorker* get_worker(JobContext& context, unsigned int index)
+{
+    auto& worker = context.workers[index];
+    if (worker)
+    {
+        return worker.get();
+    }
+
+    auto created = std::make_unique<JobWorker>();
+    if (ak_hash_create_streebog256(&created->hash_ctx) != ak_error_ok)
+    {
+        return nullptr;
+    }
+    created->hash_ready = true;
+
+    created->buffer = BufferPool::instance().acquire(context.chunk_size);
+    if (!created->buffer)
+    {
+        return nullptr;
+    }
+    created->buffers.push_back(created->buffer.data());
+
+    for (size_t i = 1; i < context.group; ++i)
+    {
+        created->extra.push_back(BufferPool::instance().acquire(context.chunk_size));
+        if (!created->extra.back())
+        {
+            return nullptr;
+        }
+        created->buffers.push_back(created->extra.back().data());
+    }
+
+    worker = std::move(created);
+    return worker.get();
+}
+
+/**
+ * @brief Открывает исходный файл и временный файл контейнера, строит таблицу.
+ */
+static bool open_file(JobContext& context, JobFile& file)
+{
+    if (!AkrContainer::init_header(context.options, file.header, context.share_salt ? context.salt : nullptr))
+    {
+        return false;
+    }
+
+    file.input_fd = open(file.source.c_str(), O_RDONLY);
+    if (file.input_fd < 0)
+    {
+        std::cerr << "Не удалось открыть файл для чтения: " << file.source << std::endl;
+        return false;
+    }
+
+    struct stat input_stat;
+    if (fstat(file.input_fd, &input_stat) != 0)
+    {
+        return false;
+    }
+
+    file.size = static_cast<std::uint64_t>(input_stat.st_size);
+    AkrContainer::plan_chunks(file.header, file.size, file.entries);
+    file.checksums.assign(file.entries.size(), 0);
+
+    const std::string partial = file.target + ".part";
+    file.output_fd = open(partial.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (file.output_fd < 0)
+    {
+        std::cerr << "Не удалось открыть файл для записи: " << partial << std::endl;
+        return false;
+    }
+
+    return ftruncate(file.output_fd, static_cast<off_t>(file.header.table_offset + file.entries.size() * AKR_ENTRY_SIZE)) == 0;
+}
+
+/**
+ * @brief Шифрует диапазон фрагментов файла на текущем потоке.
+ */
+static bool encrypt_range(JobContext& context, JobFile& file, unsigned int index, size_t first, size_t count)
+{
+    JobWorker* worker = get_worker(context, index);
+    if (!worker || JobControl::cancelled(context.options.control))
+    {
+        return false;
+    }
+
+    auto key = CryptoSession::instance().acquire_key(context.password,
+                                                     AkrContainer::salt_string(file.header),
+                                                     AkrContainer::algorithm_name(file.header));
+    if (!key)
+    {
+        return false;
+    }
+
+    if (!AkrContainer::encrypt_range(file.input_fd, file.output_fd, key.get(), &worker->hash_ctx,
+                                     worker->buffers.data(), worker->buffers.size(),
+                                     file.header, file.entries, file.checksums, file.stored_end, first, count))
+    {
+        return false;
+    }
+
+    if (context.options.control)
+    {
+        std::uint64_t bytes = 0;
+        for (size_t i = first; i < std::min(first + count, file.entries.size()); ++i)
+        {
+            bytes += file.entries[i].plain_size;
+        }
+        context.options.control->advance(bytes);
+    }
+    return true;
+}
+
+/**
+ * @brief Завершает файл: записывает таблицу и заголовок, проверяет фрагменты
+ *        и переименовывает временный файл. При ошибке временный файл удаляется.
+ *
+ * Проверка идет на одном потоке: параллельность обеспечивают другие задачи.
+ */
+static void close_file(JobContext& context, JobFile& file, bool success)
+{
+    AkrContainer::close_layout(file.header, file.stored_end);
+    success = success && AkrContainer::finish_file(file.output_fd, file.header, file.entries, file.checksums,
+                                                   context.options.verify, context.password, 1);
+
+    if (file.input_fd >= 0)
+    {
+        close(file.input_fd);
+    }
+    if (file.output_fd >= 0)
+    {
+        close(file.output_fd);
+    }
+
+    const std::string partial = file.target + ".part";
+    std::error_code error;
+
+    if (success)
+    {
+        fs::rename(partial, file.target, error);
+        success = !error;
+    }
+
+    if (!success && JobControl::cancelled(context.options.control))
+    {
+        fs::remove(partial, error); ///< Отмена - не ошибка файла
+    }
+    else if (!success)
+    {
+        fs::remove(partial, error);
+        std::cerr << "Не удалось зашифровать файл: " << file.source << std::endl;
+
+        context.failed.fetch_add(1);
+        std::lock_guard<std::mutex> lock(context.failures_mutex);
+        context.failures.push_back(file.source);
+    }
+    else
+    {
+        context.bytes.fetch_add(file.size);
+    }
+
+    context.files.fetch_add(1);
+
+    file.entries   = std::vector<AkrChunkEntry>();
+    file.checksums = std::vector<std::uint32_t>();
+}
+
+/**
+ * @brief Шифрует файл целиком на текущем потоке.
+ */
+static void encrypt_whole(JobContext& context, JobFile& file, unsigned int index)
+{
+    if (JobControl::cancelled(context.options.control))
+    {
+        return;
+    }
+
+    const bool success = open_file(context, file) &&
+                         encrypt_range(context, file, index, 0, file.entries.size());
+    close_file(context, file, success);
+}
+
+/**
+ * @brief Открывает большой файл и порождает задачи по диапазонам фрагментов.
+ *
+ * Задачи попадают в очередь текущего потока. Он сам берет их с конца,
+ * а свободные потоки перехватывают их с начала очереди. Файл завершает
+ * та задача, которая выполнилась последней.
+ */
+static void encrypt_split(JobContext& context, WorkStealingPool& pool, const std::shared_ptr<JobFile>& file)
+{
+    if (JobControl::cancelled(context.options.control))
+    {
+        return;
+    }
+
+    if (!open_file(context, *file))
+    {
+        close_file(context, *file, false);
+        return;
+    }
+
+    const size_t count  = file->entries.size();
+    const size_t ranges = (count + DIRECTORY_JOB_TASK_CHUNKS - 1) / DIRECTORY_JOB_TASK_CHUNKS;
+    file->remaining = ranges;
+
+    for (size_t range = 0; range < ranges; ++range)
+    {
+        const size_t first = range * DIRECTORY_JOB_TASK_CHUNKS;
+        context.tasks.fetch_add(1);
+
+        pool.submit([&context, file, first](unsigned int index)
+        {
+            if (!file->failed && !encrypt_range(context, *file, index, first, DIRECTORY_JOB_TASK_CHUNKS))
+            {
+                file->failed = true;
+            }
+
+            if (file->remaining.fetch_sub(1) == 1)
+            {
+                close_file(context, *file, !file->failed);
+            }
+        });
+    }
+}
+
+/**
+ * @brief Шифрует все обычные файлы каталога в выходное дерево.
+ *
+ * Эта функция рекурсивно обходит source_dir, повторяет структуру
+ * подкаталогов в output_dir и для каждого обычного файла создает
+ * контейнер <имя>.akr. Исходные файлы не изменяются. Символические ссылки
+ * и специальные файлы пропускаются, выходной каталог внутри исходного
+ * не обходится.
+ *
+ * Работа делится на задачи:
+ * - файлы до DIRECTORY_JOB_SMALL_FILE собираются в пачки (до
+ *   DIRECTORY_JOB_BATCH_FILES файлов или DIRECTORY_JOB_BATCH_BYTES байт),
+ *   пачка шифруется одной задачей;
+ * - файлы до DIRECTORY_JOB_TASK_CHUNKS фрагментов шифруются одной задачей;
+ * - большие файлы режутся на задачи по DIRECTORY_JOB_TASK_CHUNKS фрагментов.
+ *
+ * Если алгоритм это позволяет (shares_salt), все файлы задания используют
+ * общую соль, и ключ вырабатывается из пароля один раз, а не для каждого
+ * файла. Синхропосылка у каждого файла своя.
+ *
+ * Ошибка в одном файле не останавливает задание: файл попадает
+ * в result.failures, его временный файл удаляется. После отмены через
+ * options.control обход каталога прекращается, начатые файлы
+ * останавливаются на границе фрагмента и их временные файлы удаляются,
+ * а уже готовые контейнеры остаются.
+ *
+ * @param source_dir Исходный каталог.
+ * @param output_dir Выходной каталог (создается при необходимости).
+ * @param password Пароль, из которого вырабатывается ключ.
+ * @param options Алгоритм, режим, размер фрагмента, количество потоков и уровень проверки.
+ * @param result Статистика задания.
+ * @return bool true, если все файлы зашифрованы, иначе false.
+ */
+bool DirectoryJob::encrypt_tree(const std::string& source_dir,
+                                const std::string& output_dir,
+                                const std::string& password,
+                                const AkrOptions& options,
+                                DirectoryJobResult& result)
+{
+    result = DirectoryJobResult();
+
+    std::error_code source_error;
+    std::error_code output_error;
+    const fs::path source = fs::weakly_canonical(source_dir, source_error);
+    const fs::path output = fs::weakly_canonical(output_dir, output_error);
+
+    if (source_error || output_error || !fs::is_directory(source))
+    {
+        std::cerr << "Исходный каталог не найден: " << source_dir << std::endl;
+        return false;
+    }
+
+    if (source == output)
+    {
+        std::cerr << "Выходной каталог должен отличаться от исходного: " << output_dir << std::endl;
+        return false;
+    }
+
+    std::error_code error;
+    if (!fs::create_directories(output, error) && error)
+    {
+        std::cerr << "Не удалось создать каталог: " << output_dir << std::endl;
+        return false;
+    }
+
+    JobContext context(password, options);
+
+    AkrHeader probe;
+    if (!AkrContainer::init_header(options, probe))
+    {
+        return false;
+    }
+
+    std::copy(probe.salt, probe.salt + AKR_SALT_SIZE, context.salt);
+    context.share_salt = shares_salt(probe);
+    context.chunk_size = probe.chunk_size;
+
+    // Группы OFB не больше задачи, иначе буферы потока простаивают
+    if (probe.mode == AKR_MODE_OFB && probe.codec == AKR_CODEC_NONE)
+    {
+        auto key = CryptoSession::instance().acquire_key(password,
+                                                         AkrContainer::salt_string(probe),
+                                                         AkrContainer::algorithm_name(probe));
+        context.group = std::min<size_t>(AkrContainer::stream_group(probe, key.get()), DIRECTORY_JOB_TASK_CHUNKS);
+    }
+
+    WorkStealingPool pool(options.threads);
+    context.workers.resize(pool.size());
+
+    std::vector<std::shared_ptr<JobFile>> batch;
+    std::uint64_t batch_bytes = 0;
+
+    auto flush_batch = [&]()
+    {
+        if (batch.empty())
+        {
+            return;
+        }
+
+        context.tasks.fetch_add(1);
+        pool.submit([&context, files = std::move(batch)](unsigned int index)
+        {
+            for (const auto& file : files)
+            {
+                encrypt_whole(context, *file, index);
+            }
+        });
+
+        batch.clear();
+        batch_bytes = 0;
+    };
+
+    auto it = fs::recursive_directory_iterator(source, fs::directory_options::skip_permission_denied, error);
+    for (; !error && it != fs::recursive_directory_iterator() && !JobControl::cancelled(options.control); it.increment(error))
+    {
+        const fs::directory_entry& entry = *it;
+        const fs::file_status status = entry.symlink_status(error);
+        if (error)
+        {
+            break;
+        }
+
+        const fs::path relative = entry.path().lexically_relative(source);
+
+        if (fs::is_directory(status))
+        {
+            if (entry.path() == output)
+            {
+                it.disable_recursion_pending();
+            }
+            else
+            {
+                fs::create_directories(output / relative, error);
+            }
+            continue;
+        }
+
+        if (!fs::is_regular_file(status))
+        {
+            continue;
+        }
+
+        auto file = std::make_shared<JobFile>();
+        file->source = entry.path().string();
+        file->target = (output / relative).string() + DIRECTORY_JOB_SUFFIX;
+        file->size   = entry.file_size(error);
+
+        if (options.control)
+        {
+            options.control->expect(file->size);
+        }
+
+        if (file->size <= DIRECTORY_JOB_SMALL_FILE)
+        {
+            batch_bytes += file->size;
+            batch.push_back(std::move(file));
+
+            if (batch.size() >= DIRECTORY_JOB_BATCH_FILES || batch_bytes >= DIRECTORY_JOB_BATCH_BYTES)
+            {
+                flush_batch();
+            }
+        }
+        else if (file->size <= static_cast<std::uint64_t>(context.chunk_size) * DIRECTORY_JOB_TASK_CHUNKS)
+        {
+            context.tasks.fetch_add(1);
+            pool.submit([&context, file](unsigned int index) { encrypt_whole(context, *file, index); });
+        }
+        else
+        {
+            context.tasks.fetch_add(1);
+            pool.submit([&context, &pool, file](unsigned int) { encrypt_split(context, pool, file); });
+        }
+
+        error.clear();
+    }
+
+    if (error)
+    {
+        std::cerr << "Не удалось обойти каталог: " << source_dir << " (" << error.message() << ")" << std::endl;
+    }
+
+    flush_batch();
+    pool.wait();
+
+    result.files    = context.files.load();
+    result.failed   = context.failed.load();
+    result.bytes    = context.bytes.load();
+    result.tasks    = context.tasks.load();
+    result.steals   = pool.steals();
+    result.failures = std::move(context.failures);
+
+    return !error && result.failed == 0 && !JobControl::cancelled(options.control);
+}
+
+/**
+ * @brief Проверяет, могут ли файлы задания использовать общую соль.
+ *
+ * При общей соли у всех файлов один ключ, и уникальность гаммы держится
+ * только на случайной синхропосылке файла. У magma блок 64 бита: в режиме
+ * CTR синхропосылка занимает полблока, а в любом режиме объем данных на
+ * одном ключе быстро упирается в границу парадокса дней рождения
+ * (2^32 блоков). Поэтому общая соль допускается только для kuznechik,
+ * а для magma каждому файлу вырабатывается свой ключ.
+ *
+ * @param header Заголовок с алгоритмом и режимом.
+ * @return bool true, если соль можно разделить между файлами.
+ */
+bool DirectoryJob::shares_salt(const AkrHeader& header)
+{
+    return header.algorithm == AKR_ALGORITHM_KUZNECHIK;
+}
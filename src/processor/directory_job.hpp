@@ -0,0 +1,59 @@
+/**
+ * @file       <directory_job.hpp>
+ * @brief      Хэдер шифрования каталога в отдельное дерево.
+ *
+ *             Содержит в себе объявление задания, которое обходит каталог
+ *             и шифрует каждый файл в контейнер .akr в выходном каталоге
+ *             с той же структурой, не изменяя исходные файлы.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef DIRECTORY_JOB_HPP
+#define DIRECTORY_JOB_HPP
+
+#include "akr_container.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+#define DIRECTORY_JOB_SMALL_FILE   (256 << 10)
+#define DIRECTORY_JOB_BATCH_BYTES  (8 << 20)
+#define DIRECTORY_JOB_BATCH_FILES  256
+#define DIRECTORY_JOB_TASK_CHUNKS  4
+#define DIRECTORY_JOB_SUFFIX       ".akr"
+
+struct DirectoryJobResult
+{
+    size_t                   files  = 0;
+    size_t                   failed = 0;
+    std::uint64_t            bytes  = 0;
+    size_t                   tasks  = 0;
+    size_t                   steals = 0;
+    std::vector<std::string> failures;
+};
+
+class DirectoryJob
+{
+public:
+    static bool encrypt_tree(const std::string& source_dir,
+                             const std::string& output_dir,
+                             const std::string& password,
+                             const AkrOptions& options,
+                             DirectoryJobResult& result);
+
+    static bool shares_salt(const AkrHeader& header);
+};
+
+#endif // DIRECTORY_JOB_HPP
@@ -0,0 +1,90 @@
+/**
+ * @file       <file_io.cpp>
+ * @brief      Основной файл вспомогательных функций позиционного ввода-вывода.
+ *
+ *             pread/pwrite могут обработать меньше байт, чем запрошено, или
+ *             прерваться сигналом. Эти функции доводят операцию до конца.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "file_io.hpp"
+#include "job_stats.hpp"
+
+#include <cerrno>
+#include <unistd.h>
+
+/**
+ * @brief Читает ровно size байт из файла по смещению offset.
+ *
+ * Вызов учитывается в этапе чтения статистики задания (JobStats).
+ *
+ * @param fd Дескриптор файла.
+ * @param data Буфер для данных.
+ * @param size Количество байт.
+ * @param offset Смещение от начала файла.
+ * @return bool true, если все байты прочитаны, иначе false.
+ */
+bool FileIO::pread_exact(int fd, ak_uint8 *data, size_t size, off_t offset)
+{
+    StageTimer timer(STAGE_READ, size);
+
+    while (size > 0)
+    {
+        ssize_t result = pread(fd, data, size, offset);
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result <= 0)
+        {
+            return false;
+        }
+        data   += result;
+        size   -= static_cast<size_t>(result);
+        offset += result;
+    }
+    return true;
+}
+
+/**
+ * @brief Записывает ровно size байт в файл по смещению offset.
+ *
+ * Вызов учитывается в этапе записи статистики задания (JobStats).
+ *
+ * @param fd Дескриптор файла.
+ * @param data Буфер с данными.
+ * @param size Количество байт.
+ * @param offset Смещение от начала файла.
+ * @return bool true, если все байты записаны, иначе false.
+ */
+bool FileIO::pwrite_exact(int fd, const ak_uint8 *data, size_t size, off_t offset)
+{
+    StageTimer timer(STAGE_WRITE, size);
+
+    while (size > 0)
+    {
+        ssize_t result = pwrite(fd, data, size, offset);
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result <= 0)
+        {
+            return false;
+        }
+        data   += result;
+        size   -= static_cast<size_t>(result);
+        offset += result;
+    }
+    return true;
+}
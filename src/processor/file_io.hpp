@@ -0,0 +1,35 @@
+/**
+ * @file       <file_io.hpp>
+ * @brief      Хэдер вспомогательных функций позиционного ввода-вывода.
+ *
+ *             Содержит в себе обертки над pread/pwrite, которые дочитывают и
+ *             дописывают данные целиком, повторяя частичные операции.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef FILE_IO_HPP
+#define FILE_IO_HPP
+
+#include <stddef.h>
+#include <sys/types.h>
+
+typedef unsigned char ak_uint8;
+
+class FileIO
+{
+public:
+    static bool pread_exact(int fd, ak_uint8 *data, size_t size, off_t offset);
+    static bool pwrite_exact(int fd, const ak_uint8 *data, size_t size, off_t offset);
+};
+
+#endif // FILE_IO_HPP
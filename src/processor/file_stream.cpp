@@ -0,0 +1,381 @@
+/**
+ * @file       <file_stream.cpp>
+ * @brief      Основной файл потокового обработчика файлов ak-file-encryptor.
+ *
+ *             Шифрует и проверяет файлы блоками фиксированного размера, сохраняя
+ *             состояние режима OFB между блоками. Потребление памяти не зависит
+ *             от размера файла.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "file_stream.hpp"
+#include "buffer_pool.hpp"
+#include "crypto_provider.hpp"
+#include "job_stats.hpp"
+#include "keystream.hpp"
+#include "mapped_file.hpp"
+#include "pipeline.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <libakrypt.h>
+
+/**
+ * @brief Шифрует файл потоково, блоками фиксированного размера.
+ *
+ * Эта функция читает входной файл порциями по chunk_size байт, шифрует каждую
+ * порцию в режиме OFB и сразу записывает ее в выходной файл. Синхропосылка
+ * передается только для первой порции, для остальных libakrypt продолжает
+ * гамму с сохраненного в ключе состояния, поэтому результат побайтно совпадает
+ * с однократным вызовом ak_bckey_ofb для всего файла. Для больших файлов
+ * гамму заранее вырабатывает KeystreamProducer, пока читаются следующие
+ * порции, а здесь она только накладывается на данные.
+ *
+ * @param input_file Путь к исходному файлу.
+ * @param output_file Путь к файлу, в который будет записан результат.
+ * @param key Указатель на структуру bckey, содержащую ключ.
+ * @param chunk_size Размер порции в байтах (округляется вниз до кратного BLOCK_SIZE).
+ * @return bool true, если обработка прошла успешно, иначе false.
+ *
+ * @note Так как режим OFB симметричен, эта же функция используется и для расшифрования.
+ */
+bool FileStreamProcessor::process_file(const std::string& input_file,
+                                       const std::string& output_file,
+                                       struct bckey *key,
+                                       size_t chunk_size)
+{
+    chunk_size -= chunk_size % BLOCK_SIZE;
+    if (chunk_size == 0)
+    {
+        chunk_size = BLOCK_SIZE;
+    }
+
+    std::ifstream ifs(input_file, std::ios::binary);
+    if (!ifs)
+    {
+        std::cerr << "Не удалось открыть файл для чтения: " << input_file << std::endl;
+        return false;
+    }
+
+    std::ofstream ofs(output_file, std::ios::binary | std::ios::trunc);
+    if (!ofs)
+    {
+        std::cerr << "Не удалось открыть файл для записи: " << output_file << std::endl;
+        return false;
+    }
+
+    ak_uint8 iv[IV_SIZE] = IV;
+    PooledBuffer buffer = BufferPool::instance().acquire(chunk_size);
+    if (!buffer)
+    {
+        std::cerr << "Не удалось выделить буфер" << std::endl;
+        return false;
+    }
+
+    std::error_code size_error;
+    const auto input_size = std::filesystem::file_size(input_file, size_error);
+    auto keystream = size_error ? nullptr : KeystreamProducer::start(key, iv, sizeof(iv), static_cast<size_t>(input_size), chunk_size);
+
+    bool first_chunk = true;
+
+    while (ifs)
+    {
+        size_t read_size = 0;
+        {
+            StageTimer timer(STAGE_READ);
+            ifs.read(reinterpret_cast<char*>(buffer.data()), chunk_size);
+            read_size = static_cast<size_t>(ifs.gcount());
+            timer.set_input(read_size);
+        }
+
+        if (read_size == 0)
+        {
+            break;
+        }
+
+        {
+            StageTimer timer(STAGE_CIPHER, read_size);
+
+            if (keystream)
+            {
+                if (!keystream->apply(buffer.data(), buffer.data(), read_size))
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                int error = ak_bckey_ofb(key,
+                                         buffer.data(),
+                                         buffer.data(),
+                                         read_size,
+                                         first_chunk ? iv : nullptr,
+                                         first_chunk ? sizeof(iv) : 0);
+
+                if (error != ak_error_ok)
+                {
+                    std::cerr << "Шифрование не удалось: " << error << std::endl;
+                    return false;
+                }
+            }
+        }
+
+        first_chunk = false;
+
+        {
+            StageTimer timer(STAGE_WRITE, read_size);
+            ofs.write(reinterpret_cast<const char*>(buffer.data()), read_size);
+        }
+        if (!ofs)
+        {
+            std::cerr << "Не удалось записать данные в файл: " << output_file << std::endl;
+            return false;
+        }
+    }
+
+    if (ifs.bad())
+    {
+        std::cerr << "Ошибка чтения файла: " << input_file << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Шифрует файл в режиме OFB, выбирая способ ввода-вывода по размеру файла.
+ *
+ * Большие файлы обрабатываются конвейером PipelineProcessor, где чтение
+ * и запись идут параллельно с шифрованием. Файлы поменьше, которые скорее
+ * всего уже лежат в страничном кэше, шифруются через отображение в память.
+ * Если ни один из способов не подошел, используется process_file.
+ *
+ * @param input_file Путь к исходному файлу.
+ * @param output_file Путь к файлу, в который будет записан результат.
+ * @param key Указатель на структуру bckey, содержащую ключ.
+ * @return bool true, если обработка прошла успешно, иначе false.
+ */
+bool FileStreamProcessor::process_file_auto(const std::string& input_file,
+                                            const std::string& output_file,
+                                            struct bckey *key)
+{
+    std::error_code error;
+    const auto file_size = std::filesystem::file_size(input_file, error);
+
+    if (!error && file_size >= PIPELINE_MIN_FILE_SIZE)
+    {
+        if (PipelineProcessor::process_file(input_file, output_file, key))
+        {
+            return true;
+        }
+    }
+    else if (process_file_mapped(input_file, output_file, key))
+    {
+        return true;
+    }
+
+    return process_file(input_file, output_file, key);
+}
+
+/**
+ * @brief Шифрует файл через отображение в память, без копирования в кучу.
+ *
+ * Эта функция отображает исходный файл только для чтения, заранее выделяет
+ * место под файл результата, отображает его для записи и передает оба
+ * отображения напрямую в ak_bckey_ofb. Данные не копируются ни в буферы
+ * в куче, ни через std::ofstream. Обработка идет порциями по chunk_size байт
+ * с сохранением состояния OFB, поэтому результат совпадает с process_file.
+ * Гамму для больших файлов вырабатывает KeystreamProducer, пока здесь
+ * дочитываются страницы исходного файла.
+ *
+ * @param input_file Путь к исходному файлу.
+ * @param output_file Путь к файлу, в который будет записан результат.
+ * @param key Указатель на структуру bckey, содержащую ключ.
+ * @param chunk_size Размер порции в байтах (округляется вниз до кратного BLOCK_SIZE).
+ * @return bool true, если обработка прошла успешно, иначе false.
+ *
+ * @note Для файлов, которые нельзя отобразить (пустые, каналы, устройства),
+ * функция возвращает false, и следует использовать process_file.
+ */
+bool FileStreamProcessor::process_file_mapped(const std::string& input_file,
+                                              const std::string& output_file,
+                                              struct bckey *key,
+                                              size_t chunk_size)
+{
+    chunk_size -= chunk_size % BLOCK_SIZE;
+    if (chunk_size == 0)
+    {
+        chunk_size = BLOCK_SIZE;
+    }
+
+    MappedFile source;
+    if (!source.open_read(input_file))
+    {
+        return false;
+    }
+
+    MappedFile destination;
+    if (!destination.create(output_file, source.size()))
+    {
+        return false;
+    }
+
+    source.advise_sequential();
+    destination.advise_sequential();
+
+    ak_uint8 iv[IV_SIZE] = IV;
+    auto keystream = KeystreamProducer::start(key, iv, sizeof(iv), source.size(), chunk_size);
+
+    // Чтение и запись идут через page fault внутри шифрования, поэтому
+    // для них учитывается только объем, а время входит в этап шифрования
+    JobStats::record(STAGE_READ, source.size(), source.size());
+
+    for (size_t offset = 0; offset < source.size(); offset += chunk_size)
+    {
+        const size_t size = std::min(chunk_size, source.size() - offset);
+        const bool first_chunk = (offset == 0);
+        StageTimer timer(STAGE_CIPHER, size);
+
+        if (keystream)
+        {
+            if (!keystream->apply(source.data() + offset, destination.data() + offset, size))
+            {
+                return false;
+            }
+            continue;
+        }
+
+        int error = ak_bckey_ofb(key,
+                                 source.data() + offset,
+                                 destination.data() + offset,
+                                 size,
+                                 first_chunk ? iv : nullptr,
+                                 first_chunk ? sizeof(iv) : 0);
+
+        if (error != ak_error_ok)
+        {
+            std::cerr << "Шифрование не удалось: " << error << std::endl;
+            return false;
+        }
+    }
+
+    JobStats::record(STAGE_WRITE, source.size(), source.size());
+    return true;
+}
+
+/**
+ * @brief Проверяет, что выходной файл расшифровывается в исходный.
+ *
+ * Эта функция потоково расшифровывает выходной файл и сравнивает каждую
+ * порцию с соответствующей порцией исходного файла. В памяти одновременно
+ * находятся только две порции, независимо от размера файлов.
+ *
+ * @param input_file Путь к исходному файлу.
+ * @param output_file Путь к зашифрованному файлу.
+ * @param key Указатель на структуру bckey, содержащую ключ.
+ * @param chunk_size Размер порции в байтах (округляется вниз до кратного BLOCK_SIZE).
+ * @return bool true, если содержимое совпадает, иначе false.
+ */
+bool FileStreamProcessor::verify_file(const std::string& input_file,
+                                      const std::string& output_file,
+                                      struct bckey *key,
+                                      size_t chunk_size)
+{
+    chunk_size -= chunk_size % BLOCK_SIZE;
+    if (chunk_size == 0)
+    {
+        chunk_size = BLOCK_SIZE;
+    }
+
+    std::ifstream original(input_file, std::ios::binary);
+    std::ifstream processed(output_file, std::ios::binary);
+    if (!original || !processed)
+    {
+        return false;
+    }
+
+    ak_uint8 iv[IV_SIZE] = IV;
+    PooledBuffer original_buffer = BufferPool::instance().acquire(chunk_size);
+    PooledBuffer processed_buffer = BufferPool::instance().acquire(chunk_size);
+    if (!original_buffer || !processed_buffer)
+    {
+        return false;
+    }
+
+    bool first_chunk = true;
+
+    while (true)
+    {
+        original.read(reinterpret_cast<char*>(original_buffer.data()), chunk_size);
+        processed.read(reinterpret_cast<char*>(processed_buffer.data()), chunk_size);
+
+        size_t original_size = static_cast<size_t>(original.gcount());
+        size_t processed_size = static_cast<size_t>(processed.gcount());
+
+        if (original_size != processed_size)
+        {
+            return false;
+        }
+
+        if (original_size == 0)
+        {
+            break;
+        }
+
+        int error = ak_bckey_ofb(key,
+                                 processed_buffer.data(),
+                                 processed_buffer.data(),
+                                 processed_size,
+                                 first_chunk ? iv : nullptr,
+                                 first_chunk ? sizeof(iv) : 0);
+
+        if (error != ak_error_ok)
+        {
+            return false;
+        }
+
+        first_chunk = false;
+
+        if (std::memcmp(original_buffer.data(), processed_buffer.data(), original_size) != 0)
+        {
+            return false;
+        }
+    }
+
+    return !original.bad() && !processed.bad();
+}
+
+/**
+ * @brief Читает первые size байт файла.
+ *
+ * Используется интерфейсом для предпросмотра результата без загрузки
+ * всего файла в память.
+ *
+ * @param file Путь к файлу.
+ * @param size Максимальное количество байт для чтения.
+ * @return std::string Прочитанные байты (может быть короче size).
+ */
+std::string FileStreamProcessor::read_prefix(const std::string& file, size_t size)
+{
+    std::ifstream ifs(file, std::ios::binary);
+    std::string prefix(size, '\0');
+
+    ifs.read(prefix.data(), size);
+    prefix.resize(static_cast<size_t>(ifs.gcount()));
+
+    return prefix;
+}
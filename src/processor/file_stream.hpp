@@ -0,0 +1,39 @@
+/**
+ * @file       <file_stream.hpp>
+ * @brief      Хэдер потокового обработчика файлов ak-file-encryptor.
+ *
+ *             Содержит в себе объявления функций, которые шифруют файл
+ *             блоками фиксированного размера, не загружая его в память целиком.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef FILE_STREAM_HPP
+#define FILE_STREAM_HPP
+
+#include <string>
+#include <stddef.h>
+
+#define STREAM_CHUNK_SIZE (1 << 20)
+
+class FileStreamProcessor
+{
+public:
+    static bool process_file(const std::string& input_file, const std::string& output_file, struct bckey *key, size_t chunk_size = STREAM_CHUNK_SIZE);
+    static bool process_file_auto(const std::string& input_file, const std::string& output_file, struct bckey *key);
+    static bool process_file_mapped(const std::string& input_file, const std::string& output_file, struct bckey *key, size_t chunk_size = STREAM_CHUNK_SIZE);
+    static bool verify_file(const std::string& input_file, const std::string& output_file, struct bckey *key, size_t chunk_size = STREAM_CHUNK_SIZE);
+
+    static std::string read_prefix(const std::string& file, size_t size);
+};
+
+#endif // FILE_STREAM_HPP
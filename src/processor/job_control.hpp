@@ -0,0 +1,69 @@
+/**
+ * @file       <job_control.hpp>
+ * @brief      Хэдер прогресса и отмены задания.
+ *
+ *             Содержит в себе JobControl - общий объект интерфейса и рабочих
+ *             потоков задания. Рабочие потоки добавляют обработанные байты
+ *             и перед каждым фрагментом проверяют запрос отмены; интерфейс
+ *             читает прогресс и может отменить задание из другого потока.
+ *             Передается в задание через AkrOptions::control.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef JOB_CONTROL_HPP
+#define JOB_CONTROL_HPP
+
+#include <atomic>
+#include <cstdint>
+
+class JobControl
+{
+public:
+    /**
+     * @brief Увеличивает ожидаемый объем задания (входные байты).
+     *
+     * Задание по каталогу увеличивает его по мере обхода, поэтому объем
+     * может расти, пока задание уже идет.
+     *
+     * @param bytes Количество байт.
+     */
+    void expect(std::uint64_t bytes) { m_total.fetch_add(bytes, std::memory_order_relaxed); }
+
+    /**
+     * @brief Отмечает обработанные входные байты.
+     *
+     * @param bytes Количество байт.
+     */
+    void advance(std::uint64_t bytes) { m_done.fetch_add(bytes, std::memory_order_relaxed); }
+
+    /**
+     * @brief Запрашивает отмену. Рабочие потоки останавливаются на границе фрагмента.
+     */
+    void cancel() { m_cancelled.store(true, std::memory_order_relaxed); }
+
+    bool cancelled() const { return m_cancelled.load(std::memory_order_relaxed); }
+    std::uint64_t total() const { return m_total.load(std::memory_order_relaxed); }
+    std::uint64_t done() const { return m_done.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Проверяет отмену для необязательного объекта (nullptr - задание без управления).
+     */
+    static bool cancelled(const JobControl *control) { return control && control->cancelled(); }
+
+private:
+    std::atomic<std::uint64_t> m_total{0};
+    std::atomic<std::uint64_t> m_done{0};
+    std::atomic<bool>          m_cancelled{false};
+};
+
+#endif // JOB_CONTROL_HPP
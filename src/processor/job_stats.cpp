@@ -0,0 +1,401 @@
+/**
+ * @file       <job_stats.cpp>
+ * @brief      Основной файл счетчиков производительности заданий.
+ *
+ *             Счетчики потока лежат в thread_local-структуре, которая
+ *             регистрируется в общем списке при первом замере и при завершении
+ *             потока переносит накопленное в общий итог, поэтому рабочие
+ *             потоки заданий не теряют статистику и список не растет.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "job_stats.hpp"
+#include "buffer_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include <time.h>
+
+#define STATS_FIELDS 5
+
+/**
+ * @brief Счетчики одного потока. Пишет только поток-владелец.
+ */
+struct ThreadCounters
+{
+    std::array<std::array<std::atomic<std::uint64_t>, STATS_FIELDS>, STAGE_COUNT> values{};
+};
+
+/**
+ * @brief Список потоков и итог завершившихся потоков.
+ */
+struct StatsRegistry
+{
+    std::mutex                             mutex;
+    std::vector<ThreadCounters*>           threads;
+    std::array<StageCounters, STAGE_COUNT> retired;
+
+    std::atomic<std::uint64_t>             queue_samples{0};
+    std::atomic<std::uint64_t>             queue_depth_sum{0};
+    std::atomic<std::uint64_t>             queue_depth_peak{0};
+};
+
+/**
+ * @brief Возвращает общий список.
+ *
+ * Объект не разрушается: потоки могут завершаться и после статических
+ * деструкторов.
+ */
+static StatsRegistry& registry()
+{
+    static StatsRegistry *instance = new StatsRegistry;
+    return *instance;
+}
+
+/**
+ * @brief Прибавляет значение к счетчику своего потока (без блокировки шины).
+ */
+static inline void add(std::atomic<std::uint64_t>& counter, std::uint64_t value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Прибавляет счетчики потока к итогу по этапам.
+ */
+static void accumulate(std::array<StageCounters, STAGE_COUNT>& total, const ThreadCounters& counters)
+{
+    for (size_t stage = 0; stage < STAGE_COUNT; ++stage)
+    {
+        const auto& values = counters.values[stage];
+        total[stage].calls     += values[0].load(std::memory_order_relaxed);
+        total[stage].bytes_in  += values[1].load(std::memory_order_relaxed);
+        total[stage].bytes_out += values[2].load(std::memory_order_relaxed);
+        total[stage].wall_ns   += values[3].load(std::memory_order_relaxed);
+        total[stage].cpu_ns    += values[4].load(std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Регистрация счетчиков потока на время его жизни.
+ */
+struct ThreadSlot
+{
+    ThreadCounters counters;
+
+    ThreadSlot()
+    {
+        StatsRegistry& stats = registry();
+        std::lock_guard<std::mutex> lock(stats.mutex);
+        stats.threads.push_back(&counters);
+    }
+
+    ~ThreadSlot()
+    {
+        StatsRegistry& stats = registry();
+        std::lock_guard<std::mutex> lock(stats.mutex);
+        accumulate(stats.retired, counters);
+        stats.threads.erase(std::remove(stats.threads.begin(), stats.threads.end(), &counters), stats.threads.end());
+    }
+};
+
+/**
+ * @brief Возвращает счетчики текущего потока.
+ */
+static ThreadCounters& local_counters()
+{
+    thread_local ThreadSlot slot;
+    return slot.counters;
+}
+
+/**
+ * @brief Читает часы в наносекундах.
+ */
+static std::uint64_t clock_ns(clockid_t clock)
+{
+    struct timespec time = {0, 0};
+    clock_gettime(clock, &time);
+    return static_cast<std::uint64_t>(time.tv_sec) * 1000000000ull + static_cast<std::uint64_t>(time.tv_nsec);
+}
+
+/**
+ * @brief Вычисляет разность двух снимков.
+ *
+ * Пик глубины очереди не вычитается: это максимум с последнего
+ * JobStats::begin.
+ *
+ * @param start Снимок на начало задания.
+ * @return StatsSnapshot Счетчики задания и его длительность.
+ */
+StatsSnapshot StatsSnapshot::since(const StatsSnapshot& start) const
+{
+    StatsSnapshot delta = *this;
+
+    for (size_t stage = 0; stage < STAGE_COUNT; ++stage)
+    {
+        delta.stages[stage].calls     -= start.stages[stage].calls;
+        delta.stages[stage].bytes_in  -= start.stages[stage].bytes_in;
+        delta.stages[stage].bytes_out -= start.stages[stage].bytes_out;
+        delta.stages[stage].wall_ns   -= start.stages[stage].wall_ns;
+        delta.stages[stage].cpu_ns    -= start.stages[stage].cpu_ns;
+    }
+
+    delta.buffer_allocations -= start.buffer_allocations;
+    delta.buffer_reuses      -= start.buffer_reuses;
+    delta.queue_samples      -= start.queue_samples;
+    delta.queue_depth_sum    -= start.queue_depth_sum;
+    delta.seconds             = std::chrono::duration<double>(taken - start.taken).count();
+
+    return delta;
+}
+
+/**
+ * @brief Записывает результат вызова этапа в счетчики текущего потока.
+ *
+ * @param stage Этап.
+ * @param bytes_in Байт на входе этапа.
+ * @param bytes_out Байт на выходе этапа.
+ * @param wall_ns Время по часам (0, если не замерялось).
+ * @param cpu_ns Процессорное время потока.
+ */
+void JobStats::record(StatsStage stage, std::uint64_t bytes_in, std::uint64_t bytes_out, std::uint64_t wall_ns, std::uint64_t cpu_ns)
+{
+    auto& values = local_counters().values[stage];
+    add(values[0], 1);
+    add(values[1], bytes_in);
+    add(values[2], bytes_out);
+    add(values[3], wall_ns);
+    add(values[4], cpu_ns);
+}
+
+/**
+ * @brief Учитывает текущую глубину очереди конвейера.
+ *
+ * @param depth Число блоков, ожидающих следующего этапа.
+ */
+void JobStats::sample_queue(size_t depth)
+{
+    StatsRegistry& stats = registry();
+    stats.queue_samples.fetch_add(1, std::memory_order_relaxed);
+    stats.queue_depth_sum.fetch_add(depth, std::memory_order_relaxed);
+
+    std::uint64_t peak = stats.queue_depth_peak.load(std::memory_order_relaxed);
+    while (depth > peak && !stats.queue_depth_peak.compare_exchange_weak(peak, depth, std::memory_order_relaxed))
+    {
+    }
+}
+
+/**
+ * @brief Начинает задание: сбрасывает пик глубины очереди и возвращает снимок.
+ *
+ * @return StatsSnapshot Снимок на начало задания (для StatsSnapshot::since).
+ */
+StatsSnapshot JobStats::begin()
+{
+    registry().queue_depth_peak.store(0, std::memory_order_relaxed);
+    return snapshot();
+}
+
+/**
+ * @brief Суммирует счетчики всех потоков.
+ *
+ * Счетчики работающих потоков читаются без остановки потоков, поэтому
+ * снимок может не учитывать вызовы, которые завершаются в этот момент.
+ *
+ * @return StatsSnapshot Снимок.
+ */
+StatsSnapshot JobStats::snapshot()
+{
+    StatsSnapshot result;
+    StatsRegistry& stats = registry();
+
+    {
+        std::lock_guard<std::mutex> lock(stats.mutex);
+        result.stages = stats.retired;
+        for (const ThreadCounters *counters : stats.threads)
+        {
+            accumulate(result.stages, *counters);
+        }
+    }
+
+    result.buffer_allocations = BufferPool::instance().allocations();
+    result.buffer_reuses      = BufferPool::instance().reuses();
+    result.queue_samples      = stats.queue_samples.load(std::memory_order_relaxed);
+    result.queue_depth_sum    = stats.queue_depth_sum.load(std::memory_order_relaxed);
+    result.queue_depth_peak   = stats.queue_depth_peak.load(std::memory_order_relaxed);
+    result.taken              = std::chrono::steady_clock::now();
+
+    return result;
+}
+
+/**
+ * @brief Возвращает имя этапа для интерфейса и файла статистики.
+ */
+const char* JobStats::stage_name(StatsStage stage)
+{
+    static const char *names[STAGE_COUNT] = {"kdf", "read", "compress", "cipher", "write"};
+    return stage < STAGE_COUNT ? names[stage] : "unknown";
+}
+
+/**
+ * @brief Возвращает путь файла статистики из переменной окружения JOB_STATS_ENV.
+ *
+ * @return std::string Путь или пустая строка, если файл не нужен.
+ */
+std::string JobStats::default_path()
+{
+    const char *path = std::getenv(JOB_STATS_ENV);
+    return path ? path : "";
+}
+
+/**
+ * @brief Экранирует строку для JSON.
+ */
+static std::string json_string(const std::string& value)
+{
+    std::ostringstream stream;
+    stream << '"';
+
+    for (unsigned char c : value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            stream << '\\' << c;
+        }
+        else if (c < 0x20)
+        {
+            stream << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+        }
+        else
+        {
+            stream << c;
+        }
+    }
+
+    stream << '"';
+    return stream.str();
+}
+
+/**
+ * @brief Записывает статистику задания в файл JSON.
+ *
+ * Файл сначала пишется во временный и затем переименовывается, поэтому
+ * сборщик метрик никогда не читает его наполовину записанным. mb_per_s
+ * этапа - байты на входе за время задания, thread_mb_per_s - за время,
+ * которое потоки провели в этапе; их разница показывает, насколько этап
+ * распараллелен и какой из этапов ограничивает скорость.
+ *
+ * @param path Путь к файлу.
+ * @param report Описание задания.
+ * @param stats Счетчики задания (StatsSnapshot::since).
+ * @return bool true, если файл записан, иначе false.
+ */
+bool JobStats::write_json(const std::string& path, const JobReport& report, const StatsSnapshot& stats)
+{
+    auto rate = [](std::uint64_t bytes, double seconds)
+    {
+        return seconds > 0.0 ? static_cast<double>(bytes) / 1e6 / seconds : 0.0;
+    };
+
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(3);
+
+    stream << "{\n  \"tool\": \"ak-file-encryptor\",\n"
+           << "  \"operation\": " << json_string(report.operation) << ",\n"
+           << "  \"input\": " << json_string(report.input) << ",\n"
+           << "  \"output\": " << json_string(report.output) << ",\n"
+           << "  \"success\": " << (report.success ? "true" : "false") << ",\n"
+           << "  \"seconds\": " << stats.seconds << ",\n"
+           << "  \"bytes_in\": " << stats.stages[STAGE_READ].bytes_in << ",\n"
+           << "  \"bytes_out\": " << stats.stages[STAGE_WRITE].bytes_out << ",\n"
+           << "  \"stages\": {\n";
+
+    for (size_t i = 0; i < STAGE_COUNT; ++i)
+    {
+        const StageCounters& stage = stats.stages[i];
+        const double wall = static_cast<double>(stage.wall_ns) / 1e9;
+        const double cpu  = static_cast<double>(stage.cpu_ns) / 1e9;
+
+        stream << "    " << json_string(stage_name(static_cast<StatsStage>(i)))
+               << ": {\"calls\": " << stage.calls << ", \"bytes_in\": " << stage.bytes_in
+               << ", \"bytes_out\": " << stage.bytes_out << ", \"wall_seconds\": " << wall
+               << ", \"cpu_seconds\": " << cpu << ", \"mb_per_s\": " << rate(stage.bytes_in, stats.seconds)
+               << ", \"thread_mb_per_s\": " << rate(stage.bytes_in, wall) << "}"
+               << (i + 1 < STAGE_COUNT ? "," : "") << "\n";
+    }
+
+    const double mean_depth = stats.queue_samples
+                              ? static_cast<double>(stats.queue_depth_sum) / static_cast<double>(stats.queue_samples)
+                              : 0.0;
+
+    stream << "  },\n"
+           << "  \"buffers\": {\"allocations\": " << stats.buffer_allocations << ", \"reuses\": " << stats.buffer_reuses << "},\n"
+           << "  \"queue\": {\"samples\": " << stats.queue_samples << ", \"mean_depth\": " << mean_depth
+           << ", \"peak_depth\": " << stats.queue_depth_peak << "}\n"
+           << "}\n";
+
+    const std::string partial = path + ".tmp";
+    {
+        std::ofstream file(partial, std::ios::trunc);
+        if (!file || !(file << stream.str()) || !file.flush())
+        {
+            std::cerr << "Не удалось записать статистику: " << path << std::endl;
+            std::remove(partial.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(partial.c_str(), path.c_str()) != 0)
+    {
+        std::cerr << "Не удалось записать статистику: " << path << std::endl;
+        std::remove(partial.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Начинает замер вызова этапа.
+ *
+ * @param stage Этап.
+ * @param bytes Объем данных вызова (можно задать позже через set_input).
+ */
+StageTimer::StageTimer(StatsStage stage, size_t bytes)
+    : m_stage(stage),
+      m_bytes_in(bytes),
+      m_bytes_out(bytes),
+      m_wall_start(clock_ns(CLOCK_MONOTONIC)),
+      m_cpu_start(clock_ns(CLOCK_THREAD_CPUTIME_ID))
+{
+}
+
+/**
+ * @brief Завершает замер и записывает его в счетчики потока.
+ */
+StageTimer::~StageTimer()
+{
+    const std::uint64_t cpu_end  = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+    const std::uint64_t wall_end = clock_ns(CLOCK_MONOTONIC);
+
+    JobStats::record(m_stage, m_bytes_in, m_bytes_out, wall_end - m_wall_start, cpu_end - m_cpu_start);
+}
@@ -0,0 +1,132 @@
+/**
+ * @file       <job_stats.hpp>
+ * @brief      Хэдер счетчиков производительности заданий.
+ *
+ *             Содержит в себе объявление JobStats и StageTimer. Каждый поток
+ *             ведет собственные счетчики по этапам (выработка ключа, чтение,
+ *             сжатие, шифрование, запись): число вызовов, байты на входе
+ *             и выходе, время по часам и процессорное время потока. Счетчики
+ *             пишет только их поток, без блокировок и атомарных
+ *             read-modify-write; снимок суммирует их по всем потокам.
+ *             Разность двух снимков - статистика одного задания, которую
+ *             показывает интерфейс и записывает write_json.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef JOB_STATS_HPP
+#define JOB_STATS_HPP
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <stddef.h>
+
+#define JOB_STATS_ENV "AK_STATS_FILE"
+
+enum StatsStage
+{
+    STAGE_KDF = 0,
+    STAGE_READ,
+    STAGE_COMPRESS,
+    STAGE_CIPHER,
+    STAGE_WRITE,
+
+    STAGE_COUNT
+};
+
+/**
+ * @brief Счетчики одного этапа.
+ */
+struct StageCounters
+{
+    std::uint64_t calls     = 0;
+    std::uint64_t bytes_in  = 0;
+    std::uint64_t bytes_out = 0;
+    std::uint64_t wall_ns   = 0; ///< Сумма по потокам
+    std::uint64_t cpu_ns    = 0; ///< Сумма по потокам
+};
+
+/**
+ * @brief Снимок счетчиков всех потоков (или разность двух снимков).
+ */
+struct StatsSnapshot
+{
+    std::array<StageCounters, STAGE_COUNT> stages;
+
+    std::uint64_t buffer_allocations = 0;
+    std::uint64_t buffer_reuses      = 0;
+
+    std::uint64_t queue_samples      = 0;
+    std::uint64_t queue_depth_sum    = 0;
+    std::uint64_t queue_depth_peak   = 0; ///< Максимум с последнего JobStats::begin
+
+    std::chrono::steady_clock::time_point taken;
+    double                                seconds = 0.0; ///< Длительность (только у разности снимков)
+
+    StatsSnapshot since(const StatsSnapshot& start) const;
+};
+
+/**
+ * @brief Описание задания для файла статистики.
+ */
+struct JobReport
+{
+    std::string operation;
+    std::string input;
+    std::string output;
+    bool        success = false;
+};
+
+class JobStats
+{
+public:
+    static void record(StatsStage stage, std::uint64_t bytes_in, std::uint64_t bytes_out,
+                       std::uint64_t wall_ns = 0, std::uint64_t cpu_ns = 0);
+    static void sample_queue(size_t depth);
+
+    static StatsSnapshot begin();
+    static StatsSnapshot snapshot();
+
+    static const char* stage_name(StatsStage stage);
+    static std::string default_path();
+    static bool write_json(const std::string& path, const JobReport& report, const StatsSnapshot& stats);
+};
+
+/**
+ * @brief Замер одного вызова этапа: время по часам и процессорное время потока.
+ *
+ * Результат записывается в деструкторе. Объем на выходе по умолчанию равен
+ * объему на входе; для сжатия его задает set_output.
+ */
+class StageTimer
+{
+public:
+    explicit StageTimer(StatsStage stage, size_t bytes = 0);
+    ~StageTimer();
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+    void set_input(size_t bytes) { m_bytes_in = m_bytes_out = bytes; }
+    void set_output(size_t bytes) { m_bytes_out = bytes; }
+
+private:
+    StatsStage    m_stage;
+    std::uint64_t m_bytes_in;
+    std::uint64_t m_bytes_out;
+    std::uint64_t m_wall_start;
+    std::uint64_t m_cpu_start;
+};
+
+#endif // JOB_STATS_HPP
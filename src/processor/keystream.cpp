@@ -0,0 +1,344 @@
+/**
+ * @file       <keystream.cpp>
+ * @brief      Фоновая выработка гаммы режима OFB.
+ *
+ *             Поток KeystreamProducer шифрует нули в режиме OFB и складывает
+ *             гамму в кольцо из нескольких слотов; вызывающий поток только
+ *             накладывает ее на данные. Операция XOR выбирается один раз
+ *             по возможностям процессора (AVX-512, AVX2 или переносимая).
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "keystream.hpp"
+#include "job_stats.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define KEYSTREAM_X86
+#endif
+
+#include <libakrypt.h>
+
+typedef void (*XorBytes)(const ak_uint8 *in, const ak_uint8 *gamma, ak_uint8 *out, size_t size);
+
+/**
+ * @brief Переносимый XOR словами по 8 байт.
+ */
+static void xor_generic(const ak_uint8 *in, const ak_uint8 *gamma, ak_uint8 *out, size_t size)
+{
+    size_t i = 0;
+
+    for (; i + 8 <= size; i += 8)
+    {
+        std::uint64_t a, b;
+        std::memcpy(&a, in + i, 8);
+        std::memcpy(&b, gamma + i, 8);
+        a ^= b;
+        std::memcpy(out + i, &a, 8);
+    }
+
+    for (; i < size; ++i)
+    {
+        out[i] = in[i] ^ gamma[i];
+    }
+}
+
+#ifdef KEYSTREAM_X86
+
+__attribute__((target("avx2")))
+static void xor_avx2(const ak_uint8 *in, const ak_uint8 *gamma, ak_uint8 *out, size_t size)
+{
+    size_t i = 0;
+
+    for (; i + 128 <= size; i += 128)
+    {
+        for (size_t j = 0; j < 128; j += 32)
+        {
+            const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i + j));
+            const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(gamma + i + j));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + j), _mm256_xor_si256(a, b));
+        }
+    }
+
+    for (; i + 32 <= size; i += 32)
+    {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(gamma + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_xor_si256(a, b));
+    }
+
+    xor_generic(in + i, gamma + i, out + i, size - i);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void xor_avx512(const ak_uint8 *in, const ak_uint8 *gamma, ak_uint8 *out, size_t size)
+{
+    size_t i = 0;
+
+    for (; i + 256 <= size; i += 256)
+    {
+        for (size_t j = 0; j < 256; j += 64)
+        {
+            const __m512i a = _mm512_loadu_si512(in + i + j);
+            const __m512i b = _mm512_loadu_si512(gamma + i + j);
+            _mm512_storeu_si512(out + i + j, _mm512_xor_si512(a, b));
+        }
+    }
+
+    // Хвост меньше 256 байт - маскированными операциями, без скалярного цикла
+    for (; i < size; i += 64)
+    {
+        const size_t    rest = size - i;
+        const __mmask64 mask = rest >= 64 ? ~__mmask64(0) : (__mmask64(1) << rest) - 1;
+        const __m512i   a    = _mm512_maskz_loadu_epi8(mask, in + i);
+        const __m512i   b    = _mm512_maskz_loadu_epi8(mask, gamma + i);
+        _mm512_mask_storeu_epi8(out + i, mask, _mm512_xor_si512(a, b));
+    }
+}
+
+#endif
+
+/**
+ * @brief Выбирает реализацию XOR по возможностям процессора.
+ */
+static XorBytes select_xor()
+{
+#ifdef KEYSTREAM_X86
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+    {
+        return xor_avx512;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return xor_avx2;
+    }
+#endif
+    return xor_generic;
+}
+
+/**
+ * @brief Накладывает гамму на данные: out = in ^ gamma.
+ *
+ * @param in Входные данные.
+ * @param gamma Гамма.
+ * @param out Буфер для результата (может совпадать с in).
+ * @param size Длина в байтах.
+ */
+void KeystreamProducer::xor_bytes(const ak_uint8 *in, const ak_uint8 *gamma, ak_uint8 *out, size_t size)
+{
+    static const XorBytes implementation = select_xor();
+    implementation(in, gamma, out, size);
+}
+
+/**
+ * @brief Запускает выработку гаммы для данных длиной total_size.
+ *
+ * Для небольших данных поток не нужен: гамма вырабатывается быстрее, чем
+ * создается поток, и функция возвращает пустой указатель - вызывающий код
+ * шифрует как обычно. Пока производитель работает, ключ используется
+ * только им, и вызывающий код не должен обращаться к ключу.
+ *
+ * @param key Ключ.
+ * @param iv Синхропосылка (как у ak_bckey_ofb).
+ * @param iv_size Длина синхропосылки.
+ * @param total_size Ожидаемая длина данных (если данных окажется больше, гамма вырабатывается дальше).
+ * @param slot_size Размер слота кольца, кратный длине блока.
+ * @param depth Количество слотов.
+ * @return std::unique_ptr<KeystreamProducer> Производитель или nullptr.
+ */
+std::unique_ptr<KeystreamProducer> KeystreamProducer::start(struct bckey *key,
+                                                            const ak_uint8 *iv,
+                                                            size_t iv_size,
+                                                            size_t total_size,
+                                                            size_t slot_size,
+                                                            size_t depth)
+{
+    if (total_size < KEYSTREAM_MIN_SIZE || slot_size == 0 || depth < 2)
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<KeystreamProducer> producer(
+        new KeystreamProducer(key, iv, iv_size, slot_size, (total_size + slot_size - 1) / slot_size));
+
+    producer->m_zeros = BufferPool::instance().acquire(slot_size);
+    if (!producer->m_zeros)
+    {
+        return nullptr;
+    }
+    std::memset(producer->m_zeros.data(), 0, slot_size);
+
+    for (size_t i = 0; i < depth; ++i)
+    {
+        producer->m_slots.push_back(BufferPool::instance().acquire(slot_size));
+        if (!producer->m_slots.back())
+        {
+            return nullptr;
+        }
+    }
+
+    producer->m_thread = std::thread([raw = producer.get()]() { raw->run(); });
+    return producer;
+}
+
+KeystreamProducer::KeystreamProducer(struct bckey *key, const ak_uint8 *iv, size_t iv_size, size_t slot_size, size_t limit)
+    : m_key(key), m_iv(iv, iv + iv_size), m_slot_size(slot_size), m_limit(limit)
+{
+}
+
+/**
+ * @brief Останавливает поток и затирает оставшуюся гамму.
+ */
+KeystreamProducer::~KeystreamProducer()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+    }
+    m_condition.notify_all();
+
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+
+    for (auto& slot : m_slots)
+    {
+        if (slot)
+        {
+            explicit_bzero(slot.data(), m_slot_size);
+        }
+    }
+}
+
+/**
+ * @brief Цикл потока: вырабатывает слоты, пока кольцо не заполнено.
+ *
+ * Каждый слот - продолжение гаммы предыдущего (синхропосылка передается
+ * только для первого), поэтому гамма совпадает с гаммой одного вызова
+ * ak_bckey_ofb для всех данных.
+ */
+void KeystreamProducer::run()
+{
+    const size_t depth = m_slots.size();
+
+    for (size_t index = 0; ; ++index)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [&]() { return m_stopped || (index < m_limit && index - m_consumed < depth); });
+            if (m_stopped)
+            {
+                return;
+            }
+        }
+
+        const bool first_slot = (index == 0);
+        int error = ak_error_ok;
+
+        {
+            // Объем учитывает вызывающий поток при наложении гаммы, здесь - только время
+            StageTimer timer(STAGE_CIPHER, 0);
+            error = ak_bckey_ofb(m_key,
+                                 m_zeros.data(),
+                                 m_slots[index % depth].data(),
+                                 m_slot_size,
+                                 first_slot ? m_iv.data() : nullptr,
+                                 first_slot ? m_iv.size() : 0);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (error != ak_error_ok)
+            {
+                std::cerr << "Выработка гаммы не удалась: " << error << std::endl;
+                m_failed = true;
+            }
+            else
+            {
+                m_produced = index + 1;
+            }
+        }
+        m_condition.notify_all();
+
+        if (error != ak_error_ok)
+        {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Зашифровывает или расшифровывает следующую порцию данных.
+ *
+ * Порции обрабатываются по порядку, как при последовательных вызовах
+ * ak_bckey_ofb; их длина может быть любой. Если гамма еще не готова,
+ * функция ждет производителя.
+ *
+ * @param in Входные данные.
+ * @param out Буфер для результата (может совпадать с in).
+ * @param size Длина порции.
+ * @return bool false, если выработка гаммы не удалась.
+ */
+bool KeystreamProducer::apply(const ak_uint8 *in, ak_uint8 *out, size_t size)
+{
+    const size_t depth = m_slots.size();
+
+    while (size > 0)
+    {
+        size_t index = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            index = m_consumed;
+
+            if (index >= m_limit)
+            {
+                m_limit = index + 1;
+                m_condition.notify_all();
+            }
+
+            m_condition.wait(lock, [&]() { return m_failed || m_produced > index; });
+            if (m_failed)
+            {
+                return false;
+            }
+        }
+
+        const size_t bytes = std::min(size, m_slot_size - m_offset);
+        xor_bytes(in, m_slots[index % depth].data() + m_offset, out, bytes);
+
+        in       += bytes;
+        out      += bytes;
+        size     -= bytes;
+        m_offset += bytes;
+
+        if (m_offset == m_slot_size)
+        {
+            m_offset = 0;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ++m_consumed;
+            }
+            m_condition.notify_all();
+        }
+    }
+
+    return true;
+}
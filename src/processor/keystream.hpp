@@ -0,0 +1,82 @@
+/**
+ * @file       <keystream.hpp>
+ * @brief      Хэдер фоновой выработки гаммы режима OFB.
+ *
+ *             Содержит в себе объявление KeystreamProducer. В режиме OFB гамма
+ *             не зависит от открытого текста, поэтому отдельный поток
+ *             вырабатывает ее заранее в кольцевой буфер, пока файл еще
+ *             читается. На основном пути остается только наложение гаммы
+ *             (векторная операция XOR), и время шифрования прячется за
+ *             временем чтения.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef KEYSTREAM_HPP
+#define KEYSTREAM_HPP
+
+#include "buffer_pool.hpp"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stddef.h>
+
+#define KEYSTREAM_DEPTH    4
+#define KEYSTREAM_MIN_SIZE (4 << 20)
+
+class KeystreamProducer
+{
+public:
+    static std::unique_ptr<KeystreamProducer> start(struct bckey *key,
+                                                    const ak_uint8 *iv,
+                                                    size_t iv_size,
+                                                    size_t total_size,
+                                                    size_t slot_size,
+                                                    size_t depth = KEYSTREAM_DEPTH);
+
+    ~KeystreamProducer();
+
+    KeystreamProducer(const KeystreamProducer&) = delete;
+    KeystreamProducer& operator=(const KeystreamProducer&) = delete;
+
+    bool apply(const ak_uint8 *in, ak_uint8 *out, size_t size);
+
+    static void xor_bytes(const ak_uint8 *in, const ak_uint8 *gamma, ak_uint8 *out, size_t size);
+
+private:
+    KeystreamProducer(struct bckey *key, const ak_uint8 *iv, size_t iv_size, size_t slot_size, size_t limit);
+
+    void run();
+
+private:
+    struct bckey                *m_key;
+    std::vector<ak_uint8>        m_iv;
+    size_t                       m_slot_size;
+    std::vector<PooledBuffer>    m_slots;
+    PooledBuffer                 m_zeros;    ///< Открытый текст для выработки гаммы
+
+    std::mutex                   m_mutex;
+    std::condition_variable      m_condition;
+    size_t                       m_produced = 0; ///< Слотов выработано
+    size_t                       m_consumed = 0; ///< Слотов использовано полностью
+    size_t                       m_limit    = 0; ///< Сколько слотов вырабатывать (растет по запросу apply)
+    bool                         m_failed   = false;
+    bool                         m_stopped  = false;
+
+    size_t                       m_offset   = 0; ///< Позиция в текущем слоте (только поток apply)
+    std::thread                  m_thread;
+};
+
+#endif // KEYSTREAM_HPP
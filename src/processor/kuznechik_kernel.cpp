@@ -0,0 +1,943 @@
+/**
+ * @file       <kuznechik_kernel.cpp>
+ * @brief      Основной файл векторной реализации шифра Кузнечик (ГОСТ Р 34.12-2015).
+ *
+ *             Раунд Кузнечика - это сложение с ключом, подстановка pi и линейное
+ *             преобразование L. Переносимый вариант и вариант SSE4.1
+ *             выполняют подстановку и L одной таблицей: LS(x) равно сумме
+ *             шестнадцати строк таблицы, выбранных байтами x. Вариант AVX-512
+ *             обходится без таблиц строк: состояние переводится в поле AES
+ *             и разрезается по байтам (регистр хранит i-е байты 64 блоков),
+ *             подстановка выполняется инструкцией VPERMB, а умножения в L -
+ *             инструкцией GF2P8MULB.
+ *
+ *             Каждый вариант при выборе проверяется на контрольном примере
+ *             из стандарта, непрошедший вариант не используется.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "kuznechik_kernel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define KUZNECHIK_X86
+#endif
+
+typedef void (*EncryptBlocks)(const ak_uint8 (*keys)[KUZNECHIK_BLOCK_SIZE],
+                              const ak_uint8 (*keys_gf)[KUZNECHIK_BLOCK_SIZE],
+                              const ak_uint8 *in,
+                              ak_uint8 *out,
+                              size_t blocks);
+
+/**
+ * @brief Вариант реализации шифрования блоков.
+ */
+struct KernelVariant
+{
+    const char    *name;
+    EncryptBlocks  encrypt;
+    bool         (*supported)();
+    bool           passed;
+};
+
+/**
+ * @brief Таблицы, общие для всех ключей.
+ */
+struct KuznechikTables
+{
+    alignas(64) ak_uint8 ls[KUZNECHIK_BLOCK_SIZE][256][KUZNECHIK_BLOCK_SIZE]; ///< Строки LS-преобразования
+    alignas(64) ak_uint8 constants[32][KUZNECHIK_BLOCK_SIZE];                ///< Итерационные константы C_i
+    alignas(64) ak_uint8 sbox_gf[256];                                       ///< Подстановка pi в поле AES
+    alignas(64) ak_uint8 to_gf[256];                                         ///< Изоморфизм в поле AES
+    alignas(64) ak_uint8 from_gf[256];                                       ///< Обратный изоморфизм
+    alignas(64) ak_uint8 columns_gf[KUZNECHIK_BLOCK_SIZE][KUZNECHIK_BLOCK_SIZE]; ///< Столбцы матрицы L в поле AES
+    alignas(64) ak_uint8 matrix_gf[KUZNECHIK_BLOCK_SIZE][KUZNECHIK_BLOCK_SIZE][64]; ///< Элементы матрицы L, размноженные на регистр
+};
+
+static const ak_uint8 pi[256] = {
+    252, 238, 221,  17, 207, 110,  49,  22, 251, 196, 250, 218,  35, 197,   4,  77,
+    233, 119, 240, 219, 147,  46, 153, 186,  23,  54, 241, 187,  20, 205,  95, 193,
+    249,  24, 101,  90, 226,  92, 239,  33, 129,  28,  60,  66, 139,   1, 142,  79,
+      5, 132,   2, 174, 227, 106, 143, 160,   6,  11, 237, 152, 127, 212, 211,  31,
+    235,  52,  44,  81, 234, 200,  72, 171, 242,  42, 104, 162, 253,  58, 206, 204,
+    181, 112,  14,  86,   8,  12, 118,  18, 191, 114,  19,  71, 156, 183,  93, 135,
+     21, 161, 150,  41,  16, 123, 154, 199, 243, 145, 120, 111, 157, 158, 178, 177,
+     50, 117,  25,  61, 255,  53, 138, 126, 109,  84, 198, 128, 195, 189,  13,  87,
+    223, 245,  36, 169,  62, 168,  67, 201, 215, 121, 214, 246, 124,  34, 185,   3,
+    224,  15, 236, 222, 122, 148, 176, 188, 220, 232,  40,  80,  78,  51,  10,  74,
+    167, 151,  96, 115,  30,   0,  98,  68,  26, 184,  56, 130, 100, 159,  38,  65,
+    173,  69,  70, 146,  39,  94,  85,  47, 140, 163, 165, 125, 105, 213, 149,  59,
+      7,  88, 179,  64, 134, 172,  29, 247,  48,  55, 107, 228, 136, 217, 231, 137,
+    225,  27, 131,  73,  76,  63, 248, 254, 141,  83, 170, 144, 202, 216, 133,  97,
+     32, 113, 103, 164,  45,  43,   9,  91, 203, 155,  37, 208, 190, 229, 108,  82,
+     89, 166, 116, 210, 230, 244, 180, 192, 209, 102, 175, 194,  57,  75,  99, 182
+};
+
+/** Коэффициенты линейной функции l при байтах a_0 ... a_15 */
+static const ak_uint8 l_coefficients[KUZNECHIK_BLOCK_SIZE] = {
+    1, 148, 32, 133, 16, 194, 192, 1, 251, 1, 192, 194, 16, 133, 32, 148
+};
+
+static KuznechikTables g_tables;
+static std::once_flag  g_tables_once;
+
+/**
+ * @brief Умножает элементы поля GF(2^8).
+ *
+ * @param a Первый множитель.
+ * @param b Второй множитель.
+ * @param poly Младший байт неприводимого многочлена (0xC3 для Кузнечика, 0x1B для AES).
+ * @return ak_uint8 Произведение.
+ */
+static ak_uint8 gf_mul(ak_uint8 a, ak_uint8 b, ak_uint8 poly)
+{
+    ak_uint8 result = 0;
+
+    while (b)
+    {
+        if (b & 1)
+        {
+            result ^= a;
+        }
+        a = static_cast<ak_uint8>((a & 0x80) ? ((a << 1) ^ poly) : (a << 1));
+        b >>= 1;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Выполняет линейное преобразование L (шестнадцать шагов R) на месте.
+ *
+ * @param block Блок в порядке libakrypt (a_0 первым).
+ */
+static void apply_l(ak_uint8 *block)
+{
+    for (int step = 0; step < KUZNECHIK_BLOCK_SIZE; ++step)
+    {
+        ak_uint8 sum = 0;
+        for (int i = 0; i < KUZNECHIK_BLOCK_SIZE; ++i)
+        {
+            sum ^= gf_mul(block[i], l_coefficients[i], 0xC3);
+        }
+
+        std::memmove(block, block + 1, KUZNECHIK_BLOCK_SIZE - 1);
+        block[KUZNECHIK_BLOCK_SIZE - 1] = sum;
+    }
+}
+
+/**
+ * @brief Заполняет общие таблицы.
+ *
+ * Изоморфизм в поле AES задается образом элемента x - корнем многочлена
+ * Кузнечика x^8 + x^7 + x^6 + x + 1 в поле AES; он находится перебором.
+ */
+static void build_tables()
+{
+    for (int i = 0; i < KUZNECHIK_BLOCK_SIZE; ++i)
+    {
+        for (int b = 0; b < 256; ++b)
+        {
+            ak_uint8 row[KUZNECHIK_BLOCK_SIZE] = {0};
+            row[i] = pi[b];
+            apply_l(row);
+            std::memcpy(g_tables.ls[i][b], row, sizeof(row));
+        }
+    }
+
+    for (int i = 0; i < 32; ++i)
+    {
+        ak_uint8 constant[KUZNECHIK_BLOCK_SIZE] = {0};
+        constant[0] = static_cast<ak_uint8>(i + 1);
+        apply_l(constant);
+        std::memcpy(g_tables.constants[i], constant, sizeof(constant));
+    }
+
+    ak_uint8 root = 0;
+    for (int candidate = 2; candidate < 256 && !root; ++candidate)
+    {
+        const ak_uint8 c = static_cast<ak_uint8>(candidate);
+        ak_uint8 power[9] = {1};
+        for (int k = 1; k <= 8; ++k)
+        {
+            power[k] = gf_mul(power[k - 1], c, 0x1B);
+        }
+        if ((power[8] ^ power[7] ^ power[6] ^ power[1] ^ power[0]) == 0)
+        {
+            root = c;
+        }
+    }
+
+    for (int a = 0; a < 256; ++a)
+    {
+        ak_uint8 image = 0;
+        ak_uint8 power = 1;
+        for (int k = 0; k < 8; ++k)
+        {
+            if (a & (1 << k))
+            {
+                image ^= power;
+            }
+            power = gf_mul(power, root, 0x1B);
+        }
+        g_tables.to_gf[a] = image;
+        g_tables.from_gf[image] = static_cast<ak_uint8>(a);
+    }
+
+    for (int y = 0; y < 256; ++y)
+    {
+        g_tables.sbox_gf[y] = g_tables.to_gf[pi[g_tables.from_gf[y]]];
+    }
+
+    for (int i = 0; i < KUZNECHIK_BLOCK_SIZE; ++i)
+    {
+        ak_uint8 column[KUZNECHIK_BLOCK_SIZE] = {0};
+        column[i] = 1;
+        apply_l(column);
+        for (int j = 0; j < KUZNECHIK_BLOCK_SIZE; ++j)
+        {
+            g_tables.columns_gf[i][j] = g_tables.to_gf[column[j]];
+            std::memset(g_tables.matrix_gf[j][i], g_tables.columns_gf[i][j], sizeof(g_tables.matrix_gf[j][i]));
+        }
+    }
+}
+
+/**
+ * @brief Возвращает общие таблицы, заполняя их при первом обращении.
+ *
+ * @return const KuznechikTables& Таблицы.
+ */
+static const KuznechikTables& tables()
+{
+    std::call_once(g_tables_once, build_tables);
+    return g_tables;
+}
+
+/**
+ * @brief Выполняет LS-преобразование через таблицу (переносимый вариант).
+ *
+ * @param in Входной блок.
+ * @param out Результат (может совпадать с in).
+ */
+static void ls_generic(const ak_uint8 *in, ak_uint8 *out)
+{
+    std::uint64_t lo = 0;
+    std::uint64_t hi = 0;
+
+    for (int i = 0; i < KUZNECHIK_BLOCK_SIZE; ++i)
+    {
+        std::uint64_t row[2];
+        std::memcpy(row, g_tables.ls[i][in[i]], sizeof(row));
+        lo ^= row[0];
+        hi ^= row[1];
+    }
+
+    std::memcpy(out, &lo, sizeof(lo));
+    std::memcpy(out + sizeof(lo), &hi, sizeof(hi));
+}
+
+/**
+ * @brief Разворачивает ключ в раундовые ключи.
+ *
+ * @param key Ключ (KUZNECHIK_KEY_SIZE байт, младший байт первым).
+ * @param keys Раундовые ключи.
+ * @param keys_gf Раундовые ключи в представлении поля AES.
+ */
+static void expand_key(const ak_uint8 *key,
+                       ak_uint8 (*keys)[KUZNECHIK_BLOCK_SIZE],
+                       ak_uint8 (*keys_gf)[KUZNECHIK_BLOCK_SIZE])
+{
+    const KuznechikTables& t = tables();
+    ak_uint8 left[KUZNECHIK_BLOCK_SIZE];
+    ak_uint8 right[KUZNECHIK_BLOCK_SIZE];
+
+    std::memcpy(left, key + KUZNECHIK_BLOCK_SIZE, KUZNECHIK_BLOCK_SIZE);
+    std::memcpy(right, key, KUZNECHIK_BLOCK_SIZE);
+    std::memcpy(keys[0], left, KUZNECHIK_BLOCK_SIZE);
+    std::memcpy(keys[1], right, KUZNECHIK_BLOCK_SIZE);
+
+    for (int i = 0; i < 32; ++i)
+    {
+        ak_uint8 next[KUZNECHIK_BLOCK_SIZE];
+        for (int j = 0; j < KUZNECHIK_BLOCK_SIZE; ++j)
+        {
+            next[j] = left[j] ^ t.constants[i][j];
+        }
+        ls_generic(next, next);
+        for (int j = 0; j < KUZNECHIK_BLOCK_SIZE; ++j)
+        {
+            next[j] ^= right[j];
+        }
+
+        std::memcpy(right, left, KUZNECHIK_BLOCK_SIZE);
+        std::memcpy(left, next, KUZNECHIK_BLOCK_SIZE);
+
+        if ((i + 1) % 8 == 0)
+        {
+            std::memcpy(keys[(i + 1) / 4], left, KUZNECHIK_BLOCK_SIZE);
+            std::memcpy(keys[(i + 1) / 4 + 1], right, KUZNECHIK_BLOCK_SIZE);
+        }
+    }
+
+    for (int r = 0; r < KUZNECHIK_ROUND_KEYS; ++r)
+    {
+        for (int j = 0; j < KUZNECHIK_BLOCK_SIZE; ++j)
+        {
+            keys_gf[r][j] = t.to_gf[keys[r][j]];
+        }
+    }
+
+    explicit_bzero(left, sizeof(left));
+    explicit_bzero(right, sizeof(right));
+}
+
+/**
+ * @brief Шифрует блоки переносимым вариантом.
+ */
+static void encrypt_generic(const ak_uint8 (*keys)[KUZNECHIK_BLOCK_SIZE],
+                            const ak_uint8 (*)[KUZNECHIK_BLOCK_SIZE],
+                            const ak_uint8 *in,
+                            ak_uint8 *out,
+                            size_t blocks)
+{
+    for (size_t b = 0; b < blocks; ++b, in += KUZNECHIK_BLOCK_SIZE, out += KUZNECHIK_BLOCK_SIZE)
+    {
+        ak_uint8 state[KUZNECHIK_BLOCK_SIZE];
+
+        for (int j = 0; j < KUZNECHIK_BLOCK_SIZE; ++j)
+        {
+            state[j] = in[j] ^ keys[0][j];
+        }
+
+        for (int r = 1; r < KUZNECHIK_ROUND_KEYS; ++r)
+        {
+            ls_generic(state, state);
+            for (int j = 0; j < KUZNECHIK_BLOCK_SIZE; ++j)
+            {
+                state[j] ^= keys[r][j];
+            }
+        }
+
+        std::memcpy(out, state, KUZNECHIK_BLOCK_SIZE);
+    }
+}
+
+static bool supported_generic()
+{
+    return true;
+}
+
+#ifdef KUZNECHIK_X86
+
+/** Строка таблицы ls[index] по смещению offset (значение байта, умноженное на 16) */
+#define KUZNECHIK_ROW(table, index, offset) \
+    (reinterpret_cast<const ak_uint8*>(table) + (index) * 256 * KUZNECHIK_BLOCK_SIZE + (offset))
+
+/**
+ * @brief LS-преобразование блока в регистре SSE.
+ *
+ * Смещение строки для байта 2j лежит в 16-битном слове j вектора lo,
+ * для байта 2j+1 - в слове j вектора hi.
+ */
+__attribute__((target("sse4.1")))
+static inline __m128i ls_sse41(__m128i x)
+{
+    const __m128i mask = _mm_set1_epi16(0x0ff0);
+    const __m128i lo = _mm_and_si128(_mm_slli_epi16(x, 4), mask);
+    const __m128i hi = _mm_and_si128(_mm_srli_epi16(x, 4), mask);
+    const ak_uint8 *t = &g_tables.ls[0][0][0];
+
+#define KUZNECHIK_SSE_PAIR(j) \
+    _mm_xor_si128(_mm_load_si128(reinterpret_cast<const __m128i*>(KUZNECHIK_ROW(t, 2 * (j), _mm_extract_epi16(lo, j)))), \
+                  _mm_load_si128(reinterpret_cast<const __m128i*>(KUZNECHIK_ROW(t, 2 * (j) + 1, _mm_extract_epi16(hi, j)))))
+
+    const __m128i r01 = _mm_xor_si128(KUZNECHIK_SSE_PAIR(0), KUZNECHIK_SSE_PAIR(1));
+    const __m128i r23 = _mm_xor_si128(KUZNECHIK_SSE_PAIR(2), KUZNECHIK_SSE_PAIR(3));
+    const __m128i r45 = _mm_xor_si128(KUZNECHIK_SSE_PAIR(4), KUZNECHIK_SSE_PAIR(5));
+    const __m128i r67 = _mm_xor_si128(KUZNECHIK_SSE_PAIR(6), KUZNECHIK_SSE_PAIR(7));
+
+#undef KUZNECHIK_SSE_PAIR
+#undef KUZNECHIK_ROW
+
+    return _mm_xor_si128(_mm_xor_si128(r01, r23), _mm_xor_si128(r45, r67));
+}
+
+/**
+ * @brief Шифрует блоки с SSE4.1: по четыре независимых блока за итерацию.
+ */
+__attribute__((target("sse4.1")))
+static void encrypt_sse41(const ak_uint8 (*keys)[KUZNECHIK_BLOCK_SIZE],
+                          const ak_uint8 (*)[KUZNECHIK_BLOCK_SIZE],
+                          const ak_uint8 *in,
+                          ak_uint8 *out,
+                          size_t blocks)
+{
+    __m128i k[KUZNECHIK_ROUND_KEYS];
+    for (int r = 0; r < KUZNECHIK_ROUND_KEYS; ++r)
+    {
+        k[r] = _mm_load_si128(reinterpret_cast<const __m128i*>(keys[r]));
+    }
+
+    const __m128i *src = reinterpret_cast<const __m128i*>(in);
+    __m128i *dst = reinterpret_cast<__m128i*>(out);
+    size_t b = 0;
+
+    for (; b + 4 <= blocks; b += 4)
+    {
+        __m128i x0 = _mm_xor_si128(_mm_loadu_si128(src + b),     k[0]);
+        __m128i x1 = _mm_xor_si128(_mm_loadu_si128(src + b + 1), k[0]);
+        __m128i x2 = _mm_xor_si128(_mm_loadu_si128(src + b + 2), k[0]);
+        __m128i x3 = _mm_xor_si128(_mm_loadu_si128(src + b + 3), k[0]);
+
+        for (int r = 1; r < KUZNECHIK_ROUND_KEYS; ++r)
+        {
+            x0 = _mm_xor_si128(ls_sse41(x0), k[r]);
+            x1 = _mm_xor_si128(ls_sse41(x1), k[r]);
+            x2 = _mm_xor_si128(ls_sse41(x2), k[r]);
+            x3 = _mm_xor_si128(ls_sse41(x3), k[r]);
+        }
+
+        _mm_storeu_si128(dst + b,     x0);
+        _mm_storeu_si128(dst + b + 1, x1);
+        _mm_storeu_si128(dst + b + 2, x2);
+        _mm_storeu_si128(dst + b + 3, x3);
+    }
+
+    for (; b < blocks; ++b)
+    {
+        __m128i x = _mm_xor_si128(_mm_loadu_si128(src + b), k[0]);
+        for (int r = 1; r < KUZNECHIK_ROUND_KEYS; ++r)
+        {
+            x = _mm_xor_si128(ls_sse41(x), k[r]);
+        }
+        _mm_storeu_si128(dst + b, x);
+    }
+}
+
+static bool supported_sse41()
+{
+    return __builtin_cpu_supports("sse4.1");
+}
+
+/**
+ * Для распаковки и размножения 32/64-битных элементов используются варианты
+ * maskz с полной маской: на обычные интринсики GCC 12 выдает ложное
+ * предупреждение -Wmaybe-uninitialized, а код получается тот же.
+ */
+#define KUZNECHIK_AVX512_TARGET __attribute__((target("avx512f,avx512bw,avx512vbmi,gfni")))
+
+/** Блоков в одном побайтно разрезанном пакете: 16 регистров по 4 блока */
+#define KUZNECHIK_SLICE_BLOCKS 64
+
+/**
+ * @brief Подстановка байтов по таблице из 256 элементов (четыре регистра).
+ */
+KUZNECHIK_AVX512_TARGET
+static inline __m512i lookup_avx512(__m512i x, const __m512i *table)
+{
+    const __m512i low  = _mm512_permutex2var_epi8(table[0], x, table[1]);
+    const __m512i high = _mm512_permutex2var_epi8(table[2], x, table[3]);
+    return _mm512_mask_blend_epi8(_mm512_movepi8_mask(x), low, high);
+}
+
+/**
+ * @brief Транспонирует матрицы 16x16 байт в каждой 128-битной полосе регистров.
+ *
+ * Четыре шага чередования строк p и p+8 переводят байт c строки r в байт
+ * rev(r) строки c, где rev - обращение порядка четырех битов номера.
+ *
+ * @param x Шестнадцать регистров (строки матрицы).
+ */
+KUZNECHIK_AVX512_TARGET
+static inline void transpose_avx512(__m512i *x)
+{
+    __m512i t[KUZNECHIK_BLOCK_SIZE];
+
+    for (int p = 0; p < 8; ++p)
+    {
+        t[2 * p]     = _mm512_unpacklo_epi8(x[p], x[p + 8]);
+        t[2 * p + 1] = _mm512_unpackhi_epi8(x[p], x[p + 8]);
+    }
+    for (int p = 0; p < 8; ++p)
+    {
+        x[2 * p]     = _mm512_unpacklo_epi16(t[p], t[p + 8]);
+        x[2 * p + 1] = _mm512_unpackhi_epi16(t[p], t[p + 8]);
+    }
+    for (int p = 0; p < 8; ++p)
+    {
+        t[2 * p]     = _mm512_maskz_unpacklo_epi32(0xffff, x[p], x[p + 8]);
+        t[2 * p + 1] = _mm512_maskz_unpackhi_epi32(0xffff, x[p], x[p + 8]);
+    }
+    for (int p = 0; p < 8; ++p)
+    {
+        x[2 * p]     = _mm512_maskz_unpacklo_epi64(0xff, t[p], t[p + 8]);
+        x[2 * p + 1] = _mm512_maskz_unpackhi_epi64(0xff, t[p], t[p + 8]);
+    }
+}
+
+static inline int reverse_nibble(int value)
+{
+    return ((value & 1) << 3) | ((value & 2) << 1) | ((value & 4) >> 1) | ((value & 8) >> 3);
+}
+
+/**
+ * @brief Шифрует пакет из KUZNECHIK_SLICE_BLOCKS блоков в побайтно разрезанном виде.
+ *
+ * После транспонирования регистр i содержит i-е байты всех 64 блоков.
+ * Подстановка выполняется для каждого регистра целиком, а байт j
+ * результата L - сумма произведений регистров на элементы матрицы L,
+ * поэтому на раунд приходится 256 умножений на 64 блока вместо 256
+ * умножений на 16 блоков при обработке блоков по полосам.
+ *
+ * @param keys Раундовые ключи в поле AES, каждый байт размножен на регистр.
+ * @param tables Подстановки (sbox, to_gf, from_gf по четыре регистра).
+ * @param in Открытый текст.
+ * @param out Результат.
+ */
+KUZNECHIK_AVX512_TARGET
+static void encrypt_slices_avx512(const ak_uint8 (*keys)[KUZNECHIK_BLOCK_SIZE][64],
+                                  const __m512i *sbox,
+                                  const __m512i *to_gf,
+                                  const __m512i *from_gf,
+                                  const ak_uint8 *in,
+                                  ak_uint8 *out)
+{
+    __m512i x[KUZNECHIK_BLOCK_SIZE];
+
+    for (int r = 0; r < KUZNECHIK_BLOCK_SIZE; ++r)
+    {
+        x[r] = _mm512_loadu_si512(in + r * 64);
+    }
+
+    transpose_avx512(x);
+
+    for (int i = 0; i < KUZNECHIK_BLOCK_SIZE; ++i)
+    {
+        x[i] = _mm512_xor_si512(lookup_avx512(x[i], to_gf), _mm512_load_si512(keys[0][i]));
+    }
+
+    for (int r = 1; r < KUZNECHIK_ROUND_KEYS; ++r)
+    {
+        __m512i s[KUZNECHIK_BLOCK_SIZE];
+
+        for (int i = 0; i < KUZNECHIK_BLOCK_SIZE; ++i)
+        {
+            s[i] = lookup_avx512(x[i], sbox);
+        }
+
+        for (int j = 0; j < KUZNECHIK_BLOCK_SIZE; ++j)
+        {
+            const ak_uint8 (*row)[64] = g_tables.matrix_gf[j];
+            __m512i sum = _mm512_load_si512(keys[r][j]);
+
+            // Сложение трех слагаемых - одна инструкция VPTERNLOGQ (0x96 - исключающее ИЛИ)
+            for (int i = 0; i < KUZNECHIK_BLOCK_SIZE; i += 2)
+            {
+                sum = _mm512_ternarylogic_epi64(sum,
+                                                _mm512_gf2p8mul_epi8(s[i], _mm512_load_si512(row[i])),
+                                                _mm512_gf2p8mul_epi8(s[i + 1], _mm512_load_si512(row[i + 1])),
+                                                0x96);
+            }
+            x[j] = sum;
+        }
+    }
+
+    __m512i y[KUZNECHIK_BLOCK_SIZE];
+
+    for (int i = 0; i < KUZNECHIK_BLOCK_SIZE; ++i)
+    {
+        y[reverse_nibble(i)] = lookup_avx512(x[i], from_gf);
+    }
+
+    transpose_avx512(y);
+
+    for (int r = 0; r < KUZNECHIK_BLOCK_SIZE; ++r)
+    {
+        _mm512_storeu_si512(out + reverse_nibble(r) * 64, y[r]);
+    }
+}
+
+/**
+ * @brief Шифрует до четырех блоков в одном регистре (блок на полосу).
+ *
+ * @param x Регистр с блоками в поле AES.
+ * @param keys Раундовые ключи в поле AES.
+ * @param sbox Подстановка pi в поле AES.
+ * @return __m512i Результат в поле AES.
+ */
+KUZNECHIK_AVX512_TARGET
+static inline __m512i encrypt_lanes_avx512(__m512i x, const ak_uint8 (*keys)[KUZNECHIK_BLOCK_SIZE], const __m512i *sbox)
+{
+    for (int r = 0; r < KUZNECHIK_ROUND_KEYS - 1; ++r)
+    {
+        const __m512i key = _mm512_maskz_broadcast_i32x4(0xffff, _mm_load_si128(reinterpret_cast<const __m128i*>(keys[r])));
+        const __m512i s = lookup_avx512(_mm512_xor_si512(x, key), sbox);
+        __m512i sum = _mm512_setzero_si512();
+
+        for (int j = 0; j < KUZNECHIK_BLOCK_SIZE; ++j)
+        {
+            const __m512i column = _mm512_maskz_broadcast_i32x4(0xffff, _mm_load_si128(reinterpret_cast<const __m128i*>(g_tables.columns_gf[j])));
+            sum = _mm512_xor_si512(sum, _mm512_gf2p8mul_epi8(_mm512_shuffle_epi8(s, _mm512_set1_epi8(static_cast<char>(j))), column));
+        }
+
+        x = sum;
+    }
+
+    const __m512i key = _mm512_maskz_broadcast_i32x4(0xffff, _mm_load_si128(reinterpret_cast<const __m128i*>(keys[KUZNECHIK_ROUND_KEYS - 1])));
+    return _mm512_xor_si512(x, key);
+}
+
+/**
+ * @brief Шифрует блоки с AVX-512 (VBMI и GFNI).
+ *
+ * Полные пакеты по KUZNECHIK_SLICE_BLOCKS блоков шифруются в побайтно
+ * разрезанном виде, остаток - по четыре блока в регистре.
+ */
+KUZNECHIK_AVX512_TARGET
+static void encrypt_avx512(const ak_uint8 (*)[KUZNECHIK_BLOCK_SIZE],
+                           const ak_uint8 (*keys_gf)[KUZNECHIK_BLOCK_SIZE],
+                           const ak_uint8 *in,
+                           ak_uint8 *out,
+                           size_t blocks)
+{
+    __m512i sbox[4];
+    __m512i to_gf[4];
+    __m512i from_gf[4];
+
+    for (int i = 0; i < 4; ++i)
+    {
+        sbox[i]    = _mm512_load_si512(g_tables.sbox_gf + 64 * i);
+        to_gf[i]   = _mm512_load_si512(g_tables.to_gf + 64 * i);
+        from_gf[i] = _mm512_load_si512(g_tables.from_gf + 64 * i);
+    }
+
+    size_t b = 0;
+
+    if (blocks >= KUZNECHIK_SLICE_BLOCKS)
+    {
+        alignas(64) ak_uint8 keys[KUZNECHIK_ROUND_KEYS][KUZNECHIK_BLOCK_SIZE][64];
+
+        for (int r = 0; r < KUZNECHIK_ROUND_KEYS; ++r)
+        {
+            for (int i = 0; i < KUZNECHIK_BLOCK_SIZE; ++i)
+            {
+                _mm512_store_si512(keys[r][i], _mm512_set1_epi8(static_cast<char>(keys_gf[r][i])));
+            }
+        }
+
+        for (; b + KUZNECHIK_SLICE_BLOCKS <= blocks; b += KUZNECHIK_SLICE_BLOCKS)
+        {
+            encrypt_slices_avx512(keys, sbox, to_gf, from_gf, in + b * KUZNECHIK_BLOCK_SIZE, out + b * KUZNECHIK_BLOCK_SIZE);
+        }
+
+        explicit_bzero(keys, sizeof(keys));
+    }
+
+    for (; b < blocks; b += 4)
+    {
+        const size_t bytes = std::min<size_t>(4, blocks - b) * KUZNECHIK_BLOCK_SIZE;
+        const __mmask64 mask = (bytes == 64) ? ~__mmask64(0) : ((__mmask64(1) << bytes) - 1);
+
+        const __m512i x = lookup_avx512(_mm512_maskz_loadu_epi8(mask, in + b * KUZNECHIK_BLOCK_SIZE), to_gf);
+        _mm512_mask_storeu_epi8(out + b * KUZNECHIK_BLOCK_SIZE, mask, lookup_avx512(encrypt_lanes_avx512(x, keys_gf, sbox), from_gf));
+    }
+}
+
+static bool supported_avx512()
+{
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+           __builtin_cpu_supports("avx512vbmi") && __builtin_cpu_supports("gfni");
+}
+
+#endif // KUZNECHIK_X86
+
+/** Варианты в порядке предпочтения */
+static KernelVariant g_variants[] = {
+#ifdef KUZNECHIK_X86
+    {"avx512",  encrypt_avx512,  supported_avx512,  false},
+    {"sse4.1",  encrypt_sse41,   supported_sse41,   false},
+#endif
+    {"generic", encrypt_generic, supported_generic, false},
+};
+
+static std::atomic<const KernelVariant*> g_variant{nullptr};
+static std::once_flag                    g_variant_once;
+
+/**
+ * @brief Проверяет вариант на контрольных примерах.
+ *
+ * Шифрование одного блока сверяется с примером из ГОСТ Р 34.12-2015,
+ * а шифрование 71 блока - с переносимым вариантом, чтобы проверить
+ * и полные пакеты, и обработку остатка.
+ *
+ * @param variant Проверяемый вариант.
+ * @return bool true, если результаты совпали.
+ */
+static bool check_variant(const KernelVariant& variant)
+{
+    static const ak_uint8 key[KUZNECHIK_KEY_SIZE] = {
+        0xef, 0xcd, 0xab, 0x89, 0x67, 0x45, 0x23, 0x01, 0x10, 0x32, 0x54, 0x76, 0x98, 0xba, 0xdc, 0xfe,
+        0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11, 0x00, 0xff, 0xee, 0xdd, 0xcc, 0xbb, 0xaa, 0x99, 0x88
+    };
+    static const ak_uint8 plain[KUZNECHIK_BLOCK_SIZE] = {
+        0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, 0x00, 0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11
+    };
+    static const ak_uint8 cipher[KUZNECHIK_BLOCK_SIZE] = {
+        0xcd, 0xed, 0xd4, 0xb9, 0x42, 0x8d, 0x46, 0x5a, 0x30, 0x24, 0xbc, 0xbe, 0x90, 0x9d, 0x67, 0x7f
+    };
+
+    alignas(64) ak_uint8 keys[KUZNECHIK_ROUND_KEYS][KUZNECHIK_BLOCK_SIZE];
+    alignas(64) ak_uint8 keys_gf[KUZNECHIK_ROUND_KEYS][KUZNECHIK_BLOCK_SIZE];
+    expand_key(key, keys, keys_gf);
+
+    ak_uint8 block[KUZNECHIK_BLOCK_SIZE];
+    variant.encrypt(keys, keys_gf, plain, block, 1);
+    if (std::memcmp(block, cipher, sizeof(block)) != 0)
+    {
+        return false;
+    }
+
+    const size_t blocks = 71;
+    ak_uint8 input[blocks * KUZNECHIK_BLOCK_SIZE];
+    ak_uint8 expected[blocks * KUZNECHIK_BLOCK_SIZE];
+    ak_uint8 actual[blocks * KUZNECHIK_BLOCK_SIZE];
+
+    for (size_t i = 0; i < sizeof(input); ++i)
+    {
+        input[i] = static_cast<ak_uint8>(i * 131 + 7);
+    }
+
+    encrypt_generic(keys, keys_gf, input, expected, blocks);
+    variant.encrypt(keys, keys_gf, input, actual, blocks);
+
+    return std::memcmp(expected, actual, sizeof(actual)) == 0;
+}
+
+/**
+ * @brief Возвращает выбранный вариант, выбирая его при первом обращении.
+ *
+ * @return const KernelVariant* Вариант или nullptr, если ни один не прошел проверку.
+ */
+static const KernelVariant* current_variant()
+{
+    std::call_once(g_variant_once, []()
+    {
+        tables();
+
+        for (auto& variant : g_variants)
+        {
+            variant.passed = variant.supported() && check_variant(variant);
+        }
+
+        for (const auto& variant : g_variants)
+        {
+            if (variant.passed)
+            {
+                g_variant.store(&variant);
+                break;
+            }
+        }
+    });
+
+    return g_variant.load();
+}
+
+static inline std::uint64_t load_le64(const ak_uint8 *data)
+{
+    std::uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+static inline void store_le64(ak_uint8 *data, std::uint64_t value)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    std::memcpy(data, &value, sizeof(value));
+}
+
+/**
+ * @brief Разворачивает ключ.
+ *
+ * @param key Ключ (KUZNECHIK_KEY_SIZE байт в порядке libakrypt).
+ */
+KuznechikKernel::KuznechikKernel(const ak_uint8 *key)
+{
+    expand_key(key, m_keys, m_keys_gf);
+}
+
+/**
+ * @brief Затирает раундовые ключи.
+ */
+KuznechikKernel::~KuznechikKernel()
+{
+    explicit_bzero(m_keys, sizeof(m_keys));
+    explicit_bzero(m_keys_gf, sizeof(m_keys_gf));
+}
+
+/**
+ * @brief Шифрует блоки в режиме простой замены.
+ *
+ * @param in Открытый текст (blocks * KUZNECHIK_BLOCK_SIZE байт).
+ * @param out Буфер для результата (может совпадать с in).
+ * @param blocks Количество блоков.
+ *
+ * @note Перед вызовом is_available() должна вернуть true.
+ */
+void KuznechikKernel::encrypt_ecb(const ak_uint8 *in, ak_uint8 *out, size_t blocks) const
+{
+    current_variant()->encrypt(m_keys, m_keys_gf, in, out, blocks);
+}
+
+/**
+ * @brief Зашифровывает или расшифровывает данные в режиме гаммирования (CTR).
+ *
+ * Гамма вырабатывается пачками по KUZNECHIK_CTR_BATCH блоков: значения
+ * счетчика записываются в буфер, шифруются одним вызовом варианта
+ * и складываются с данными. Счетчик увеличивается на количество
+ * использованных блоков, поэтому следующий вызов продолжает гамму
+ * (как вызов ak_bckey_ctr без синхропосылки).
+ *
+ * @param in Входные данные.
+ * @param out Буфер для результата (может совпадать с in).
+ * @param size Длина данных в байтах.
+ * @param counter Счетчик (KUZNECHIK_BLOCK_SIZE байт, младший байт первым).
+ */
+void KuznechikKernel::ctr(const ak_uint8 *in, ak_uint8 *out, size_t size, ak_uint8 *counter) const
+{
+    const KernelVariant *variant = current_variant();
+    alignas(64) ak_uint8 gamma[KUZNECHIK_CTR_BATCH * KUZNECHIK_BLOCK_SIZE];
+
+    while (size > 0)
+    {
+        const size_t blocks = std::min<size_t>(KUZNECHIK_CTR_BATCH, (size + KUZNECHIK_BLOCK_SIZE - 1) / KUZNECHIK_BLOCK_SIZE);
+
+        std::uint64_t low  = load_le64(counter);
+        std::uint64_t high = load_le64(counter + 8);
+
+        for (size_t b = 0; b < blocks; ++b)
+        {
+            store_le64(gamma + b * KUZNECHIK_BLOCK_SIZE, low);
+            store_le64(gamma + b * KUZNECHIK_BLOCK_SIZE + 8, high);
+            high += (++low == 0);
+        }
+
+        store_le64(counter, low);
+        store_le64(counter + 8, high);
+
+        variant->encrypt(m_keys, m_keys_gf, gamma, gamma, blocks);
+
+        const size_t bytes = std::min(size, blocks * KUZNECHIK_BLOCK_SIZE);
+        for (size_t i = 0; i < bytes; ++i)
+        {
+            out[i] = in[i] ^ gamma[i];
+        }
+
+        in   += bytes;
+        out  += bytes;
+        size -= bytes;
+    }
+
+    explicit_bzero(gamma, sizeof(gamma));
+}
+
+/**
+ * @brief Формирует начальное значение счетчика CTR из синхропосылки.
+ *
+ * Как и в ГОСТ Р 34.13-2015, синхропосылка занимает старшую половину
+ * счетчика, а младшая половина обнулена.
+ *
+ * @param iv Синхропосылка (KUZNECHIK_IV_SIZE байт).
+ * @param counter Счетчик (KUZNECHIK_BLOCK_SIZE байт).
+ */
+void KuznechikKernel::ctr_counter(const ak_uint8 *iv, ak_uint8 *counter)
+{
+    std::memset(counter, 0, KUZNECHIK_BLOCK_SIZE - KUZNECHIK_IV_SIZE);
+    std::memcpy(counter + KUZNECHIK_BLOCK_SIZE - KUZNECHIK_IV_SIZE, iv, KUZNECHIK_IV_SIZE);
+}
+
+/**
+ * @brief Проверяет, что хотя бы один вариант прошел самотестирование.
+ *
+ * @return bool true, если реализацией можно пользоваться.
+ */
+bool KuznechikKernel::is_available()
+{
+    return current_variant() != nullptr;
+}
+
+/**
+ * @brief Имя выбранного варианта.
+ *
+ * @return const char* Имя варианта ("avx512", "sse4.1", "generic") или "none".
+ */
+const char* KuznechikKernel::isa()
+{
+    const KernelVariant *variant = current_variant();
+    return variant ? variant->name : "none";
+}
+
+/**
+ * @brief Список вариантов, доступных на этом процессоре и прошедших проверку.
+ *
+ * @return std::vector<std::string> Имена вариантов в порядке предпочтения.
+ */
+std::vector<std::string> KuznechikKernel::supported_isas()
+{
+    current_variant();
+
+    std::vector<std::string> names;
+    for (const auto& variant : g_variants)
+    {
+        if (variant.passed)
+        {
+            names.emplace_back(variant.name);
+        }
+    }
+
+    return names;
+}
+
+/**
+ * @brief Принудительно выбирает вариант (для замеров и отладки).
+ *
+ * @param isa Имя варианта.
+ * @return bool true, если вариант доступен и выбран.
+ */
+bool KuznechikKernel::select_isa(const std::string& isa)
+{
+    current_variant();
+
+    for (const auto& variant : g_variants)
+    {
+        if (variant.passed && isa == variant.name)
+        {
+            g_variant.store(&variant);
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file       <kuznechik_kernel.hpp>
+ * @brief      Хэдер векторной реализации шифра Кузнечик (ГОСТ Р 34.12-2015).
+ *
+ *             Содержит в себе объявление собственной реализации Кузнечика
+ *             для режимов ECB и CTR. Вариант вычислений (переносимый,
+ *             SSE4.1 или AVX-512) выбирается при первом обращении
+ *             по возможностям процессора, поэтому одна сборка работает
+ *             на любом x86-64. Байты ключа и блоков хранятся в том же
+ *             порядке, что и в libakrypt (младший байт первым).
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef KUZNECHIK_KERNEL_HPP
+#define KUZNECHIK_KERNEL_HPP
+
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+#define KUZNECHIK_KEY_SIZE    32
+#define KUZNECHIK_BLOCK_SIZE  16
+#define KUZNECHIK_IV_SIZE     8
+#define KUZNECHIK_ROUND_KEYS  10
+#define KUZNECHIK_CTR_BATCH   256
+
+typedef unsigned char ak_uint8;
+
+class KuznechikKernel
+{
+public:
+    explicit KuznechikKernel(const ak_uint8 *key);
+    ~KuznechikKernel();
+
+    KuznechikKernel(const KuznechikKernel&) = delete;
+    KuznechikKernel& operator=(const KuznechikKernel&) = delete;
+
+    void encrypt_ecb(const ak_uint8 *in, ak_uint8 *out, size_t blocks) const;
+    void ctr(const ak_uint8 *in, ak_uint8 *out, size_t size, ak_uint8 *counter) const;
+
+    static void ctr_counter(const ak_uint8 *iv, ak_uint8 *counter);
+
+    static bool is_available();
+    static const char* isa();
+    static std::vector<std::string> supported_isas();
+    static bool select_isa(const std::string& isa);
+
+private:
+    alignas(64) ak_uint8 m_keys[KUZNECHIK_ROUND_KEYS][KUZNECHIK_BLOCK_SIZE];    ///< Раундовые ключи
+    alignas(64) ak_uint8 m_keys_gf[KUZNECHIK_ROUND_KEYS][KUZNECHIK_BLOCK_SIZE]; ///< Раундовые ключи в представлении поля AES (для GFNI)
+};
+
+#endif // KUZNECHIK_KERNEL_HPP
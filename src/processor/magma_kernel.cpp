@@ -0,0 +1,807 @@
+/**
+ * @file       <magma_kernel.cpp>
+ * @brief      Основной файл многопоточной (multi-buffer) реализации шифра Магма.
+ *
+ *             Раунд Магмы - сложение половины блока с раундовым ключом по
+ *             модулю 2^32, подстановка восьми 4-битных S-блоков и циклический
+ *             сдвиг на 11 бит. 32 раунда одного блока образуют длинную цепочку
+ *             зависимых операций, поэтому один поток не загружает процессор.
+ *             Здесь блоки обрабатываются пачками: половины блоков хранятся
+ *             в двух массивах (младшие и старшие 32 бита), и за один проход
+ *             раунда вычисляется сразу несколько независимых блоков -
+ *             по четыре в переносимом варианте (параллелизм на уровне
+ *             инструкций), по 16 в двух регистрах AVX2 и по 16 (или 32)
+ *             в регистрах AVX-512. Подстановка в векторных вариантах выполняется
+ *             инструкциями VPSHUFB (AVX2) и VPERMB (AVX-512 VBMI) по
+ *             4-битным полубайтам.
+ *
+ *             Каждый вариант при выборе проверяется на контрольном примере
+ *             из стандарта, непрошедший вариант не используется.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "magma_kernel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define MAGMA_X86
+#endif
+
+typedef void (*EncryptLanes)(const std::uint32_t *keys, std::uint32_t *lo, std::uint32_t *hi, size_t count);
+
+/**
+ * @brief Вариант реализации шифрования пачки блоков.
+ */
+struct MagmaVariant
+{
+    const char    *name;
+    EncryptLanes   encrypt;
+    size_t         lanes;   ///< Сколько потоков OFB нужно, чтобы загрузить вариант
+    bool         (*supported)();
+    bool           passed;
+};
+
+/**
+ * @brief Таблицы, общие для всех ключей.
+ */
+struct MagmaTables
+{
+    alignas(64) std::uint32_t bytes[4][256];    ///< Подстановка байта j со сдвигом на 11 бит
+    alignas(64) ak_uint8      nibble_lo[4][16]; ///< Младшие полубайты байта j (для AVX2)
+    alignas(64) ak_uint8      nibble_hi[4][16]; ///< Старшие полубайты байта j, сдвинутые на 4 бита (для AVX2)
+    alignas(64) ak_uint8      perm_lo[64];      ///< nibble_lo подряд, индекс (j << 4) | полубайт (для AVX-512)
+    alignas(64) ak_uint8      perm_hi[64];      ///< nibble_hi подряд (для AVX-512)
+};
+
+/** Подстановки pi'_0 ... pi'_7 из ГОСТ Р 34.12-2015 */
+static const ak_uint8 pi[8][16] = {
+    {12,  4,  6,  2, 10,  5, 11,  9, 14,  8, 13,  7,  0,  3, 15,  1},
+    { 6,  8,  2,  3,  9, 10,  5, 12,  1, 14,  4,  7, 11, 13,  0, 15},
+    {11,  3,  5,  8,  2, 15, 10, 13, 14,  1,  7,  4, 12,  9,  6,  0},
+    {12,  8,  2,  1, 13,  4, 15,  6,  7,  0, 10,  5,  3, 14,  9, 11},
+    { 7, 15,  5, 10,  8,  1,  6, 13,  0,  9,  3, 14, 11,  4,  2, 12},
+    { 5, 13, 15,  6,  9,  2, 12, 10, 11,  7,  8,  1,  4,  3, 14,  0},
+    { 8, 14,  2,  5,  6,  9,  1, 12, 15,  4, 11,  0, 13, 10,  3,  7},
+    { 1,  7, 14, 13,  0,  5,  8,  3,  4, 15, 10,  6,  9, 12, 11,  2}
+};
+
+static MagmaTables    g_tables;
+static std::once_flag g_tables_once;
+
+static inline std::uint32_t rotl11(std::uint32_t x)
+{
+    return (x << 11) | (x >> 21);
+}
+
+/**
+ * @brief Заполняет таблицы подстановки.
+ */
+static void build_tables()
+{
+    for (int j = 0; j < 4; ++j)
+    {
+        for (int b = 0; b < 256; ++b)
+        {
+            const std::uint32_t s = static_cast<std::uint32_t>(pi[2 * j + 1][b >> 4] << 4 | pi[2 * j][b & 15]);
+            g_tables.bytes[j][b] = rotl11(s << (8 * j));
+        }
+
+        for (int n = 0; n < 16; ++n)
+        {
+            g_tables.nibble_lo[j][n] = pi[2 * j][n];
+            g_tables.nibble_hi[j][n] = static_cast<ak_uint8>(pi[2 * j + 1][n] << 4);
+            g_tables.perm_lo[j * 16 + n] = g_tables.nibble_lo[j][n];
+            g_tables.perm_hi[j * 16 + n] = g_tables.nibble_hi[j][n];
+        }
+    }
+}
+
+static const MagmaTables& tables()
+{
+    std::call_once(g_tables_once, build_tables);
+    return g_tables;
+}
+
+static inline std::uint32_t load_le32(const ak_uint8 *data)
+{
+    std::uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap32(value);
+#endif
+    return value;
+}
+
+static inline void store_le32(ak_uint8 *data, std::uint32_t value)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap32(value);
+#endif
+    std::memcpy(data, &value, sizeof(value));
+}
+
+static inline std::uint64_t load_le64(const ak_uint8 *data)
+{
+    std::uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+static inline void store_le64(ak_uint8 *data, std::uint64_t value)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    std::memcpy(data, &value, sizeof(value));
+}
+
+/**
+ * @brief Разворачивает ключ в 32 раундовых ключа.
+ *
+ * libakrypt хранит ключ младшим байтом вперед, поэтому K_1 из стандарта -
+ * это последнее 32-битное слово ключа, а K_8 - первое. Раунды 1-24
+ * используют K_1 ... K_8 три раза подряд, раунды 25-32 - K_8 ... K_1.
+ *
+ * @param key Ключ (MAGMA_KEY_SIZE байт в порядке libakrypt).
+ * @param keys Раундовые ключи.
+ */
+static void expand_key(const ak_uint8 *key, std::uint32_t *keys)
+{
+    for (int r = 0; r < MAGMA_ROUND_KEYS; ++r)
+    {
+        const int word = (r < 24) ? 7 - (r % 8) : r - 24;
+        keys[r] = load_le32(key + 4 * word);
+    }
+}
+
+/**
+ * @brief Шифрует W блоков одновременно табличным способом.
+ *
+ * Цепочки раундов разных блоков независимы, и компилятор чередует их
+ * инструкции, поэтому W блоков занимают почти столько же тактов, сколько один.
+ */
+template <size_t W>
+static inline void encrypt_scalar(const std::uint32_t *keys, std::uint32_t *lo, std::uint32_t *hi)
+{
+    const auto& t = tables().bytes;
+    std::uint32_t n1[W];
+    std::uint32_t n2[W];
+
+    for (size_t i = 0; i < W; ++i)
+    {
+        n1[i] = lo[i];
+        n2[i] = hi[i];
+    }
+
+    for (int r = 0; r < MAGMA_ROUND_KEYS; r += 2)
+    {
+        for (size_t i = 0; i < W; ++i)
+        {
+            const std::uint32_t x = n1[i] + keys[r];
+            n2[i] ^= t[0][x & 0xff] ^ t[1][(x >> 8) & 0xff] ^ t[2][(x >> 16) & 0xff] ^ t[3][x >> 24];
+        }
+        for (size_t i = 0; i < W; ++i)
+        {
+            const std::uint32_t x = n2[i] + keys[r + 1];
+            n1[i] ^= t[0][x & 0xff] ^ t[1][(x >> 8) & 0xff] ^ t[2][(x >> 16) & 0xff] ^ t[3][x >> 24];
+        }
+    }
+
+    for (size_t i = 0; i < W; ++i)
+    {
+        lo[i] = n2[i];
+        hi[i] = n1[i];
+    }
+}
+
+static void encrypt_generic(const std::uint32_t *keys, std::uint32_t *lo, std::uint32_t *hi, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        encrypt_scalar<4>(keys, lo + i, hi + i);
+    }
+    for (; i < count; ++i)
+    {
+        encrypt_scalar<1>(keys, lo + i, hi + i);
+    }
+}
+
+static bool supported_generic()
+{
+    return true;
+}
+
+#ifdef MAGMA_X86
+
+#define MAGMA_AVX2_TARGET __attribute__((target("avx2")))
+
+/**
+ * @brief Подстановка t для восьми 32-битных слов.
+ *
+ * VPSHUFB выбирает по полубайту из одной таблицы на 16 элементов, а у
+ * каждого байта слова свои S-блоки, поэтому для каждого из четырех байтов
+ * выполняется отдельная выборка, и результат маскируется по положению байта.
+ */
+MAGMA_AVX2_TARGET
+static inline __m256i substitute_avx2(__m256i x, const __m256i *lo_tables, const __m256i *hi_tables, const __m256i *masks)
+{
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    const __m256i low    = _mm256_and_si256(x, nibble);
+    const __m256i high   = _mm256_and_si256(_mm256_srli_epi32(x, 4), nibble);
+
+    __m256i s = _mm256_setzero_si256();
+    for (int j = 0; j < 4; ++j)
+    {
+        const __m256i byte = _mm256_or_si256(_mm256_shuffle_epi8(lo_tables[j], low), _mm256_shuffle_epi8(hi_tables[j], high));
+        s = _mm256_or_si256(s, _mm256_and_si256(byte, masks[j]));
+    }
+
+    return _mm256_or_si256(_mm256_slli_epi32(s, 11), _mm256_srli_epi32(s, 21));
+}
+
+MAGMA_AVX2_TARGET
+static void encrypt_avx2(const std::uint32_t *keys, std::uint32_t *lo, std::uint32_t *hi, size_t count)
+{
+    const auto& t = tables();
+    __m256i lo_tables[4];
+    __m256i hi_tables[4];
+    __m256i masks[4];
+
+    for (int j = 0; j < 4; ++j)
+    {
+        lo_tables[j] = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(t.nibble_lo[j])));
+        hi_tables[j] = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(t.nibble_hi[j])));
+        masks[j]     = _mm256_set1_epi32(static_cast<int>(0xffu << (8 * j)));
+    }
+
+    size_t i = 0;
+
+    // Две независимые цепочки по 8 блоков скрывают задержку раунда
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lo + i));
+        __m256i a2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hi + i));
+        __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lo + i + 8));
+        __m256i b2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hi + i + 8));
+
+        for (int r = 0; r < MAGMA_ROUND_KEYS; r += 2)
+        {
+            const __m256i k1 = _mm256_set1_epi32(static_cast<int>(keys[r]));
+            const __m256i k2 = _mm256_set1_epi32(static_cast<int>(keys[r + 1]));
+
+            a2 = _mm256_xor_si256(a2, substitute_avx2(_mm256_add_epi32(a1, k1), lo_tables, hi_tables, masks));
+            b2 = _mm256_xor_si256(b2, substitute_avx2(_mm256_add_epi32(b1, k1), lo_tables, hi_tables, masks));
+            a1 = _mm256_xor_si256(a1, substitute_avx2(_mm256_add_epi32(a2, k2), lo_tables, hi_tables, masks));
+            b1 = _mm256_xor_si256(b1, substitute_avx2(_mm256_add_epi32(b2, k2), lo_tables, hi_tables, masks));
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lo + i), a2);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(hi + i), a1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lo + i + 8), b2);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(hi + i + 8), b1);
+    }
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i n1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lo + i));
+        __m256i n2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hi + i));
+
+        for (int r = 0; r < MAGMA_ROUND_KEYS; r += 2)
+        {
+            n2 = _mm256_xor_si256(n2, substitute_avx2(_mm256_add_epi32(n1, _mm256_set1_epi32(static_cast<int>(keys[r]))), lo_tables, hi_tables, masks));
+            n1 = _mm256_xor_si256(n1, substitute_avx2(_mm256_add_epi32(n2, _mm256_set1_epi32(static_cast<int>(keys[r + 1]))), lo_tables, hi_tables, masks));
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lo + i), n2);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(hi + i), n1);
+    }
+
+    encrypt_generic(keys, lo + i, hi + i, count - i);
+}
+
+static bool supported_avx2()
+{
+    return __builtin_cpu_supports("avx2");
+}
+
+/**
+ * Сдвиги и VPERMB вызываются в вариантах maskz с полной маской: на обычные
+ * интринсики GCC 12 выдает ложное предупреждение -Wmaybe-uninitialized.
+ */
+#define MAGMA_AVX512_TARGET __attribute__((target("avx512f,avx512bw,avx512vbmi")))
+
+/**
+ * @brief Подстановка t для шестнадцати 32-битных слов.
+ *
+ * VPERMB выбирает байт из таблицы на 64 элемента, поэтому к полубайту
+ * добавляется номер байта в слове (j << 4), и все четыре S-блока
+ * каждой половины байта выбираются одной инструкцией.
+ */
+MAGMA_AVX512_TARGET
+static inline __m512i substitute_avx512(__m512i x, __m512i lo_table, __m512i hi_table, __m512i nibble, __m512i position)
+{
+    const __mmask16 all_dwords = 0xffff;
+    const __mmask64 all_bytes  = ~0ull;
+
+    const __m512i low  = _mm512_ternarylogic_epi32(x, nibble, position, 0xea);
+    const __m512i high = _mm512_ternarylogic_epi32(_mm512_maskz_srli_epi32(all_dwords, x, 4), nibble, position, 0xea);
+    const __m512i s    = _mm512_or_si512(_mm512_maskz_permutexvar_epi8(all_bytes, low, lo_table),
+                                         _mm512_maskz_permutexvar_epi8(all_bytes, high, hi_table));
+
+    return _mm512_maskz_rol_epi32(all_dwords, s, 11);
+}
+
+MAGMA_AVX512_TARGET
+static void encrypt_avx512(const std::uint32_t *keys, std::uint32_t *lo, std::uint32_t *hi, size_t count)
+{
+    const auto& t = tables();
+    const __m512i lo_table = _mm512_load_si512(t.perm_lo);
+    const __m512i hi_table = _mm512_load_si512(t.perm_hi);
+    const __m512i nibble   = _mm512_set1_epi8(0x0f);
+    const __m512i position = _mm512_set1_epi32(0x30201000);
+
+    size_t i = 0;
+
+    // Две независимые цепочки по 16 блоков скрывают задержку раунда
+    for (; i + 32 <= count; i += 32)
+    {
+        __m512i a1 = _mm512_loadu_si512(lo + i);
+        __m512i a2 = _mm512_loadu_si512(hi + i);
+        __m512i b1 = _mm512_loadu_si512(lo + i + 16);
+        __m512i b2 = _mm512_loadu_si512(hi + i + 16);
+
+        for (int r = 0; r < MAGMA_ROUND_KEYS; r += 2)
+        {
+            const __m512i k1 = _mm512_set1_epi32(static_cast<int>(keys[r]));
+            const __m512i k2 = _mm512_set1_epi32(static_cast<int>(keys[r + 1]));
+
+            a2 = _mm512_xor_si512(a2, substitute_avx512(_mm512_add_epi32(a1, k1), lo_table, hi_table, nibble, position));
+            b2 = _mm512_xor_si512(b2, substitute_avx512(_mm512_add_epi32(b1, k1), lo_table, hi_table, nibble, position));
+            a1 = _mm512_xor_si512(a1, substitute_avx512(_mm512_add_epi32(a2, k2), lo_table, hi_table, nibble, position));
+            b1 = _mm512_xor_si512(b1, substitute_avx512(_mm512_add_epi32(b2, k2), lo_table, hi_table, nibble, position));
+        }
+
+        _mm512_storeu_si512(lo + i, a2);
+        _mm512_storeu_si512(hi + i, a1);
+        _mm512_storeu_si512(lo + i + 16, b2);
+        _mm512_storeu_si512(hi + i + 16, b1);
+    }
+
+    // Остаток: по 16 блоков, последняя неполная пачка - под маской
+    for (; i < count; i += 16)
+    {
+        const __mmask16 mask = (count - i >= 16) ? static_cast<__mmask16>(0xffff)
+                                                 : static_cast<__mmask16>((1u << (count - i)) - 1);
+
+        __m512i n1 = _mm512_maskz_loadu_epi32(mask, lo + i);
+        __m512i n2 = _mm512_maskz_loadu_epi32(mask, hi + i);
+
+        for (int r = 0; r < MAGMA_ROUND_KEYS; r += 2)
+        {
+            n2 = _mm512_xor_si512(n2, substitute_avx512(_mm512_add_epi32(n1, _mm512_set1_epi32(static_cast<int>(keys[r]))), lo_table, hi_table, nibble, position));
+            n1 = _mm512_xor_si512(n1, substitute_avx512(_mm512_add_epi32(n2, _mm512_set1_epi32(static_cast<int>(keys[r + 1]))), lo_table, hi_table, nibble, position));
+        }
+
+        _mm512_mask_storeu_epi32(lo + i, mask, n2);
+        _mm512_mask_storeu_epi32(hi + i, mask, n1);
+    }
+}
+
+static bool supported_avx512()
+{
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+           __builtin_cpu_supports("avx512vbmi");
+}
+
+#endif // MAGMA_X86
+
+/** Варианты в порядке предпочтения */
+static MagmaVariant g_variants[] = {
+#ifdef MAGMA_X86
+    {"avx512",  encrypt_avx512,  16, supported_avx512,  false},
+    {"avx2",    encrypt_avx2,    16, supported_avx2,    false},
+#endif
+    {"generic", encrypt_generic, 4,  supported_generic, false},
+};
+
+static std::atomic<const MagmaVariant*> g_variant{nullptr};
+static std::once_flag                   g_variant_once;
+
+/**
+ * @brief Проверяет вариант на контрольных примерах.
+ *
+ * Шифрование одного блока сверяется с примером из ГОСТ Р 34.12-2015,
+ * а шифрование 71 блока - с переносимым вариантом, чтобы проверить
+ * и полные пачки, и обработку остатка.
+ *
+ * @param variant Проверяемый вариант.
+ * @return bool true, если результаты совпали.
+ */
+static bool check_variant(const MagmaVariant& variant)
+{
+    static const ak_uint8 key[MAGMA_KEY_SIZE] = {
+        0xff, 0xfe, 0xfd, 0xfc, 0xfb, 0xfa, 0xf9, 0xf8, 0xf7, 0xf6, 0xf5, 0xf4, 0xf3, 0xf2, 0xf1, 0xf0,
+        0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+    };
+    static const ak_uint8 plain[MAGMA_BLOCK_SIZE]  = {0x10, 0x32, 0x54, 0x76, 0x98, 0xba, 0xdc, 0xfe};
+    static const ak_uint8 cipher[MAGMA_BLOCK_SIZE] = {0x3d, 0xca, 0xd8, 0xc2, 0xe5, 0x01, 0xe9, 0x4e};
+
+    std::uint32_t keys[MAGMA_ROUND_KEYS];
+    expand_key(key, keys);
+
+    std::uint32_t lo = load_le32(plain);
+    std::uint32_t hi = load_le32(plain + 4);
+    variant.encrypt(keys, &lo, &hi, 1);
+
+    if (lo != load_le32(cipher) || hi != load_le32(cipher + 4))
+    {
+        return false;
+    }
+
+    const size_t blocks = 71;
+    std::uint32_t expected_lo[blocks], expected_hi[blocks];
+    std::uint32_t actual_lo[blocks], actual_hi[blocks];
+
+    for (size_t i = 0; i < blocks; ++i)
+    {
+        expected_lo[i] = actual_lo[i] = static_cast<std::uint32_t>(i * 2654435761u);
+        expected_hi[i] = actual_hi[i] = static_cast<std::uint32_t>(i * 40503u + 7);
+    }
+
+    encrypt_generic(keys, expected_lo, expected_hi, blocks);
+    variant.encrypt(keys, actual_lo, actual_hi, blocks);
+
+    return std::memcmp(expected_lo, actual_lo, sizeof(actual_lo)) == 0 &&
+           std::memcmp(expected_hi, actual_hi, sizeof(actual_hi)) == 0;
+}
+
+/**
+ * @brief Возвращает выбранный вариант, выбирая его при первом обращении.
+ *
+ * @return const MagmaVariant* Вариант или nullptr, если ни один не прошел проверку.
+ */
+static const MagmaVariant* current_variant()
+{
+    std::call_once(g_variant_once, []()
+    {
+        tables();
+
+        for (auto& variant : g_variants)
+        {
+            variant.passed = variant.supported() && check_variant(variant);
+        }
+
+        for (const auto& variant : g_variants)
+        {
+            if (variant.passed)
+            {
+                g_variant.store(&variant);
+                break;
+            }
+        }
+    });
+
+    return g_variant.load();
+}
+
+/**
+ * @brief Складывает блок гаммы с данными (size байт, не больше блока).
+ */
+static inline void xor_gamma(const ak_uint8 *in, ak_uint8 *out, size_t size, std::uint32_t lo, std::uint32_t hi)
+{
+    const std::uint64_t gamma = static_cast<std::uint64_t>(hi) << 32 | lo;
+
+    if (size == MAGMA_BLOCK_SIZE)
+    {
+        store_le64(out, load_le64(in) ^ gamma);
+        return;
+    }
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        out[i] = in[i] ^ static_cast<ak_uint8>(gamma >> (8 * i));
+    }
+}
+
+/**
+ * @brief Разворачивает ключ.
+ *
+ * @param key Ключ (MAGMA_KEY_SIZE байт в порядке libakrypt).
+ */
+MagmaKernel::MagmaKernel(const ak_uint8 *key)
+{
+    expand_key(key, m_keys);
+}
+
+/**
+ * @brief Затирает раундовые ключи.
+ */
+MagmaKernel::~MagmaKernel()
+{
+    explicit_bzero(m_keys, sizeof(m_keys));
+}
+
+/**
+ * @brief Шифрует блоки в режиме простой замены.
+ *
+ * @param in Открытый текст (blocks * MAGMA_BLOCK_SIZE байт).
+ * @param out Буфер для результата (может совпадать с in).
+ * @param blocks Количество блоков.
+ *
+ * @note Перед вызовом is_available() должна вернуть true.
+ */
+void MagmaKernel::encrypt_ecb(const ak_uint8 *in, ak_uint8 *out, size_t blocks) const
+{
+    const MagmaVariant *variant = current_variant();
+    alignas(64) std::uint32_t lo[MAGMA_BATCH];
+    alignas(64) std::uint32_t hi[MAGMA_BATCH];
+
+    while (blocks > 0)
+    {
+        const size_t count = std::min<size_t>(blocks, MAGMA_BATCH);
+
+        for (size_t b = 0; b < count; ++b)
+        {
+            lo[b] = load_le32(in + b * MAGMA_BLOCK_SIZE);
+            hi[b] = load_le32(in + b * MAGMA_BLOCK_SIZE + 4);
+        }
+
+        variant->encrypt(m_keys, lo, hi, count);
+
+        for (size_t b = 0; b < count; ++b)
+        {
+            store_le32(out + b * MAGMA_BLOCK_SIZE, lo[b]);
+            store_le32(out + b * MAGMA_BLOCK_SIZE + 4, hi[b]);
+        }
+
+        in     += count * MAGMA_BLOCK_SIZE;
+        out    += count * MAGMA_BLOCK_SIZE;
+        blocks -= count;
+    }
+}
+
+/**
+ * @brief Зашифровывает или расшифровывает данные в режиме гаммирования (CTR).
+ *
+ * Соседние блоки гаммы независимы, поэтому они шифруются пачками по
+ * MAGMA_BATCH блоков. Счетчик увеличивается на количество использованных
+ * блоков, и следующий вызов продолжает гамму (как вызов ak_bckey_ctr
+ * без синхропосылки).
+ *
+ * @param in Входные данные.
+ * @param out Буфер для результата (может совпадать с in).
+ * @param size Длина данных в байтах.
+ * @param counter Счетчик (MAGMA_BLOCK_SIZE байт, младший байт первым).
+ */
+void MagmaKernel::ctr(const ak_uint8 *in, ak_uint8 *out, size_t size, ak_uint8 *counter) const
+{
+    const MagmaVariant *variant = current_variant();
+    alignas(64) std::uint32_t lo[MAGMA_BATCH];
+    alignas(64) std::uint32_t hi[MAGMA_BATCH];
+
+    std::uint64_t value = load_le64(counter);
+
+    while (size > 0)
+    {
+        const size_t count = std::min<size_t>(MAGMA_BATCH, (size + MAGMA_BLOCK_SIZE - 1) / MAGMA_BLOCK_SIZE);
+
+        for (size_t b = 0; b < count; ++b, ++value)
+        {
+            lo[b] = static_cast<std::uint32_t>(value);
+            hi[b] = static_cast<std::uint32_t>(value >> 32);
+        }
+
+        variant->encrypt(m_keys, lo, hi, count);
+
+        for (size_t b = 0; b < count && size > 0; ++b)
+        {
+            const size_t bytes = std::min<size_t>(size, MAGMA_BLOCK_SIZE);
+            xor_gamma(in, out, bytes, lo[b], hi[b]);
+
+            in   += bytes;
+            out  += bytes;
+            size -= bytes;
+        }
+    }
+
+    store_le64(counter, value);
+    explicit_bzero(lo, sizeof(lo));
+    explicit_bzero(hi, sizeof(hi));
+}
+
+/**
+ * @brief Зашифровывает или расшифровывает несколько потоков в режиме OFB.
+ *
+ * В OFB каждый блок гаммы - это зашифрованный предыдущий, поэтому внутри
+ * одного потока блоки шифруются строго по очереди. Здесь до MAGMA_LANES
+ * потоков занимают по дорожке, и за один вызов варианта вычисляется
+ * очередной блок гаммы каждого из них. Закончившийся поток освобождает
+ * дорожку для следующего. Результат для каждого потока совпадает
+ * с однократным вызовом ak_bckey_ofb с его синхропосылкой.
+ *
+ * @param streams Потоки (синхропосылка каждого - MAGMA_BLOCK_SIZE байт).
+ * @param count Количество потоков.
+ */
+void MagmaKernel::ofb(const MagmaStream *streams, size_t count) const
+{
+    struct Lane
+    {
+        const ak_uint8 *in;
+        ak_uint8       *out;
+        size_t          left;
+    };
+
+    const MagmaVariant *variant = current_variant();
+    alignas(64) std::uint32_t lo[MAGMA_LANES];
+    alignas(64) std::uint32_t hi[MAGMA_LANES];
+    Lane lanes[MAGMA_LANES];
+
+    size_t next   = 0;
+    size_t active = 0;
+
+    auto load = [&](size_t slot) -> bool
+    {
+        while (next < count && streams[next].size == 0)
+        {
+            ++next;
+        }
+        if (next == count)
+        {
+            return false;
+        }
+
+        const MagmaStream& stream = streams[next++];
+        lanes[slot] = {stream.in, stream.out, stream.size};
+        lo[slot]    = load_le32(stream.iv);
+        hi[slot]    = load_le32(stream.iv + 4);
+        return true;
+    };
+
+    while (active < MAGMA_LANES && load(active))
+    {
+        ++active;
+    }
+
+    while (active > 0)
+    {
+        variant->encrypt(m_keys, lo, hi, active);
+
+        for (size_t slot = 0; slot < active;)
+        {
+            Lane& lane = lanes[slot];
+            const size_t bytes = std::min<size_t>(lane.left, MAGMA_BLOCK_SIZE);
+
+            xor_gamma(lane.in, lane.out, bytes, lo[slot], hi[slot]);
+            lane.in   += bytes;
+            lane.out  += bytes;
+            lane.left -= bytes;
+
+            if (lane.left > 0 || load(slot))
+            {
+                ++slot;
+                continue;
+            }
+
+            // Поток закончился, а новых нет: на его место встает последняя
+            // дорожка (в этом проходе она еще не обработана)
+            --active;
+            lanes[slot] = lanes[active];
+            lo[slot]    = lo[active];
+            hi[slot]    = hi[active];
+        }
+    }
+
+    explicit_bzero(lo, sizeof(lo));
+    explicit_bzero(hi, sizeof(hi));
+}
+
+/**
+ * @brief Формирует начальное значение счетчика CTR из синхропосылки.
+ *
+ * Как и в ГОСТ Р 34.13-2015, синхропосылка занимает старшую половину
+ * счетчика, а младшая половина обнулена.
+ *
+ * @param iv Синхропосылка (MAGMA_IV_SIZE байт).
+ * @param counter Счетчик (MAGMA_BLOCK_SIZE байт).
+ */
+void MagmaKernel::ctr_counter(const ak_uint8 *iv, ak_uint8 *counter)
+{
+    std::memset(counter, 0, MAGMA_BLOCK_SIZE - MAGMA_IV_SIZE);
+    std::memcpy(counter + MAGMA_BLOCK_SIZE - MAGMA_IV_SIZE, iv, MAGMA_IV_SIZE);
+}
+
+/**
+ * @brief Проверяет, что хотя бы один вариант прошел самотестирование.
+ *
+ * @return bool true, если реализацией можно пользоваться.
+ */
+bool MagmaKernel::is_available()
+{
+    return current_variant() != nullptr;
+}
+
+/**
+ * @brief Имя выбранного варианта.
+ *
+ * @return const char* Имя варианта ("avx512", "avx2", "generic") или "none".
+ */
+const char* MagmaKernel::isa()
+{
+    const MagmaVariant *variant = current_variant();
+    return variant ? variant->name : "none";
+}
+
+/**
+ * @brief Сколько потоков OFB стоит передавать в ofb() за раз.
+ *
+ * @return size_t Число дорожек выбранного варианта (1, если вариантов нет).
+ */
+size_t MagmaKernel::lanes()
+{
+    const MagmaVariant *variant = current_variant();
+    return variant ? variant->lanes : 1;
+}
+
+/**
+ * @brief Список вариантов, доступных на этом процессоре и прошедших проверку.
+ *
+ * @return std::vector<std::string> Имена вариантов в порядке предпочтения.
+ */
+std::vector<std::string> MagmaKernel::supported_isas()
+{
+    current_variant();
+
+    std::vector<std::string> names;
+    for (const auto& variant : g_variants)
+    {
+        if (variant.passed)
+        {
+            names.emplace_back(variant.name);
+        }
+    }
+
+    return names;
+}
+
+/**
+ * @brief Принудительно выбирает вариант (для замеров и отладки).
+ *
+ * @param isa Имя варианта.
+ * @return bool true, если вариант доступен и выбран.
+ */
+bool MagmaKernel::select_isa(const std::string& isa)
+{
+    current_variant();
+
+    for (const auto& variant : g_variants)
+    {
+        if (variant.passed && isa == variant.name)
+        {
+            g_variant.store(&variant);
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file       <magma_kernel.hpp>
+ * @brief      Хэдер многопоточной (multi-buffer) реализации шифра Магма (ГОСТ Р 34.12-2015).
+ *
+ *             Содержит в себе объявление собственной реализации Магмы, которая
+ *             шифрует сразу несколько независимых блоков: в режимах ECB и CTR -
+ *             соседние блоки одного потока, в режиме OFB - по одному блоку
+ *             нескольких независимых потоков (разных файлов или фрагментов).
+ *             Вариант вычислений (переносимый, AVX2 или AVX-512) выбирается
+ *             при первом обращении по возможностям процессора. Байты ключа
+ *             и блоков хранятся в том же порядке, что и в libakrypt.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef MAGMA_KERNEL_HPP
+#define MAGMA_KERNEL_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+#define MAGMA_KEY_SIZE     32
+#define MAGMA_BLOCK_SIZE   8
+#define MAGMA_IV_SIZE      4
+#define MAGMA_ROUND_KEYS   32
+#define MAGMA_LANES        16
+#define MAGMA_BATCH        256
+
+typedef unsigned char ak_uint8;
+
+/**
+ * @brief Один поток для MagmaKernel::ofb.
+ */
+struct MagmaStream
+{
+    const ak_uint8 *in   = nullptr;
+    ak_uint8       *out  = nullptr; ///< Может совпадать с in
+    size_t          size = 0;
+    const ak_uint8 *iv   = nullptr; ///< Синхропосылка (MAGMA_BLOCK_SIZE байт)
+};
+
+class MagmaKernel
+{
+public:
+    explicit MagmaKernel(const ak_uint8 *key);
+    ~MagmaKernel();
+
+    MagmaKernel(const MagmaKernel&) = delete;
+    MagmaKernel& operator=(const MagmaKernel&) = delete;
+
+    void encrypt_ecb(const ak_uint8 *in, ak_uint8 *out, size_t blocks) const;
+    void ctr(const ak_uint8 *in, ak_uint8 *out, size_t size, ak_uint8 *counter) const;
+    void ofb(const MagmaStream *streams, size_t count) const;
+
+    static void ctr_counter(const ak_uint8 *iv, ak_uint8 *counter);
+
+    static bool is_available();
+    static const char* isa();
+    static size_t lanes();
+    static std::vector<std::string> supported_isas();
+    static bool select_isa(const std::string& isa);
+
+private:
+    alignas(64) std::uint32_t m_keys[MAGMA_ROUND_KEYS]; ///< Раундовые ключи в порядке использования
+};
+
+#endif // MAGMA_KERNEL_HPP
@@ -0,0 +1,192 @@
+/**
+ * @file       <mapped_file.cpp>
+ * @brief      Основной файл отображения файлов в память для ak-file-encryptor.
+ *
+ *             Позволяет шифровать данные напрямую из отображения исходного файла
+ *             в отображение файла результата, без промежуточных буферов в куче.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "mapped_file.hpp"
+
+#include <cerrno>
+#include <iostream>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Освобождает отображение и закрывает файл.
+ */
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+/**
+ * @brief Перемещающий конструктор, забирает отображение у other.
+ *
+ * @param other Объект, владение отображением которого передается.
+ */
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : m_fd(std::exchange(other.m_fd, -1)),
+      m_data(std::exchange(other.m_data, nullptr)),
+      m_size(std::exchange(other.m_size, 0))
+{
+}
+
+/**
+ * @brief Перемещающее присваивание, забирает отображение у other.
+ *
+ * @param other Объект, владение отображением которого передается.
+ * @return MappedFile& Ссылка на текущий объект.
+ */
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        m_fd   = std::exchange(other.m_fd, -1);
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+    }
+    return *this;
+}
+
+/**
+ * @brief Отображает существующий файл в память только для чтения.
+ *
+ * @param path Путь к файлу.
+ * @return bool true, если файл отображен, иначе false (в том числе для пустых файлов).
+ */
+bool MappedFile::open_read(const std::string& path)
+{
+    close();
+
+    m_fd = ::open(path.c_str(), O_RDONLY);
+    if (m_fd < 0)
+    {
+        std::cerr << "Не удалось открыть файл для чтения: " << path << std::endl;
+        return false;
+    }
+
+    struct stat file_stat;
+    if (fstat(m_fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode) || file_stat.st_size == 0)
+    {
+        close();
+        return false;
+    }
+
+    m_size = static_cast<size_t>(file_stat.st_size);
+
+    void* mapping = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        std::cerr << "Не удалось отобразить файл в память: " << path << std::endl;
+        close();
+        return false;
+    }
+
+    m_data = static_cast<ak_uint8*>(mapping);
+    return true;
+}
+
+/**
+ * @brief Создает файл заданного размера и отображает его в память для записи.
+ *
+ * Место под файл резервируется через fallocate, чтобы запись в отображение
+ * не приводила к SIGBUS при нехватке места на диске. Если файловая система
+ * не поддерживает fallocate, размер задается через ftruncate.
+ *
+ * @param path Путь к файлу.
+ * @param size Размер файла в байтах.
+ * @return bool true, если файл создан и отображен, иначе false.
+ */
+bool MappedFile::create(const std::string& path, size_t size)
+{
+    close();
+
+    if (size == 0)
+    {
+        return false;
+    }
+
+    m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m_fd < 0)
+    {
+        std::cerr << "Не удалось открыть файл для записи: " << path << std::endl;
+        return false;
+    }
+
+    int error = fallocate(m_fd, 0, 0, static_cast<off_t>(size));
+    if (error != 0 && (errno == EOPNOTSUPP || errno == ENOSYS))
+    {
+        error = ftruncate(m_fd, static_cast<off_t>(size));
+    }
+
+    if (error != 0)
+    {
+        std::cerr << "Не удалось выделить место под файл: " << path << std::endl;
+        close();
+        return false;
+    }
+
+    m_size = size;
+
+    void* mapping = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        std::cerr << "Не удалось отобразить файл в память: " << path << std::endl;
+        close();
+        return false;
+    }
+
+    m_data = static_cast<ak_uint8*>(mapping);
+    return true;
+}
+
+/**
+ * @brief Освобождает отображение и закрывает дескриптор файла.
+ */
+void MappedFile::close()
+{
+    if (m_data)
+    {
+        munmap(m_data, m_size);
+        m_data = nullptr;
+    }
+
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+    m_size = 0;
+}
+
+/**
+ * @brief Сообщает ядру, что отображение будет читаться последовательно.
+ *
+ * Ядро увеличивает упреждающее чтение и раньше освобождает уже пройденные страницы.
+ */
+void MappedFile::advise_sequential()
+{
+    if (m_data)
+    {
+        madvise(m_data, m_size, MADV_SEQUENTIAL);
+    }
+}
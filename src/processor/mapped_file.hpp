@@ -0,0 +1,55 @@
+/**
+ * @file       <mapped_file.hpp>
+ * @brief      Хэдер отображения файлов в память для ak-file-encryptor.
+ *
+ *             Содержит в себе объявление обертки над mmap, которая владеет
+ *             дескриптором файла и отображением и освобождает их в деструкторе.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <string>
+#include <stddef.h>
+
+typedef unsigned char ak_uint8;
+
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool open_read(const std::string& path);
+    bool create(const std::string& path, size_t size);
+    void close();
+
+    void advise_sequential();
+
+    ak_uint8* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    int       m_fd   = -1;
+    ak_uint8* m_data = nullptr;
+    size_t    m_size = 0;
+};
+
+#endif // MAPPED_FILE_HPP
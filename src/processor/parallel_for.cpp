@@ -0,0 +1,107 @@
+/**
+ * @file       <parallel_for.cpp>
+ * @brief      Основной файл параллельного выполнения независимых задач.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "parallel_for.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Выполняет задачи 0..count-1 на нескольких потоках.
+ *
+ * Каждый поток один раз вызывает make_worker и получает собственный
+ * обработчик задач. Так у каждого потока может быть свое состояние
+ * (ключ, контекст хэширования, буферы), которое не нужно защищать
+ * мьютексами. Задачи раздаются через атомарный счетчик в порядке
+ * возрастания номеров. Если обработчик вернул false, остальные потоки
+ * не берут новые задачи.
+ *
+ * @param count Количество задач.
+ * @param threads Количество потоков (0 - по числу ядер).
+ * @param make_worker Фабрика обработчиков задач. Пустой обработчик означает ошибку.
+ * @return bool true, если все задачи выполнены успешно, иначе false.
+ */
+bool ParallelFor::run(size_t count, unsigned int threads, const WorkerFactory& make_worker)
+{
+    std::atomic<size_t> next_index{0};
+    std::atomic<bool>   failed{false};
+
+    auto worker = [&]()
+    {
+        Task task = make_worker();
+        if (!task)
+        {
+            failed = true;
+            return;
+        }
+
+        while (!failed)
+        {
+            const size_t index = next_index.fetch_add(1);
+            if (index >= count)
+            {
+                break;
+            }
+
+            if (!task(index))
+            {
+                failed = true;
+            }
+        }
+    };
+
+    threads = resolve_threads(threads, count);
+
+    if (threads == 1)
+    {
+        worker();
+        return !failed;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+
+    for (unsigned int i = 0; i < threads; ++i)
+    {
+        workers.emplace_back(worker);
+    }
+
+    for (auto& thread : workers)
+    {
+        thread.join();
+    }
+
+    return !failed;
+}
+
+/**
+ * @brief Определяет количество потоков для заданного числа задач.
+ *
+ * @param threads Запрошенное количество потоков (0 - по числу ядер).
+ * @param count Количество задач.
+ * @return unsigned int Количество потоков (от 1 до count).
+ */
+unsigned int ParallelFor::resolve_threads(unsigned int threads, size_t count)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    return static_cast<unsigned int>(std::clamp<size_t>(count, 1, threads));
+}
@@ -0,0 +1,37 @@
+/**
+ * @file       <parallel_for.hpp>
+ * @brief      Хэдер параллельного выполнения независимых задач.
+ *
+ *             Содержит в себе объявление функции, которая раздает задачи с номерами
+ *             0..count-1 нескольким потокам и останавливается на первой ошибке.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef PARALLEL_FOR_HPP
+#define PARALLEL_FOR_HPP
+
+#include <functional>
+#include <stddef.h>
+
+class ParallelFor
+{
+public:
+    using Task          = std::function<bool(size_t index)>;
+    using WorkerFactory = std::function<Task()>;
+
+public:
+    static bool run(size_t count, unsigned int threads, const WorkerFactory& make_worker);
+    static unsigned int resolve_threads(unsigned int threads, size_t count);
+};
+
+#endif // PARALLEL_FOR_HPP
@@ -0,0 +1,506 @@
+/**
+ * @file       <pipeline.cpp>
+ * @brief      Основной файл конвейера чтение -> шифрование -> запись.
+ *
+ *             Основная реализация использует io_uring (если проект собран с liburing):
+ *             несколько чтений и записей находятся в очереди ядра, пока текущая
+ *             порция шифруется. Если io_uring недоступен, используется запасной
+ *             вариант с отдельными потоками чтения (pread) и записи (pwrite).
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "pipeline.hpp"
+#include "blocking_queue.hpp"
+#include "buffer_pool.hpp"
+#include "crypto_provider.hpp"
+#include "file_io.hpp"
+#include "job_stats.hpp"
+#include "keystream.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef AK_HAVE_IO_URING
+#include <liburing.h>
+#endif
+
+#include <libakrypt.h>
+
+/**
+ * @brief Шифрует файл в режиме OFB, совмещая чтение, шифрование и запись.
+ *
+ * Эта функция держит в работе до depth порций одновременно: часть из них
+ * читается, одна шифруется, остальные записываются. Время обработки
+ * стремится к максимуму из времени ввода-вывода и времени шифрования,
+ * а не к их сумме. Гамму OFB заранее вырабатывает отдельный поток
+ * (KeystreamProducer), поэтому стадия шифрования сводится к наложению
+ * гаммы. Результат совпадает с FileStreamProcessor::process_file.
+ *
+ * @param input_file Путь к исходному файлу.
+ * @param output_file Путь к файлу, в который будет записан результат.
+ * @param key Указатель на структуру bckey, содержащую ключ.
+ * @param backend Способ ввода-вывода (BACKEND_AUTO выбирает io_uring, если он доступен).
+ * @param depth Количество порций, одновременно находящихся в конвейере.
+ * @param chunk_size Размер порции в байтах (округляется вниз до кратного BLOCK_SIZE).
+ * @return bool true, если обработка прошла успешно, иначе false.
+ */
+bool PipelineProcessor::process_file(const std::string& input_file,
+                                     const std::string& output_file,
+                                     struct bckey *key,
+                                     Backend backend,
+                                     size_t depth,
+                                     size_t chunk_size)
+{
+    chunk_size -= chunk_size % BLOCK_SIZE;
+    if (chunk_size == 0)
+    {
+        chunk_size = BLOCK_SIZE;
+    }
+    depth = std::max<size_t>(depth, 2);
+
+    int input_fd = open(input_file.c_str(), O_RDONLY);
+    if (input_fd < 0)
+    {
+        std::cerr << "Не удалось открыть файл для чтения: " << input_file << std::endl;
+        return false;
+    }
+
+    struct stat input_stat;
+    if (fstat(input_fd, &input_stat) != 0 || !S_ISREG(input_stat.st_mode))
+    {
+        close(input_fd);
+        return false;
+    }
+
+    int output_fd = open(output_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (output_fd < 0)
+    {
+        std::cerr << "Не удалось открыть файл для записи: " << output_file << std::endl;
+        close(input_fd);
+        return false;
+    }
+
+    const size_t file_size = static_cast<size_t>(input_stat.st_size);
+    posix_fadvise(input_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    int result = -1;
+
+    if (backend != BACKEND_THREADS)
+    {
+        result = process_io_uring(input_fd, output_fd, file_size, key, depth, chunk_size);
+    }
+
+    if (result < 0)
+    {
+        if (backend == BACKEND_IO_URING)
+        {
+            std::cerr << "io_uring недоступен, используется обработка потоками" << std::endl;
+        }
+        result = process_threads(input_fd, output_fd, file_size, key, depth, chunk_size) ? 1 : 0;
+    }
+
+    close(input_fd);
+    close(output_fd);
+
+    return result == 1;
+}
+
+/**
+ * @brief Проверяет, собран ли проект с поддержкой io_uring и разрешен ли он ядром.
+ *
+ * @return bool true, если кольцо io_uring удалось создать, иначе false.
+ */
+bool PipelineProcessor::is_io_uring_available()
+{
+#ifdef AK_HAVE_IO_URING
+    struct io_uring ring;
+    if (io_uring_queue_init(2, &ring, 0) < 0)
+    {
+        return false;
+    }
+    io_uring_queue_exit(&ring);
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Конвейер на io_uring.
+ *
+ * Порция с номером i всегда занимает слот i % depth. Чтение порции ставится
+ * в очередь, как только ее слот освободился после записи предыдущей порции.
+ * Порции шифруются строго по порядку (этого требует OFB), но пока идет
+ * шифрование, в ядре выполняются остальные чтения и записи.
+ *
+ * @param input_fd Дескриптор исходного файла.
+ * @param output_fd Дескриптор файла результата.
+ * @param file_size Размер исходного файла.
+ * @param key Указатель на структуру bckey, содержащую ключ.
+ * @param depth Количество слотов.
+ * @param chunk_size Размер порции.
+ * @return int 1 при успехе, 0 при ошибке, -1 если io_uring недоступен
+ * (в этом случае файлы не изменялись и можно использовать запасной вариант).
+ */
+int PipelineProcessor::process_io_uring(int input_fd, int output_fd, size_t file_size, struct bckey *key, size_t depth, size_t chunk_size)
+{
+#ifdef AK_HAVE_IO_URING
+    struct io_uring ring;
+    if (io_uring_queue_init(static_cast<unsigned>(depth * 2), &ring, 0) < 0)
+    {
+        return -1;
+    }
+
+    enum SlotState { SLOT_FREE, SLOT_READING, SLOT_READY, SLOT_WRITING };
+
+    struct Slot
+    {
+        PooledBuffer          buffer;
+        size_t                offset = 0;
+        size_t                size   = 0;
+        size_t                done   = 0;
+        SlotState             state  = SLOT_FREE;
+        bool                  pending = false; ///< Операция слота передана ядру и еще не завершена
+    };
+
+    std::vector<Slot> slots(depth);
+    for (auto& slot : slots)
+    {
+        slot.buffer = BufferPool::instance().acquire(chunk_size);
+        if (!slot.buffer)
+        {
+            io_uring_queue_exit(&ring);
+            return -1;
+        }
+    }
+
+    const size_t chunk_count = (file_size + chunk_size - 1) / chunk_size;
+    size_t next_read    = 0;
+    size_t next_encrypt = 0;
+    size_t written      = 0;
+    size_t in_flight    = 0;
+    bool   failed       = false;
+    ak_uint8 iv[IV_SIZE] = IV;
+    auto keystream = KeystreamProducer::start(key, iv, sizeof(iv), file_size, chunk_size);
+
+    ///< user_data: указатель на слот, тип операции определяется состоянием слота
+    auto submit = [&](size_t index, bool write)
+    {
+        Slot& slot = slots[index];
+        struct io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+
+        if (write)
+        {
+            io_uring_prep_write(sqe, output_fd, slot.buffer.data() + slot.done,
+                                static_cast<unsigned>(slot.size - slot.done), slot.offset + slot.done);
+        }
+        else
+        {
+            io_uring_prep_read(sqe, input_fd, slot.buffer.data() + slot.done,
+                               static_cast<unsigned>(slot.size - slot.done), slot.offset + slot.done);
+        }
+        io_uring_sqe_set_data(sqe, &slot);
+        slot.pending = true;
+        ++in_flight;
+    };
+
+    while (written < chunk_count && !failed)
+    {
+        while (next_read < chunk_count && slots[next_read % depth].state == SLOT_FREE)
+        {
+            Slot& slot  = slots[next_read % depth];
+            slot.offset = next_read * chunk_size;
+            slot.size   = std::min(chunk_size, file_size - slot.offset);
+            slot.done   = 0;
+            slot.state  = SLOT_READING;
+            submit(next_read % depth, false);
+            ++next_read;
+        }
+
+        io_uring_submit(&ring);
+
+        if (next_encrypt < next_read && slots[next_encrypt % depth].state == SLOT_READY)
+        {
+            Slot& slot = slots[next_encrypt % depth];
+            const bool first_chunk = (next_encrypt == 0);
+
+            JobStats::sample_queue(next_read - next_encrypt);
+            StageTimer timer(STAGE_CIPHER, slot.size);
+
+            const bool encrypted = keystream
+                ? keystream->apply(slot.buffer.data(), slot.buffer.data(), slot.size)
+                : ak_bckey_ofb(key,
+                               slot.buffer.data(),
+                               slot.buffer.data(),
+                               slot.size,
+                               first_chunk ? iv : nullptr,
+                               first_chunk ? sizeof(iv) : 0) == ak_error_ok;
+            if (!encrypted)
+            {
+                failed = true;
+                break;
+            }
+
+            slot.done  = 0;
+            slot.state = SLOT_WRITING;
+            submit(next_encrypt % depth, true);
+            io_uring_submit(&ring);
+            ++next_encrypt;
+            continue; ///< Сначала шифруем все готовые порции, потом ждем ядро
+        }
+
+        struct io_uring_cqe* cqe = nullptr;
+        if (io_uring_wait_cqe(&ring, &cqe) < 0)
+        {
+            failed = true;
+            break;
+        }
+
+        do
+        {
+            Slot&        slot  = *static_cast<Slot*>(io_uring_cqe_get_data(cqe));
+            const size_t index = static_cast<size_t>(&slot - slots.data());
+            const bool   write = (slot.state == SLOT_WRITING);
+
+            slot.pending = false;
+            --in_flight;
+
+            if (cqe->res <= 0)
+            {
+                failed = true;
+            }
+            else
+            {
+                slot.done += static_cast<size_t>(cqe->res);
+
+                if (slot.done < slot.size)
+                {
+                    submit(index, write); ///< Частичная операция, дочитываем/дописываем остаток
+                }
+                else if (write)
+                {
+                    JobStats::record(STAGE_WRITE, slot.size, slot.size); ///< Время операций ядра не видно, только объем
+                    slot.state = SLOT_FREE;
+                    ++written;
+                }
+                else
+                {
+                    JobStats::record(STAGE_READ, slot.size, slot.size);
+                    slot.state = SLOT_READY;
+                }
+            }
+
+            io_uring_cqe_seen(&ring, cqe);
+        }
+        while (!failed && io_uring_peek_cqe(&ring, &cqe) == 0);
+    }
+
+    // Буферы слотов вернутся в пул, поэтому ядро не должно больше к ним
+    // обращаться: после ошибки незавершенные операции отменяются, и все их
+    // завершения дочитываются до io_uring_queue_exit
+    if (in_flight > 0)
+    {
+        for (auto& slot : slots)
+        {
+            if (!slot.pending)
+            {
+                continue;
+            }
+
+            struct io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+            if (!sqe)
+            {
+                io_uring_submit(&ring);
+                sqe = io_uring_get_sqe(&ring);
+            }
+            if (sqe)
+            {
+                io_uring_prep_cancel(sqe, &slot, 0);
+                io_uring_sqe_set_data(sqe, nullptr); ///< Завершение самой отмены
+            }
+        }
+        io_uring_submit(&ring);
+    }
+
+    while (in_flight > 0)
+    {
+        struct io_uring_cqe* cqe = nullptr;
+        const int error = io_uring_wait_cqe(&ring, &cqe);
+
+        if (error == -EINTR)
+        {
+            continue;
+        }
+        if (error < 0)
+        {
+            // Завершений не дождаться: буферы остаются ядру и не возвращаются в пул
+            for (auto& slot : slots)
+            {
+                if (slot.pending)
+                {
+                    static_cast<void>(new PooledBuffer(std::move(slot.buffer)));
+                }
+            }
+            break;
+        }
+
+        if (auto* slot = static_cast<Slot*>(io_uring_cqe_get_data(cqe)))
+        {
+            slot->pending = false;
+            --in_flight;
+        }
+        io_uring_cqe_seen(&ring, cqe);
+    }
+
+    io_uring_queue_exit(&ring);
+    return failed ? 0 : 1;
+#else
+    (void)input_fd;
+    (void)output_fd;
+    (void)file_size;
+    (void)key;
+    (void)depth;
+    (void)chunk_size;
+    return -1;
+#endif
+}
+
+/**
+ * @brief Запасной конвейер на потоках.
+ *
+ * Поток чтения заполняет свободные буферы через pread, вызывающий поток
+ * шифрует их по порядку, поток записи сохраняет результат через pwrite
+ * и возвращает буфер в список свободных. Гамма для больших файлов
+ * вырабатывается заранее четвертым потоком (KeystreamProducer).
+ *
+ * @param input_fd Дескриптор исходного файла.
+ * @param output_fd Дескриптор файла результата.
+ * @param file_size Размер исходного файла.
+ * @param key Указатель на структуру bckey, содержащую ключ.
+ * @param depth Количество буферов.
+ * @param chunk_size Размер порции.
+ * @return bool true, если обработка прошла успешно, иначе false.
+ */
+bool PipelineProcessor::process_threads(int input_fd, int output_fd, size_t file_size, struct bckey *key, size_t depth, size_t chunk_size)
+{
+    struct Item
+    {
+        size_t slot;
+        size_t offset;
+        size_t size;
+    };
+
+    std::vector<PooledBuffer> buffers;
+    buffers.reserve(depth);
+    for (size_t i = 0; i < depth; ++i)
+    {
+        buffers.push_back(BufferPool::instance().acquire(chunk_size));
+        if (!buffers.back())
+        {
+            return false;
+        }
+    }
+
+    BlockingQueue<size_t> free_slots;
+    BlockingQueue<Item>   read_queue;
+    BlockingQueue<Item>   write_queue;
+    std::atomic<bool>     failed{false};
+
+    for (size_t i = 0; i < depth; ++i)
+    {
+        free_slots.push(i);
+    }
+
+    std::thread reader([&]()
+    {
+        for (size_t offset = 0; offset < file_size && !failed; offset += chunk_size)
+        {
+            auto slot = free_slots.pop();
+            if (!slot)
+            {
+                break;
+            }
+
+            const size_t size = std::min(chunk_size, file_size - offset);
+            if (!FileIO::pread_exact(input_fd, buffers[*slot].data(), size, static_cast<off_t>(offset)))
+            {
+                failed = true;
+                break;
+            }
+
+            read_queue.push({*slot, offset, size});
+        }
+        read_queue.close();
+    });
+
+    std::thread writer([&]()
+    {
+        while (auto item = write_queue.pop())
+        {
+            if (!failed && !FileIO::pwrite_exact(output_fd, buffers[item->slot].data(), item->size, static_cast<off_t>(item->offset)))
+            {
+                failed = true;
+                free_slots.close();
+            }
+            free_slots.push(item->slot);
+        }
+    });
+
+    ak_uint8 iv[IV_SIZE] = IV;
+    bool first_chunk = true;
+    auto keystream = KeystreamProducer::start(key, iv, sizeof(iv), file_size, chunk_size);
+
+    while (auto item = read_queue.pop())
+    {
+        if (failed)
+        {
+            continue; ///< Дочитываем очередь, чтобы поток чтения завершился
+        }
+
+        JobStats::sample_queue(read_queue.size() + 1);
+        StageTimer timer(STAGE_CIPHER, item->size);
+
+        const bool encrypted = keystream
+            ? keystream->apply(buffers[item->slot].data(), buffers[item->slot].data(), item->size)
+            : ak_bckey_ofb(key,
+                           buffers[item->slot].data(),
+                           buffers[item->slot].data(),
+                           item->size,
+                           first_chunk ? iv : nullptr,
+                           first_chunk ? sizeof(iv) : 0) == ak_error_ok;
+        first_chunk = false;
+
+        if (!encrypted)
+        {
+            failed = true;
+            free_slots.close();
+            continue;
+        }
+
+        write_queue.push(*item);
+    }
+
+    write_queue.close();
+    reader.join();
+    writer.join();
+
+    return !failed;
+}
@@ -0,0 +1,57 @@
+/**
+ * @file       <pipeline.hpp>
+ * @brief      Хэдер конвейера чтение -> шифрование -> запись.
+ *
+ *             Содержит в себе объявления функций, которые совмещают ввод-вывод
+ *             с шифрованием: пока шифруется одна порция, следующие уже читаются,
+ *             а предыдущие записываются.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include "file_stream.hpp"
+
+#include <string>
+#include <stddef.h>
+
+#define PIPELINE_DEPTH 8
+#define PIPELINE_MIN_FILE_SIZE (64 << 20)
+
+class PipelineProcessor
+{
+public:
+    enum Backend
+    {
+        BACKEND_AUTO = 0,
+        BACKEND_IO_URING,
+        BACKEND_THREADS
+    };
+
+public:
+    static bool process_file(const std::string& input_file,
+                             const std::string& output_file,
+                             struct bckey *key,
+                             Backend backend = BACKEND_AUTO,
+                             size_t depth = PIPELINE_DEPTH,
+                             size_t chunk_size = STREAM_CHUNK_SIZE);
+
+    static bool is_io_uring_available();
+
+private:
+    static int process_io_uring(int input_fd, int output_fd, size_t file_size, struct bckey *key, size_t depth, size_t chunk_size);
+    static bool process_threads(int input_fd, int output_fd, size_t file_size, struct bckey *key, size_t depth, size_t chunk_size);
+};
+
+#endif // PIPELINE_HPP
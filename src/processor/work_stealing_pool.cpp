@@ -0,0 +1,187 @@
+/**
+ * @file       <work_stealing_pool.cpp>
+ * @brief      Основной файл пула потоков с перехватом задач.
+ *
+ *             Задачи каталога сильно различаются по объему: тысячи мелких
+ *             файлов и несколько огромных. Общая очередь с одним мьютексом
+ *             становится узким местом, а раздача задач заранее оставляет
+ *             потоки без работы. Здесь каждый поток берет задачи с конца
+ *             своей очереди (новые задачи, которые он сам породил, еще
+ *             горячие в кэше), а свободный поток забирает самую старую
+ *             задачу из начала чужой очереди.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#include "work_stealing_pool.hpp"
+#include "parallel_for.hpp"
+
+#include <climits>
+
+static thread_local const WorkStealingPool* current_pool  = nullptr;
+static thread_local unsigned int            current_index = UINT_MAX;
+
+/**
+ * @brief Запускает потоки пула.
+ *
+ * @param threads Количество потоков (0 - по числу ядер).
+ */
+WorkStealingPool::WorkStealingPool(unsigned int threads)
+{
+    threads = ParallelFor::resolve_threads(threads, SIZE_MAX);
+
+    m_queues.reserve(threads);
+    for (unsigned int i = 0; i < threads; ++i)
+    {
+        m_queues.push_back(std::make_unique<Queue>());
+    }
+
+    m_threads.reserve(threads);
+    for (unsigned int i = 0; i < threads; ++i)
+    {
+        m_threads.emplace_back(&WorkStealingPool::worker_loop, this, i);
+    }
+}
+
+/**
+ * @brief Дожидается выполнения всех задач и останавливает потоки.
+ */
+WorkStealingPool::~WorkStealingPool()
+{
+    wait();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_work_ready.notify_all();
+
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+/**
+ * @brief Добавляет задачу в пул.
+ *
+ * Задача, добавленная из потока этого же пула, попадает в его собственную
+ * очередь. Задачи извне раздаются по очередям по кругу.
+ *
+ * @param job Задача. Получает номер потока, на котором выполняется.
+ */
+void WorkStealingPool::submit(Job job)
+{
+    const unsigned int index = (current_pool == this)
+        ? current_index
+        : m_next_queue.fetch_add(1) % size();
+
+    m_pending.fetch_add(1);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queued.fetch_add(1);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+        m_queues[index]->jobs.push_back(std::move(job));
+    }
+    m_work_ready.notify_one();
+}
+
+/**
+ * @brief Ждет, пока не будут выполнены все задачи, включая порожденные.
+ *
+ * @warning Нельзя вызывать из потока этого же пула.
+ */
+void WorkStealingPool::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_all_done.wait(lock, [this]() { return m_pending.load() == 0; });
+}
+
+/**
+ * @brief Цикл рабочего потока.
+ *
+ * @param index Номер потока и его очереди.
+ */
+void WorkStealingPool::worker_loop(unsigned int index)
+{
+    current_pool  = this;
+    current_index = index;
+
+    while (true)
+    {
+        Job job;
+
+        if (!take_job(index, job))
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_work_ready.wait(lock, [this]() { return m_stop || m_queued.load() > 0; });
+
+            if (m_stop && m_queued.load() == 0)
+            {
+                return;
+            }
+            continue;
+        }
+
+        job(index);
+
+        if (m_pending.fetch_sub(1) == 1)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_all_done.notify_all();
+        }
+    }
+}
+
+/**
+ * @brief Берет задачу из своей очереди или перехватывает из чужой.
+ *
+ * @param index Номер потока.
+ * @param job Задача, которая будет выполнена.
+ * @return bool true, если задача найдена, иначе false.
+ */
+bool WorkStealingPool::take_job(unsigned int index, Job& job)
+{
+    {
+        Queue& own = *m_queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+
+        if (!own.jobs.empty())
+        {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            m_queued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    for (unsigned int offset = 1; offset < size(); ++offset)
+    {
+        Queue& victim = *m_queues[(index + offset) % size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+
+        if (!victim.jobs.empty())
+        {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            m_queued.fetch_sub(1);
+            m_steals.fetch_add(1);
+            return true;
+        }
+    }
+
+    return false;
+}
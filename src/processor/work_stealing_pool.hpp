@@ -0,0 +1,77 @@
+/**
+ * @file       <work_stealing_pool.hpp>
+ * @brief      Хэдер пула потоков с перехватом задач.
+ *
+ *             Содержит в себе объявление пула, в котором у каждого потока
+ *             своя очередь задач, а освободившиеся потоки забирают задачи
+ *             из чужих очередей.
+ *
+ * @author     THE_CHOODICK
+ * @date       17-10-2026
+ * @version    0.0.1
+ *
+ * @warning    Этот проект предназначен только для ознокомительных целей, сам проект содежит огромное количество говнокода и багов.
+ *
+ * @copyright  Copyright 2024 chooisfox. All rights reserved.
+ *
+ *             (Not really)
+ *
+ * @license    This project is released under the GNUv3 Public License.
+ */
+#ifndef WORK_STEALING_POOL_HPP
+#define WORK_STEALING_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stddef.h>
+
+class WorkStealingPool
+{
+public:
+    using Job = std::function<void(unsigned int worker)>;
+
+public:
+    explicit WorkStealingPool(unsigned int threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void submit(Job job);
+    void wait();
+
+    unsigned int size() const { return static_cast<unsigned int>(m_queues.size()); }
+    size_t steals() const { return m_steals.load(); }
+
+private:
+    struct Queue
+    {
+        std::mutex      mutex;
+        std::deque<Job> jobs;
+    };
+
+private:
+    void worker_loop(unsigned int index);
+    bool take_job(unsigned int index, Job& job);
+
+private:
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread>            m_threads;
+
+    std::mutex                          m_mutex;
+    std::condition_variable             m_work_ready;
+    std::condition_variable             m_all_done;
+    std::atomic<size_t>                 m_queued{0};
+    std::atomic<size_t>                 m_pending{0};
+    std::atomic<size_t>                 m_steals{0};
+    std::atomic<unsigned int>           m_next_queue{0};
+    bool                                m_stop = false;
+};
+
+#endif // WORK_STEALING_POOL_HPP